@@ -0,0 +1,26 @@
+import { defineConfig, devices } from '@playwright/test';
+
+const projectRoot = __dirname;
+
+export default defineConfig({
+  testDir: './tests',
+  fullyParallel: false,
+  workers: 1,
+  timeout: 600000,
+  use: {
+    headless: true,
+    baseURL: 'http://localhost:4310',
+  },
+  projects: [
+    { name: 'chromium', use: { ...devices['Desktop Chrome'] } },
+    { name: 'firefox', use: { ...devices['Desktop Firefox'] } },
+    { name: 'webkit', use: { ...devices['Desktop Safari'] } },
+  ],
+  webServer: {
+    command: 'pnpm vite --host --port 4310 --config vite.config.ts',
+    cwd: projectRoot,
+    url: 'http://localhost:4310/bench.html',
+    reuseExistingServer: !process.env.CI,
+    timeout: 120000,
+  },
+});
@@ -0,0 +1,42 @@
+import { parseArgs } from 'node:util';
+
+import { writeJson } from './lib/benchmarks.js';
+import {
+  CALIBRATION_PROBES,
+  formatCalibrationReport,
+  proposeGasSchedule,
+} from './lib/calibration.js';
+import { runCalibration } from './lib/calibration-bench.js';
+
+const { values } = parseArgs({
+  options: {
+    iterations: { type: 'string' },
+    warmup: { type: 'string' },
+    filter: { type: 'string' },
+    out: { type: 'string' },
+    quiet: { type: 'boolean', short: 'q' },
+  },
+});
+
+const log = values.quiet
+  ? () => undefined
+  : (line: string) => console.log(line);
+const filter = values.filter;
+
+const samples = await runCalibration({
+  probes: filter
+    ? CALIBRATION_PROBES.filter((probe) => probe.name.includes(filter))
+    : CALIBRATION_PROBES,
+  iterations: Number(values.iterations ?? 20),
+  warmup: Number(values.warmup ?? 3),
+  log,
+});
+const report = proposeGasSchedule(samples);
+
+for (const line of formatCalibrationReport(report)) {
+  console.log(line);
+}
+
+if (values.out) {
+  writeJson(values.out, { report, samples });
+}
@@ -0,0 +1,9 @@
+export * from './lib/benchmarks.js';
+export * from './lib/calibration.js';
+export * from './lib/calibration-bench.js';
+export * from './lib/corpus.js';
+export * from './lib/harness-bench.js';
+export * from './lib/report.js';
+export * from './lib/runtime-bench.js';
+export * from './lib/stats.js';
+export * from './lib/workloads.js';
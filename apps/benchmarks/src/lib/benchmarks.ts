@@ -0,0 +1,177 @@
+import { existsSync, readFileSync, writeFileSync } from 'node:fs';
+import { arch, cpus, platform } from 'node:os';
+import { join } from 'node:path';
+
+import {
+  getQuickjsNativeAddonPath,
+  getQuickjsNativeMetadataPath,
+} from '@blue-quickjs/quickjs-native';
+
+import { readGasCorpus } from './corpus.js';
+import { NATIVE_HARNESS_BACKEND, runHarnessBench } from './harness-bench.js';
+import {
+  BENCH_REPORT_VERSION,
+  type BenchBaseline,
+  type BenchReport,
+  type BenchRegression,
+  compareToBaseline,
+  createBaseline,
+} from './report.js';
+import { runRuntimeBench } from './runtime-bench.js';
+import { createWorkloads, filterWorkloads } from './workloads.js';
+
+export const NODE_BACKENDS = [
+  NATIVE_HARNESS_BACKEND,
+  'node-wasm',
+  'node-wasm-snapshot',
+  'node-native',
+] as const;
+
+export type NodeBenchBackend = (typeof NODE_BACKENDS)[number];
+
+export interface NodeBenchOptions {
+  repoRoot: string;
+  backends?: readonly NodeBenchBackend[];
+  iterations?: number;
+  warmup?: number;
+  filter?: string;
+  log?: (line: string) => void;
+}
+
+export const DEFAULT_ITERATIONS = 50;
+export const DEFAULT_WARMUP = 5;
+
+/**
+ * Runs the corpus and heavy workloads on the native harness and on Node
+ * `quickjs-runtime` (wasm and, when the addon is built, native). Backends
+ * that cannot run here are reported as skipped.
+ */
+export async function runNodeBenchmarks(
+  options: NodeBenchOptions,
+): Promise<BenchReport> {
+  const log = options.log ?? (() => undefined);
+  const iterations = options.iterations ?? DEFAULT_ITERATIONS;
+  const warmup = options.warmup ?? DEFAULT_WARMUP;
+  const harnessRoot = join(
+    options.repoRoot,
+    'tools',
+    'quickjs-native-harness',
+  );
+  const workloads = filterWorkloads(
+    createWorkloads(readGasCorpus(join(harnessRoot, 'fixtures', 'gas'))),
+    options.filter,
+  );
+
+  const report: BenchReport = {
+    version: BENCH_REPORT_VERSION,
+    createdAt: new Date().toISOString(),
+    environment: {
+      node: process.version,
+      platform: platform(),
+      arch: arch(),
+      cpu: cpus()[0]?.model ?? 'unknown',
+    },
+    backends: [],
+    entries: [],
+  };
+
+  for (const backend of options.backends ?? NODE_BACKENDS) {
+    log(`running ${backend} (${workloads.length} workloads)`);
+    if (backend === NATIVE_HARNESS_BACKEND) {
+      const binPath = join(harnessRoot, 'dist', 'quickjs-native-harness');
+      if (!existsSync(binPath)) {
+        report.backends.push({
+          backend,
+          runtimeInitMs: null,
+          skipped: `harness binary not found at ${binPath}`,
+        });
+        continue;
+      }
+      const result = await runHarnessBench({
+        binPath,
+        workloads,
+        iterations,
+        warmup,
+      });
+      report.backends.push(result.info);
+      report.entries.push(...result.entries);
+      continue;
+    }
+
+    const missing = backend === 'node-native' ? missingNativeAddon() : null;
+    if (missing) {
+      report.backends.push({ backend, runtimeInitMs: null, skipped: missing });
+      continue;
+    }
+    const result = await runRuntimeBench({
+      backend,
+      selection:
+        backend === 'node-native'
+          ? { backend: 'native', allowNonConsensus: true }
+          : { backend: 'wasm' },
+      restore: backend === 'node-wasm-snapshot',
+      workloads,
+      iterations,
+      warmup,
+      sampleMemory: () => {
+        const usage = process.memoryUsage();
+        return { rssBytes: usage.rss, heapBytes: usage.heapUsed };
+      },
+    });
+    report.backends.push(result.info);
+    report.entries.push(...result.entries);
+  }
+
+  return report;
+}
+
+function missingNativeAddon(): string | null {
+  for (const path of [
+    getQuickjsNativeAddonPath(),
+    getQuickjsNativeMetadataPath(),
+  ]) {
+    if (!existsSync(path)) {
+      return `native addon artifact not found at ${path}`;
+    }
+  }
+  return null;
+}
+
+export function readBaseline(path: string): BenchBaseline {
+  return JSON.parse(readFileSync(path, 'utf8')) as BenchBaseline;
+}
+
+export function writeJson(path: string, value: unknown): void {
+  writeFileSync(path, `${JSON.stringify(value, null, 2)}\n`);
+}
+
+/**
+ * Merges the report's entries into the baseline file, keeping entries of
+ * backends that did not run (e.g. browsers when updating from Node).
+ * `gasOnly` records gas without the machine-specific timings.
+ */
+export function updateBaseline(
+  path: string,
+  report: BenchReport,
+  tolerance?: number,
+  gasOnly = false,
+): BenchBaseline {
+  const previous = existsSync(path) ? readBaseline(path) : undefined;
+  const baseline = createBaseline(
+    report.entries,
+    tolerance ?? previous?.tolerance,
+    previous,
+    gasOnly,
+  );
+  writeJson(path, baseline);
+  return baseline;
+}
+
+export function checkBaseline(
+  path: string,
+  report: BenchReport,
+  tolerance?: number,
+): BenchRegression[] {
+  const baseline = readBaseline(path);
+  return compareToBaseline(report.entries, baseline, tolerance);
+}
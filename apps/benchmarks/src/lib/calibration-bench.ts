@@ -0,0 +1,123 @@
+import {
+  createRuntime,
+  initializeDeterministicVm,
+} from '@blue-quickjs/quickjs-runtime';
+import { DETERMINISM_INPUT } from '@blue-quickjs/test-harness';
+
+import {
+  CALIBRATION_PROBES,
+  type CalibrationProbe,
+  type CalibrationSample,
+} from './calibration.js';
+import { median } from './stats.js';
+import {
+  BENCH_GAS_LIMIT,
+  BENCH_MANIFEST,
+  BENCH_PROGRAM,
+  createBenchHost,
+} from './workloads.js';
+
+const UTF8_DECODER = new TextDecoder();
+
+export interface CalibrationRunOptions {
+  probes?: readonly CalibrationProbe[];
+  iterations: number;
+  warmup: number;
+  log?: (line: string) => void;
+}
+
+/**
+ * Runs every probe size on the `calibration` build type and pairs the gas it
+ * billed with the shim's wall-clock counters. Times are medians over the
+ * iterations; billing must not vary between them.
+ */
+export async function runCalibration(
+  options: CalibrationRunOptions,
+): Promise<CalibrationSample[]> {
+  const log = options.log ?? (() => undefined);
+  const runtime = await createRuntime({
+    manifest: BENCH_MANIFEST,
+    handlers: createBenchHost(),
+    buildType: 'calibration',
+  });
+
+  const samples: CalibrationSample[] = [];
+  for (const probe of options.probes ?? CALIBRATION_PROBES) {
+    for (const size of probe.sizes) {
+      const code = probe.code(size);
+      const program = { ...BENCH_PROGRAM, code };
+      let billed: Omit<CalibrationSample, 'vmNs' | 'hostNs' | 'gcNs'> | null =
+        null;
+      const vmNs: number[] = [];
+      const hostNs: number[] = [];
+      const gcNs: number[] = [];
+
+      for (let i = 0; i < options.warmup + options.iterations; i++) {
+        const vm = initializeDeterministicVm(
+          runtime,
+          program,
+          DETERMINISM_INPUT,
+          BENCH_GAS_LIMIT,
+        );
+        try {
+          vm.enableGasTrace(true, { hostGas: true });
+          vm.readCalibrationCounters();
+          const output = vm.evalBinary(code);
+          if (output.kind !== 'result') {
+            const message = UTF8_DECODER.decode(output.payload).trim();
+            throw new Error(`${probe.name}@${size}: ${message}`);
+          }
+          const counters = vm.readCalibrationCounters();
+          const trace = vm.readGasTraceCounters();
+          const hosts = vm.readHostGas().functions;
+          const sample = {
+            probe: probe.name,
+            category: probe.category,
+            size,
+            opcodes: Number(trace.opcodeCount),
+            arrayCbCalls: Number(trace.arrayCbBaseCount),
+            arrayCbElements: Number(trace.arrayCbPerElCount),
+            allocations: Number(trace.allocationCount),
+            allocationBytes: Number(trace.allocationBytes),
+            hostCalls: hosts.reduce((sum, host) => sum + host.calls, 0),
+            hostRequestBytes: hosts.reduce(
+              (sum, host) => sum + Number(host.reqBytes),
+              0,
+            ),
+            hostResponseBytes: hosts.reduce(
+              (sum, host) => sum + Number(host.respBytes),
+              0,
+            ),
+            gasUsed: Number(output.gasUsed),
+          };
+          if (billed && billed.gasUsed !== sample.gasUsed) {
+            throw new Error(
+              `${probe.name}@${size}: gas ${sample.gasUsed} differs from the first run (${billed.gasUsed})`,
+            );
+          }
+          billed = sample;
+          if (i >= options.warmup) {
+            const host = Number(counters.hostNs);
+            const gc = Number(counters.gcNs);
+            vmNs.push(Math.max(0, Number(counters.evalNs) - host - gc));
+            hostNs.push(host);
+            gcNs.push(gc);
+          }
+        } finally {
+          vm.dispose();
+        }
+      }
+
+      if (billed) {
+        samples.push({
+          ...billed,
+          vmNs: median(vmNs),
+          hostNs: median(hostNs),
+          gcNs: median(gcNs),
+        });
+        log(`${probe.name}@${size}: ${billed.gasUsed} gas`);
+      }
+    }
+  }
+  return samples;
+}
@@ -0,0 +1,156 @@
+import {
+  CALIBRATION_PROBES,
+  type CalibrationSample,
+  fitNonNegative,
+  formatCalibrationReport,
+  proposeGasSchedule,
+} from './calibration.js';
+
+// Synthetic machine: 2 ns per opcode, 40 ns per callback call, 1 ns per
+// callback element, 4 ns per allocation, 1 ns per 4 bytes, 500 ns per eval.
+// Host-side: 300 ns per call and 2 ns per request byte.
+function sample(
+  probe: string,
+  category: CalibrationSample['category'],
+  counts: Partial<CalibrationSample>,
+  nsPerOpcode = 2,
+): CalibrationSample {
+  const base: CalibrationSample = {
+    probe,
+    category,
+    size: 0,
+    opcodes: 0,
+    arrayCbCalls: 0,
+    arrayCbElements: 0,
+    allocations: 0,
+    allocationBytes: 0,
+    hostCalls: 0,
+    hostRequestBytes: 0,
+    hostResponseBytes: 0,
+    gasUsed: 0,
+    vmNs: 0,
+    hostNs: 0,
+    gcNs: 10,
+    ...counts,
+  };
+  return {
+    ...base,
+    vmNs:
+      500 +
+      nsPerOpcode * base.opcodes +
+      40 * base.arrayCbCalls +
+      base.arrayCbElements +
+      4 * base.allocations +
+      base.allocationBytes / 4,
+    hostNs: 300 * base.hostCalls + 2 * base.hostRequestBytes,
+  };
+}
+
+const SAMPLES: CalibrationSample[] = [1000, 4000, 16000].flatMap((n) => [
+  sample('opcode/arith', 'opcode', { opcodes: 10 * n }),
+  sample('opcode/string-builtin', 'opcode', { opcodes: n }, 8),
+  sample('array-callback/base', 'array-callback', {
+    opcodes: 12 * n,
+    arrayCbCalls: n,
+    arrayCbElements: n,
+  }),
+  sample('array-callback/per-element', 'array-callback', {
+    opcodes: 6 * n,
+    arrayCbCalls: 4,
+    arrayCbElements: 4 * n,
+  }),
+  sample('allocation/count', 'allocation', {
+    opcodes: 9 * n,
+    allocations: n,
+    allocationBytes: 32 * n,
+  }),
+  sample('allocation/bytes', 'allocation', {
+    opcodes: 640,
+    allocations: 64,
+    allocationBytes: 64 * n,
+  }),
+  sample('host/emit', 'host', {
+    opcodes: 600,
+    hostCalls: 64,
+    hostRequestBytes: 64 * n,
+    hostResponseBytes: 256,
+  }),
+  sample('host/document-get', 'host', {
+    opcodes: 300,
+    hostCalls: 32,
+    hostRequestBytes: 8 * n,
+    hostResponseBytes: 8 * n,
+  }),
+]);
+
+describe('calibration', () => {
+  it('fits non-negative coefficients', () => {
+    const rows = [
+      [1, 0],
+      [0, 1],
+      [1, 1],
+      [2, 1],
+    ];
+    const [a, b] = fitNonNegative(
+      rows,
+      rows.map(([x, y]) => 3 * x + 0.5 * y),
+    );
+    expect(a).toBeCloseTo(3, 6);
+    expect(b).toBeCloseTo(0.5, 6);
+
+    // The unconstrained solution would make the second coefficient negative.
+    const [c, d] = fitNonNegative(
+      [
+        [1, 1],
+        [2, 1],
+      ],
+      [1, 3],
+    );
+    expect(d).toBe(0);
+    expect(c).toBeCloseTo(1.4, 6);
+  });
+
+  it('recovers the costs in opcode gas and proposes an upward schedule', () => {
+    const report = proposeGasSchedule(SAMPLES);
+
+    expect(report.targetGasVersion).toBe(2);
+    expect(report.nsPerOpcodeGas).toBeCloseTo(2, 3);
+    expect(report.evalOverheadGas).toBeCloseTo(250, 0);
+    expect(report.measured.arrayCbBase).toBeCloseTo(20, 2);
+    expect(report.measured.arrayCbPerElement).toBeCloseTo(0.5, 2);
+    expect(report.measured.allocBase).toBeCloseTo(2, 2);
+    expect(report.measured.allocPerByte).toBeCloseTo(0.125, 3);
+    expect(report.proposed).toEqual({
+      arrayCbBase: 20,
+      arrayCbPerElement: 2,
+      allocBase: 3,
+      allocPerByteShift: 3,
+    });
+    expect(report.host).toEqual({ base: 150, kArgBytes: 1, kRetBytes: 0 });
+    expect(report.gcGasPerEval).toBeCloseTo(5, 6);
+
+    expect(
+      report.opcodeClasses.map(({ probe, underpriced }) => ({
+        probe,
+        underpriced,
+      })),
+    ).toEqual([
+      { probe: 'opcode/arith', underpriced: false },
+      { probe: 'opcode/string-builtin', underpriced: true },
+    ]);
+    expect(report.opcodeClasses[1].ratio).toBeCloseTo(4, 2);
+
+    const lines = formatCalibrationReport(report);
+    expect(lines[0]).toMatch(/JS_GAS_VERSION 2 \(current 1\)/);
+    expect(lines.some((line) => /string-builtin.*UNDERPRICED/.test(line))).toBe(
+      true,
+    );
+  });
+
+  it('generates distinct programs per probe size', () => {
+    for (const probe of CALIBRATION_PROBES) {
+      const programs = new Set(probe.sizes.map((size) => probe.code(size)));
+      expect(programs.size).toBe(probe.sizes.length);
+    }
+  });
+});
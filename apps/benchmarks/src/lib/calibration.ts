@@ -0,0 +1,440 @@
+/**
+ * Gas categories the shim meters outside the per-opcode charge, as charged by
+ * `JS_GAS_VERSION_LATEST` (docs/gas-schedule.md).
+ */
+export const CURRENT_GAS_SCHEDULE = {
+  arrayCbBase: 5,
+  arrayCbPerElement: 2,
+  allocBase: 3,
+  allocPerByteShift: 4,
+} as const;
+
+export const CURRENT_GAS_VERSION = 1;
+
+/** A proposal below this ratio to the current price is left unchanged. */
+export const UNDERPRICED_RATIO = 1.5;
+
+const FIT_EPSILON = 1e-6;
+
+export type CalibrationCategory =
+  | 'opcode'
+  | 'array-callback'
+  | 'allocation'
+  | 'host';
+
+/**
+ * A program that stresses one gas category (and, for opcodes, one opcode
+ * class). Each probe runs at several sizes so the fit can separate per-unit
+ * cost from the fixed cost of an eval.
+ */
+export interface CalibrationProbe {
+  name: string;
+  category: CalibrationCategory;
+  code: (size: number) => string;
+  sizes: readonly number[];
+}
+
+const loop = (size: number, body: string, setup = '', result = 's') =>
+  `(() => { ${setup} let s = 0; for (let i = 0; i < ${size}; i++) { ${body} } return ${result}; })()`;
+
+export const CALIBRATION_PROBES: readonly CalibrationProbe[] = [
+  {
+    name: 'opcode/arith',
+    category: 'opcode',
+    code: (n) => loop(n, 's = (s + i * 3) ^ (i >> 1);'),
+    sizes: [2000, 8000, 32000],
+  },
+  {
+    name: 'opcode/property',
+    category: 'opcode',
+    code: (n) =>
+      loop(n, 's += o.a + o.b; o.a = s & 7;', 'const o = { a: 1, b: 2 };'),
+    sizes: [2000, 8000, 32000],
+  },
+  {
+    name: 'opcode/call',
+    category: 'opcode',
+    code: (n) => loop(n, 's = f(s);', 'const f = (v) => (v + 1) | 0;'),
+    sizes: [2000, 8000, 32000],
+  },
+  {
+    name: 'opcode/array-index',
+    category: 'opcode',
+    code: (n) =>
+      loop(n, 's += a[i & 7];', 'const a = [1, 2, 3, 4, 5, 6, 7, 8];'),
+    sizes: [2000, 8000, 32000],
+  },
+  {
+    // Native string builtins do work proportional to their input for a
+    // single call opcode.
+    name: 'opcode/string-builtin',
+    category: 'opcode',
+    code: (n) =>
+      loop(
+        n,
+        "s += t.indexOf('z') + t.charCodeAt(i & 63);",
+        "const t = 'y'.repeat(64);",
+      ),
+    sizes: [1000, 4000, 16000],
+  },
+  {
+    name: 'array-callback/base',
+    category: 'array-callback',
+    code: (n) => loop(n, 'a.forEach((v) => { s += v; });', 'const a = [1];'),
+    sizes: [1000, 4000, 16000],
+  },
+  {
+    name: 'array-callback/per-element',
+    category: 'array-callback',
+    code: (n) =>
+      loop(
+        4,
+        'a.forEach((v) => { s += v; });',
+        `const a = []; for (let j = 0; j < ${n}; j++) a.push(j & 7);`,
+      ),
+    sizes: [2000, 8000, 32000],
+  },
+  {
+    name: 'allocation/count',
+    category: 'allocation',
+    code: (n) => loop(n, 'o = { i }; s += o.i;', 'let o;'),
+    sizes: [1000, 4000, 16000],
+  },
+  {
+    name: 'allocation/bytes',
+    category: 'allocation',
+    code: (n) => loop(64, `t = 'x'.repeat(${n}) + i; s += t.length;`, 'let t;'),
+    sizes: [1024, 8192, 65536],
+  },
+  {
+    // The bench host echoes the path, so request and response grow together.
+    name: 'host/document-get',
+    category: 'host',
+    code: (n) =>
+      loop(
+        64,
+        's += Host.v1.document.get(p + i).length;',
+        `const p = 'd'.repeat(${n});`,
+      ),
+    sizes: [16, 256, 2048],
+  },
+  {
+    // `emit` answers null, so only the request grows.
+    name: 'host/emit',
+    category: 'host',
+    code: (n) =>
+      loop(64, 'Host.v1.emit({ p, i }); s++;', `const p = 'e'.repeat(${n});`),
+    sizes: [16, 1024, 16384],
+  },
+];
+
+/**
+ * What one probe run billed (from the gas trace and the host-call gas
+ * breakdown) and how long it took (from the calibration counters).
+ */
+export interface CalibrationSample {
+  probe: string;
+  category: CalibrationCategory;
+  size: number;
+  opcodes: number;
+  arrayCbCalls: number;
+  arrayCbElements: number;
+  allocations: number;
+  allocationBytes: number;
+  hostCalls: number;
+  hostRequestBytes: number;
+  hostResponseBytes: number;
+  gasUsed: number;
+  /** Eval time outside host calls and GC checkpoints. */
+  vmNs: number;
+  hostNs: number;
+  gcNs: number;
+}
+
+export interface OpcodeClassCost {
+  probe: string;
+  /** VM ns per opcode after the fitted allocation and callback costs. */
+  nsPerOpcode: number;
+  /** `nsPerOpcode` over the fitted ns per opcode gas; 1 is fairly priced. */
+  ratio: number;
+  underpriced: boolean;
+}
+
+export interface CalibrationReport {
+  /** The schedule the proposal would ship as. */
+  targetGasVersion: number;
+  samples: number;
+  /** Reference cost: one gas is one opcode dispatch. */
+  nsPerOpcodeGas: number;
+  /** Fixed VM cost of one eval, in opcode gas. */
+  evalOverheadGas: number;
+  measured: {
+    arrayCbBase: number;
+    arrayCbPerElement: number;
+    allocBase: number;
+    /** Measured gas per allocated byte. */
+    allocPerByte: number;
+  };
+  proposed: {
+    arrayCbBase: number;
+    arrayCbPerElement: number;
+    allocBase: number;
+    allocPerByteShift: number;
+  };
+  /**
+   * Host-function constants for the benchmark host. They are manifest
+   * fields, so each deployment has to calibrate against its own handlers.
+   */
+  host: {
+    base: number;
+    kArgBytes: number;
+    kRetBytes: number;
+  };
+  opcodeClasses: OpcodeClassCost[];
+  /** GC checkpoint time per eval in opcode gas; GC is not charged. */
+  gcGasPerEval: number;
+}
+
+/**
+ * Non-negative least squares `min |A x - b|` with `x >= 0`, by cyclic
+ * coordinate descent on the normal equations. Columns are scaled to unit
+ * norm first, so features counted in bytes and in calls converge alike.
+ */
+export function fitNonNegative(
+  rows: readonly (readonly number[])[],
+  targets: readonly number[],
+  sweeps = 500,
+): number[] {
+  if (rows.length !== targets.length) {
+    throw new Error('fitNonNegative: rows and targets differ in length');
+  }
+  const width = rows[0]?.length ?? 0;
+  const scale = Array.from({ length: width }, (_, j) => {
+    const norm = Math.sqrt(rows.reduce((sum, row) => sum + row[j] ** 2, 0));
+    return norm > 0 ? norm : 1;
+  });
+  const a = rows.map((row) => row.map((value, j) => value / scale[j]));
+  const gram = Array.from({ length: width }, (_, i) =>
+    Array.from({ length: width }, (_, j) =>
+      a.reduce((sum, row) => sum + row[i] * row[j], 0),
+    ),
+  );
+  const rhs = Array.from({ length: width }, (_, j) =>
+    a.reduce((sum, row, k) => sum + row[j] * targets[k], 0),
+  );
+
+  const x = new Array<number>(width).fill(0);
+  for (let sweep = 0; sweep < sweeps; sweep++) {
+    let moved = 0;
+    for (let j = 0; j < width; j++) {
+      if (gram[j][j] === 0) {
+        continue;
+      }
+      let residual = rhs[j];
+      for (let k = 0; k < width; k++) {
+        residual -= gram[j][k] * x[k];
+      }
+      const next = Math.max(0, x[j] + residual / gram[j][j]);
+      moved = Math.max(moved, Math.abs(next - x[j]));
+      x[j] = next;
+    }
+    if (moved < 1e-12) {
+      break;
+    }
+  }
+  return x.map((value, j) => value / scale[j]);
+}
+
+/**
+ * Fit per-unit costs to the samples and express them in opcode gas. Rounding
+ * is upward: over-pricing costs throughput, under-pricing is a DoS vector.
+ */
+export function proposeGasSchedule(
+  samples: readonly CalibrationSample[],
+): CalibrationReport {
+  if (samples.length === 0) {
+    throw new Error('proposeGasSchedule: no samples');
+  }
+
+  // Columns: eval overhead, opcodes, callback calls, callback elements,
+  // allocations, allocated bytes. Opcode classes other than the plain
+  // interpreter loop are fitted separately below.
+  const vmSamples = samples.filter(
+    (sample) =>
+      sample.category !== 'opcode' || sample.probe === 'opcode/arith',
+  );
+  const [overhead, perOpcode, cbCall, cbElement, alloc, allocByte] =
+    fitNonNegative(
+      vmSamples.map((sample) => [
+        1,
+        sample.opcodes,
+        sample.arrayCbCalls,
+        sample.arrayCbElements,
+        sample.allocations,
+        sample.allocationBytes,
+      ]),
+      vmSamples.map((sample) => sample.vmNs),
+    );
+  if (!(perOpcode > 0)) {
+    throw new Error(
+      'proposeGasSchedule: opcode cost fitted to zero; add opcode samples',
+    );
+  }
+
+  const hostSamples = samples.filter((sample) => sample.hostCalls > 0);
+  const [hostCall, requestByte, responseByte] =
+    hostSamples.length > 0
+      ? fitNonNegative(
+          hostSamples.map((sample) => [
+            sample.hostCalls,
+            sample.hostRequestBytes,
+            sample.hostResponseBytes,
+          ]),
+          hostSamples.map((sample) => sample.hostNs),
+        )
+      : [0, 0, 0];
+
+  const gas = (ns: number) => ns / perOpcode;
+  const allocPerByte = gas(allocByte);
+  const opcodeClasses = [
+    ...new Set(
+      samples
+        .filter((sample) => sample.category === 'opcode')
+        .map((sample) => sample.probe),
+    ),
+  ].map((probe) => {
+    const runs = samples.filter((sample) => sample.probe === probe);
+    const explained = (sample: CalibrationSample) =>
+      overhead +
+      cbCall * sample.arrayCbCalls +
+      cbElement * sample.arrayCbElements +
+      alloc * sample.allocations +
+      allocByte * sample.allocationBytes;
+    const [nsPerOpcode] = fitNonNegative(
+      runs.map((sample) => [sample.opcodes]),
+      runs.map((sample) => Math.max(0, sample.vmNs - explained(sample))),
+    );
+    const ratio = gas(nsPerOpcode);
+    return {
+      probe,
+      nsPerOpcode,
+      ratio,
+      underpriced: ratio >= UNDERPRICED_RATIO,
+    };
+  });
+
+  const gcNs =
+    samples.reduce((sum, sample) => sum + sample.gcNs, 0) / samples.length;
+  const current = CURRENT_GAS_SCHEDULE;
+  const keepUnlessUnderpriced = (measured: number, price: number) =>
+    measured >= price * UNDERPRICED_RATIO ? ceilGas(measured) : price;
+
+  return {
+    targetGasVersion: CURRENT_GAS_VERSION + 1,
+    samples: samples.length,
+    nsPerOpcodeGas: perOpcode,
+    evalOverheadGas: gas(overhead),
+    measured: {
+      arrayCbBase: gas(cbCall),
+      arrayCbPerElement: gas(cbElement),
+      allocBase: gas(alloc),
+      allocPerByte,
+    },
+    proposed: {
+      arrayCbBase: keepUnlessUnderpriced(gas(cbCall), current.arrayCbBase),
+      arrayCbPerElement: keepUnlessUnderpriced(
+        gas(cbElement),
+        current.arrayCbPerElement,
+      ),
+      allocBase: keepUnlessUnderpriced(gas(alloc), current.allocBase),
+      allocPerByteShift:
+        allocPerByte * 2 ** current.allocPerByteShift >= UNDERPRICED_RATIO
+          ? allocPerByteShift(allocPerByte)
+          : current.allocPerByteShift,
+    },
+    host: {
+      base: ceilGas(gas(hostCall)),
+      kArgBytes: ceilGas(gas(requestByte)),
+      kRetBytes: ceilGas(gas(responseByte)),
+    },
+    opcodeClasses,
+    gcGasPerEval: gas(gcNs),
+  };
+}
+
+// Rounds up, ignoring fit noise far below one gas.
+function ceilGas(value: number): number {
+  return Math.max(0, Math.ceil(value - FIT_EPSILON));
+}
+
+// The largest shift (1 gas per 2^shift bytes) that still charges at least
+// the measured per-byte cost.
+function allocPerByteShift(gasPerByte: number): number {
+  if (gasPerByte >= 1) {
+    return 0;
+  }
+  const shift = Math.floor(Math.log2(1 / gasPerByte) + FIT_EPSILON);
+  return Math.max(0, Math.min(16, shift));
+}
+
+/**
+ * Human-readable proposal: the constants table (measured in gas, proposed
+ * rounded up), opcode classes with `UNDERPRICED` marks, host constants and
+ * the uncharged GC time.
+ */
+export function formatCalibrationReport(report: CalibrationReport): string[] {
+  const current = CURRENT_GAS_SCHEDULE;
+  const fixed = (value: number) => value.toFixed(2);
+  const row = (cells: string[], raise = false) =>
+    `  ${cells[0].padEnd(28)} ${cells[1].padStart(7)} ${cells[2].padStart(10)} ${cells[3].padStart(9)}${raise ? '  raise' : ''}`;
+  const constant = (
+    name: string,
+    now: number,
+    measured: number,
+    next: number,
+  ) => row([name, String(now), fixed(measured), String(next)], next > now);
+  const bytesPerGas = 1 / Math.max(report.measured.allocPerByte, 1e-9);
+
+  return [
+    `Proposed gas schedule for JS_GAS_VERSION ${report.targetGasVersion} (current ${CURRENT_GAS_VERSION}), from ${report.samples} samples`,
+    `1 gas = ${fixed(report.nsPerOpcodeGas)} ns (one opcode dispatch); eval overhead ${fixed(report.evalOverheadGas)} gas`,
+    '',
+    row(['constant', 'current', 'measured', 'proposed']),
+    constant(
+      'JS_GAS_ARRAY_CB_BASE',
+      current.arrayCbBase,
+      report.measured.arrayCbBase,
+      report.proposed.arrayCbBase,
+    ),
+    constant(
+      'JS_GAS_ARRAY_CB_PER_ELEMENT',
+      current.arrayCbPerElement,
+      report.measured.arrayCbPerElement,
+      report.proposed.arrayCbPerElement,
+    ),
+    constant(
+      'JS_GAS_ALLOC_BASE',
+      current.allocBase,
+      report.measured.allocBase,
+      report.proposed.allocBase,
+    ),
+    row(
+      [
+        'JS_GAS_ALLOC_PER_BYTE_SHIFT',
+        String(current.allocPerByteShift),
+        `1/${fixed(bytesPerGas)}B`,
+        String(report.proposed.allocPerByteShift),
+      ],
+      report.proposed.allocPerByteShift < current.allocPerByteShift,
+    ),
+    '',
+    'Opcode classes (ns per opcode, and relative to 1 gas):',
+    ...report.opcodeClasses.map(
+      (entry) =>
+        `  ${entry.probe.padEnd(28)} ${fixed(entry.nsPerOpcode).padStart(8)} ns ${fixed(entry.ratio).padStart(7)}x${entry.underpriced ? '  UNDERPRICED' : ''}`,
+    ),
+    '',
+    `Host functions (benchmark host; set per manifest): base ${report.host.base}, k_arg_bytes ${report.host.kArgBytes}, k_ret_bytes ${report.host.kRetBytes}`,
+    `GC checkpoints: ${fixed(report.gcGasPerEval)} gas per eval (not charged)`,
+  ];
+}
@@ -0,0 +1,17 @@
+import { readFileSync, readdirSync } from 'node:fs';
+import { basename, join } from 'node:path';
+
+import type { CorpusSource } from './workloads.js';
+
+/**
+ * Reads the native harness gas corpus (`fixtures/gas/*.js`) from disk.
+ */
+export function readGasCorpus(fixturesDir: string): CorpusSource[] {
+  return readdirSync(fixturesDir)
+    .filter((file) => file.endsWith('.js'))
+    .sort()
+    .map((file) => ({
+      name: basename(file, '.js'),
+      code: readFileSync(join(fixturesDir, file), 'utf8'),
+    }));
+}
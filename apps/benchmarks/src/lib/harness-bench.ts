@@ -0,0 +1,208 @@
+import { type ChildProcess, spawn } from 'node:child_process';
+import { readFileSync } from 'node:fs';
+
+import { encodeDv } from '@blue-quickjs/dv';
+import { HOST_V1_BYTES_HEX, HOST_V1_HASH } from '@blue-quickjs/test-harness';
+
+import type { BenchBackendInfo, BenchEntry } from './report.js';
+import { evalsPerSecond, nsPerGas, summarizeLatencies } from './stats.js';
+import type { BenchWorkload } from './workloads.js';
+
+export const NATIVE_HARNESS_BACKEND = 'native-harness';
+
+export interface HarnessBenchOptions {
+  binPath: string;
+  workloads: readonly BenchWorkload[];
+  iterations: number;
+  warmup: number;
+  now?: () => number;
+}
+
+export interface HarnessBenchResult {
+  info: BenchBackendInfo;
+  entries: BenchEntry[];
+}
+
+interface HarnessResponse {
+  status: number;
+  stdout: string;
+}
+
+const GAS_PATTERN = / GAS remaining=(\d+) used=(\d+)$/;
+
+/**
+ * Benchmarks `quickjs-native-harness` through one `--serve` process, so the
+ * numbers exclude process spawn. Eval requests get a fresh runtime each, so
+ * latencies are end to end (init, eval, DV encode and print) and no phase
+ * breakdown is reported.
+ */
+export async function runHarnessBench(
+  options: HarnessBenchOptions,
+): Promise<HarnessBenchResult> {
+  const now = options.now ?? (() => performance.now());
+  const harness = new HarnessServer(options.binPath);
+  try {
+    const entries: BenchEntry[] = [];
+    for (const workload of options.workloads) {
+      entries.push(await benchWorkload(harness, workload, options, now));
+    }
+    return {
+      info: { backend: NATIVE_HARNESS_BACKEND, runtimeInitMs: null },
+      entries,
+    };
+  } finally {
+    await harness.close();
+  }
+}
+
+async function benchWorkload(
+  harness: HarnessServer,
+  workload: BenchWorkload,
+  options: HarnessBenchOptions,
+  now: () => number,
+): Promise<BenchEntry> {
+  const args = [
+    '--abi-manifest-hex',
+    HOST_V1_BYTES_HEX,
+    '--abi-manifest-hash',
+    HOST_V1_HASH,
+    '--context-blob-hex',
+    Buffer.from(encodeDv(workload.input)).toString('hex'),
+    '--gas-limit',
+    workload.gasLimit.toString(),
+    '--report-gas',
+    '--eval',
+    workload.code,
+  ];
+
+  const latencies: number[] = [];
+  let gasUsed: bigint | null = null;
+  let error: string | undefined;
+
+  for (let i = 0; i < options.warmup + options.iterations; i++) {
+    const start = now();
+    const response = await harness.request(args);
+    const end = now();
+
+    const stdout = response.stdout.trim();
+    const gas = stdout.match(GAS_PATTERN);
+    if (!gas || response.status > 1) {
+      throw new Error(`${workload.name}: unexpected harness output: ${stdout}`);
+    }
+    const used = BigInt(gas[2]);
+    if (gasUsed !== null && used !== gasUsed) {
+      throw new Error(
+        `${workload.name}: gas ${used} differs from the first run (${gasUsed})`,
+      );
+    }
+    gasUsed = used;
+    if (stdout.startsWith('ERROR ')) {
+      error ??= stdout.slice('ERROR '.length, stdout.length - gas[0].length);
+    }
+
+    if (i >= options.warmup) {
+      latencies.push(end - start);
+    }
+  }
+
+  const latency = summarizeLatencies(latencies);
+  const used = gasUsed ?? 0n;
+  return {
+    backend: NATIVE_HARNESS_BACKEND,
+    workload: workload.name,
+    iterations: options.iterations,
+    status: error === undefined ? 'ok' : 'error',
+    ...(error === undefined ? {} : { error }),
+    gasUsed: used.toString(),
+    evalsPerSec: evalsPerSecond(latencies),
+    latency,
+    phases: null,
+    nsPerGas: nsPerGas(latency.p50Ms, used),
+    rssBytes: harness.rssBytes(),
+    heapBytes: null,
+  };
+}
+
+/**
+ * Minimal client for the harness `--serve` protocol: a u32 length and
+ * NUL-terminated argv tokens per request; exit code, output length and the
+ * one-shot output per response (all little-endian).
+ */
+class HarnessServer {
+  private readonly child: ChildProcess;
+  private readonly pending: {
+    resolve: (response: HarnessResponse) => void;
+    reject: (error: Error) => void;
+  }[] = [];
+  private buffered = Buffer.alloc(0);
+  private failure: Error | null = null;
+
+  constructor(binPath: string) {
+    this.child = spawn(binPath, ['--serve'], {
+      stdio: ['pipe', 'pipe', 'inherit'],
+    });
+    this.child.on('error', (error) => this.fail(error));
+    this.child.on('exit', (code, signal) =>
+      this.fail(
+        new Error(`harness --serve exited (code=${code}, signal=${signal})`),
+      ),
+    );
+    this.child.stdout?.on('data', (chunk: Buffer) => this.receive(chunk));
+  }
+
+  request(args: readonly string[]): Promise<HarnessResponse> {
+    if (this.failure) {
+      return Promise.reject(this.failure);
+    }
+    const body = Buffer.from(args.map((arg) => `${arg}\0`).join(''), 'utf8');
+    const header = Buffer.alloc(4);
+    header.writeUInt32LE(body.length, 0);
+    return new Promise((resolve, reject) => {
+      this.pending.push({ resolve, reject });
+      this.child.stdin?.write(Buffer.concat([header, body]));
+    });
+  }
+
+  /** Current resident set size of the harness process (Linux only). */
+  rssBytes(): number | null {
+    try {
+      const status = readFileSync(`/proc/${this.child.pid}/status`, 'utf8');
+      const match = status.match(/^VmRSS:\s+(\d+) kB$/m);
+      return match ? Number(match[1]) * 1024 : null;
+    } catch {
+      return null;
+    }
+  }
+
+  close(): Promise<void> {
+    return new Promise((resolve) => {
+      if (this.child.exitCode !== null || this.child.signalCode !== null) {
+        resolve();
+        return;
+      }
+      this.child.once('exit', () => resolve());
+      this.child.stdin?.end();
+    });
+  }
+
+  private receive(chunk: Buffer): void {
+    this.buffered = Buffer.concat([this.buffered, chunk]);
+    while (this.buffered.length >= 8) {
+      const length = this.buffered.readUInt32LE(4);
+      if (this.buffered.length < 8 + length) {
+        return;
+      }
+      const status = this.buffered.readUInt32LE(0);
+      const stdout = this.buffered.subarray(8, 8 + length).toString('utf8');
+      this.buffered = this.buffered.subarray(8 + length);
+      this.pending.shift()?.resolve({ status, stdout });
+    }
+  }
+
+  private fail(error: Error): void {
+    this.failure ??= error;
+    for (const request of this.pending.splice(0)) {
+      request.reject(this.failure);
+    }
+  }
+}
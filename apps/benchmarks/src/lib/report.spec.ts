@@ -0,0 +1,87 @@
+import {
+  type BenchEntry,
+  compareToBaseline,
+  createBaseline,
+  formatRegressions,
+} from './report.js';
+import { summarizeLatencies } from './stats.js';
+
+function entry(overrides: Partial<BenchEntry> = {}): BenchEntry {
+  return {
+    backend: 'node-wasm',
+    workload: 'corpus/addition',
+    iterations: 4,
+    status: 'ok',
+    gasUsed: '154',
+    evalsPerSec: 1000,
+    latency: summarizeLatencies([1, 1, 1, 1]),
+    phases: { initMs: 0.25, evalMs: 0.5, decodeMs: 0.25 },
+    nsPerGas: 3000,
+    rssBytes: null,
+    heapBytes: null,
+    ...overrides,
+  };
+}
+
+describe('baseline gate', () => {
+  const baseline = createBaseline([entry()], 0.25);
+
+  it('records gas, p50 and ns per gas per backend/workload', () => {
+    expect(baseline.entries).toEqual({
+      'node-wasm/corpus/addition': {
+        gasUsed: '154',
+        p50Ms: 1,
+        nsPerGas: 3000,
+      },
+    });
+  });
+
+  it('passes within the tolerance', () => {
+    const slower = entry({
+      latency: summarizeLatencies([1.2, 1.2, 1.2, 1.2]),
+      nsPerGas: 3700,
+    });
+    expect(compareToBaseline([slower], baseline)).toEqual([]);
+  });
+
+  it('flags gas changes and slowdowns beyond the tolerance', () => {
+    const changed = entry({
+      gasUsed: '160',
+      latency: summarizeLatencies([2, 2, 2, 2]),
+      nsPerGas: 4000,
+    });
+    expect(
+      compareToBaseline([changed], baseline).map((r) => r.metric),
+    ).toEqual(['gasUsed', 'p50Ms', 'nsPerGas']);
+    expect(formatRegressions(compareToBaseline([changed], baseline))[0]).toBe(
+      'node-wasm/corpus/addition: gasUsed 160 (baseline 154)',
+    );
+  });
+
+  it('gates only gas for gas-only entries', () => {
+    const gasOnly = createBaseline([entry()], 0.25, undefined, true);
+    expect(gasOnly.entries).toEqual({
+      'node-wasm/corpus/addition': { gasUsed: '154' },
+    });
+    const slower = entry({
+      latency: summarizeLatencies([9, 9, 9, 9]),
+      nsPerGas: 30000,
+    });
+    expect(compareToBaseline([slower], gasOnly)).toEqual([]);
+    expect(
+      compareToBaseline([entry({ gasUsed: '160' })], gasOnly).map(
+        (r) => r.metric,
+      ),
+    ).toEqual(['gasUsed']);
+  });
+
+  it('ignores entries without a baseline and merges new ones', () => {
+    const other = entry({ backend: 'native-harness' });
+    expect(compareToBaseline([other], baseline)).toEqual([]);
+    const merged = createBaseline([other], 0.25, baseline);
+    expect(Object.keys(merged.entries)).toEqual([
+      'native-harness/corpus/addition',
+      'node-wasm/corpus/addition',
+    ]);
+  });
+});
@@ -0,0 +1,225 @@
+import type { LatencySummary } from './stats.js';
+
+export const BENCH_REPORT_VERSION = 1;
+
+export const DEFAULT_BASELINE_TOLERANCE = 0.25;
+
+/** Median time per evaluation spent in each phase. */
+export interface PhaseBreakdown {
+  /** VM creation: context init, manifest and input envelope. */
+  initMs: number;
+  evalMs: number;
+  /** DV decode of the result on the embedder side. */
+  decodeMs: number;
+}
+
+export interface BenchEntry {
+  backend: string;
+  workload: string;
+  iterations: number;
+  status: 'ok' | 'error';
+  /** First VM error message, for workloads that end in an error. */
+  error?: string;
+  /** Gas per evaluation, as a decimal string. */
+  gasUsed: string;
+  evalsPerSec: number;
+  latency: LatencySummary;
+  /** `null` when the backend only exposes end-to-end timings. */
+  phases: PhaseBreakdown | null;
+  nsPerGas: number | null;
+  /** Resident set size after the workload, where the backend exposes it. */
+  rssBytes: number | null;
+  /** JS heap in use after the workload, where the backend exposes it. */
+  heapBytes: number | null;
+}
+
+export interface BenchBackendInfo {
+  backend: string;
+  /** One-off runtime creation (module load and instantiation). */
+  runtimeInitMs: number | null;
+  /** Why the backend did not run, when it was skipped. */
+  skipped?: string;
+}
+
+export interface BenchReport {
+  version: typeof BENCH_REPORT_VERSION;
+  createdAt: string;
+  environment: Record<string, string>;
+  backends: BenchBackendInfo[];
+  entries: BenchEntry[];
+}
+
+export interface BenchBaselineEntry {
+  gasUsed: string;
+  /**
+   * Timings are machine-specific, so gas-only entries (like the committed
+   * baseline) omit them and gate `gasUsed` alone.
+   */
+  p50Ms?: number;
+  nsPerGas?: number | null;
+}
+
+export interface BenchBaseline {
+  version: typeof BENCH_REPORT_VERSION;
+  /** Allowed relative slowdown (0.25 = 25%) before a timing regresses. */
+  tolerance: number;
+  entries: Record<string, BenchBaselineEntry>;
+}
+
+export interface BenchRegression {
+  key: string;
+  metric: 'gasUsed' | 'p50Ms' | 'nsPerGas';
+  baseline: string | number;
+  actual: string | number;
+}
+
+export function entryKey(
+  entry: Pick<BenchEntry, 'backend' | 'workload'>,
+): string {
+  return `${entry.backend}/${entry.workload}`;
+}
+
+export function createBaseline(
+  entries: readonly BenchEntry[],
+  tolerance = DEFAULT_BASELINE_TOLERANCE,
+  previous?: BenchBaseline,
+  gasOnly = false,
+): BenchBaseline {
+  const next: Record<string, BenchBaselineEntry> = {
+    ...(previous?.entries ?? {}),
+  };
+  for (const entry of entries) {
+    next[entryKey(entry)] = gasOnly
+      ? { gasUsed: entry.gasUsed }
+      : {
+          gasUsed: entry.gasUsed,
+          p50Ms: entry.latency.p50Ms,
+          nsPerGas: entry.nsPerGas,
+        };
+  }
+  const sorted = Object.fromEntries(
+    Object.entries(next).sort(([a], [b]) => (a < b ? -1 : a > b ? 1 : 0)),
+  );
+  return { version: BENCH_REPORT_VERSION, tolerance, entries: sorted };
+}
+
+/**
+ * Gas must match the baseline exactly (it is deterministic, so any change is
+ * an engine change); timings may exceed it by `tolerance`. Entries without a
+ * baseline are not gated, and timings are only gated where recorded.
+ */
+export function compareToBaseline(
+  entries: readonly BenchEntry[],
+  baseline: BenchBaseline,
+  tolerance = baseline.tolerance,
+): BenchRegression[] {
+  const regressions: BenchRegression[] = [];
+  const limit = (value: number) => value * (1 + tolerance);
+
+  for (const entry of entries) {
+    const key = entryKey(entry);
+    const expected = baseline.entries[key];
+    if (!expected) {
+      continue;
+    }
+    if (entry.gasUsed !== expected.gasUsed) {
+      regressions.push({
+        key,
+        metric: 'gasUsed',
+        baseline: expected.gasUsed,
+        actual: entry.gasUsed,
+      });
+    }
+    if (
+      expected.p50Ms !== undefined &&
+      entry.latency.p50Ms > limit(expected.p50Ms)
+    ) {
+      regressions.push({
+        key,
+        metric: 'p50Ms',
+        baseline: expected.p50Ms,
+        actual: entry.latency.p50Ms,
+      });
+    }
+    if (
+      entry.nsPerGas !== null &&
+      expected.nsPerGas != null &&
+      entry.nsPerGas > limit(expected.nsPerGas)
+    ) {
+      regressions.push({
+        key,
+        metric: 'nsPerGas',
+        baseline: expected.nsPerGas,
+        actual: entry.nsPerGas,
+      });
+    }
+  }
+
+  return regressions;
+}
+
+const MIB = 1024 * 1024;
+const REPORT_COLUMNS = [
+  'backend/workload',
+  'evals/s',
+  'p50',
+  'p99',
+  'init',
+  'eval',
+  'decode',
+  'ns/gas',
+  'gas',
+  'rss MiB',
+];
+const REPORT_WIDTHS = [44, 9, 10, 10, 10, 10, 10, 8, 10, 8];
+
+export function formatReport(report: BenchReport): string[] {
+  const lines: string[] = [];
+  for (const backend of report.backends) {
+    if (backend.skipped) {
+      lines.push(`${backend.backend}: skipped (${backend.skipped})`);
+    } else if (backend.runtimeInitMs !== null) {
+      lines.push(
+        `${backend.backend}: runtime init ${formatMs(backend.runtimeInitMs)}`,
+      );
+    }
+  }
+
+  const rows = report.entries.map((entry) => [
+    `${entryKey(entry)}${entry.status === 'error' ? ' (error)' : ''}`,
+    entry.evalsPerSec.toFixed(1),
+    formatMs(entry.latency.p50Ms),
+    formatMs(entry.latency.p99Ms),
+    formatMs(entry.phases?.initMs),
+    formatMs(entry.phases?.evalMs),
+    formatMs(entry.phases?.decodeMs),
+    entry.nsPerGas === null ? '-' : entry.nsPerGas.toFixed(2),
+    entry.gasUsed,
+    entry.rssBytes === null ? '-' : (entry.rssBytes / MIB).toFixed(1),
+  ]);
+  for (const row of [REPORT_COLUMNS, ...rows]) {
+    lines.push(
+      row
+        .map((cell, index) =>
+          index === 0
+            ? cell.padEnd(REPORT_WIDTHS[index])
+            : cell.padStart(REPORT_WIDTHS[index]),
+        )
+        .join(' '),
+    );
+  }
+  return lines;
+}
+
+export function formatRegressions(
+  regressions: readonly BenchRegression[],
+): string[] {
+  return regressions.map(
+    (regression) =>
+      `${regression.key}: ${regression.metric} ${regression.actual} (baseline ${regression.baseline})`,
+  );
+}
+
+function formatMs(value: number | undefined): string {
+  return value === undefined ? '-' : `${value.toFixed(3)}ms`;
+}
@@ -0,0 +1,185 @@
+import { decodeDv } from '@blue-quickjs/dv';
+import {
+  type DeterministicVmSnapshot,
+  type RuntimeArtifactSelection,
+  type RuntimeInstance,
+  createRuntime,
+  evaluate,
+  initializeDeterministicVm,
+  restoreDeterministicVm,
+} from '@blue-quickjs/quickjs-runtime';
+
+import type { BenchBackendInfo, BenchEntry } from './report.js';
+import {
+  evalsPerSecond,
+  median,
+  nsPerGas,
+  summarizeLatencies,
+} from './stats.js';
+import {
+  BENCH_MANIFEST,
+  BENCH_PROGRAM,
+  type BenchWorkload,
+  createBenchHost,
+} from './workloads.js';
+
+export interface MemorySample {
+  rssBytes: number | null;
+  heapBytes: number | null;
+}
+
+export interface RuntimeBenchOptions {
+  /** Report label, e.g. `node-wasm` or `browser-chromium`. */
+  backend: string;
+  selection: RuntimeArtifactSelection;
+  /**
+   * Restore a per-workload snapshot, with the input re-injected, instead of
+   * running VM init each iteration.
+   */
+  restore?: boolean;
+  workloads: readonly BenchWorkload[];
+  iterations: number;
+  warmup: number;
+  sampleMemory: () => MemorySample;
+  now?: () => number;
+}
+
+export interface RuntimeBenchResult {
+  info: BenchBackendInfo;
+  entries: BenchEntry[];
+}
+
+const UTF8_DECODER = new TextDecoder();
+
+/**
+ * Benchmarks `quickjs-runtime` on one artifact selection. Each workload is
+ * first run through `evaluate()` for reference gas; the timed iterations then
+ * replay the same steps on one warm runtime (VM init, `evalBinary`, DV
+ * decode, dispose) so every phase can be timed, and must bill the same gas.
+ * With `restore`, the init phase is a snapshot restore instead.
+ */
+export async function runRuntimeBench(
+  options: RuntimeBenchOptions,
+): Promise<RuntimeBenchResult> {
+  const now = options.now ?? (() => performance.now());
+  const handlers = createBenchHost();
+
+  const initStart = now();
+  const runtime = await createRuntime({
+    manifest: BENCH_MANIFEST,
+    handlers,
+    ...options.selection,
+  });
+  const runtimeInitMs = now() - initStart;
+
+  const entries: BenchEntry[] = [];
+  for (const workload of options.workloads) {
+    entries.push(await benchWorkload(runtime, workload, options, now));
+  }
+
+  return {
+    info: { backend: options.backend, runtimeInitMs },
+    entries,
+  };
+}
+
+async function benchWorkload(
+  runtime: RuntimeInstance,
+  workload: BenchWorkload,
+  options: RuntimeBenchOptions,
+  now: () => number,
+): Promise<BenchEntry> {
+  const program = { ...BENCH_PROGRAM, code: workload.code };
+  const reference = await evaluate({
+    program,
+    input: workload.input,
+    gasLimit: workload.gasLimit,
+    manifest: BENCH_MANIFEST,
+    handlers: createBenchHost(),
+    ...options.selection,
+  });
+
+  const latencies: number[] = [];
+  const initTimes: number[] = [];
+  const evalTimes: number[] = [];
+  const decodeTimes: number[] = [];
+  let error: string | undefined;
+
+  let snapshot: DeterministicVmSnapshot | undefined;
+  if (options.restore) {
+    const fresh = initializeDeterministicVm(
+      runtime,
+      program,
+      workload.input,
+      workload.gasLimit,
+    );
+    snapshot = fresh.snapshot();
+    fresh.dispose();
+  }
+
+  for (let i = 0; i < options.warmup + options.iterations; i++) {
+    const start = now();
+    const vm = snapshot
+      ? restoreDeterministicVm(
+          runtime,
+          snapshot,
+          workload.gasLimit,
+          workload.input,
+        )
+      : initializeDeterministicVm(
+          runtime,
+          program,
+          workload.input,
+          workload.gasLimit,
+        );
+    const initialized = now();
+    let evaluated = initialized;
+    let decoded = initialized;
+    try {
+      const output = vm.evalBinary(program.code);
+      evaluated = now();
+      if (output.kind === 'result') {
+        decodeDv(output.payload);
+      } else {
+        error ??= UTF8_DECODER.decode(output.payload).trim();
+      }
+      decoded = now();
+      if (output.gasUsed !== reference.gasUsed) {
+        throw new Error(
+          `${workload.name}: gas ${output.gasUsed} differs from evaluate() (${reference.gasUsed})`,
+        );
+      }
+    } finally {
+      vm.dispose();
+    }
+    const end = now();
+
+    if (i >= options.warmup) {
+      latencies.push(end - start);
+      initTimes.push(initialized - start);
+      evalTimes.push(evaluated - initialized);
+      decodeTimes.push(decoded - evaluated);
+    }
+  }
+
+  const evalMs = median(evalTimes);
+  const memory = options.sampleMemory();
+  return {
+    backend: options.backend,
+    workload: workload.name,
+    iterations: options.iterations,
+    status: error === undefined ? 'ok' : 'error',
+    ...(error === undefined ? {} : { error }),
+    gasUsed: reference.gasUsed.toString(),
+    evalsPerSec: evalsPerSecond(latencies),
+    latency: summarizeLatencies(latencies),
+    phases: {
+      initMs: median(initTimes),
+      evalMs,
+      decodeMs: median(decodeTimes),
+    },
+    nsPerGas: nsPerGas(evalMs, reference.gasUsed),
+    rssBytes: memory.rssBytes,
+    heapBytes: memory.heapBytes,
+  };
+}
@@ -0,0 +1,37 @@
+import {
+  evalsPerSecond,
+  median,
+  nsPerGas,
+  percentile,
+  summarizeLatencies,
+} from './stats.js';
+
+describe('stats', () => {
+  it('uses nearest-rank percentiles', () => {
+    const sorted = Array.from({ length: 100 }, (_, i) => i + 1);
+    expect(percentile(sorted, 50)).toBe(50);
+    expect(percentile(sorted, 99)).toBe(99);
+    expect(percentile(sorted, 100)).toBe(100);
+    expect(percentile([7], 99)).toBe(7);
+    expect(percentile([], 50)).toBe(0);
+    expect(median([3, 1, 2])).toBe(2);
+  });
+
+  it('summarizes latency samples', () => {
+    expect(summarizeLatencies([4, 1, 3, 2])).toEqual({
+      count: 4,
+      meanMs: 2.5,
+      minMs: 1,
+      p50Ms: 2,
+      p99Ms: 4,
+      maxMs: 4,
+    });
+  });
+
+  it('derives throughput and ns per gas', () => {
+    expect(evalsPerSecond([2, 2, 6])).toBe(300);
+    expect(evalsPerSecond([])).toBe(0);
+    expect(nsPerGas(0.5, 1000n)).toBe(500);
+    expect(nsPerGas(0.5, 0n)).toBeNull();
+  });
+});
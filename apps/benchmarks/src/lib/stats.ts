@@ -0,0 +1,53 @@
+export interface LatencySummary {
+  count: number;
+  meanMs: number;
+  minMs: number;
+  p50Ms: number;
+  p99Ms: number;
+  maxMs: number;
+}
+
+/**
+ * Nearest-rank percentile of an ascending sample list (`p` in 0..100).
+ */
+export function percentile(sorted: readonly number[], p: number): number {
+  if (sorted.length === 0) {
+    return 0;
+  }
+  const rank = Math.ceil((p / 100) * sorted.length);
+  return sorted[Math.min(sorted.length, Math.max(1, rank)) - 1];
+}
+
+export function median(samples: readonly number[]): number {
+  return percentile([...samples].sort((a, b) => a - b), 50);
+}
+
+export function summarizeLatencies(
+  samples: readonly number[],
+): LatencySummary {
+  const sorted = [...samples].sort((a, b) => a - b);
+  const total = sorted.reduce((sum, sample) => sum + sample, 0);
+  return {
+    count: sorted.length,
+    meanMs: sorted.length > 0 ? total / sorted.length : 0,
+    minMs: sorted[0] ?? 0,
+    p50Ms: percentile(sorted, 50),
+    p99Ms: percentile(sorted, 99),
+    maxMs: sorted[sorted.length - 1] ?? 0,
+  };
+}
+
+/**
+ * Evaluations per second over back-to-back samples.
+ */
+export function evalsPerSecond(samples: readonly number[]): number {
+  const totalMs = samples.reduce((sum, sample) => sum + sample, 0);
+  return totalMs > 0 ? (samples.length * 1000) / totalMs : 0;
+}
+
+/**
+ * Wall time per unit of gas, or `null` when the workload used none.
+ */
+export function nsPerGas(timeMs: number, gasUsed: bigint): number | null {
+  return gasUsed > 0n ? (timeMs * 1e6) / Number(gasUsed) : null;
+}
@@ -0,0 +1,142 @@
+import type { DV } from '@blue-quickjs/dv';
+import type { HostDispatcherHandlers } from '@blue-quickjs/quickjs-runtime';
+import {
+  DETERMINISM_INPUT,
+  HOST_V1_HASH,
+  HOST_V1_MANIFEST,
+} from '@blue-quickjs/test-harness';
+
+export interface BenchInput {
+  event: DV;
+  eventCanonical: DV;
+  steps: DV;
+}
+
+export interface BenchWorkload {
+  /** `corpus/<fixture>` for the shared gas corpus, `heavy/<name>` otherwise. */
+  name: string;
+  code: string;
+  input: BenchInput;
+  gasLimit: bigint;
+}
+
+/** One `tools/quickjs-native-harness/fixtures/gas/*.js` file. */
+export interface CorpusSource {
+  name: string;
+  code: string;
+}
+
+export const BENCH_GAS_LIMIT = 100_000_000n;
+
+export const BENCH_MANIFEST = HOST_V1_MANIFEST;
+
+export const BENCH_PROGRAM = {
+  abiId: 'Host.v1',
+  abiVersion: 1,
+  abiManifestHash: HOST_V1_HASH,
+} as const;
+
+const LARGE_RESULT_ITEMS = 2000;
+const HOST_CALLS = 500;
+const CONTEXT_STEPS = 4000;
+
+function createBigContextInput(): BenchInput {
+  const steps: DV[] = [];
+  for (let i = 0; i < CONTEXT_STEPS; i++) {
+    steps.push({
+      name: `step-${i}`,
+      status: i % 3 === 0 ? 'done' : 'pending',
+      index: i,
+    });
+  }
+  const event = { type: 'bulk', payload: { count: CONTEXT_STEPS } };
+  return { event, eventCanonical: event, steps };
+}
+
+/**
+ * Heavier programs than the gas corpus: a large DV result to encode and
+ * decode, a host-call-heavy loop, and a context blob of a few hundred KiB.
+ */
+export const HEAVY_WORKLOADS: readonly BenchWorkload[] = [
+  {
+    name: 'heavy/large-dv-result',
+    code: `
+      (() => {
+        const items = [];
+        for (let i = 0; i < ${LARGE_RESULT_ITEMS}; i++) {
+          items.push({ id: i, label: 'item-' + i, tags: ['a', 'b'] });
+        }
+        return { items };
+      })()
+    `.trim(),
+    input: DETERMINISM_INPUT,
+    gasLimit: BENCH_GAS_LIMIT,
+  },
+  {
+    name: 'heavy/host-call-heavy',
+    code: `
+      (() => {
+        let total = 0;
+        for (let i = 0; i < ${HOST_CALLS}; i++) {
+          total += Host.v1.document.get('doc/' + i).length;
+        }
+        Host.v1.emit({ total });
+        return total;
+      })()
+    `.trim(),
+    input: DETERMINISM_INPUT,
+    gasLimit: BENCH_GAS_LIMIT,
+  },
+  {
+    name: 'heavy/big-context',
+    code: `
+      (() => {
+        let done = 0;
+        for (const step of steps) {
+          if (step.status === 'done') done++;
+        }
+        return { done, count: event.payload.count };
+      })()
+    `.trim(),
+    input: createBigContextInput(),
+    gasLimit: BENCH_GAS_LIMIT,
+  },
+];
+
+export function createWorkloads(
+  corpus: readonly CorpusSource[],
+): BenchWorkload[] {
+  const fromCorpus = [...corpus]
+    .sort((a, b) => (a.name < b.name ? -1 : a.name > b.name ? 1 : 0))
+    .map((source) => ({
+      name: `corpus/${source.name}`,
+      code: source.code,
+      input: DETERMINISM_INPUT,
+      gasLimit: BENCH_GAS_LIMIT,
+    }));
+  return [...fromCorpus, ...HEAVY_WORKLOADS];
+}
+
+export function filterWorkloads(
+  workloads: readonly BenchWorkload[],
+  filter?: string,
+): BenchWorkload[] {
+  return filter
+    ? workloads.filter((workload) => workload.name.includes(filter))
+    : [...workloads];
+}
+
+/**
+ * Host handlers mirroring the native harness's manifest stub: `document.get`
+ * and `document.getCanonical` echo the path for one unit, `emit` is free. Gas
+ * is therefore comparable across every backend.
+ */
+export function createBenchHost(): HostDispatcherHandlers {
+  return {
+    document: {
+      get: (path: string) => ({ ok: path, units: 1 }),
+      getCanonical: (path: string) => ({ ok: path, units: 1 }),
+    },
+    emit: () => ({ ok: null, units: 0 }),
+  };
+}
@@ -0,0 +1,92 @@
+import { readFileSync } from 'node:fs';
+import { fileURLToPath } from 'node:url';
+import { parseArgs } from 'node:util';
+
+import {
+  DEFAULT_ITERATIONS,
+  DEFAULT_WARMUP,
+  NODE_BACKENDS,
+  type NodeBenchBackend,
+  checkBaseline,
+  runNodeBenchmarks,
+  updateBaseline,
+  writeJson,
+} from './lib/benchmarks.js';
+import {
+  type BenchReport,
+  formatRegressions,
+  formatReport,
+} from './lib/report.js';
+
+const { values } = parseArgs({
+  options: {
+    backends: { type: 'string' },
+    iterations: { type: 'string' },
+    warmup: { type: 'string' },
+    filter: { type: 'string' },
+    include: { type: 'string', multiple: true },
+    out: { type: 'string' },
+    baseline: { type: 'string' },
+    check: { type: 'boolean' },
+    'update-baseline': { type: 'boolean' },
+    'gas-only': { type: 'boolean' },
+    tolerance: { type: 'string' },
+    quiet: { type: 'boolean', short: 'q' },
+  },
+});
+
+const repoRoot = fileURLToPath(new URL('../../../', import.meta.url));
+const baselinePath =
+  values.baseline ??
+  fileURLToPath(new URL('../baseline.json', import.meta.url));
+const log = values.quiet
+  ? () => undefined
+  : (line: string) => console.log(line);
+
+const backends = values.backends?.split(',').map((name) => {
+  if (!(NODE_BACKENDS as readonly string[]).includes(name)) {
+    throw new Error(
+      `unknown backend ${name} (expected one of ${NODE_BACKENDS.join(', ')})`,
+    );
+  }
+  return name as NodeBenchBackend;
+});
+const tolerance =
+  values.tolerance === undefined ? undefined : Number(values.tolerance);
+
+const report = await runNodeBenchmarks({
+  repoRoot,
+  backends,
+  iterations: Number(values.iterations ?? DEFAULT_ITERATIONS),
+  warmup: Number(values.warmup ?? DEFAULT_WARMUP),
+  filter: values.filter,
+  log,
+});
+
+// Browser reports (see tests/bench.spec.ts) join the same table and gate.
+for (const path of values.include ?? []) {
+  const included = JSON.parse(readFileSync(path, 'utf8')) as BenchReport;
+  report.backends.push(...included.backends);
+  report.entries.push(...included.entries);
+}
+
+for (const line of formatReport(report)) {
+  log(line);
+}
+
+if (values.out) {
+  writeJson(values.out, report);
+}
+
+if (values['update-baseline']) {
+  updateBaseline(baselinePath, report, tolerance, values['gas-only']);
+  log(`baseline updated: ${baselinePath}`);
+} else if (values.check) {
+  const regressions = checkBaseline(baselinePath, report, tolerance);
+  for (const line of formatRegressions(regressions)) {
+    console.error(`regression: ${line}`);
+  }
+  if (regressions.length > 0) {
+    process.exitCode = 1;
+  }
+}
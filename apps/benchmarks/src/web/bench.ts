@@ -0,0 +1,108 @@
+import {
+  loadQuickjsWasmBinary,
+  loadQuickjsWasmMetadata,
+} from '@blue-quickjs/quickjs-wasm';
+
+import {
+  BENCH_REPORT_VERSION,
+  type BenchReport,
+  formatReport,
+} from '../lib/report.js';
+import { type MemorySample, runRuntimeBench } from '../lib/runtime-bench.js';
+import {
+  type CorpusSource,
+  createWorkloads,
+  filterWorkloads,
+} from '../lib/workloads.js';
+
+type RunState = 'idle' | 'running' | 'done' | 'error';
+
+declare global {
+  interface Window {
+    __BENCH_REPORT__?: BenchReport;
+    __BENCH_ERROR__?: string;
+  }
+}
+
+interface ChromiumPerformance extends Performance {
+  memory?: { usedJSHeapSize: number };
+}
+
+const CORPUS_MODULES = import.meta.glob<string>(
+  '../../../../tools/quickjs-native-harness/fixtures/gas/*.js',
+  { query: '?raw', import: 'default', eager: true },
+);
+
+function readCorpus(): CorpusSource[] {
+  return Object.entries(CORPUS_MODULES).map(([path, code]) => ({
+    name: path.slice(path.lastIndexOf('/') + 1, -'.js'.length),
+    code,
+  }));
+}
+
+function sampleMemory(): MemorySample {
+  // Only Chromium exposes heap usage; no browser exposes RSS to the page.
+  const memory = (performance as ChromiumPerformance).memory;
+  return { rssBytes: null, heapBytes: memory?.usedJSHeapSize ?? null };
+}
+
+/**
+ * Runs the `runtime-bench` suite on the wasm build in this browser tab.
+ * Options come from the query string (`backend`, `iterations`, `warmup`,
+ * `filter`); the report lands on `window.__BENCH_REPORT__`.
+ */
+async function run(): Promise<void> {
+  const status = document.querySelector<HTMLElement>('[data-runstate]');
+  const output = document.querySelector<HTMLElement>('[data-results]');
+  const setState = (state: RunState, label: string) => {
+    status?.setAttribute('data-runstate', state);
+    if (status) {
+      status.textContent = label;
+    }
+  };
+
+  const params = new URLSearchParams(window.location.search);
+  const backend = params.get('backend') ?? 'browser';
+  setState('running', `Running ${backend}`);
+
+  try {
+    const [metadata, wasmBinary] = await Promise.all([
+      loadQuickjsWasmMetadata(),
+      loadQuickjsWasmBinary(),
+    ]);
+    const workloads = filterWorkloads(
+      createWorkloads(readCorpus()),
+      params.get('filter') ?? undefined,
+    );
+    const result = await runRuntimeBench({
+      backend,
+      selection: { metadata, wasmBinary },
+      workloads,
+      iterations: Number(params.get('iterations') ?? 20),
+      warmup: Number(params.get('warmup') ?? 3),
+      sampleMemory,
+    });
+
+    const report: BenchReport = {
+      version: BENCH_REPORT_VERSION,
+      createdAt: new Date().toISOString(),
+      environment: { userAgent: navigator.userAgent },
+      backends: [result.info],
+      entries: result.entries,
+    };
+    window.__BENCH_REPORT__ = report;
+    if (output) {
+      output.textContent = formatReport(report).join('\n');
+    }
+    setState('done', 'Done');
+  } catch (error) {
+    const message = error instanceof Error ? error.message : String(error);
+    window.__BENCH_ERROR__ = message;
+    if (output) {
+      output.textContent = message;
+    }
+    setState('error', message);
+  }
+}
+
+void run();
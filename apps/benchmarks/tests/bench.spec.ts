@@ -0,0 +1,67 @@
+import { mkdirSync, readFileSync, writeFileSync } from 'node:fs';
+import path from 'node:path';
+
+import { type Page, expect, test } from '@playwright/test';
+
+import {
+  type BenchBaseline,
+  type BenchReport,
+  compareToBaseline,
+  formatRegressions,
+  formatReport,
+} from '../src/lib/report.js';
+
+const projectRoot = path.resolve(__dirname, '..');
+const iterations = process.env.BENCH_ITERATIONS ?? '20';
+const warmup = process.env.BENCH_WARMUP ?? '3';
+const filter = process.env.BENCH_FILTER;
+
+test('browser benchmark', async ({ page, browserName }) => {
+  test.setTimeout(600000);
+  const backend = `browser-${browserName}`;
+  const query = new URLSearchParams({ backend, iterations, warmup });
+  if (filter) {
+    query.set('filter', filter);
+  }
+
+  await page.goto(`/bench.html?${query}`);
+  await page.waitForSelector(
+    '[data-runstate="done"], [data-runstate="error"]',
+    { timeout: 600000 },
+  );
+  const error = await readWindow<string>(page, '__BENCH_ERROR__');
+  expect(error).toBeNull();
+
+  const report = await readWindow<BenchReport>(page, '__BENCH_REPORT__');
+  expect(report, 'browser benchmark report is missing').toBeTruthy();
+  if (!report) {
+    return;
+  }
+
+  const outDir = process.env.BENCH_OUT_DIR;
+  if (outDir) {
+    mkdirSync(outDir, { recursive: true });
+    writeFileSync(
+      path.join(outDir, `${backend}.json`),
+      `${JSON.stringify(report, null, 2)}\n`,
+    );
+  }
+  console.log(formatReport(report).join('\n'));
+
+  if (process.env.BENCH_CHECK === '1') {
+    const baseline = JSON.parse(
+      readFileSync(path.join(projectRoot, 'baseline.json'), 'utf8'),
+    ) as BenchBaseline;
+    const regressions = compareToBaseline(report.entries, baseline);
+    expect(formatRegressions(regressions)).toEqual([]);
+  }
+});
+
+async function readWindow<T>(page: Page, key: string): Promise<T | null> {
+  return page.evaluate(
+    (windowKey) =>
+      ((window as unknown as Record<string, unknown>)[windowKey] ??
+        null) as T | null,
+    key,
+  );
+}
@@ -0,0 +1,27 @@
+/// <reference types='vitest' />
+import path from 'node:path';
+import { defineConfig } from 'vite';
+
+export default defineConfig(() => ({
+  root: import.meta.dirname,
+  cacheDir: '../../node_modules/.vite/apps/benchmarks',
+  server: {
+    fs: {
+      // The browser page reads the gas corpus and the built wasm artifacts.
+      allow: [path.resolve(import.meta.dirname, '..', '..')],
+    },
+  },
+  plugins: [],
+  test: {
+    name: 'benchmarks',
+    watch: false,
+    globals: true,
+    environment: 'node',
+    include: ['src/**/*.{test,spec}.{js,mjs,cjs,ts,mts,cts,jsx,tsx}'],
+    reporters: ['default'],
+    coverage: {
+      reportsDirectory: './test-output/vitest/coverage',
+      provider: 'v8' as const,
+    },
+  },
+}));
@@ -1,4 +1,7 @@
 import { createHash } from 'crypto';
+import { existsSync } from 'fs';
+import { setFlagsFromString } from 'v8';
+import { runInNewContext } from 'vm';
 
 import { encodeDv } from '@blue-quickjs/dv';
 import {
@@ -8,9 +11,11 @@ import {
 } from '@blue-quickjs/test-harness';
 import {
   type EvaluateResult,
+  createRuntimePool,
   evaluate,
   type HostTapeRecord,
 } from '@blue-quickjs/quickjs-runtime';
+import { getQuickjsNativeAddonPath } from '@blue-quickjs/quickjs-native';
 
 interface FixtureSnapshot {
   resultHash: string | null;
@@ -42,8 +47,95 @@ describe('smoke-node determinism fixtures', () => {
       expect(actual).toEqual(expected);
     }
   });
+
+  // Allocation gas follows 64-bit struct sizes natively, so gasUsed cannot
+  // match the wasm32 goldens. It is compared where it must agree: host-call
+  // gas and tapes match wasm32, the budget balances, and native runs repeat.
+  it.skipIf(!existsSync(getQuickjsNativeAddonPath()))(
+    'matches expected results and host-call gas on the native backend',
+    async () => {
+      for (const fixture of DETERMINISM_FIXTURES) {
+        const run = (backend: 'wasm' | 'native', hostGas = false) =>
+          evaluate({
+            program: fixture.program,
+            input: fixture.input,
+            gasLimit: fixture.gasLimit,
+            manifest: fixture.manifest,
+            handlers: fixture.createHost().handlers,
+            backend,
+            allowNonConsensus: backend === 'native',
+            ...(hostGas
+              ? { hostGas: true }
+              : { tape: { capacity: TAPE_CAPACITY } }),
+          });
+
+        const result = await run('native');
+        const actual = await summarizeFixture(result);
+        const expected = normalizeExpected(fixture.expected);
+        expect({
+          resultHash: actual.resultHash,
+          errorCode: actual.errorCode,
+          errorTag: actual.errorTag,
+          tapeHash: actual.tapeHash,
+          tapeLength: actual.tapeLength,
+        }).toEqual({
+          resultHash: expected.resultHash,
+          errorCode: expected.errorCode,
+          errorTag: expected.errorTag,
+          tapeHash: expected.tapeHash,
+          tapeLength: expected.tapeLength,
+        });
+        expect(result.gasUsed + result.gasRemaining).toBe(
+          BigInt(fixture.gasLimit),
+        );
+
+        const repeat = await run('native', true);
+        expect(repeat.gasUsed).toBe(result.gasUsed);
+        expect(repeat.hostGas).toEqual((await run('wasm', true)).hostGas);
+      }
+    },
+  );
+
+  it.skipIf(!existsSync(getQuickjsNativeAddonPath()))(
+    'keeps native host imports alive across garbage collection',
+    async () => {
+      const fixture = DETERMINISM_FIXTURES[0];
+      const pool = createRuntimePool({
+        backend: 'native',
+        allowNonConsensus: true,
+        max: 1,
+      });
+      const options = {
+        program: fixture.program,
+        input: fixture.input,
+        gasLimit: fixture.gasLimit,
+        manifest: fixture.manifest,
+        pool,
+        tape: { capacity: TAPE_CAPACITY },
+      };
+      try {
+        await evaluate({ ...options, handlers: fixture.createHost().handlers });
+        // The addon holds the imports weakly; only the runtime keeps them.
+        collectGarbage();
+        const result = await evaluate({
+          ...options,
+          handlers: fixture.createHost().handlers,
+        });
+        const actual = await summarizeFixture(result);
+        expect(actual.resultHash).toBe(fixture.expected.resultHash);
+        expect(actual.tapeLength).toBe(fixture.expected.tapeLength);
+      } finally {
+        pool.close();
+      }
+    },
+  );
 });
 
+function collectGarbage(): void {
+  setFlagsFromString('--expose-gc');
+  (runInNewContext('gc') as () => void)();
+}
+
 function normalizeExpected(
   expected: DeterminismFixtureBaseline,
 ): FixtureSnapshot {
@@ -204,6 +204,34 @@ describe('abi-manifest', () => {
     expect(() => validateAbiManifest(manifest)).toThrow(AbiManifestError);
   });
 
+  it('accepts pure on READ functions without changing bytes or hash', () => {
+    const [documentGet, , emit] = HOST_V1_MANIFEST.functions;
+    const plain = hashAbiManifest({
+      ...HOST_V1_MANIFEST,
+      functions: [documentGet],
+    });
+    const pure = hashAbiManifest({
+      ...HOST_V1_MANIFEST,
+      functions: [{ ...documentGet, pure: true }],
+    });
+    expect(pure.manifest.functions[0].pure).toBe(true);
+    expect(hex(pure.bytes)).toBe(hex(plain.bytes));
+    expect(pure.hash).toBe(plain.hash);
+
+    const notPure = validateAbiManifest({
+      ...HOST_V1_MANIFEST,
+      functions: [{ ...documentGet, pure: false }],
+    });
+    expect(notPure.functions[0]).not.toHaveProperty('pure');
+
+    expect(() =>
+      validateAbiManifest({
+        ...HOST_V1_MANIFEST,
+        functions: [{ ...emit, pure: true }],
+      }),
+    ).toThrow(/only READ functions may be pure/);
+  });
+
   it('rejects -0 in uint32 fields', () => {
     const manifest: AbiManifest = {
       ...HOST_V1_MANIFEST,
@@ -56,6 +56,13 @@ export interface AbiFunction {
   gas: AbiGasParameters;
   limits: AbiLimits;
   error_codes: AbiErrorCode[];
+  /**
+   * READ functions whose response depends only on the request bytes. The wasm
+   * shim may replay an earlier response to an identical request within one
+   * evaluation instead of calling the host again; gas is charged as usual.
+   * Embedder-side only: not part of the encoded manifest bytes or hash.
+   */
+  pure?: boolean;
 }
 
 export interface AbiManifest {
@@ -108,12 +115,12 @@ export function validateAbiManifest(
 
 export function encodeAbiManifest(manifest: AbiManifest): Uint8Array {
   const canonical = validateAbiManifest(manifest);
-  return encodeDv(canonical);
+  return encodeDv(toEncodedManifest(canonical));
 }
 
 export function hashAbiManifest(manifest: AbiManifest): AbiManifestBytes {
   const canonical = validateAbiManifest(manifest);
-  const bytes = encodeDv(canonical);
+  const bytes = encodeDv(toEncodedManifest(canonical));
   return {
     bytes,
     hash: hashAbiManifestBytes(bytes),
@@ -133,6 +140,20 @@ export function hashAbiManifestBytes(
   return bytesToHex(sha256(view));
 }
 
+/**
+ * The manifest as the VM sees it, without embedder-side annotations.
+ */
+function toEncodedManifest(manifest: CanonicalAbiManifest): AbiManifest {
+  return {
+    ...manifest,
+    functions: manifest.functions.map((fn) => {
+      const encoded = { ...fn };
+      delete encoded.pure;
+      return encoded;
+    }),
+  };
+}
+
 function validateManifestRoot(manifest: AbiManifest): CanonicalAbiManifest {
   const value = expectPlainObject(manifest, 'manifest');
   enforceExactKeys(value, ['abi_id', 'abi_version', 'functions'], 'manifest');
@@ -166,8 +187,10 @@ function validateFunction(value: unknown, path: string): CanonicalAbiFunction {
       'gas',
       'limits',
       'error_codes',
+      'pure',
     ],
     path,
+    ['pure'],
   );
 
   const fnId = expectUint32(fn.fn_id, `${path}.fn_id`, { min: 1 });
@@ -190,6 +213,7 @@ function validateFunction(value: unknown, path: string): CanonicalAbiFunction {
     `${path}.error_codes`,
   );
   ensureGasMaxChargeWithinBounds(gas, limits, `${path}.gas`);
+  const pure = validatePure(fn.pure, effect, `${path}.pure`);
 
   return {
     fn_id: fnId,
@@ -201,6 +225,7 @@ function validateFunction(value: unknown, path: string): CanonicalAbiFunction {
     gas,
     limits,
     error_codes: errorCodes,
+    ...(pure ? { pure: true } : {}),
   };
 }
 
@@ -242,6 +267,23 @@ function validateEffect(value: unknown, path: string): AbiEffect {
   return value;
 }
 
+function validatePure(
+  value: unknown,
+  effect: AbiEffect,
+  path: string,
+): boolean {
+  if (value === undefined) {
+    return false;
+  }
+  if (typeof value !== 'boolean') {
+    throw error('INVALID_TYPE', 'pure must be a boolean', path);
+  }
+  if (value && effect !== 'READ') {
+    throw error('INVALID_VALUE', 'only READ functions may be pure', path);
+  }
+  return value;
+}
+
 function validateArgSchemas(
   schemas: unknown[],
   arity: number,
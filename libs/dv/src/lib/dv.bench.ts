@@ -0,0 +1,149 @@
+import { bench, describe, expect } from 'vitest';
+
+import { DV, DvEncoder, encodeDv } from './dv.js';
+
+/**
+ * Compact copy of the previous `number[]`-backed encoder (limit checks
+ * dropped), kept only as the baseline for these benchmarks.
+ */
+function encodeLegacy(value: DV): Uint8Array {
+  const out: number[] = [];
+  const textEncoder = new TextEncoder();
+
+  const pushUint = (length: number, width: 1 | 2 | 4 | 8): void => {
+    const view = new DataView(new ArrayBuffer(width));
+    if (width === 1) {
+      view.setUint8(0, length);
+    } else if (width === 2) {
+      view.setUint16(0, length, false);
+    } else if (width === 4) {
+      view.setUint32(0, length, false);
+    } else {
+      view.setBigUint64(0, BigInt(length), false);
+    }
+    for (const b of new Uint8Array(view.buffer)) {
+      out.push(b);
+    }
+  };
+
+  const header = (major: number, length: number): void => {
+    if (length <= 23) {
+      out.push((major << 5) | length);
+    } else if (length <= 0xff) {
+      out.push((major << 5) | 24);
+      pushUint(length, 1);
+    } else if (length <= 0xffff) {
+      out.push((major << 5) | 25);
+      pushUint(length, 2);
+    } else if (length <= 0xffffffff) {
+      out.push((major << 5) | 26);
+      pushUint(length, 4);
+    } else {
+      out.push((major << 5) | 27);
+      pushUint(length, 8);
+    }
+  };
+
+  const text = (bytes: Uint8Array): void => {
+    header(3, bytes.length);
+    for (const b of bytes) {
+      out.push(b);
+    }
+  };
+
+  const visit = (node: DV): void => {
+    if (node === null) {
+      out.push(0xf6);
+    } else if (typeof node === 'boolean') {
+      out.push(node ? 0xf5 : 0xf4);
+    } else if (typeof node === 'number') {
+      const n = Object.is(node, -0) ? 0 : node;
+      if (Number.isInteger(n)) {
+        header(n >= 0 ? 0 : 1, n >= 0 ? n : -1 - n);
+      } else {
+        out.push(0xfb);
+        const view = new DataView(new ArrayBuffer(8));
+        view.setFloat64(0, n, false);
+        for (const b of new Uint8Array(view.buffer)) {
+          out.push(b);
+        }
+      }
+    } else if (typeof node === 'string') {
+      text(textEncoder.encode(node));
+    } else if (Array.isArray(node)) {
+      header(4, node.length);
+      node.forEach(visit);
+    } else {
+      const keys = Object.keys(node)
+        .map((key) => ({ key, bytes: textEncoder.encode(key) }))
+        .sort((a, b) => {
+          if (a.bytes.length !== b.bytes.length) {
+            return a.bytes.length - b.bytes.length;
+          }
+          for (let i = 0; i < a.bytes.length; i += 1) {
+            if (a.bytes[i] !== b.bytes[i]) {
+              return a.bytes[i] - b.bytes[i];
+            }
+          }
+          return 0;
+        });
+      header(5, keys.length);
+      for (const { key, bytes } of keys) {
+        text(bytes);
+        visit(node[key]);
+      }
+    }
+  };
+
+  visit(value);
+  return Uint8Array.from(out);
+}
+
+// Roughly 800 KiB encoded: close to the default maxEncodedBytes.
+function createContextBlob(): DV {
+  const entries: DV[] = [];
+  for (let i = 0; i < 6_000; i += 1) {
+    entries.push({
+      id: i,
+      path: `documents/${i}/body`,
+      score: i / 7,
+      tags: ['alpha', 'beta', 'gamma'],
+      note: 'lorem ipsum dolor sit amet '.repeat(2),
+    });
+  }
+  return { documents: entries, owner: 'bench', version: 1 };
+}
+
+const HOST_CALL: DV = ['path/to/doc', { canonical: true, depth: 2 }];
+const CONTEXT_BLOB = createContextBlob();
+const encoder = new DvEncoder();
+const target = new Uint8Array(2 * 1024 * 1024);
+
+for (const value of [HOST_CALL, CONTEXT_BLOB]) {
+  expect(encodeLegacy(value)).toEqual(encodeDv(value));
+  expect(encoder.encode(value)).toEqual(encodeDv(value));
+}
+
+describe('host-call envelope', () => {
+  bench('legacy number[] builder', () => {
+    encodeLegacy(HOST_CALL);
+  });
+  bench('encodeDv', () => {
+    encodeDv(HOST_CALL);
+  });
+  bench('DvEncoder.encodeInto', () => {
+    encoder.encodeInto(HOST_CALL, target);
+  });
+});
+
+describe('large context blob', () => {
+  bench('legacy number[] builder', () => {
+    encodeLegacy(CONTEXT_BLOB);
+  });
+  bench('encodeDv', () => {
+    encodeDv(CONTEXT_BLOB);
+  });
+  bench('DvEncoder.encodeInto', () => {
+    encoder.encodeInto(CONTEXT_BLOB, target);
+  });
+});
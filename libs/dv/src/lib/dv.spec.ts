@@ -4,8 +4,10 @@ import { describe, expect, it } from 'vitest';
 import {
   DV,
   DV_LIMIT_DEFAULTS,
+  DvEncoder,
   DvError,
   DvErrorCode,
+  DvView,
   decodeDv,
   encodeDv,
   isDv,
@@ -179,3 +181,173 @@ describe('encodeDv / decodeDv', () => {
     );
   });
 });
+
+describe('DvEncoder', () => {
+  const sample: DV = {
+    name: 'blue',
+    nested: { list: [1, -2, 1.5, 'é😀', null, true], big: 2 ** 40 },
+    text: 'x'.repeat(300),
+  };
+
+  it('produces the same bytes as encodeDv across reused calls', () => {
+    const encoder = new DvEncoder({ initialCapacity: 16 });
+    const values: DV[] = [sample, 'short', [sample, sample], { b: 2, aa: 1 }];
+    for (const value of values) {
+      expect(hex(encoder.encode(value))).toBe(hex(encodeDv(value)));
+      expect(hex(encoder.encodeView(value))).toBe(hex(encodeDv(value)));
+    }
+  });
+
+  it('encodes into a caller buffer and rejects targets that are too small', () => {
+    const encoder = new DvEncoder();
+    const expected = encodeDv(sample);
+
+    const exact = new Uint8Array(expected.length + 4);
+    const written = encoder.encodeInto(sample, exact.subarray(4));
+    expect(written).toBe(expected.length);
+    expect(hex(exact.subarray(4))).toBe(hex(expected));
+
+    expect(() =>
+      encoder.encodeInto(sample, new Uint8Array(expected.length - 1)),
+    ).toThrow(RangeError);
+    expect(hex(encoder.encode(sample))).toBe(hex(expected));
+  });
+
+  it('keeps DV limit errors distinct from target overflow', () => {
+    const encoder = new DvEncoder({ limits: { maxEncodedBytes: 8 } });
+    expectCode(
+      () => encoder.encodeInto('a'.repeat(16), new Uint8Array(64)),
+      'ENCODED_TOO_LARGE',
+    );
+    expectCode(() => encoder.encode(NaN), 'NAN_OR_INF');
+  });
+});
+
+describe('map key caching', () => {
+  it('encodes repeated and reordered shapes identically', () => {
+    const records = Array.from({ length: 3 }, (_, i) => ({
+      zeta: i,
+      id: `r${i}`,
+      tags: { b: true, a: false },
+    }));
+    const reordered = { tags: { a: false, b: true }, id: 'r0', zeta: 0 };
+
+    const first = hex(encodeDv(records));
+    expect(hex(encodeDv(records))).toBe(first);
+    expect(hex(encodeDv(reordered))).toBe(hex(encodeDv(records[0])));
+    expect(decodeDv(encodeDv(records))).toEqual(records);
+  });
+
+  it('still enforces per-call key limits on cached shapes', () => {
+    const value = { short: 1, longer_key: 2 };
+    encodeDv(value);
+    expectCode(
+      () => encodeDv(value, { limits: { maxStringBytes: 5 } }),
+      'STRING_TOO_LONG',
+    );
+    expect(hex(encodeDv(value))).toBe(
+      hex(encodeDv({ longer_key: 2, short: 1 })),
+    );
+    expectCode(() => encodeDv({ short: 1, 'a\uD800': 2 }), 'INVALID_STRING');
+  });
+});
+
+describe('DvView', () => {
+  const value: DV = {
+    items: [{ id: 1, tags: ['a', 'b'] }, { id: 2 }, 'tail'],
+    meta: { score: 1.5, ok: true, none: null, name: 'é😀' },
+    big: 2 ** 40,
+  };
+
+  it('navigates maps and arrays without decoding the whole value', () => {
+    const bytes = encodeDv(value);
+    const view = DvView.from(bytes);
+
+    expect(view.kind).toBe('map');
+    expect(view.length).toBe(3);
+    expect(view.keys()).toEqual(['big', 'meta', 'items']);
+    expect(view.get('missing')).toBeUndefined();
+    expect(view.get('big')?.toValue()).toBe(2 ** 40);
+    expect(view.path('items', 0, 'tags', 1)?.toValue()).toBe('b');
+    expect(view.path('items', 3)).toBeUndefined();
+    expect(view.path('items', 2, 'x')).toBeUndefined();
+    expect(view.path('meta', 'name')?.kind).toBe('string');
+    expect(view.path('meta', 'none')?.kind).toBe('null');
+    expect(view.path('meta', 'score')?.kind).toBe('number');
+
+    const items = view.get('items');
+    expect(items?.length).toBe(3);
+    expect(items?.at(1)?.toValue()).toEqual({ id: 2 });
+    expect(hex(items?.bytes() ?? new Uint8Array())).toBe(
+      hex(encodeDv((value as { items: DV }).items)),
+    );
+    expect(
+      Array.from(view.get('meta')?.entries() ?? [], ([key]) => key),
+    ).toEqual(['ok', 'name', 'none', 'score']);
+    expect(view.toValue()).toEqual(decodeDv(bytes));
+  });
+
+  it('rejects the same malformed inputs as decodeDv', () => {
+    const malformed = [
+      [0x61],
+      [0x62, 0xc3, 0x28],
+      [0x63, 0xef, 0xbb, 0xbf],
+      [0x18, 0x01],
+      [0xfa, 0x3f, 0x80, 0x00, 0x00],
+      [0x40],
+      [0xf6, 0xf6],
+      [0x81, 0x81, 0x80],
+      [0xa2, 0x62, 0x61, 0x61, 0x01, 0x61, 0x62, 0x02],
+      [0xa2, 0x61, 0x61, 0x01, 0x61, 0x61, 0x02],
+      [0xa1, 0x01, 0x02],
+    ].map((bytes) => Uint8Array.from(bytes));
+    const limits = { maxDepth: 1 };
+
+    for (const bytes of malformed) {
+      let expected: DvErrorCode | undefined;
+      try {
+        decodeDv(bytes, { limits });
+      } catch (err) {
+        expected = (err as DvError).code;
+      }
+      expect(expected).toBeDefined();
+      expectCode(() => DvView.from(bytes, { limits }), expected as DvErrorCode);
+    }
+  });
+
+  it('matches decodeDv under property-based generation', () => {
+    const keyArb = fc.string({ maxLength: 8 });
+    const leaf = fc.oneof(
+      fc.constant(null),
+      fc.boolean(),
+      fc.integer(),
+      fc.double({ min: -1e6, max: 1e6, noNaN: true }),
+      fc.string({ maxLength: 16 }),
+    );
+    const { tree } = fc.letrec<{ tree: DV }>((tie) => ({
+      tree: fc.oneof(
+        { depthSize: 'small' },
+        leaf,
+        fc.array(tie('tree'), { maxLength: 4 }),
+        fc.dictionary(keyArb, tie('tree'), { maxKeys: 4 }),
+      ),
+    }));
+
+    fc.assert(
+      fc.property(tree, (input) => {
+        const bytes = encodeDv(input);
+        const view = DvView.from(bytes);
+        const decoded = decodeDv(bytes);
+        expect(view.toValue()).toEqual(decoded);
+        if (view.kind === 'map') {
+          for (const key of view.keys()) {
+            expect(view.get(key)?.toValue()).toEqual(
+              (decoded as Record<string, DV>)[key],
+            );
+          }
+        }
+      }),
+      { numRuns: 150 },
+    );
+  });
+});
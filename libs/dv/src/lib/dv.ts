@@ -33,6 +33,7 @@ export const DV_LIMIT_DEFAULTS: Readonly<DvLimits> = {
 };
 
 type PartialLimits = Partial<DvLimits>;
+type DvInput = ArrayBufferView | ArrayBuffer | Uint8Array;
 
 export interface DvEncodeOptions {
   limits?: PartialLimits;
@@ -71,14 +72,66 @@ export class DvError extends Error {
   }
 }
 
+export interface DvEncoderOptions extends DvEncodeOptions {
+  /**
+   * Initial size of the internal buffer in bytes (default 256). It doubles as
+   * needed and is kept across calls.
+   */
+  initialCapacity?: number;
+}
+
+/**
+ * Reusable DV encoder. Output is written into one growable `Uint8Array`
+ * through a persistent `DataView`, so repeated encodes allocate nothing but
+ * their results. Produces exactly the bytes of `encodeDv`.
+ */
+export class DvEncoder {
+  private readonly limits: DvLimits;
+  private readonly sink: ByteSink;
+
+  constructor(options?: DvEncoderOptions) {
+    this.limits = normalizeLimits(options?.limits);
+    this.sink = new ByteSink(options?.initialCapacity ?? INITIAL_CAPACITY);
+  }
+
+  /**
+   * Encode into a fresh `Uint8Array` owned by the caller.
+   */
+  encode(value: unknown): Uint8Array {
+    return this.encodeView(value).slice();
+  }
+
+  /**
+   * Encode and return a view into the encoder's buffer. The view is only valid
+   * until the next call on this encoder.
+   */
+  encodeView(value: unknown): Uint8Array {
+    this.sink.begin(this.limits.maxEncodedBytes);
+    encodeValue(value, this.sink, this.limits, 0);
+    return this.sink.view();
+  }
+
+  /**
+   * Encode straight into `target` and return the number of bytes written.
+   * Throws a `RangeError` when the encoding does not fit; `target` may then
+   * hold a partial encoding. DV limit violations still throw `DvError`.
+   */
+  encodeInto(value: unknown, target: Uint8Array): number {
+    this.sink.begin(this.limits.maxEncodedBytes, target);
+    try {
+      encodeValue(value, this.sink, this.limits, 0);
+      return this.sink.length;
+    } finally {
+      this.sink.release();
+    }
+  }
+}
+
 export function encodeDv(
   value: unknown,
   options?: DvEncodeOptions,
 ): Uint8Array {
-  const limits = normalizeLimits(options?.limits);
-  const builder = new ByteBuilder(limits.maxEncodedBytes);
-  encodeValue(value, builder, limits, 0);
-  return builder.toUint8Array();
+  return withSharedSink(value, options, (sink) => sink.view().slice());
 }
 
 export function decodeDv(
@@ -86,19 +139,7 @@ export function decodeDv(
   options?: DvDecodeOptions,
 ): DV {
   const limits = normalizeLimits(options?.limits);
-  const bytes =
-    input instanceof Uint8Array
-      ? input
-      : input instanceof ArrayBuffer
-        ? new Uint8Array(input)
-        : new Uint8Array(input.buffer, input.byteOffset, input.byteLength);
-
-  if (bytes.length > limits.maxEncodedBytes) {
-    throw dvError(
-      'ENCODED_TOO_LARGE',
-      `encoded DV exceeds maxEncodedBytes (${bytes.length} > ${limits.maxEncodedBytes})`,
-    );
-  }
+  const bytes = toDecodeInput(input, limits);
 
   const reader = new CborReader(bytes);
   const value = readValue(reader, limits, 0);
@@ -115,7 +156,23 @@ export function validateDv(
   options?: DvValidateOptions,
 ): asserts value is DV {
   // Encoding performs full validation, including size/limit checks.
-  encodeDv(value, options);
+  withSharedSink(value, options, () => undefined);
+}
+
+/**
+ * Check that `input` is one canonical DV value within limits, accepting exactly
+ * what `decodeDv` accepts, without decoding it.
+ */
+export function validateEncodedDv(
+  input: DvInput,
+  options?: DvDecodeOptions,
+): void {
+  const limits = normalizeLimits(options?.limits);
+  const reader = new CborReader(toDecodeInput(input, limits));
+  indexValue(reader, limits, 0, null);
+  if (!reader.isEOF()) {
+    throw dvError('TRAILING_BYTES', 'unexpected trailing bytes after DV value');
+  }
 }
 
 export function isDv(value: unknown, options?: DvValidateOptions): value is DV {
@@ -127,6 +184,203 @@ export function isDv(value: unknown, options?: DvValidateOptions): value is DV {
   }
 }
 
+export type DvKind = 'null' | 'boolean' | 'number' | 'string' | 'array' | 'map';
+
+type DvPathStep = string | number;
+
+/**
+ * Read-only, lazily decoded view over DV bytes. `DvView.from` validates the
+ * whole input in one pass (accepting exactly what `decodeDv` accepts) and
+ * records where every value starts; scalars and subtrees are only decoded when
+ * read. Views keep a reference to the input, which must not change afterwards.
+ */
+export class DvView {
+  private constructor(
+    private readonly index: DvIndex,
+    private readonly node: number,
+  ) {}
+
+  static from(input: DvInput, options?: DvDecodeOptions): DvView {
+    const limits = normalizeLimits(options?.limits);
+    const bytes = toDecodeInput(input, limits);
+    const index = new DvIndex(bytes, limits);
+    const reader = new CborReader(bytes);
+    indexValue(reader, limits, 0, index);
+
+    if (!reader.isEOF()) {
+      throw dvError(
+        'TRAILING_BYTES',
+        'unexpected trailing bytes after DV value',
+      );
+    }
+
+    return new DvView(index, 0);
+  }
+
+  get kind(): DvKind {
+    const initial = this.index.bytes[this.index.starts[this.node]];
+    switch (initial >> 5) {
+      case CBOR_MAJOR_UINT:
+      case CBOR_MAJOR_NINT:
+        return 'number';
+      case CBOR_MAJOR_TEXT:
+        return 'string';
+      case CBOR_MAJOR_ARRAY:
+        return 'array';
+      case CBOR_MAJOR_MAP:
+        return 'map';
+      default:
+        return initial === 0xf6
+          ? 'null'
+          : initial === 0xfb
+            ? 'number'
+            : 'boolean';
+    }
+  }
+
+  /**
+   * Element count of an array or entry count of a map; 0 for scalars.
+   */
+  get length(): number {
+    const kind = this.kind;
+    return kind === 'array' || kind === 'map'
+      ? headerArgument(this.index.bytes, this.index.starts[this.node])
+      : 0;
+  }
+
+  /**
+   * Array element at `position`, or `undefined` when out of range or when this
+   * is not an array.
+   */
+  at(position: number): DvView | undefined {
+    if (this.kind !== 'array' || !Number.isInteger(position)) {
+      return undefined;
+    }
+    const children = this.index.children(this.node);
+    return position >= 0 && position < children.length
+      ? new DvView(this.index, children[position])
+      : undefined;
+  }
+
+  /**
+   * Map value stored under `key`, or `undefined` when missing or when this is
+   * not a map. Keys are binary searched in canonical order.
+   */
+  get(key: string): DvView | undefined {
+    if (this.kind !== 'map' || !isWellFormedString(key)) {
+      return undefined;
+    }
+    const probe = encodeKey(key);
+    const children = this.index.children(this.node);
+    let low = 0;
+    let high = children.length / 2 - 1;
+    while (low <= high) {
+      const middle = (low + high) >> 1;
+      const ordering = compareCanonicalKeys(
+        this.index.raw(children[middle * 2]),
+        probe,
+      );
+      if (ordering === 0) {
+        return new DvView(this.index, children[middle * 2 + 1]);
+      }
+      if (ordering < 0) {
+        low = middle + 1;
+      } else {
+        high = middle - 1;
+      }
+    }
+    return undefined;
+  }
+
+  has(key: string): boolean {
+    return this.get(key) !== undefined;
+  }
+
+  /**
+   * Follow map keys and array positions from this value.
+   */
+  path(...steps: DvPathStep[]): DvView | undefined {
+    if (steps.length === 0) {
+      return this;
+    }
+    const [step, ...rest] = steps;
+    const child = typeof step === 'number' ? this.at(step) : this.get(step);
+    return child?.path(...rest);
+  }
+
+  /**
+   * Map keys in canonical order; empty for non-maps.
+   */
+  keys(): string[] {
+    if (this.kind !== 'map') {
+      return [];
+    }
+    const children = this.index.children(this.node);
+    const keys: string[] = [];
+    for (let i = 0; i < children.length; i += 2) {
+      keys.push(this.index.decode(children[i]) as string);
+    }
+    return keys;
+  }
+
+  /**
+   * Map entries in canonical order, or array elements keyed by position.
+   */
+  *entries(): IterableIterator<[string | number, DvView]> {
+    const kind = this.kind;
+    if (kind !== 'array' && kind !== 'map') {
+      return;
+    }
+    const children = this.index.children(this.node);
+    if (kind === 'array') {
+      for (let i = 0; i < children.length; i += 1) {
+        yield [i, new DvView(this.index, children[i])];
+      }
+      return;
+    }
+    for (let i = 0; i < children.length; i += 2) {
+      yield [
+        this.index.decode(children[i]) as string,
+        new DvView(this.index, children[i + 1]),
+      ];
+    }
+  }
+
+  /**
+   * Decode this value, materializing the full subtree for containers.
+   */
+  toValue(): DV {
+    return this.index.decode(this.node);
+  }
+
+  /**
+   * Canonical encoding of this value, as a view into the input bytes.
+   */
+  bytes(): Uint8Array {
+    return this.index.raw(this.node);
+  }
+}
+
+function toDecodeInput(
+  input: ArrayBufferView | ArrayBuffer | Uint8Array,
+  limits: DvLimits,
+): Uint8Array {
+  const bytes =
+    input instanceof Uint8Array
+      ? input
+      : input instanceof ArrayBuffer
+        ? new Uint8Array(input)
+        : new Uint8Array(input.buffer, input.byteOffset, input.byteLength);
+
+  if (bytes.length > limits.maxEncodedBytes) {
+    throw dvError(
+      'ENCODED_TOO_LARGE',
+      `encoded DV exceeds maxEncodedBytes (${bytes.length} > ${limits.maxEncodedBytes})`,
+    );
+  }
+  return bytes;
+}
+
 function normalizeLimits(limits?: PartialLimits): DvLimits {
   return {
     maxDepth: limits?.maxDepth ?? DV_LIMIT_DEFAULTS.maxDepth,
@@ -138,60 +392,189 @@ function normalizeLimits(limits?: PartialLimits): DvLimits {
   };
 }
 
-class ByteBuilder {
-  private readonly chunks: number[] = [];
+const INITIAL_CAPACITY = 256;
+
+let sharedSink: ByteSink | null = null;
+
+/**
+ * Run one encode on the module-wide sink. A nested call (e.g. from a getter
+ * reached while encoding) gets a private sink instead.
+ */
+function withSharedSink<T>(
+  value: unknown,
+  options: DvEncodeOptions | undefined,
+  finish: (sink: ByteSink) => T,
+): T {
+  const limits = normalizeLimits(options?.limits);
+  const sink = sharedSink ?? new ByteSink(INITIAL_CAPACITY);
+  sharedSink = null;
+  try {
+    sink.begin(limits.maxEncodedBytes);
+    encodeValue(value, sink, limits, 0);
+    return finish(sink);
+  } finally {
+    sharedSink = sink;
+  }
+}
+
+class ByteSink {
+  private owned: Uint8Array;
+  private ownedView: DataView;
+  private bytes: Uint8Array;
+  private data: DataView;
   private size = 0;
+  private maxBytes = 0;
+  private fixed = false;
+
+  constructor(capacity: number) {
+    this.owned = new Uint8Array(Math.max(capacity, 16));
+    this.ownedView = new DataView(this.owned.buffer);
+    this.bytes = this.owned;
+    this.data = this.ownedView;
+  }
+
+  get length(): number {
+    return this.size;
+  }
+
+  begin(maxBytes: number, target?: Uint8Array): void {
+    this.size = 0;
+    this.maxBytes = maxBytes;
+    if (!target) {
+      return;
+    }
+    this.bytes = target;
+    this.data = new DataView(
+      target.buffer,
+      target.byteOffset,
+      target.byteLength,
+    );
+    this.fixed = true;
+  }
 
-  constructor(private readonly maxBytes: number) {}
+  release(): void {
+    this.bytes = this.owned;
+    this.data = this.ownedView;
+    this.fixed = false;
+  }
+
+  view(): Uint8Array {
+    return this.bytes.subarray(0, this.size);
+  }
 
   pushByte(byte: number): void {
-    this.ensure(1);
-    this.chunks.push(byte & 0xff);
+    this.reserve(1);
+    this.bytes[this.size] = byte & 0xff;
     this.size += 1;
   }
 
   pushBytes(bytes: Uint8Array): void {
-    this.ensure(bytes.length);
-    for (const b of bytes) {
-      this.chunks.push(b);
-    }
+    this.reserve(bytes.length);
+    this.bytes.set(bytes, this.size);
     this.size += bytes.length;
   }
 
-  pushUint(value: number | bigint, width: 1 | 2 | 4 | 8): void {
-    this.ensure(width);
-    const view = new DataView(new ArrayBuffer(width));
+  pushUint(value: number, width: 1 | 2 | 4 | 8): void {
+    this.reserve(width);
+    const offset = this.size;
     if (width === 1) {
-      view.setUint8(0, Number(value));
+      this.data.setUint8(offset, value);
     } else if (width === 2) {
-      view.setUint16(0, Number(value), false);
+      this.data.setUint16(offset, value, false);
     } else if (width === 4) {
-      view.setUint32(0, Number(value), false);
+      this.data.setUint32(offset, value, false);
     } else {
-      view.setBigUint64(0, BigInt(value), false);
+      // Lengths and integers stay within 2^53, so split into two words.
+      this.data.setUint32(offset, Math.floor(value / 0x1_0000_0000), false);
+      this.data.setUint32(offset + 4, value >>> 0, false);
     }
-    this.pushBytes(new Uint8Array(view.buffer));
+    this.size += width;
   }
 
   pushFloat64(value: number): void {
-    this.ensure(8);
-    const view = new DataView(new ArrayBuffer(8));
-    view.setFloat64(0, value, false);
-    this.pushBytes(new Uint8Array(view.buffer));
-  }
+    this.reserve(8);
+    this.data.setFloat64(this.size, value, false);
+    this.size += 8;
+  }
+
+  /**
+   * Write a text string (header + UTF-8) with `TextEncoder.encodeInto`,
+   * leaving room for the largest possible header and sliding the bytes back
+   * when the actual header is shorter.
+   */
+  pushText(value: string, maxStringBytes: number): void {
+    const worstBytes = value.length * 3;
+    const worstHeader = headerLength(worstBytes);
+    if (!this.tryCapacity(this.size + worstHeader + worstBytes)) {
+      const bytes = textEncoder.encode(value);
+      checkStringLength(bytes.length, maxStringBytes);
+      encodeTypeAndLength(this, CBOR_MAJOR_TEXT, bytes.length);
+      this.pushBytes(bytes);
+      return;
+    }
 
-  toUint8Array(): Uint8Array {
-    return Uint8Array.from(this.chunks);
+    const start = this.size + worstHeader;
+    const { written } = textEncoder.encodeInto(
+      value,
+      this.bytes.subarray(start, start + worstBytes),
+    );
+    checkStringLength(written, maxStringBytes);
+    encodeTypeAndLength(this, CBOR_MAJOR_TEXT, written);
+    this.reserve(written);
+    if (this.size !== start) {
+      this.bytes.copyWithin(this.size, start, start + written);
+    }
+    this.size += written;
   }
 
-  private ensure(additional: number): void {
+  private reserve(additional: number): void {
     if (this.size + additional > this.maxBytes) {
       throw dvError(
         'ENCODED_TOO_LARGE',
         `encoded DV exceeds maxEncodedBytes (${this.size + additional} > ${this.maxBytes})`,
       );
     }
+    if (!this.tryCapacity(this.size + additional)) {
+      throw new RangeError(
+        `encoded DV does not fit the target buffer (${this.size + additional} > ${this.bytes.length})`,
+      );
+    }
+  }
+
+  private tryCapacity(required: number): boolean {
+    if (required <= this.bytes.length) {
+      return true;
+    }
+    if (this.fixed) {
+      return false;
+    }
+    let capacity = this.owned.length * 2;
+    while (capacity < required) {
+      capacity *= 2;
+    }
+    const grown = new Uint8Array(capacity);
+    grown.set(this.owned.subarray(0, this.size));
+    this.owned = grown;
+    this.ownedView = new DataView(grown.buffer);
+    this.bytes = grown;
+    this.data = this.ownedView;
+    return true;
+  }
+}
+
+const headerSink = new ByteSink(16);
+
+function headerLength(length: number): number {
+  if (length <= 23) {
+    return 1;
+  }
+  if (length <= 0xff) {
+    return 2;
   }
+  if (length <= 0xffff) {
+    return 3;
+  }
+  return length <= 0xffffffff ? 5 : 9;
 }
 
 function dvError(code: DvErrorCode, message: string): DvError {
@@ -200,7 +583,7 @@ function dvError(code: DvErrorCode, message: string): DvError {
 
 function encodeValue(
   value: unknown,
-  builder: ByteBuilder,
+  builder: ByteSink,
   limits: DvLimits,
   depth: number,
 ): void {
@@ -238,7 +621,7 @@ function encodeValue(
   throw dvError('UNSUPPORTED_TYPE', `unsupported DV type: ${type}`);
 }
 
-function encodeNumber(value: number, builder: ByteBuilder): void {
+function encodeNumber(value: number, builder: ByteSink): void {
   if (!Number.isFinite(value)) {
     throw dvError('NAN_OR_INF', 'DV numbers must be finite');
   }
@@ -262,7 +645,7 @@ function encodeNumber(value: number, builder: ByteBuilder): void {
   builder.pushFloat64(value);
 }
 
-function encodeInteger(value: number, builder: ByteBuilder): void {
+function encodeInteger(value: number, builder: ByteSink): void {
   if (value >= 0) {
     encodeTypeAndLength(builder, CBOR_MAJOR_UINT, value);
   } else {
@@ -272,7 +655,7 @@ function encodeInteger(value: number, builder: ByteBuilder): void {
 
 function encodeString(
   value: string,
-  builder: ByteBuilder,
+  builder: ByteSink,
   limits: DvLimits,
 ): void {
   if (!isWellFormedString(value)) {
@@ -281,20 +664,12 @@ function encodeString(
       'string contains lone surrogate code points',
     );
   }
-  const bytes = textEncoder.encode(value);
-  if (bytes.length > limits.maxStringBytes) {
-    throw dvError(
-      'STRING_TOO_LONG',
-      `string exceeds maxStringBytes (${bytes.length} > ${limits.maxStringBytes})`,
-    );
-  }
-  encodeTypeAndLength(builder, CBOR_MAJOR_TEXT, bytes.length);
-  builder.pushBytes(bytes);
+  builder.pushText(value, limits.maxStringBytes);
 }
 
 function encodeArray(
   value: DVArray,
-  builder: ByteBuilder,
+  builder: ByteSink,
   limits: DvLimits,
   depth: number,
 ): void {
@@ -317,7 +692,7 @@ function encodeArray(
 
 function encodeMap(
   value: Record<string, unknown>,
-  builder: ByteBuilder,
+  builder: ByteSink,
   limits: DvLimits,
   depth: number,
 ): void {
@@ -334,34 +709,123 @@ function encodeMap(
     );
   }
 
-  const encodedKeys = keys.map((key) => {
-    const keyBytes = encodeStringBytes(key, limits);
-    const header = typeAndLengthBytes(CBOR_MAJOR_TEXT, keyBytes.length);
-    const full = concat(header, keyBytes);
-    return { key, encoded: full };
-  });
+  const entries = canonicalKeyOrder(keys, limits);
+  encodeTypeAndLength(builder, CBOR_MAJOR_MAP, entries.length);
+  for (const entry of entries) {
+    builder.pushBytes(entry.encoded);
+    encodeValue(value[entry.key], builder, limits, nextDepth);
+  }
+}
+
+interface CanonicalKey {
+  readonly key: string;
+  /** Text header plus UTF-8 payload. */
+  readonly encoded: Uint8Array;
+  readonly byteLength: number;
+}
+
+/**
+ * One node per key in `Object.keys` order; `entries` caches the canonical
+ * order for objects whose own keys end here.
+ */
+interface MapShape {
+  readonly children: Map<string, MapShape>;
+  entries?: readonly CanonicalKey[];
+  maxKeyBytes: number;
+}
+
+// Records that share a shape are encoded over and over (documents, events),
+// so map keys and their canonical order are cached. Long keys and wide maps
+// are left out, and each cache is simply dropped once it hits its bound.
+const MAX_CACHED_KEY_LENGTH = 64;
+const MAX_CACHED_SHAPE_KEYS = 64;
+const KEY_CACHE_LIMIT = 4096;
+const SHAPE_CACHE_LIMIT = 4096;
+
+const keyCache = new Map<string, CanonicalKey>();
+let shapeRoot: MapShape = { children: new Map(), maxKeyBytes: 0 };
+let shapeNodes = 0;
+
+function canonicalKeyOrder(
+  keys: string[],
+  limits: DvLimits,
+): readonly CanonicalKey[] {
+  if (keys.length > MAX_CACHED_SHAPE_KEYS) {
+    return sortCanonicalKeys(keys, limits);
+  }
+  if (shapeNodes + keys.length > SHAPE_CACHE_LIMIT) {
+    shapeRoot = { children: new Map(), maxKeyBytes: 0 };
+    shapeNodes = 0;
+  }
+
+  let shape = shapeRoot;
+  for (const key of keys) {
+    let next = shape.children.get(key);
+    if (!next) {
+      if (key.length > MAX_CACHED_KEY_LENGTH) {
+        return sortCanonicalKeys(keys, limits);
+      }
+      next = { children: new Map(), maxKeyBytes: 0 };
+      shape.children.set(key, next);
+      shapeNodes += 1;
+    }
+    shape = next;
+  }
+
+  // A cached order is only reused when every key fits the current limits;
+  // otherwise the uncached path reports the violation exactly as before.
+  if (shape.entries && shape.maxKeyBytes <= limits.maxStringBytes) {
+    return shape.entries;
+  }
+  const entries = sortCanonicalKeys(keys, limits);
+  shape.entries = entries;
+  shape.maxKeyBytes = entries.reduce(
+    (max, entry) => Math.max(max, entry.byteLength),
+    0,
+  );
+  return entries;
+}
 
-  encodedKeys.sort((a, b) => compareCanonicalKeys(a.encoded, b.encoded));
+function sortCanonicalKeys(keys: string[], limits: DvLimits): CanonicalKey[] {
+  const entries = keys.map((key) => canonicalKey(key, limits));
+  entries.sort((a, b) => compareCanonicalKeys(a.encoded, b.encoded));
 
-  for (let i = 1; i < encodedKeys.length; i += 1) {
+  for (let i = 1; i < entries.length; i += 1) {
     if (
-      compareCanonicalKeys(
-        encodedKeys[i - 1].encoded,
-        encodedKeys[i].encoded,
-      ) === 0
+      compareCanonicalKeys(entries[i - 1].encoded, entries[i].encoded) === 0
     ) {
       throw dvError(
         'DUPLICATE_KEY',
-        `map contains duplicate key "${encodedKeys[i].key}"`,
+        `map contains duplicate key "${entries[i].key}"`,
       );
     }
   }
+  return entries;
+}
 
-  encodeTypeAndLength(builder, CBOR_MAJOR_MAP, encodedKeys.length);
-  for (const entry of encodedKeys) {
-    builder.pushBytes(entry.encoded);
-    encodeValue(value[entry.key], builder, limits, nextDepth);
+function canonicalKey(key: string, limits: DvLimits): CanonicalKey {
+  const cached = keyCache.get(key);
+  if (cached) {
+    checkStringLength(cached.byteLength, limits.maxStringBytes);
+    return cached;
+  }
+
+  const keyBytes = encodeStringBytes(key, limits);
+  const entry: CanonicalKey = {
+    key,
+    encoded: concat(
+      typeAndLengthBytes(CBOR_MAJOR_TEXT, keyBytes.length),
+      keyBytes,
+    ),
+    byteLength: keyBytes.length,
+  };
+  if (key.length <= MAX_CACHED_KEY_LENGTH) {
+    if (keyCache.size >= KEY_CACHE_LIMIT) {
+      keyCache.clear();
+    }
+    keyCache.set(key, entry);
   }
+  return entry;
 }
 
 function encodeStringBytes(value: string, limits: DvLimits): Uint8Array {
@@ -372,52 +836,56 @@ function encodeStringBytes(value: string, limits: DvLimits): Uint8Array {
     );
   }
   const bytes = textEncoder.encode(value);
-  if (bytes.length > limits.maxStringBytes) {
+  checkStringLength(bytes.length, limits.maxStringBytes);
+  return bytes;
+}
+
+function checkStringLength(length: number, maxStringBytes: number): void {
+  if (length > maxStringBytes) {
     throw dvError(
       'STRING_TOO_LONG',
-      `string exceeds maxStringBytes (${bytes.length} > ${limits.maxStringBytes})`,
+      `string exceeds maxStringBytes (${length} > ${maxStringBytes})`,
     );
   }
-  return bytes;
 }
 
-function typeAndLengthBytes(
-  major: number,
-  length: number | bigint,
-): Uint8Array {
-  const builder = new ByteBuilder(Number.MAX_SAFE_INTEGER);
-  encodeTypeAndLength(builder, major, length);
-  return builder.toUint8Array();
+function typeAndLengthBytes(major: number, length: number): Uint8Array {
+  const header = new Uint8Array(headerLength(length));
+  headerSink.begin(Number.MAX_SAFE_INTEGER, header);
+  try {
+    encodeTypeAndLength(headerSink, major, length);
+  } finally {
+    headerSink.release();
+  }
+  return header;
 }
 
 function encodeTypeAndLength(
-  builder: ByteBuilder,
+  builder: ByteSink,
   major: number,
-  length: number | bigint,
+  length: number,
 ): void {
-  if (typeof length === 'number' && (!Number.isInteger(length) || length < 0)) {
+  if (!Number.isInteger(length) || length < 0) {
     throw dvError(
       'NON_CANONICAL_LENGTH',
       `length must be a non-negative integer: ${length}`,
     );
   }
 
-  const value = typeof length === 'bigint' ? length : BigInt(length);
-
-  if (value <= 23n) {
-    builder.pushByte((major << 5) | Number(value));
-  } else if (value <= 0xffn) {
+  if (length <= 23) {
+    builder.pushByte((major << 5) | length);
+  } else if (length <= 0xff) {
     builder.pushByte((major << 5) | 24);
-    builder.pushUint(value, 1);
-  } else if (value <= 0xffffn) {
+    builder.pushUint(length, 1);
+  } else if (length <= 0xffff) {
     builder.pushByte((major << 5) | 25);
-    builder.pushUint(value, 2);
-  } else if (value <= 0xffffffffn) {
+    builder.pushUint(length, 2);
+  } else if (length <= 0xffffffff) {
     builder.pushByte((major << 5) | 26);
-    builder.pushUint(value, 4);
+    builder.pushUint(length, 4);
   } else {
     builder.pushByte((major << 5) | 27);
-    builder.pushUint(value, 8);
+    builder.pushUint(length, 8);
   }
 }
 
@@ -525,6 +993,17 @@ class CborReader {
     return this.bytes.slice(start, end);
   }
 
+  view(start: number, end: number): Uint8Array {
+    return this.bytes.subarray(start, end);
+  }
+
+  skip(length: number): void {
+    if (this.offset + length > this.bytes.length) {
+      throw dvError('TRUNCATED', 'unexpected end of buffer');
+    }
+    this.offset += length;
+  }
+
   position(): number {
     return this.offset;
   }
@@ -534,6 +1013,294 @@ class CborReader {
   }
 }
 
+/**
+ * Pre-order table of value start offsets. `next[node]` is the node that
+ * follows the subtree rooted at `node`, which also gives the subtree's end.
+ */
+class DvIndex {
+  starts = new Uint32Array(64);
+  next = new Uint32Array(64);
+  count = 0;
+  private readonly childCache = new Map<number, Uint32Array>();
+
+  constructor(
+    readonly bytes: Uint8Array,
+    readonly limits: DvLimits,
+  ) {}
+
+  open(start: number): number {
+    if (this.count === this.starts.length) {
+      const starts = new Uint32Array(this.starts.length * 2);
+      const next = new Uint32Array(this.next.length * 2);
+      starts.set(this.starts);
+      next.set(this.next);
+      this.starts = starts;
+      this.next = next;
+    }
+    this.starts[this.count] = start;
+    return this.count++;
+  }
+
+  close(node: number): void {
+    this.next[node] = this.count;
+  }
+
+  raw(node: number): Uint8Array {
+    const after = this.next[node];
+    const end = after < this.count ? this.starts[after] : this.bytes.length;
+    return this.bytes.subarray(this.starts[node], end);
+  }
+
+  decode(node: number): DV {
+    return readValue(new CborReader(this.raw(node)), this.limits, 0);
+  }
+
+  /**
+   * Direct children of an array or map node (keys and values interleaved for
+   * maps), computed on first use.
+   */
+  children(node: number): Uint32Array {
+    let children = this.childCache.get(node);
+    if (!children) {
+      const initial = this.bytes[this.starts[node]];
+      const length = headerArgument(this.bytes, this.starts[node]);
+      children = new Uint32Array(
+        initial >> 5 === CBOR_MAJOR_MAP ? length * 2 : length,
+      );
+      let child = node + 1;
+      for (let i = 0; i < children.length; i += 1) {
+        children[i] = child;
+        child = this.next[child];
+      }
+      this.childCache.set(node, children);
+    }
+    return children;
+  }
+}
+
+/**
+ * Validate one value exactly as `readValue` does while recording it in
+ * `index` (when given), without decoding strings or building containers.
+ */
+function indexValue(
+  reader: CborReader,
+  limits: DvLimits,
+  depth: number,
+  index: DvIndex | null,
+): void {
+  const node = index ? index.open(reader.position()) : 0;
+  const initial = reader.readByte();
+  const major = initial >> 5;
+  const additional = initial & 0x1f;
+
+  switch (major) {
+    case CBOR_MAJOR_UINT:
+      readUnsigned(additional, reader);
+      break;
+    case CBOR_MAJOR_NINT:
+      readNegative(additional, reader);
+      break;
+    case CBOR_MAJOR_TEXT:
+      skipText(additional, reader, limits);
+      break;
+    case CBOR_MAJOR_ARRAY:
+      indexArray(additional, reader, limits, depth, index);
+      break;
+    case CBOR_MAJOR_MAP:
+      indexMap(additional, reader, limits, depth, index);
+      break;
+    case CBOR_MAJOR_SIMPLE:
+      readSimpleOrFloat(additional, reader);
+      break;
+    default:
+      throw dvError('UNSUPPORTED_CBOR', `unsupported CBOR major type ${major}`);
+  }
+
+  index?.close(node);
+}
+
+function indexArray(
+  additional: number,
+  reader: CborReader,
+  limits: DvLimits,
+  depth: number,
+  index: DvIndex | null,
+): void {
+  const length = readLength(additional, reader);
+  const nextDepth = depth + 1;
+  if (nextDepth > limits.maxDepth) {
+    throw dvError('DEPTH_EXCEEDED', `maxDepth ${limits.maxDepth} exceeded`);
+  }
+  if (length > limits.maxArrayLength) {
+    throw dvError(
+      'ARRAY_TOO_LONG',
+      `array length exceeds maxArrayLength (${length} > ${limits.maxArrayLength})`,
+    );
+  }
+  for (let i = 0; i < length; i += 1) {
+    indexValue(reader, limits, nextDepth, index);
+  }
+}
+
+function indexMap(
+  additional: number,
+  reader: CborReader,
+  limits: DvLimits,
+  depth: number,
+  index: DvIndex | null,
+): void {
+  const length = readLength(additional, reader);
+  const nextDepth = depth + 1;
+
+  if (nextDepth > limits.maxDepth) {
+    throw dvError('DEPTH_EXCEEDED', `maxDepth ${limits.maxDepth} exceeded`);
+  }
+  if (length > limits.maxMapLength) {
+    throw dvError(
+      'MAP_TOO_LONG',
+      `map entries exceed maxMapLength (${length} > ${limits.maxMapLength})`,
+    );
+  }
+
+  let previousKey: Uint8Array | undefined;
+
+  for (let i = 0; i < length; i += 1) {
+    const keyStart = reader.position();
+    const keyNode = index ? index.open(keyStart) : 0;
+    const keyInitial = reader.readByte();
+    if (keyInitial >> 5 !== CBOR_MAJOR_TEXT) {
+      throw dvError('UNSUPPORTED_CBOR', 'map keys must be text strings');
+    }
+    skipText(keyInitial & 0x1f, reader, limits);
+    index?.close(keyNode);
+    const encodedKey = reader.view(keyStart, reader.position());
+
+    if (previousKey) {
+      const ordering = compareCanonicalKeys(previousKey, encodedKey);
+      if (ordering === 0) {
+        const key = readValue(new CborReader(encodedKey), limits, depth);
+        throw dvError('DUPLICATE_KEY', `map contains duplicate key "${key}"`);
+      }
+      if (ordering > 0) {
+        throw dvError('KEY_ORDER', 'map keys are not in canonical order');
+      }
+    }
+
+    previousKey = encodedKey;
+    indexValue(reader, limits, nextDepth, index);
+  }
+}
+
+function skipText(
+  additional: number,
+  reader: CborReader,
+  limits: DvLimits,
+): void {
+  const length = readLength(additional, reader);
+  if (length > limits.maxStringBytes) {
+    throw dvError(
+      'STRING_TOO_LONG',
+      `string exceeds maxStringBytes (${length} > ${limits.maxStringBytes})`,
+    );
+  }
+  const start = reader.position();
+  reader.skip(length);
+  if (!isStrictUtf8(reader.view(start, start + length))) {
+    throw dvError('INVALID_UTF8', 'invalid UTF-8 in string');
+  }
+}
+
+/**
+ * Allocation-free equivalent of the fatal-decode plus round-trip check in
+ * `readText`, including its rejection of a leading byte order mark.
+ */
+function isStrictUtf8(bytes: Uint8Array): boolean {
+  if (
+    bytes.length >= 3 &&
+    bytes[0] === 0xef &&
+    bytes[1] === 0xbb &&
+    bytes[2] === 0xbf
+  ) {
+    return false;
+  }
+  let i = 0;
+  while (i < bytes.length) {
+    const lead = bytes[i];
+    if (lead < 0x80) {
+      i += 1;
+      continue;
+    }
+    let needed: number;
+    let lower = 0x80;
+    let upper = 0xbf;
+    if (lead >= 0xc2 && lead <= 0xdf) {
+      needed = 1;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+      needed = 2;
+      if (lead === 0xe0) {
+        lower = 0xa0;
+      } else if (lead === 0xed) {
+        upper = 0x9f;
+      }
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+      needed = 3;
+      if (lead === 0xf0) {
+        lower = 0x90;
+      } else if (lead === 0xf4) {
+        upper = 0x8f;
+      }
+    } else {
+      return false;
+    }
+    if (i + needed >= bytes.length) {
+      return false;
+    }
+    const second = bytes[i + 1];
+    if (second < lower || second > upper) {
+      return false;
+    }
+    for (let k = 2; k <= needed; k += 1) {
+      const next = bytes[i + k];
+      if (next < 0x80 || next > 0xbf) {
+        return false;
+      }
+    }
+    i += needed + 1;
+  }
+  return true;
+}
+
+/**
+ * Header argument of an already validated value (length or integer).
+ */
+function headerArgument(bytes: Uint8Array, offset: number): number {
+  const additional = bytes[offset] & 0x1f;
+  if (additional <= 23) {
+    return additional;
+  }
+  if (additional === 24) {
+    return bytes[offset + 1];
+  }
+  if (additional === 25) {
+    return (bytes[offset + 1] << 8) | bytes[offset + 2];
+  }
+  const high =
+    bytes[offset + 1] * 0x1000000 +
+    ((bytes[offset + 2] << 16) | (bytes[offset + 3] << 8) | bytes[offset + 4]);
+  if (additional === 26) {
+    return high;
+  }
+  const low =
+    bytes[offset + 5] * 0x1000000 +
+    ((bytes[offset + 6] << 16) | (bytes[offset + 7] << 8) | bytes[offset + 8]);
+  return high * 0x100000000 + low;
+}
+
+function encodeKey(key: string): Uint8Array {
+  const keyBytes = textEncoder.encode(key);
+  return concat(typeAndLengthBytes(CBOR_MAJOR_TEXT, keyBytes.length), keyBytes);
+}
+
 function readValue(reader: CborReader, limits: DvLimits, depth: number): DV {
   const initial = reader.readByte();
   const major = initial >> 5;
@@ -592,9 +1359,7 @@ function readText(
     );
   }
   const start = reader.position();
-  for (let i = 0; i < length; i += 1) {
-    reader.readByte();
-  }
+  reader.skip(length);
   const bytes = reader.takeSlice(start, start + length);
   let decoded: string;
   try {
@@ -0,0 +1,148 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+SCRIPT_DIR="$(cd -- "$(dirname -- "${BASH_SOURCE[0]}")" && pwd)"
+REPO_ROOT="$(cd -- "${SCRIPT_DIR}/../../.." && pwd)"
+PROJECT_ROOT="${REPO_ROOT}/libs/quickjs-native"
+QJS_DIR="${REPO_ROOT}/vendor/quickjs"
+SHIM_DIR="${REPO_ROOT}/libs/quickjs-wasm-build/src/wasm"
+NATIVE_DIR="${PROJECT_ROOT}/src/native"
+OUT_DIR="${PROJECT_ROOT}/dist"
+OBJ_DIR="${OUT_DIR}/obj"
+ADDON_BASENAME="quickjs-native.node"
+METADATA_BASENAME="quickjs-native.metadata.json"
+CC_BIN="${CC:-cc}"
+# Matches the default (32mib) wasm memory profile; the region is the VM heap.
+MEMORY_BYTES=$((32 * 1024 * 1024))
+
+if [[ -n "${NODE_API_INCLUDE_DIR:-}" ]]; then
+  NODE_INCLUDE_DIR="${NODE_API_INCLUDE_DIR}"
+else
+  NODE_INCLUDE_DIR="$(node -p "require('path').resolve(process.execPath, '../../include/node')")"
+fi
+if [[ ! -f "${NODE_INCLUDE_DIR}/node_api.h" ]]; then
+  echo "node_api.h not found in ${NODE_INCLUDE_DIR}. Set NODE_API_INCLUDE_DIR." >&2
+  exit 1
+fi
+
+VERSION="$(cat "${QJS_DIR}/VERSION")"
+
+mkdir -p "${OBJ_DIR}"
+
+CFLAGS=(
+  -std=gnu11
+  -O2
+  -Wall
+  -Wextra
+  -Wno-unused-parameter
+  -Wno-missing-field-initializers
+  -fPIC
+  -fvisibility=hidden
+  -funsigned-char
+  -fwrapv
+  -I"${QJS_DIR}"
+  -I"${NATIVE_DIR}"
+  -D_GNU_SOURCE
+  "-DCONFIG_VERSION=\"${VERSION}\""
+  "-DQJS_DET_MEMORY_BYTES=${MEMORY_BYTES}u"
+)
+
+LDFLAGS=(
+  -shared
+  -lm
+  -pthread
+)
+
+# Instrumented addon for collecting the wasm optimized build's profile (see
+# docs/toolchain.md). Needs CC=clang with the emsdk's LLVM major version; the
+# flag lands in buildFlags, so the addon is never mistaken for a release.
+if [[ "${QJS_NATIVE_PROFILE_GENERATE:-0}" == "1" ]]; then
+  CFLAGS+=(-fprofile-instr-generate)
+  LDFLAGS+=(-fprofile-instr-generate)
+fi
+
+UNAME_OUT="$(uname -s)"
+if [[ "${UNAME_OUT}" == "Darwin" ]]; then
+  LDFLAGS+=(-undefined dynamic_lookup)
+fi
+
+# Engine and shim sources allocate from the instance region (see
+# quickjs_det_native_alloc.h); the glue keeps the process allocator.
+ENGINE_SRC_FILES=(
+  "${QJS_DIR}/quickjs.c"
+  "${QJS_DIR}/quickjs-host.c"
+  "${QJS_DIR}/quickjs-dv.c"
+  "${QJS_DIR}/quickjs-sha256.c"
+  "${QJS_DIR}/dtoa.c"
+  "${QJS_DIR}/libregexp.c"
+  "${QJS_DIR}/libunicode.c"
+  "${QJS_DIR}/cutils.c"
+  "${QJS_DIR}/quickjs-libc.c"
+  "${SHIM_DIR}/quickjs_wasm.c"
+)
+
+OBJ_FILES=()
+for src in "${ENGINE_SRC_FILES[@]}"; do
+  obj="${OBJ_DIR}/$(basename "${src%.*}").o"
+  "${CC_BIN}" "${CFLAGS[@]}" -include quickjs_det_native_alloc.h -c "${src}" -o "${obj}"
+  OBJ_FILES+=("${obj}")
+done
+
+glue_obj="${OBJ_DIR}/quickjs_det_napi.o"
+"${CC_BIN}" "${CFLAGS[@]}" -I"${NODE_INCLUDE_DIR}" -c "${NATIVE_DIR}/quickjs_det_napi.c" -o "${glue_obj}"
+OBJ_FILES+=("${glue_obj}")
+
+"${CC_BIN}" -o "${OUT_DIR}/${ADDON_BASENAME}" "${OBJ_FILES[@]}" "${LDFLAGS[@]}"
+
+echo "Built ${OUT_DIR}/${ADDON_BASENAME}"
+
+export QJS_NATIVE_BUILD_FLAGS="$(printf '%s\n' "${CFLAGS[@]}")"
+
+node - "${OUT_DIR}" "${QJS_DIR}" "${ADDON_BASENAME}" "${METADATA_BASENAME}" "${MEMORY_BYTES}" <<'NODE'
+const crypto = require('crypto');
+const fs = require('fs');
+const path = require('path');
+const { execFileSync } = require('child_process');
+
+const [outDir, qjsDir, addonBasename, metadataBasename, memoryBytesRaw] =
+  process.argv.slice(2);
+
+const addonPath = path.join(outDir, addonBasename);
+const addonBytes = fs.readFileSync(addonPath);
+const sha256 = crypto.createHash('sha256').update(addonBytes).digest('hex');
+
+let quickjsCommit = null;
+try {
+  quickjsCommit = execFileSync('git', ['-C', qjsDir, 'rev-parse', 'HEAD'], {
+    encoding: 'utf8',
+  }).trim();
+} catch {
+  quickjsCommit = null;
+}
+
+const metadata = {
+  quickjsVersion: fs.readFileSync(path.join(qjsDir, 'VERSION'), 'utf8').trim(),
+  quickjsCommit,
+  engineBuildHash: sha256,
+  buildType: 'release',
+  memoryProfile: '32mib',
+  platform: `${process.platform}-${process.arch}`,
+  napiVersion: Number.parseInt(process.versions.napi, 10),
+  addon: {
+    filename: addonBasename,
+    sha256,
+    size: addonBytes.length,
+  },
+  memory: {
+    bytes: Number.parseInt(memoryBytesRaw, 10),
+  },
+  buildFlags: (process.env.QJS_NATIVE_BUILD_FLAGS ?? '')
+    .split(/\r?\n/)
+    .map((flag) => flag.trim())
+    .filter((flag) => flag && !flag.startsWith('-I')),
+};
+
+const outPath = path.join(outDir, metadataBasename);
+fs.writeFileSync(outPath, `${JSON.stringify(metadata, null, 2)}\n`, 'utf8');
+console.log(`Wrote metadata: ${outPath}`);
+NODE
@@ -0,0 +1 @@
+export * from './lib/quickjs-native.js';
@@ -0,0 +1,92 @@
+import fs from 'node:fs';
+import os from 'node:os';
+import path from 'node:path';
+
+import {
+  QUICKJS_NATIVE_ADDON_BASENAME,
+  QUICKJS_NATIVE_METADATA_BASENAME,
+  createQuickjsNativeModule,
+  getQuickjsNativeAddonPath,
+  getQuickjsNativeArtifact,
+  getQuickjsNativeMetadataPath,
+  readQuickjsNativeMetadata,
+} from './quickjs-native.js';
+
+const normalize = (p: string) => p.split(path.sep).join('/');
+const addonBuilt = fs.existsSync(getQuickjsNativeAddonPath());
+
+describe('artifact helpers', () => {
+  it('returns stable dist paths', () => {
+    expect(normalize(getQuickjsNativeAddonPath())).toMatch(
+      /libs\/quickjs-native\/dist\/quickjs-native\.node$/,
+    );
+    expect(normalize(getQuickjsNativeMetadataPath())).toMatch(
+      /libs\/quickjs-native\/dist\/quickjs-native\.metadata\.json$/,
+    );
+    expect(QUICKJS_NATIVE_ADDON_BASENAME).toBe('quickjs-native.node');
+    expect(QUICKJS_NATIVE_METADATA_BASENAME).toBe(
+      'quickjs-native.metadata.json',
+    );
+  });
+
+  it('reads metadata from a custom path', () => {
+    const tempDir = fs.mkdtempSync(
+      path.join(os.tmpdir(), 'quickjs-native-meta-'),
+    );
+    const metadataPath = path.join(tempDir, 'meta.json');
+    const sample = {
+      quickjsVersion: '2024-01-01',
+      quickjsCommit: 'abc123',
+      engineBuildHash: 'deadbeef',
+      buildType: 'release',
+      memoryProfile: '32mib',
+      platform: 'linux-x64',
+      napiVersion: 9,
+      addon: { filename: 'quickjs-native.node', sha256: 'deadbeef', size: 1 },
+      memory: { bytes: 33554432 },
+      buildFlags: ['-O2'],
+    };
+    fs.writeFileSync(metadataPath, JSON.stringify(sample), 'utf8');
+
+    const parsed = readQuickjsNativeMetadata(metadataPath);
+    expect(parsed).toEqual(sample);
+    const artifact = getQuickjsNativeArtifact(parsed);
+    expect(normalize(artifact.addonPath)).toMatch(
+      /libs\/quickjs-native\/dist\/quickjs-native\.node$/,
+    );
+    expect(artifact.variantMetadata.engineBuildHash).toBe('deadbeef');
+  });
+});
+
+describe.skipIf(!addonBuilt)('native module', () => {
+  it('round-trips heap strings through the instance allocator', () => {
+    const module = createQuickjsNativeModule({
+      host: { host_call: () => 0xffffffff },
+    });
+    const ptr = module._malloc(16);
+    expect(ptr).toBeGreaterThan(0);
+    expect(ptr + 16).toBeLessThanOrEqual(module.HEAPU8.length);
+    module.HEAPU8.set(new TextEncoder().encode('héllo\0'), ptr);
+    expect(module.UTF8ToString(ptr)).toBe('héllo');
+    module._free(ptr);
+  });
+
+  it('keeps instances isolated', () => {
+    const host = { host_call: () => 0xffffffff };
+    const first = createQuickjsNativeModule({ host });
+    const second = createQuickjsNativeModule({ host });
+    expect(first.HEAPU8.buffer).not.toBe(second.HEAPU8.buffer);
+    const inputBuffer = (module: typeof first) =>
+      module.cwrap<(capacity: number) => number>(
+        'qjs_det_input_buffer',
+        'number',
+        ['number'],
+      );
+    const ptr = inputBuffer(first)(64);
+    first.HEAPU8.fill(0x5a, ptr, ptr + 64);
+    const other = inputBuffer(second)(64);
+    expect(second.HEAPU8.subarray(other, other + 64).includes(0x5a)).toBe(
+      false,
+    );
+  });
+});
@@ -0,0 +1,230 @@
+import fs from 'node:fs';
+import { createRequire } from 'node:module';
+import path from 'node:path';
+import { fileURLToPath } from 'node:url';
+
+export const QUICKJS_NATIVE_ADDON_BASENAME = 'quickjs-native.node';
+export const QUICKJS_NATIVE_METADATA_BASENAME = 'quickjs-native.metadata.json';
+
+export interface QuickjsNativeBuildMetadata {
+  quickjsVersion: string;
+  quickjsCommit: string | null;
+  /** sha256 of the addon binary. */
+  engineBuildHash: string;
+  buildType: 'release';
+  memoryProfile: '32mib';
+  /** `${process.platform}-${process.arch}` of the build host. */
+  platform: string;
+  napiVersion: number;
+  addon: {
+    filename: string;
+    sha256: string;
+    size: number;
+  };
+  memory: {
+    bytes: number;
+  };
+  buildFlags: string[];
+}
+
+export interface QuickjsNativeArtifact {
+  addonPath: string;
+  buildType: 'release';
+  memoryProfile: '32mib';
+  /** Mirrors the wasm artifact field read for engine hash checks. */
+  variantMetadata: { engineBuildHash: string };
+}
+
+/**
+ * Imports of one native instance; same signatures as the wasm module's
+ * `host` imports, with pointers as offsets into `HEAPU8`.
+ */
+export interface QuickjsNativeHost {
+  host_call: (
+    fnId: number,
+    reqPtr: number,
+    reqLen: number,
+    respPtr: number,
+    respCapacity: number,
+  ) => number;
+  tape_sink?: (handle: number, ptr: number, count: number) => void;
+}
+
+/**
+ * Emscripten-module-shaped view of one native instance, so the deterministic
+ * ABI wrappers drive it unchanged. Each instance owns a fixed region that
+ * plays the role of linear memory.
+ */
+export interface QuickjsNativeModule {
+  HEAPU8: Uint8Array;
+  cwrap<T extends (...args: unknown[]) => unknown>(
+    ident: string,
+    returnType: string | null,
+    argTypes: Array<string | null>,
+    opts?: { async?: boolean },
+  ): T;
+  UTF8ToString(ptr: number, maxBytesToRead?: number): string;
+  _malloc(size: number): number;
+  _free(ptr: number): void;
+  /**
+   * The instance's imports. The addon references them weakly, because their
+   * closures usually capture the heap and a strong reference would keep the
+   * instance from ever being finalized, so this field keeps them alive.
+   */
+  host: QuickjsNativeHost;
+}
+
+type NativeExport = (heap: ArrayBuffer, ...args: unknown[]) => unknown;
+
+interface QuickjsNativeAddon {
+  regionSize: number;
+  createInstance(
+    hostCall: QuickjsNativeHost['host_call'],
+    tapeSink?: QuickjsNativeHost['tape_sink'],
+  ): ArrayBuffer;
+  [name: string]: unknown;
+}
+
+function resolveArtifactDir(): string {
+  const baseUrl = new URL('../..', import.meta.url);
+  if (baseUrl.protocol === 'file:') {
+    return path.resolve(fileURLToPath(baseUrl), 'dist');
+  }
+  return path.resolve(process.cwd(), 'libs/quickjs-native/dist');
+}
+
+const artifactDir = resolveArtifactDir();
+const ADDONS = new Map<string, QuickjsNativeAddon>();
+const encoder = new TextEncoder();
+const decoder = new TextDecoder();
+
+export function getQuickjsNativeAddonPath() {
+  return path.join(artifactDir, QUICKJS_NATIVE_ADDON_BASENAME);
+}
+
+export function getQuickjsNativeMetadataPath() {
+  return path.join(artifactDir, QUICKJS_NATIVE_METADATA_BASENAME);
+}
+
+export function readQuickjsNativeMetadata(
+  metadataPath: string = getQuickjsNativeMetadataPath(),
+): QuickjsNativeBuildMetadata {
+  if (!fs.existsSync(metadataPath)) {
+    throw new Error(
+      `QuickJS native metadata not found at ${metadataPath}. Did you run pnpm nx build quickjs-native?`,
+    );
+  }
+  const raw = fs.readFileSync(metadataPath, 'utf8');
+  return JSON.parse(raw) as QuickjsNativeBuildMetadata;
+}
+
+export function getQuickjsNativeArtifact(
+  metadata: QuickjsNativeBuildMetadata = readQuickjsNativeMetadata(),
+): QuickjsNativeArtifact {
+  return {
+    addonPath: path.join(artifactDir, metadata.addon.filename),
+    buildType: metadata.buildType,
+    memoryProfile: metadata.memoryProfile,
+    variantMetadata: { engineBuildHash: metadata.engineBuildHash },
+  };
+}
+
+function loadAddon(addonPath: string): QuickjsNativeAddon {
+  let addon = ADDONS.get(addonPath);
+  if (!addon) {
+    if (!fs.existsSync(addonPath)) {
+      throw new Error(
+        `QuickJS native addon not found at ${addonPath}. Did you run pnpm nx build quickjs-native?`,
+      );
+    }
+    const require = createRequire(import.meta.url);
+    addon = require(addonPath) as QuickjsNativeAddon;
+    ADDONS.set(addonPath, addon);
+  }
+  return addon;
+}
+
+/**
+ * Create a native instance with its own heap region. The addon is loaded
+ * once per thread; the instance may only be used on the calling thread.
+ */
+export function createQuickjsNativeModule(options: {
+  host: QuickjsNativeHost;
+  addonPath?: string;
+}): QuickjsNativeModule {
+  const addon = loadAddon(options.addonPath ?? getQuickjsNativeAddonPath());
+  const heap = addon.createInstance(
+    options.host.host_call,
+    options.host.tape_sink,
+  );
+  const HEAPU8 = new Uint8Array(heap);
+
+  const resolveExport = (ident: string): NativeExport => {
+    const fn = addon[ident];
+    if (typeof fn !== 'function') {
+      throw new Error(`QuickJS native addon has no export ${ident}`);
+    }
+    return fn as NativeExport;
+  };
+  const malloc = resolveExport('malloc');
+  const free = resolveExport('free');
+  const _malloc = (size: number) => malloc(heap, size) as number;
+  const _free = (ptr: number) => {
+    free(heap, ptr);
+  };
+
+  const UTF8ToString = (ptr: number, maxBytesToRead?: number): string => {
+    if (!ptr) {
+      return '';
+    }
+    const limit =
+      maxBytesToRead === undefined
+        ? HEAPU8.length
+        : Math.min(HEAPU8.length, ptr + maxBytesToRead);
+    let end = ptr;
+    while (end < limit && HEAPU8[end] !== 0) {
+      end += 1;
+    }
+    return decoder.decode(HEAPU8.subarray(ptr, end));
+  };
+
+  // `async` is accepted for parity with the Asyncify build; native exports
+  // always complete synchronously.
+  const cwrap = <T extends (...args: unknown[]) => unknown>(
+    ident: string,
+    returnType: string | null,
+    argTypes: Array<string | null>,
+  ): T => {
+    const fn = resolveExport(ident);
+    const wrapped = (...args: unknown[]) => {
+      const owned: number[] = [];
+      try {
+        const converted = args.map((arg, index) => {
+          if (argTypes[index] !== 'string') {
+            return arg;
+          }
+          const bytes = encoder.encode(String(arg));
+          const ptr = _malloc(bytes.length + 1);
+          if (!ptr) {
+            throw new Error('quickjs-native: out of memory');
+          }
+          HEAPU8.set(bytes, ptr);
+          HEAPU8[ptr + bytes.length] = 0;
+          owned.push(ptr);
+          return ptr;
+        });
+        const result = fn(heap, ...converted);
+        return returnType === 'string'
+          ? UTF8ToString(result as number)
+          : result;
+      } finally {
+        for (const ptr of owned) {
+          _free(ptr);
+        }
+      }
+    };
+    return wrapped as T;
+  };
+
+  return { HEAPU8, cwrap, UTF8ToString, _malloc, _free, host: options.host };
+}
@@ -0,0 +1,556 @@
+#include "quickjs_det_native.h"
+#include <node_api.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* N-API glue for the native deterministic engine. An instance is an external
+   ArrayBuffer over its region (the embedder's HEAPU8), wrapped with the
+   record below. Every export takes it as the first argument, followed by the
+   arguments of the wasm export of the same name; pointers are passed and
+   returned as 32-bit offsets into the region, exactly like wasm32 addresses.
+   Instances are bound to the thread (and Node environment) that created
+   them; load the addon in each worker that needs one. */
+
+#define DET_NAPI_MAX_ARGS 7
+#define DET_HOST_TRANSPORT_ERROR 0xffffffffu
+
+typedef struct {
+  DetState *state;
+  napi_env env;
+  /* Weak: a strong reference would keep the heap that their closures capture
+     alive, so the instance would never be finalized. createQuickjsNativeModule
+     keeps them alive as `module.host`; a collected host_call fails like a
+     transport error. */
+  napi_ref host_call;
+  napi_ref tape_sink;
+  /* First exception thrown by an import during the current call; rethrown
+     when the export returns, as it would propagate out of a wasm call. */
+  napi_ref pending;
+} DetNativeInstance;
+
+/* Instance whose export is running on this thread (imports are routed to it). */
+static _Thread_local DetNativeInstance *det_current;
+
+typedef struct {
+  napi_env env;
+  DetNativeInstance *inst;
+  DetNativeInstance *prev_inst;
+  DetState *prev_state;
+  napi_value argv[DET_NAPI_MAX_ARGS];
+  int failed;
+} DetCall;
+
+static void capture_exception(DetNativeInstance *inst) {
+  napi_value error;
+  if (napi_get_and_clear_last_exception(inst->env, &error) != napi_ok || inst->pending) {
+    return;
+  }
+  napi_create_reference(inst->env, error, 1, &inst->pending);
+}
+
+static int call_begin(napi_env env, napi_callback_info info, size_t argc, DetCall *call) {
+  size_t got = DET_NAPI_MAX_ARGS;
+  void *data = NULL;
+
+  memset(call, 0, sizeof(*call));
+  call->env = env;
+  if (napi_get_cb_info(env, info, &got, call->argv, NULL, NULL) != napi_ok) {
+    return -1;
+  }
+  if (got < argc + 1) {
+    napi_throw_type_error(env, NULL, "quickjs-native: missing arguments");
+    return -1;
+  }
+  if (napi_unwrap(env, call->argv[0], &data) != napi_ok || !data) {
+    napi_throw_type_error(env, NULL, "quickjs-native: expected an instance heap");
+    return -1;
+  }
+
+  call->inst = data;
+  call->prev_inst = det_current;
+  det_current = call->inst;
+  call->prev_state = qjs_det_native_enter(call->inst->state);
+  return 0;
+}
+
+static napi_value call_end(DetCall *call, napi_value result) {
+  DetNativeInstance *inst = call->inst;
+
+  qjs_det_native_enter(call->prev_state);
+  det_current = call->prev_inst;
+  if (inst->pending) {
+    napi_value error;
+    napi_get_reference_value(call->env, inst->pending, &error);
+    napi_delete_reference(call->env, inst->pending);
+    inst->pending = NULL;
+    napi_throw(call->env, error);
+    return NULL;
+  }
+  return call->failed ? NULL : result;
+}
+
+static void arg_error(DetCall *call, const char *message) {
+  if (!call->failed) {
+    call->failed = 1;
+    napi_throw_type_error(call->env, NULL, message);
+  }
+}
+
+static uint32_t arg_u32(DetCall *call, size_t index) {
+  uint32_t value = 0;
+  if (napi_get_value_uint32(call->env, call->argv[index + 1], &value) != napi_ok) {
+    arg_error(call, "quickjs-native: expected a number");
+  }
+  return value;
+}
+
+static int32_t arg_i32(DetCall *call, size_t index) {
+  int32_t value = 0;
+  if (napi_get_value_int32(call->env, call->argv[index + 1], &value) != napi_ok) {
+    arg_error(call, "quickjs-native: expected a number");
+  }
+  return value;
+}
+
+static uint64_t arg_u64(DetCall *call, size_t index) {
+  uint64_t value = 0;
+  bool lossless = true;
+  if (napi_get_value_bigint_uint64(call->env, call->argv[index + 1], &value, &lossless) !=
+      napi_ok) {
+    arg_error(call, "quickjs-native: expected a bigint");
+  }
+  return value;
+}
+
+/* Offset argument checked to leave `span` readable bytes in the region; 0 is
+   NULL. */
+static void *arg_ptr(DetCall *call, size_t index, uint32_t span) {
+  uint32_t offset = arg_u32(call, index);
+  if (offset == 0 || call->failed) {
+    return NULL;
+  }
+  if ((uint64_t)offset + span > qjs_det_native_region_size()) {
+    arg_error(call, "quickjs-native: pointer outside the instance heap");
+    return NULL;
+  }
+  return (uint8_t *)call->inst->state + offset;
+}
+
+static napi_value ret_u32(DetCall *call, uint32_t value) {
+  napi_value out = NULL;
+  napi_create_uint32(call->env, value, &out);
+  return out;
+}
+
+static napi_value ret_i32(DetCall *call, int32_t value) {
+  napi_value out = NULL;
+  napi_create_int32(call->env, value, &out);
+  return out;
+}
+
+static napi_value ret_ptr(DetCall *call, const void *ptr) {
+  const uint8_t *base = (const uint8_t *)call->inst->state;
+  return ret_u32(call, ptr ? (uint32_t)((const uint8_t *)ptr - base) : 0);
+}
+
+static napi_value ret_void(DetCall *call) {
+  napi_value out = NULL;
+  napi_get_undefined(call->env, &out);
+  return out;
+}
+
+uint32_t host_call(uint32_t fn_id,
+                   uint32_t req_ptr,
+                   uint32_t req_len,
+                   uint32_t resp_ptr,
+                   uint32_t resp_capacity) {
+  DetNativeInstance *inst = det_current;
+  napi_handle_scope scope;
+  napi_value fn = NULL;
+  napi_value recv;
+  napi_value argv[5];
+  napi_value result;
+  uint32_t written = DET_HOST_TRANSPORT_ERROR;
+
+  if (!inst || inst->pending || napi_open_handle_scope(inst->env, &scope) != napi_ok) {
+    return DET_HOST_TRANSPORT_ERROR;
+  }
+  napi_get_reference_value(inst->env, inst->host_call, &fn);
+  if (fn) {
+    napi_get_undefined(inst->env, &recv);
+    napi_create_uint32(inst->env, fn_id, &argv[0]);
+    napi_create_uint32(inst->env, req_ptr, &argv[1]);
+    napi_create_uint32(inst->env, req_len, &argv[2]);
+    napi_create_uint32(inst->env, resp_ptr, &argv[3]);
+    napi_create_uint32(inst->env, resp_capacity, &argv[4]);
+    if (napi_call_function(inst->env, recv, fn, 5, argv, &result) == napi_ok) {
+      if (napi_get_value_uint32(inst->env, result, &written) != napi_ok) {
+        written = DET_HOST_TRANSPORT_ERROR;
+      }
+    } else {
+      capture_exception(inst);
+    }
+  }
+  napi_close_handle_scope(inst->env, scope);
+  return written;
+}
+
+void tape_sink(uint32_t handle, uint32_t records_ptr, uint32_t count) {
+  DetNativeInstance *inst = det_current;
+  napi_handle_scope scope;
+  napi_value fn = NULL;
+  napi_value recv;
+  napi_value argv[3];
+  napi_value result;
+
+  if (!inst || !inst->tape_sink || inst->pending ||
+      napi_open_handle_scope(inst->env, &scope) != napi_ok) {
+    return;
+  }
+  napi_get_reference_value(inst->env, inst->tape_sink, &fn);
+  if (fn) {
+    napi_get_undefined(inst->env, &recv);
+    napi_create_uint32(inst->env, handle, &argv[0]);
+    napi_create_uint32(inst->env, records_ptr, &argv[1]);
+    napi_create_uint32(inst->env, count, &argv[2]);
+    if (napi_call_function(inst->env, recv, fn, 3, argv, &result) != napi_ok) {
+      capture_exception(inst);
+    }
+  }
+  napi_close_handle_scope(inst->env, scope);
+}
+
+static void instance_finalize(napi_env env, void *data, void *hint) {
+  DetNativeInstance *inst = hint;
+  DetNativeInstance *prev = det_current;
+  int64_t adjusted;
+  (void)data;
+
+  det_current = inst;
+  qjs_det_native_state_free(inst->state);
+  det_current = prev;
+  napi_adjust_external_memory(env, -(int64_t)qjs_det_native_region_size(), &adjusted);
+  if (inst->host_call) {
+    napi_delete_reference(env, inst->host_call);
+  }
+  if (inst->tape_sink) {
+    napi_delete_reference(env, inst->tape_sink);
+  }
+  if (inst->pending) {
+    napi_delete_reference(env, inst->pending);
+  }
+  free(inst);
+}
+
+static int is_function(napi_env env, napi_value value) {
+  napi_valuetype type;
+  return napi_typeof(env, value, &type) == napi_ok && type == napi_function;
+}
+
+/* createInstance(host_call, tape_sink?) -> heap ArrayBuffer */
+static napi_value js_create_instance(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value argv[2];
+  napi_value heap;
+  int64_t adjusted;
+
+  if (napi_get_cb_info(env, info, &argc, argv, NULL, NULL) != napi_ok) {
+    return NULL;
+  }
+  if (argc < 1 || !is_function(env, argv[0])) {
+    napi_throw_type_error(env, NULL, "quickjs-native: host_call must be a function");
+    return NULL;
+  }
+
+  DetNativeInstance *inst = calloc(1, sizeof(DetNativeInstance));
+  if (!inst) {
+    napi_throw_error(env, NULL, "quickjs-native: out of memory");
+    return NULL;
+  }
+  inst->state = qjs_det_native_state_new();
+  if (!inst->state) {
+    free(inst);
+    napi_throw_error(env, NULL, "quickjs-native: failed to map the instance heap");
+    return NULL;
+  }
+  inst->env = env;
+  napi_create_reference(env, argv[0], 0, &inst->host_call);
+  if (argc > 1 && is_function(env, argv[1])) {
+    napi_create_reference(env, argv[1], 0, &inst->tape_sink);
+  }
+
+  if (napi_create_external_arraybuffer(env, inst->state, qjs_det_native_region_size(),
+                                       instance_finalize, inst, &heap) != napi_ok) {
+    instance_finalize(env, NULL, inst);
+    return NULL;
+  }
+  napi_adjust_external_memory(env, (int64_t)qjs_det_native_region_size(), &adjusted);
+  if (napi_wrap(env, heap, inst, NULL, NULL, NULL) != napi_ok) {
+    return NULL;
+  }
+  return heap;
+}
+
+#define DET_EXPORT(name) static napi_value js_##name(napi_env env, napi_callback_info info)
+#define DET_BEGIN(argc)                                \
+  DetCall call;                                        \
+  if (call_begin(env, info, (argc), &call) != 0) {     \
+    return NULL;                                       \
+  }
+/* The export only runs when every argument converted. */
+#define DET_RETURN(expr) return call_end(&call, call.failed ? NULL : (expr))
+
+DET_EXPORT(malloc) {
+  DET_BEGIN(1);
+  uint32_t size = arg_u32(&call, 0);
+  DET_RETURN(ret_ptr(&call, det_malloc(size)));
+}
+
+DET_EXPORT(free) {
+  DET_BEGIN(1);
+  void *ptr = arg_ptr(&call, 0, 0);
+  DET_RETURN((det_free(ptr), ret_void(&call)));
+}
+
+DET_EXPORT(qjs_det_input_buffer) {
+  DET_BEGIN(1);
+  uint32_t capacity = arg_u32(&call, 0);
+  DET_RETURN(ret_ptr(&call, qjs_det_input_buffer(capacity)));
+}
+
+DET_EXPORT(qjs_det_set_manifest) {
+  DET_BEGIN(2);
+  uint32_t size = arg_u32(&call, 1);
+  const uint8_t *bytes = arg_ptr(&call, 0, size);
+  DET_RETURN(ret_i32(&call, qjs_det_set_manifest(bytes, size)));
+}
+
+DET_EXPORT(qjs_det_use_arena) {
+  DET_BEGIN(1);
+  int32_t enabled = arg_i32(&call, 0);
+  DET_RETURN(ret_i32(&call, qjs_det_use_arena(enabled)));
+}
+
+DET_EXPORT(qjs_det_init) {
+  DET_BEGIN(6);
+  uint32_t manifest_size = arg_u32(&call, 1);
+  uint32_t context_size = arg_u32(&call, 4);
+  const uint8_t *manifest = arg_ptr(&call, 0, manifest_size);
+  const char *hash = arg_ptr(&call, 2, 0);
+  const uint8_t *context = arg_ptr(&call, 3, context_size);
+  uint64_t gas_limit = arg_u64(&call, 5);
+  DET_RETURN(ret_u32(
+      &call, qjs_det_init(manifest, manifest_size, hash, context, context_size, gas_limit)));
+}
+
+DET_EXPORT(qjs_det_take_init_error) {
+  DET_BEGIN(0);
+  DET_RETURN(ret_ptr(&call, qjs_det_take_init_error()));
+}
+
+DET_EXPORT(qjs_det_eval) {
+  DET_BEGIN(2);
+  uint32_t handle = arg_u32(&call, 0);
+  const char *code = arg_ptr(&call, 1, 1);
+  if (!code) {
+    arg_error(&call, "quickjs-native: code must not be NULL");
+  }
+  DET_RETURN(ret_ptr(&call, qjs_det_eval(handle, code)));
+}
+
+/* Code and prelude must be NUL-terminated at [len], hence len + 1. */
+DET_EXPORT(qjs_det_eval_bin) {
+  DET_BEGIN(3);
+  uint32_t handle = arg_u32(&call, 0);
+  uint32_t len = arg_u32(&call, 2);
+  const char *code = arg_ptr(&call, 1, len + 1);
+  DET_RETURN(ret_ptr(&call, qjs_det_eval_bin(handle, code, len)));
+}
+
+DET_EXPORT(qjs_det_compile) {
+  DET_BEGIN(3);
+  uint32_t handle = arg_u32(&call, 0);
+  uint32_t len = arg_u32(&call, 2);
+  const char *code = arg_ptr(&call, 1, len + 1);
+  DET_RETURN(ret_ptr(&call, qjs_det_compile(handle, code, len)));
+}
+
+DET_EXPORT(qjs_det_eval_bytecode) {
+  DET_BEGIN(3);
+  uint32_t handle = arg_u32(&call, 0);
+  uint32_t len = arg_u32(&call, 2);
+  const uint8_t *artifact = arg_ptr(&call, 1, len);
+  DET_RETURN(ret_ptr(&call, qjs_det_eval_bytecode(handle, artifact, len)));
+}
+
+DET_EXPORT(qjs_det_memoize_host_fn) {
+  DET_BEGIN(2);
+  uint32_t handle = arg_u32(&call, 0);
+  uint32_t fn_id = arg_u32(&call, 1);
+  DET_RETURN(ret_i32(&call, qjs_det_memoize_host_fn(handle, fn_id)));
+}
+
+DET_EXPORT(qjs_det_set_gas_limit) {
+  DET_BEGIN(2);
+  uint32_t handle = arg_u32(&call, 0);
+  uint64_t gas_limit = arg_u64(&call, 1);
+  DET_RETURN(ret_i32(&call, qjs_det_set_gas_limit(handle, gas_limit)));
+}
+
+DET_EXPORT(qjs_det_free) {
+  DET_BEGIN(1);
+  uint32_t handle = arg_u32(&call, 0);
+  DET_RETURN((qjs_det_free(handle), ret_void(&call)));
+}
+
+DET_EXPORT(qjs_det_free_all) {
+  DET_BEGIN(0);
+  DET_RETURN((qjs_det_free_all(), ret_void(&call)));
+}
+
+DET_EXPORT(qjs_det_snapshot) {
+  DET_BEGIN(1);
+  uint32_t handle = arg_u32(&call, 0);
+  DET_RETURN(ret_u32(&call, qjs_det_snapshot(handle)));
+}
+
+DET_EXPORT(qjs_det_restore) {
+  DET_BEGIN(4);
+  uint32_t handle = arg_u32(&call, 0);
+  uint64_t gas_limit = arg_u64(&call, 1);
+  uint32_t context_size = arg_u32(&call, 3);
+  const uint8_t *context = arg_ptr(&call, 2, context_size);
+  DET_RETURN(ret_i32(&call, qjs_det_restore(handle, gas_limit, context, context_size)));
+}
+
+DET_EXPORT(qjs_det_session_begin) {
+  DET_BEGIN(3);
+  uint32_t handle = arg_u32(&call, 0);
+  uint32_t len = arg_u32(&call, 2);
+  const char *prelude = arg_ptr(&call, 1, len + 1);
+  DET_RETURN(ret_ptr(&call, qjs_det_session_begin(handle, prelude, len)));
+}
+
+DET_EXPORT(qjs_det_heap_top) {
+  DET_BEGIN(0);
+  DET_RETURN(ret_u32(&call, qjs_det_heap_top()));
+}
+
+DET_EXPORT(qjs_det_enable_tape) {
+  DET_BEGIN(2);
+  uint32_t handle = arg_u32(&call, 0);
+  uint32_t capacity = arg_u32(&call, 1);
+  DET_RETURN(ret_i32(&call, qjs_det_enable_tape(handle, capacity)));
+}
+
+DET_EXPORT(qjs_det_stream_tape) {
+  DET_BEGIN(2);
+  uint32_t handle = arg_u32(&call, 0);
+  int32_t enabled = arg_i32(&call, 1);
+  DET_RETURN(ret_i32(&call, qjs_det_stream_tape(handle, enabled)));
+}
+
+DET_EXPORT(qjs_det_flush_tape) {
+  DET_BEGIN(1);
+  uint32_t handle = arg_u32(&call, 0);
+  DET_RETURN(ret_i32(&call, qjs_det_flush_tape(handle)));
+}
+
+DET_EXPORT(qjs_det_read_tape) {
+  DET_BEGIN(1);
+  uint32_t handle = arg_u32(&call, 0);
+  DET_RETURN(ret_ptr(&call, qjs_det_read_tape(handle)));
+}
+
+DET_EXPORT(qjs_det_read_tape_bin) {
+  DET_BEGIN(3);
+  uint32_t handle = arg_u32(&call, 0);
+  uint32_t capacity = arg_u32(&call, 2);
+  uint8_t *out = arg_ptr(&call, 1, capacity);
+  DET_RETURN(ret_i32(&call, qjs_det_read_tape_bin(handle, out, capacity)));
+}
+
+DET_EXPORT(qjs_det_enable_trace) {
+  DET_BEGIN(2);
+  uint32_t handle = arg_u32(&call, 0);
+  int32_t mode = arg_i32(&call, 1);
+  DET_RETURN(ret_i32(&call, qjs_det_enable_trace(handle, mode)));
+}
+
+DET_EXPORT(qjs_det_read_trace) {
+  DET_BEGIN(1);
+  uint32_t handle = arg_u32(&call, 0);
+  DET_RETURN(ret_ptr(&call, qjs_det_read_trace(handle)));
+}
+
+DET_EXPORT(qjs_det_read_trace_bin) {
+  DET_BEGIN(3);
+  uint32_t handle = arg_u32(&call, 0);
+  uint32_t capacity = arg_u32(&call, 2);
+  uint8_t *out = arg_ptr(&call, 1, capacity);
+  DET_RETURN(ret_i32(&call, qjs_det_read_trace_bin(handle, out, capacity)));
+}
+
+DET_EXPORT(qjs_det_read_host_gas_bin) {
+  DET_BEGIN(3);
+  uint32_t handle = arg_u32(&call, 0);
+  uint32_t capacity = arg_u32(&call, 2);
+  uint8_t *out = arg_ptr(&call, 1, capacity);
+  DET_RETURN(ret_i32(&call, qjs_det_read_host_gas_bin(handle, out, capacity)));
+}
+
+DET_EXPORT(qjs_det_read_calibration_bin) {
+  DET_BEGIN(3);
+  uint32_t handle = arg_u32(&call, 0);
+  uint32_t capacity = arg_u32(&call, 2);
+  uint8_t *out = arg_ptr(&call, 1, capacity);
+  DET_RETURN(ret_i32(&call, qjs_det_read_calibration_bin(handle, out, capacity)));
+}
+
+#define DET_METHOD(name) {#name, NULL, js_##name, NULL, NULL, NULL, napi_enumerable, NULL}
+
+NAPI_MODULE_INIT() {
+  napi_value region_size;
+  napi_property_descriptor methods[] = {
+      {"createInstance", NULL, js_create_instance, NULL, NULL, NULL, napi_enumerable, NULL},
+      DET_METHOD(malloc),
+      DET_METHOD(free),
+      DET_METHOD(qjs_det_input_buffer),
+      DET_METHOD(qjs_det_set_manifest),
+      DET_METHOD(qjs_det_use_arena),
+      DET_METHOD(qjs_det_init),
+      DET_METHOD(qjs_det_take_init_error),
+      DET_METHOD(qjs_det_eval),
+      DET_METHOD(qjs_det_eval_bin),
+      DET_METHOD(qjs_det_compile),
+      DET_METHOD(qjs_det_eval_bytecode),
+      DET_METHOD(qjs_det_memoize_host_fn),
+      DET_METHOD(qjs_det_set_gas_limit),
+      DET_METHOD(qjs_det_free),
+      DET_METHOD(qjs_det_free_all),
+      DET_METHOD(qjs_det_snapshot),
+      DET_METHOD(qjs_det_restore),
+      DET_METHOD(qjs_det_session_begin),
+      DET_METHOD(qjs_det_heap_top),
+      DET_METHOD(qjs_det_enable_tape),
+      DET_METHOD(qjs_det_stream_tape),
+      DET_METHOD(qjs_det_flush_tape),
+      DET_METHOD(qjs_det_read_tape),
+      DET_METHOD(qjs_det_read_tape_bin),
+      DET_METHOD(qjs_det_enable_trace),
+      DET_METHOD(qjs_det_read_trace),
+      DET_METHOD(qjs_det_read_trace_bin),
+      DET_METHOD(qjs_det_read_host_gas_bin),
+      DET_METHOD(qjs_det_read_calibration_bin),
+  };
+
+  if (napi_define_properties(env, exports, sizeof(methods) / sizeof(methods[0]), methods) !=
+      napi_ok) {
+    return NULL;
+  }
+  if (napi_create_uint32(env, qjs_det_native_region_size(), &region_size) != napi_ok ||
+      napi_set_named_property(env, exports, "regionSize", region_size) != napi_ok) {
+    return NULL;
+  }
+  return exports;
+}
@@ -0,0 +1,71 @@
+#ifndef QUICKJS_DET_NATIVE_H
+#define QUICKJS_DET_NATIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Native build of the deterministic shim (libs/quickjs-wasm-build/src/wasm/
+   quickjs_wasm.c), shared with the N-API glue. Every export below keeps its
+   wasm signature; the glue turns the embedder's 32-bit heap offsets into
+   pointers into the current state's region and back. */
+
+#define EMSCRIPTEN_KEEPALIVE __attribute__((visibility("default")))
+
+typedef struct DetEvalResult DetEvalResult;
+typedef struct DetState DetState;
+
+/* Host imports, implemented by the glue for the instance being called. */
+uint32_t host_call(uint32_t fn_id,
+                   uint32_t req_ptr,
+                   uint32_t req_len,
+                   uint32_t resp_ptr,
+                   uint32_t resp_capacity);
+void tape_sink(uint32_t handle, uint32_t records_ptr, uint32_t count);
+
+/* Region lifecycle. A state is the base of its region; exports act on the
+   state made current with qjs_det_native_enter on the calling thread. */
+DetState *qjs_det_native_state_new(void);
+void qjs_det_native_state_free(DetState *state);
+DetState *qjs_det_native_enter(DetState *state);
+uint32_t qjs_det_native_region_size(void);
+
+void *det_malloc(size_t size);
+void det_free(void *ptr);
+
+uint8_t *qjs_det_input_buffer(uint32_t capacity);
+int qjs_det_set_manifest(const uint8_t *manifest_bytes, uint32_t manifest_size);
+int qjs_det_use_arena(int enabled);
+uint32_t qjs_det_init(const uint8_t *manifest_bytes,
+                      uint32_t manifest_size,
+                      const char *manifest_hash_hex,
+                      const uint8_t *context_blob,
+                      uint32_t context_blob_size,
+                      uint64_t gas_limit);
+char *qjs_det_take_init_error(void);
+char *qjs_det_eval(uint32_t handle, const char *code);
+const DetEvalResult *qjs_det_eval_bin(uint32_t handle, const char *code, uint32_t code_len);
+const DetEvalResult *qjs_det_compile(uint32_t handle, const char *code, uint32_t code_len);
+const DetEvalResult *qjs_det_eval_bytecode(uint32_t handle, const uint8_t *artifact,
+                                           uint32_t artifact_len);
+int qjs_det_memoize_host_fn(uint32_t handle, uint32_t fn_id);
+int qjs_det_set_gas_limit(uint32_t handle, uint64_t gas_limit);
+void qjs_det_free(uint32_t handle);
+void qjs_det_free_all(void);
+uint32_t qjs_det_snapshot(uint32_t handle);
+int qjs_det_restore(uint32_t handle, uint64_t gas_limit,
+                    const uint8_t *context_blob, uint32_t context_blob_size);
+const DetEvalResult *qjs_det_session_begin(uint32_t handle, const char *prelude,
+                                           uint32_t prelude_len);
+uint32_t qjs_det_heap_top(void);
+int qjs_det_enable_tape(uint32_t handle, uint32_t capacity);
+int qjs_det_stream_tape(uint32_t handle, int enabled);
+int qjs_det_flush_tape(uint32_t handle);
+char *qjs_det_read_tape(uint32_t handle);
+int32_t qjs_det_read_tape_bin(uint32_t handle, uint8_t *out, uint32_t capacity);
+int qjs_det_enable_trace(uint32_t handle, int mode);
+char *qjs_det_read_trace(uint32_t handle);
+int32_t qjs_det_read_trace_bin(uint32_t handle, uint8_t *out, uint32_t capacity);
+int32_t qjs_det_read_host_gas_bin(uint32_t handle, uint8_t *out, uint32_t capacity);
+int32_t qjs_det_read_calibration_bin(uint32_t handle, uint8_t *out, uint32_t capacity);
+
+#endif
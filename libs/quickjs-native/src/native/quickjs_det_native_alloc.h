@@ -0,0 +1,40 @@
+#ifndef QUICKJS_DET_NATIVE_ALLOC_H
+#define QUICKJS_DET_NATIVE_ALLOC_H
+
+/* Force-included (-include) into every QuickJS and shim source of the native
+   addon. The shim's allocator entry points carve memory out of the current
+   instance's region; renaming the calls here keeps them out of the symbol
+   namespace of the host process, whose own malloc stays untouched. libc is
+   still reachable through det_libc_*, for pointers that libc handed out. */
+
+#include <stdlib.h>
+#ifdef __linux__
+#include <malloc.h>
+#endif
+
+static inline void det_libc_free(void *ptr) { free(ptr); }
+
+static inline void *det_libc_realloc(void *ptr, size_t size) { return realloc(ptr, size); }
+
+static inline size_t det_libc_usable_size(void *ptr) {
+#ifdef __linux__
+  return malloc_usable_size(ptr);
+#else
+  (void)ptr;
+  return 0;
+#endif
+}
+
+void *det_malloc(size_t size);
+void det_free(void *ptr);
+void *det_calloc(size_t count, size_t size);
+void *det_realloc(void *ptr, size_t size);
+size_t det_malloc_usable_size(void *ptr);
+
+#define malloc det_malloc
+#define free det_free
+#define calloc det_calloc
+#define realloc det_realloc
+#define malloc_usable_size det_malloc_usable_size
+
+#endif
@@ -3,3 +3,6 @@ export * from './lib/host-dispatcher.js';
 export * from './lib/runtime.js';
 export * from './lib/deterministic-init.js';
 export * from './lib/evaluate.js';
+export * from './lib/host-gas.js';
+export * from './lib/runtime-pool.js';
+export * from './lib/parallel-evaluator.js';
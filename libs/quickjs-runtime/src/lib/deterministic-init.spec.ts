@@ -1,6 +1,10 @@
 import { decodeDv } from '@blue-quickjs/dv';
 import { HOST_V1_HASH, HOST_V1_MANIFEST } from '@blue-quickjs/test-harness';
-import { initializeDeterministicVm } from './deterministic-init.js';
+import {
+  createDeterministicSession,
+  initializeDeterministicVm,
+  restoreDeterministicVm,
+} from './deterministic-init.js';
 import type { HostDispatcherHandlers } from './host-dispatcher.js';
 import { parseHexToBytes } from './hex-utils.js';
 import { createRuntime } from './runtime.js';
@@ -87,6 +91,323 @@ describe('initializeDeterministicVm', () => {
       ),
     ).toThrow(/manifest hash/i);
   });
+
+  it('grows the input arena for larger context blobs', async () => {
+    const runtime = await createRuntime({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const large = 'x'.repeat(20_000);
+
+    for (const name of ['small', large, 'small again']) {
+      const vm = initializeDeterministicVm(
+        runtime,
+        BASE_PROGRAM,
+        { ...BASE_INPUT, steps: [{ name }] },
+        TEST_GAS_LIMIT,
+      );
+      try {
+        expect(parseEvalOutput(vm.eval('steps[0].name')).value).toBe(name);
+      } finally {
+        vm.dispose();
+      }
+    }
+  });
+
+  it('keeps several live VMs in one runtime independent', async () => {
+    const runtime = await createRuntime({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const first = initializeDeterministicVm(
+      runtime,
+      BASE_PROGRAM,
+      BASE_INPUT,
+      TEST_GAS_LIMIT,
+    );
+    const second = initializeDeterministicVm(
+      runtime,
+      BASE_PROGRAM,
+      { ...BASE_INPUT, steps: [{ name: 'second' }] },
+      TEST_GAS_LIMIT,
+    );
+    try {
+      first.eval('globalThis.counter = 1; 0');
+      expect(
+        parseEvalOutput(second.eval('typeof globalThis.counter')).value,
+      ).toBe('undefined');
+      expect(parseEvalOutput(first.eval('steps[0].name')).value).toBe(
+        'first',
+      );
+      expect(parseEvalOutput(second.eval('steps[0].name')).value).toBe(
+        'second',
+      );
+      expect(() => first.snapshot()).toThrow(/only live VM/);
+    } finally {
+      first.dispose();
+    }
+    expect(parseEvalOutput(second.eval('1 + 1')).value).toBe(2);
+    second.dispose();
+    expect(() => first.eval('1')).toThrow(/released/);
+  });
+
+  it('reads the same tape and gas trace through the binary readout', async () => {
+    const runtime = await createRuntime({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers({
+        document: {
+          get: (path: string) =>
+            path === 'missing'
+              ? { err: { code: 'NOT_FOUND', tag: 'host/not_found' }, units: 2 }
+              : { ok: { path }, units: 5 },
+          getCanonical: (path: string) => ({ ok: path, units: 3 }),
+        },
+      }),
+    });
+    const vm = initializeDeterministicVm(
+      runtime,
+      BASE_PROGRAM,
+      BASE_INPUT,
+      TEST_GAS_LIMIT,
+    );
+    try {
+      vm.enableTape(8);
+      vm.enableGasTrace(true);
+      vm.evalBinary('try { document("missing"); } catch {} document("a")');
+
+      const json = JSON.parse(vm.readTape()) as Record<string, unknown>[];
+      expect(vm.readTapeRecords()).toEqual(
+        json.map((record) => ({
+          ...record,
+          gasPre: BigInt(record.gasPre as string),
+          gasPost: BigInt(record.gasPost as string),
+        })),
+      );
+      expect(vm.readTapeRecords().map((record) => record.isError)).toEqual([
+        true,
+        false,
+      ]);
+
+      const trace = JSON.parse(vm.readGasTrace()) as Record<string, string>;
+      expect(vm.readGasTraceCounters()).toEqual(
+        Object.fromEntries(
+          Object.entries(trace).map(([key, value]) => [key, BigInt(value)]),
+        ),
+      );
+      expect(vm.readGasTraceCounters().opcodeCount).toBeGreaterThan(0n);
+    } finally {
+      vm.dispose();
+    }
+  });
+});
+
+describe('restoreDeterministicVm', () => {
+  it('resumes a snapshot with the same results and gas as a fresh init', async () => {
+    const runtime = await createRuntime({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const code = '({ doc: document("path/to/doc"), event, steps })';
+
+    const fresh = initializeDeterministicVm(
+      runtime,
+      BASE_PROGRAM,
+      BASE_INPUT,
+      TEST_GAS_LIMIT,
+    );
+    const snapshot = fresh.snapshot();
+    const expected = fresh.eval(code);
+    fresh.dispose();
+
+    for (let i = 0; i < 2; i += 1) {
+      const restored = restoreDeterministicVm(
+        runtime,
+        snapshot,
+        TEST_GAS_LIMIT,
+      );
+      try {
+        expect(restored.eval(code)).toBe(expected);
+      } finally {
+        restored.dispose();
+      }
+    }
+  });
+
+  it('does not carry state from an earlier run into the restored VM', async () => {
+    const runtime = await createRuntime({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const vm = initializeDeterministicVm(
+      runtime,
+      BASE_PROGRAM,
+      BASE_INPUT,
+      TEST_GAS_LIMIT,
+    );
+    const snapshot = vm.snapshot();
+    vm.eval('globalThis.leaked = 1; 0');
+
+    const restored = restoreDeterministicVm(runtime, snapshot, TEST_GAS_LIMIT);
+    try {
+      const parsed = parseEvalOutput(restored.eval('typeof globalThis.leaked'));
+      expect(parsed.value).toBe('undefined');
+    } finally {
+      restored.dispose();
+    }
+  });
+
+  it('re-injects a different input envelope into the restored VM', async () => {
+    const runtime = await createRuntime({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const vm = initializeDeterministicVm(
+      runtime,
+      BASE_PROGRAM,
+      BASE_INPUT,
+      TEST_GAS_LIMIT,
+    );
+    const snapshot = vm.snapshot();
+    vm.dispose();
+
+    const input: InputEnvelope = {
+      event: { type: 'update', payload: { id: 2 } },
+      eventCanonical: { type: 'update', payload: { id: 2 } },
+      steps: [{ name: 'second' }],
+    };
+    const code =
+      '({ type: event.type, id: eventCanonical.payload.id, step: steps[0].name, frozen: Object.isFrozen(event.payload) })';
+    const restored = restoreDeterministicVm(
+      runtime,
+      snapshot,
+      TEST_GAS_LIMIT,
+      input,
+    );
+    try {
+      expect(parseEvalOutput(restored.eval(code)).value).toEqual({
+        type: 'update',
+        id: 2,
+        step: 'second',
+        frozen: true,
+      });
+    } finally {
+      restored.dispose();
+    }
+  });
+
+  it('rejects snapshots after eval and across wasm modules', async () => {
+    const runtime = await createRuntime({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const vm = initializeDeterministicVm(
+      runtime,
+      BASE_PROGRAM,
+      BASE_INPUT,
+      TEST_GAS_LIMIT,
+    );
+    const snapshot = vm.snapshot();
+    vm.eval('1');
+    expect(() => vm.snapshot()).toThrow(/freshly initialized/);
+    vm.dispose();
+
+    expect(() =>
+      restoreDeterministicVm(
+        runtime,
+        { ...snapshot, wasmModule: {} },
+        TEST_GAS_LIMIT,
+      ),
+    ).toThrow(/different wasm module/);
+  });
+});
+
+describe('createDeterministicSession', () => {
+  it('meters each step like a standalone evaluation', async () => {
+    const runtime = await createRuntime({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const code = 'const doc = document("path/to/doc"); ({ doc, event })';
+
+    const fresh = initializeDeterministicVm(
+      runtime,
+      BASE_PROGRAM,
+      BASE_INPUT,
+      TEST_GAS_LIMIT,
+    );
+    const expected = fresh.evalBinary(code);
+    const expectedPayload = expected.payload.slice();
+    fresh.dispose();
+
+    const session = createDeterministicSession(
+      runtime,
+      BASE_PROGRAM,
+      BASE_INPUT,
+    );
+    try {
+      for (let i = 0; i < 3; i += 1) {
+        const step = session.run(code, TEST_GAS_LIMIT);
+        expect(step.kind).toBe('result');
+        expect(step.payload).toEqual(expectedPayload);
+        expect(step.gasUsed).toBe(expected.gasUsed);
+        expect(step.gasRemaining).toBe(expected.gasRemaining);
+      }
+      expect(session.steps).toBe(3);
+    } finally {
+      session.dispose();
+    }
+  });
+
+  it('shares the prelude but resets step scope', async () => {
+    const runtime = await createRuntime({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const session = createDeterministicSession(
+      runtime,
+      BASE_PROGRAM,
+      BASE_INPUT,
+      { prelude: 'function validate(x) { return x.type === "create"; }' },
+    );
+    try {
+      const first = session.run(
+        'globalThis.leaked = 1; validate(event)',
+        TEST_GAS_LIMIT,
+      );
+      expect(decodeDv(first.payload)).toBe(true);
+
+      const second = session.run(
+        '[typeof leaked, typeof validate]',
+        TEST_GAS_LIMIT,
+      );
+      expect(decodeDv(second.payload)).toEqual(['undefined', 'function']);
+    } finally {
+      session.dispose();
+    }
+  });
+
+  it('applies a separate gas limit per step', async () => {
+    const runtime = await createRuntime({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const session = createDeterministicSession(
+      runtime,
+      BASE_PROGRAM,
+      BASE_INPUT,
+    );
+    try {
+      const starved = session.run('let n = 0; while (true) { n += 1; }', 50n);
+      expect(starved.kind).toBe('error');
+      expect(new TextDecoder().decode(starved.payload)).toMatch(/out of gas/);
+
+      const next = session.run('1 + 2', TEST_GAS_LIMIT);
+      expect(next.kind).toBe('result');
+      expect(next.gasUsed + next.gasRemaining).toBe(TEST_GAS_LIMIT);
+    } finally {
+      session.dispose();
+    }
+  });
 });
 
 function createHandlers(
@@ -1,16 +1,45 @@
-import { encodeAbiManifest } from '@blue-quickjs/abi-manifest';
-import { encodeDv } from '@blue-quickjs/dv';
+import {
+  type CanonicalAbiManifest,
+  encodeAbiManifest,
+  hashAbiManifest,
+} from '@blue-quickjs/abi-manifest';
+import { DV_LIMIT_DEFAULTS, DvEncoder } from '@blue-quickjs/dv';
+import type { QuickjsWasmCompiledModule } from '@blue-quickjs/quickjs-wasm';
 import type { QuickjsWasmModule } from './runtime.js';
 import {
+  type BytecodeProgramArtifact,
   type InputEnvelope,
   type ProgramArtifact,
+  type SourceProgramArtifact,
+  authenticateBytecode,
+  hashBytecode,
+  isBytecodeProgram,
+  macBytecode,
   validateInputEnvelope,
   validateProgramArtifact,
 } from './quickjs-runtime.js';
-import type { RuntimeInstance } from './runtime.js';
+import {
+  type RuntimeInstance,
+  setTapeSink,
+  withSuspendableHostCalls,
+} from './runtime.js';
+import { type HostGasBreakdown, decodeHostGasBreakdown } from './host-gas.js';
+import { bytesToHex } from './hex-utils.js';
 
 const UTF8_ENCODER = new TextEncoder();
+const UTF8_DECODER = new TextDecoder();
 const UINT64_MAX = (1n << 64n) - 1n;
+const EXPORTS_CACHE = new WeakMap<QuickjsWasmModule, DeterministicExports>();
+const MANIFEST_HASHES = new WeakMap<CanonicalAbiManifest, string>();
+const LIVE_VMS = new WeakMap<QuickjsWasmModule, Set<VmState>>();
+const VM_STATES = new WeakMap<DeterministicVm, VmState>();
+const INSTALLED_MANIFESTS = new WeakSet<QuickjsWasmModule>();
+// Compilation never reads the context blob; any valid envelope will do.
+const COMPILE_INPUT: InputEnvelope = {
+  event: null,
+  eventCanonical: null,
+  steps: [],
+};
 
 type DetInitFn = (
   manifestPtr: number,
@@ -21,34 +50,236 @@ type DetInitFn = (
   gasLimit: bigint,
 ) => number;
 
-type DetEvalFn = (code: string) => number;
-type DetSetGasLimitFn = (gasLimit: bigint) => number;
-type EnableTapeFn = (capacity: number) => number;
-type ReadTapeFn = () => number;
-type EnableTraceFn = (enabled: number) => number;
-type ReadTraceFn = () => number;
+type DetInputBufferFn = (capacity: number) => number;
+type DetSetManifestFn = (manifestPtr: number, manifestLength: number) => number;
+type DetEvalFn = (handle: number, code: string) => number;
+type DetEvalBinFn = (
+  handle: number,
+  codePtr: number,
+  codeLength: number,
+) => number;
+type DetCompileFn = (
+  handle: number,
+  codePtr: number,
+  codeLength: number,
+) => number;
+type DetEvalBytecodeFn = (
+  handle: number,
+  artifactPtr: number,
+  artifactLength: number,
+) => number;
+type AsyncExport<F extends (...args: never[]) => number> = (
+  ...args: Parameters<F>
+) => Promise<number>;
+type DetUseArenaFn = (enabled: number) => number;
+type DetSetGasLimitFn = (handle: number, gasLimit: bigint) => number;
+type DetMemoizeHostFnFn = (handle: number, fnId: number) => number;
+type DetFreeFn = (handle: number) => void;
+type EnableTapeFn = (handle: number, capacity: number) => number;
+type ReadTapeFn = (handle: number) => number;
+type EnableTraceFn = (handle: number, enabled: number) => number;
+type ReadTraceFn = (handle: number) => number;
+type ReadBinFn = (handle: number, outPtr: number, capacity: number) => number;
+type StreamTapeFn = (handle: number, enabled: number) => number;
+type FlushTapeFn = (handle: number) => number;
+type DetSnapshotFn = (handle: number) => number;
+type DetRestoreFn = (
+  handle: number,
+  gasLimit: bigint,
+  contextPtr: number,
+  contextLength: number,
+) => number;
+type DetHeapTopFn = () => number;
+type DetSessionBeginFn = (
+  handle: number,
+  preludePtr: number,
+  preludeLength: number,
+) => number;
 
 interface DeterministicExports {
   init: DetInitFn;
+  takeInitError: () => number;
+  inputBuffer: DetInputBufferFn;
+  setManifest: DetSetManifestFn;
+  useArena: DetUseArenaFn;
   eval: DetEvalFn;
+  evalBin: DetEvalBinFn;
+  evalBinAsync: AsyncExport<DetEvalBinFn>;
+  compile: DetCompileFn;
+  evalBytecode: DetEvalBytecodeFn;
+  evalBytecodeAsync: AsyncExport<DetEvalBytecodeFn>;
   setGasLimit: DetSetGasLimitFn;
-  freeRuntime: () => void;
+  memoizeHostFn: DetMemoizeHostFnFn;
+  free: DetFreeFn;
+  freeAll: () => void;
+  snapshot: DetSnapshotFn;
+  restore: DetRestoreFn;
+  heapTop: DetHeapTopFn;
+  sessionBegin: DetSessionBeginFn;
   enableTape: EnableTapeFn;
   readTape: ReadTapeFn;
+  readTapeBin: ReadBinFn;
+  streamTape: StreamTapeFn;
+  flushTape: FlushTapeFn;
   enableTrace: EnableTraceFn;
   readTrace: ReadTraceFn;
+  readTraceBin: ReadBinFn;
+  readHostGasBin: ReadBinFn;
+  readCalibrationBin: ReadBinFn;
+}
+
+/**
+ * Liveness of one shim handle. Restoring a snapshot or freeing the runtime's
+ * VMs releases every tracked state, so stale `DeterministicVm` objects throw
+ * instead of reaching a handle that now names a different VM.
+ */
+type VmState = {
+  handle: number;
+  released: boolean;
+};
+
+/**
+ * Result read from the `qjs_det_eval_bin` struct. `payload` is a view into
+ * wasm memory (DV bytes for results, UTF-8 message for errors) that stays
+ * valid only until the next eval or dispose.
+ */
+export interface DeterministicEvalResult {
+  kind: 'result' | 'error';
+  payload: Uint8Array;
+  gasRemaining: bigint;
+  gasUsed: bigint;
 }
 
 export interface DeterministicVm {
+  /**
+   * Text channel (`RESULT <dv-hex> GAS …`); kept for debugging and harness
+   * parity. Prefer `evalBinary` for production reads.
+   */
   eval(code: string): string;
+  evalBinary(code: string): DeterministicEvalResult;
+  /**
+   * Run a `qjs_det_compile` artifact (see `compileProgram`). Same result shape
+   * and gas accounting as `evalBinary`, minus the parse/compile charges.
+   * `mac` is the artifact's `bytecodeMac`; bytes it does not authenticate
+   * throw before reaching the engine (see `setBytecodeKey`).
+   */
+  evalBytecode(bytecode: Uint8Array, mac: string): DeterministicEvalResult;
+  /**
+   * `evalBinary` for the `async` build type: host handlers may return
+   * promises, which suspend the VM until they settle. Gas and tape match the
+   * synchronous call. On other build types this simply wraps `evalBinary`.
+   */
+  evalBinaryAsync(code: string): Promise<DeterministicEvalResult>;
+  evalBytecodeAsync(
+    bytecode: Uint8Array,
+    mac: string,
+  ): Promise<DeterministicEvalResult>;
+  /**
+   * Compile code to a bytecode artifact without running it (unmetered).
+   * Returns a copy owned by the caller.
+   */
+  compile(code: string): Uint8Array;
   setGasLimit(limit: bigint | number): void;
   enableTape(capacity: number): void;
+  /**
+   * JSON tape built inside the VM; kept for harness parity. Prefer
+   * `readTapeRecords`, which copies packed structs out without touching the
+   * VM heap.
+   */
   readTape(): string;
-  enableGasTrace(enabled: boolean): void;
+  readTapeRecords(): HostTapeRecord[];
+  /**
+   * Stream the tape instead of keeping a ring: records are handed to
+   * `onRecords` at every host-call boundary, so VM memory stays constant
+   * however many calls a run makes. Replaces `enableTape`; call `flushTape`
+   * after each eval for the remaining records.
+   */
+  streamTape(onRecords: (records: HostTapeRecord[]) => void): void;
+  /**
+   * Deliver the records still in the VM to the `streamTape` callback, then
+   * rethrow the first error that callback raised since the last flush.
+   */
+  flushTape(): void;
+  /**
+   * `hostGas` also records host-call gas per function (see `readHostGas`).
+   * It reads host-call gas off the tape, so it cannot be combined with
+   * `enableTape`; `streamTape` is fine.
+   */
+  enableGasTrace(enabled: boolean, options?: { hostGas?: boolean }): void;
   readGasTrace(): string;
+  readGasTraceCounters(): GasTrace;
+  /**
+   * Gas per host function since `enableGasTrace(true, { hostGas: true })`.
+   */
+  readHostGas(): HostGasBreakdown;
+  /**
+   * Wall-clock counters accumulated since the previous read, which resets
+   * them. Only the out-of-band `calibration` build records them; every other
+   * build throws.
+   */
+  readCalibrationCounters(): CalibrationCounters;
+  /**
+   * Capture the linear-memory image of this VM. Only valid right after init
+   * (before any eval) while it is the only live VM in the runtime; restore it
+   * with `restoreDeterministicVm`.
+   */
+  snapshot(): DeterministicVmSnapshot;
   dispose(): void;
 }
 
+export interface HostTapeRecord {
+  fnId: number;
+  reqLen: number;
+  respLen: number;
+  units: number;
+  gasPre: bigint;
+  gasPost: bigint;
+  isError: boolean;
+  chargeFailed: boolean;
+  reqHash: string;
+  respHash: string;
+}
+
+export interface GasTrace {
+  opcodeCount: bigint;
+  opcodeGas: bigint;
+  arrayCbBaseCount: bigint;
+  arrayCbBaseGas: bigint;
+  arrayCbPerElCount: bigint;
+  arrayCbPerElGas: bigint;
+  allocationCount: bigint;
+  allocationBytes: bigint;
+  allocationGas: bigint;
+}
+
+/**
+ * Timings from the `calibration` build. `evalNs` covers whole eval exports
+ * and includes `hostNs` (host_call import, memo hits excluded) and `gcNs`.
+ */
+export interface CalibrationCounters {
+  evals: bigint;
+  evalNs: bigint;
+  hostCalls: bigint;
+  hostNs: bigint;
+  gcCheckpoints: bigint;
+  gcNs: bigint;
+}
+
+/**
+ * Linear-memory image of a freshly initialized VM. The image bakes in the
+ * manifest, manifest hash and context blob used at init; restore re-arms the
+ * gas limit and can swap in a different input envelope.
+ */
+export interface DeterministicVmSnapshot {
+  readonly wasmModule: QuickjsWasmCompiledModule;
+  readonly abiManifestHash: string;
+  /**
+   * Handle of the snapshotted VM; restoring revives it under this handle.
+   */
+  readonly vmHandle: number;
+  readonly image: Uint8Array;
+}
+
 export function initializeDeterministicVm(
   runtime: RuntimeInstance,
   program: ProgramArtifact,
@@ -59,55 +290,480 @@ export function initializeDeterministicVm(
   const validatedProgram = validateProgramArtifact(program);
   const validatedInput = validateInputEnvelope(input);
 
-  const manifestBytes = encodeAbiManifest(runtime.manifest);
-  const contextBlob = encodeDv({
-    event: validatedInput.event,
-    eventCanonical: validatedInput.eventCanonical,
-    steps: validatedInput.steps,
-  });
+  const ffi = getDeterministicExports(runtime.module);
+  installManifest(runtime, ffi);
 
-  const ffi = createDeterministicExports(runtime.module);
-  const manifestPtr = writeBytes(runtime.module, manifestBytes);
-  const contextPtr =
-    contextBlob.length > 0 ? writeBytes(runtime.module, contextBlob) : 0;
-  const hashPtr = writeCString(
-    runtime.module,
+  // Arena layout: NUL-terminated manifest hash, then the context blob at an
+  // 8-byte aligned offset. Both are consumed by qjs_det_init.
+  const hashBytes = UTF8_ENCODER.encode(validatedProgram.abiManifestHash);
+  const contextOffset = alignTo8(hashBytes.length + 1);
+  const { arenaPtr, contextLength } = encodeContextIntoArena(
+    runtime,
+    ffi,
+    contextOffset,
+    {
+      event: validatedInput.event,
+      eventCanonical: validatedInput.eventCanonical,
+      steps: validatedInput.steps,
+    },
+  );
+  const heap = runtime.module.HEAPU8;
+  heap.set(hashBytes, arenaPtr);
+  heap[arenaPtr + hashBytes.length] = 0;
+
+  ffi.useArena(runtime.allocator === 'arena' ? 1 : 0);
+  const handle = ffi.init(
+    0,
+    0,
+    arenaPtr,
+    contextLength > 0 ? arenaPtr + contextOffset : 0,
+    contextLength,
+    normalizedGasLimit,
+  );
+  if (handle === 0) {
+    const errorPtr = ffi.takeInitError();
+    const message =
+      errorPtr === 0
+        ? 'unknown error'
+        : readAndFreeCString(runtime.module, errorPtr);
+    throw new Error(`VM init failed: ${message}`);
+  }
+
+  // Pure host functions are replayed by the shim for identical requests
+  // within one evaluation; gas and tape records are unaffected.
+  for (const fn of runtime.manifest.functions) {
+    if (fn.pure && ffi.memoizeHostFn(handle, fn.fn_id) !== 0) {
+      ffi.free(handle);
+      throw new Error(`qjs_det_memoize_host_fn failed for fn_id=${fn.fn_id}`);
+    }
+  }
+
+  return createVmHandle(
+    runtime,
+    ffi,
+    trackVm(runtime.module, handle),
     validatedProgram.abiManifestHash,
   );
+}
 
-  try {
-    const errorPtr = ffi.init(
-      manifestPtr,
-      manifestBytes.length,
-      hashPtr,
-      contextPtr,
-      contextBlob.length,
-      normalizedGasLimit,
+/**
+ * Compile a source program into a bytecode artifact pinned to this runtime's
+ * engine build and gas version. Compilation runs in a throwaway VM outside any
+ * metered run; evaluating the artifact bills execution only, so its gasUsed is
+ * lower than the source form's (which also pays parse/compile allocations).
+ */
+export function compileProgram(
+  runtime: RuntimeInstance,
+  program: SourceProgramArtifact,
+): BytecodeProgramArtifact {
+  const validated = validateProgramArtifact(program);
+  if (isBytecodeProgram(validated)) {
+    throw new Error('program is already compiled to bytecode');
+  }
+  const engineBuildHash =
+    runtime.artifact.variantMetadata.engineBuildHash ??
+    runtime.metadata.engineBuildHash;
+  if (!engineBuildHash) {
+    throw new Error(
+      'Engine build hash is unavailable; cannot pin compiled bytecode',
     );
-    if (errorPtr !== 0) {
-      const message = readAndFreeCString(runtime.module, errorPtr);
-      ffi.freeRuntime();
-      throw new Error(`VM init failed: ${message}`);
-    }
+  }
+  if (
+    validated.engineBuildHash !== undefined &&
+    validated.engineBuildHash !== engineBuildHash
+  ) {
+    throw new Error(
+      `engineBuildHash mismatch: program=${validated.engineBuildHash} runtime=${engineBuildHash}`,
+    );
+  }
+
+  const vm = initializeDeterministicVm(
+    runtime,
+    validated,
+    COMPILE_INPUT,
+    UINT64_MAX,
+  );
+  let bytecode: Uint8Array;
+  try {
+    bytecode = vm.compile(validated.code);
   } finally {
-    runtime.module._free(manifestPtr);
-    runtime.module._free(hashPtr);
-    if (contextPtr) {
-      runtime.module._free(contextPtr);
+    vm.dispose();
+  }
+
+  return {
+    bytecode,
+    bytecodeHash: hashBytecode(bytecode),
+    bytecodeMac: macBytecode(bytecode),
+    gasVersion: new DataView(
+      bytecode.buffer,
+      bytecode.byteOffset,
+      bytecode.byteLength,
+    ).getUint32(8, true),
+    abiId: validated.abiId,
+    abiVersion: validated.abiVersion,
+    abiManifestHash: validated.abiManifestHash,
+    engineBuildHash,
+  };
+}
+
+/**
+ * Resume a VM from a snapshot instead of running `qjs_det_init`. The runtime
+ * must come from the same compiled wasm module and manifest as the snapshot.
+ * Every VM currently held by the runtime is released. When `input` is given,
+ * its `event`, `eventCanonical` and `steps` replace the ones baked into the
+ * image, so one snapshot serves every input envelope.
+ */
+export function restoreDeterministicVm(
+  runtime: RuntimeInstance,
+  snapshot: DeterministicVmSnapshot,
+  gasLimit: bigint | number,
+  input?: InputEnvelope,
+): DeterministicVm {
+  const normalizedGasLimit = normalizeGasLimit(gasLimit);
+  const validatedInput = input ? validateInputEnvelope(input) : undefined;
+  if (runtime.wasmModule !== snapshot.wasmModule) {
+    throw new Error('VM snapshot was captured from a different wasm module');
+  }
+  const runtimeHash = getManifestHash(runtime.manifest);
+  if (runtimeHash !== snapshot.abiManifestHash) {
+    throw new Error(
+      `VM snapshot manifest mismatch: snapshot=${snapshot.abiManifestHash} runtime=${runtimeHash}`,
+    );
+  }
+
+  const ffi = getDeterministicExports(runtime.module);
+  const state = applySnapshot(
+    runtime,
+    ffi,
+    snapshot,
+    normalizedGasLimit,
+    undefined,
+    validatedInput,
+  );
+  return createVmHandle(runtime, ffi, state, snapshot.abiManifestHash);
+}
+
+/**
+ * Write the image back, re-arm gas and optionally re-inject the context. The
+ * image covers all of linear memory, so every VM previously live in the
+ * runtime is released; only the snapshot's VM (reusing `survivor` when given)
+ * is live afterwards.
+ */
+function applySnapshot(
+  runtime: RuntimeInstance,
+  ffi: DeterministicExports,
+  snapshot: DeterministicVmSnapshot,
+  gasLimit: bigint,
+  survivor?: VmState,
+  input?: InputEnvelope,
+): VmState {
+  // Cost is one copy of the image plus clearing only what the heap grew past
+  // it, since fresh sbrk memory must read as zero; memory above the current
+  // break is never touched, whatever the memory profile.
+  const heap = runtime.module.HEAPU8;
+  const top = ffi.heapTop() >>> 0;
+  if (top > snapshot.image.length) {
+    heap.fill(0, snapshot.image.length, top);
+  }
+  heap.set(snapshot.image, 0);
+  releaseTrackedVms(runtime.module, survivor);
+  INSTALLED_MANIFESTS.add(runtime.module);
+
+  // The arena belongs to the restored allocator, so only encode into it once
+  // the image is back in place.
+  const context = input
+    ? encodeContextIntoArena(runtime, ffi, 0, {
+        event: input.event,
+        eventCanonical: input.eventCanonical,
+        steps: input.steps,
+      })
+    : { arenaPtr: 0, contextLength: 0 };
+  if (
+    ffi.restore(
+      snapshot.vmHandle,
+      gasLimit,
+      context.arenaPtr,
+      context.contextLength,
+    ) !== 0
+  ) {
+    ffi.freeAll();
+    releaseTrackedVms(runtime.module);
+    throw new Error(
+      input
+        ? 'VM restore failed: snapshot does not hold a fresh VM or its context cannot be replaced'
+        : 'VM restore failed: snapshot does not hold a fresh VM',
+    );
+  }
+  return survivor ?? trackVm(runtime.module, snapshot.vmHandle);
+}
+
+export interface DeterministicSessionOptions {
+  /**
+   * Source run once after init, e.g. entrypoint definitions the steps call.
+   * Its completion value is discarded; its globals are visible to every step.
+   */
+  prelude?: string;
+  /**
+   * Gas limit for init and the prelude (default: unlimited). Steps are metered
+   * separately.
+   */
+  setupGasLimit?: bigint | number;
+  /**
+   * Record a host-call tape per step (returned as JSON on each step).
+   */
+  tape?: { capacity: number };
+  /**
+   * Record a gas trace per step (returned as JSON on each step).
+   */
+  gasTrace?: boolean;
+}
+
+export interface DeterministicSessionStep extends DeterministicEvalResult {
+  tape?: string;
+  gasTrace?: string;
+}
+
+export interface DeterministicSession {
+  /**
+   * Evaluate one step from the session baseline under its own gas limit.
+   * `payload` is valid until the next step or dispose.
+   */
+  run(code: string, gasLimit: bigint | number): DeterministicSessionStep;
+  runBytecode(
+    bytecode: Uint8Array,
+    mac: string,
+    gasLimit: bigint | number,
+  ): DeterministicSessionStep;
+  readonly steps: number;
+  dispose(): void;
+}
+
+/**
+ * Run several programs/entrypoints against one input envelope without paying
+ * init per step. After init (and the optional prelude) the VM state is
+ * captured once; every step after the first restores it, so steps see the
+ * same globals and cannot observe each other's bindings, and each step is
+ * billed from its own gas limit exactly like a standalone evaluation of the
+ * same baseline.
+ */
+export function createDeterministicSession(
+  runtime: RuntimeInstance,
+  program: ProgramArtifact,
+  input: InputEnvelope,
+  options: DeterministicSessionOptions = {},
+): DeterministicSession {
+  const vm = initializeDeterministicVm(
+    runtime,
+    program,
+    input,
+    options.setupGasLimit ?? UINT64_MAX,
+  );
+  const ffi = getDeterministicExports(runtime.module);
+  const state = VM_STATES.get(vm) as VmState;
+
+  let baseline: DeterministicVmSnapshot;
+  try {
+    const setup = beginSession(
+      runtime.module,
+      ffi,
+      state.handle,
+      options.prelude,
+    );
+    if (setup.kind === 'error') {
+      throw new Error(
+        `session prelude failed: ${UTF8_DECODER.decode(setup.payload)}`,
+      );
     }
+    baseline = vm.snapshot();
+  } catch (err) {
+    vm.dispose();
+    throw err;
   }
 
+  let dirty = false;
+  let disposed = false;
+  let steps = 0;
+
+  const step = (
+    gasLimit: bigint | number,
+    run: () => DeterministicEvalResult,
+  ): DeterministicSessionStep => {
+    if (disposed) {
+      throw new Error('deterministic session is disposed');
+    }
+    const normalized = normalizeGasLimit(gasLimit);
+    if (dirty) {
+      applySnapshot(runtime, ffi, baseline, normalized, state);
+    } else if (ffi.restore(state.handle, normalized, 0, 0) !== 0) {
+      throw new Error('failed to arm session step gas limit');
+    }
+    dirty = true;
+
+    if (options.tape) {
+      vm.enableTape(options.tape.capacity);
+    }
+    if (options.gasTrace) {
+      vm.enableGasTrace(true);
+    }
+    const result: DeterministicSessionStep = run();
+    steps += 1;
+    if (options.tape) {
+      result.tape = vm.readTape();
+    }
+    if (options.gasTrace) {
+      result.gasTrace = vm.readGasTrace();
+    }
+    return result;
+  };
+
   return {
+    run(code, gasLimit) {
+      return step(gasLimit, () => vm.evalBinary(code));
+    },
+    runBytecode(bytecode, mac, gasLimit) {
+      return step(gasLimit, () => vm.evalBytecode(bytecode, mac));
+    },
+    get steps() {
+      return steps;
+    },
+    dispose() {
+      if (!disposed) {
+        disposed = true;
+        vm.dispose();
+      }
+    },
+  };
+}
+
+function beginSession(
+  module: QuickjsWasmModule,
+  ffi: DeterministicExports,
+  handle: number,
+  prelude: string | undefined,
+): DeterministicEvalResult {
+  if (prelude === undefined) {
+    return readEvalResult(module, ffi.sessionBegin(handle, 0, 0));
+  }
+  const encoded = UTF8_ENCODER.encode(prelude);
+  const preludePtr = writeCStringBytes(module, encoded);
+  try {
+    return readEvalResult(
+      module,
+      ffi.sessionBegin(handle, preludePtr, encoded.length),
+    );
+  } finally {
+    module._free(preludePtr);
+  }
+}
+
+function createVmHandle(
+  runtime: RuntimeInstance,
+  ffi: DeterministicExports,
+  state: VmState,
+  abiManifestHash: string,
+): DeterministicVm {
+  const live = (): number => {
+    if (state.released) {
+      throw new Error('deterministic VM has been released');
+    }
+    return state.handle;
+  };
+  let tapeCapacity = 0;
+  let tapeFailure: { error: unknown } | null = null;
+  const vm: DeterministicVm = {
     eval(code: string): string {
-      const ptr = ffi.eval(code);
+      const ptr = ffi.eval(live(), code);
       if (ptr === 0) {
         throw new Error('qjs_det_eval returned a null pointer');
       }
       return readAndFreeCString(runtime.module, ptr);
     },
+    evalBinary(code: string): DeterministicEvalResult {
+      const encoded = UTF8_ENCODER.encode(code);
+      const codePtr = writeCStringBytes(runtime.module, encoded);
+      let resultPtr: number;
+      try {
+        resultPtr = ffi.evalBin(live(), codePtr, encoded.length);
+      } finally {
+        runtime.module._free(codePtr);
+      }
+      if (resultPtr === 0) {
+        throw new Error('qjs_det_eval_bin returned a null pointer');
+      }
+      return readEvalResult(runtime.module, resultPtr);
+    },
+    evalBytecode(bytecode: Uint8Array, mac: string): DeterministicEvalResult {
+      const trusted = trustedBytecode(bytecode, mac);
+      const artifactPtr = writeBytes(runtime.module, trusted);
+      let resultPtr: number;
+      try {
+        resultPtr = ffi.evalBytecode(live(), artifactPtr, trusted.length);
+      } finally {
+        runtime.module._free(artifactPtr);
+      }
+      if (resultPtr === 0) {
+        throw new Error('qjs_det_eval_bytecode returned a null pointer');
+      }
+      return readEvalResult(runtime.module, resultPtr);
+    },
+    async evalBinaryAsync(code: string): Promise<DeterministicEvalResult> {
+      const encoded = UTF8_ENCODER.encode(code);
+      const codePtr = writeCStringBytes(runtime.module, encoded);
+      let resultPtr: number;
+      try {
+        resultPtr = await withSuspendableHostCalls(runtime, () =>
+          ffi.evalBinAsync(live(), codePtr, encoded.length),
+        );
+      } finally {
+        runtime.module._free(codePtr);
+      }
+      if (resultPtr === 0) {
+        throw new Error('qjs_det_eval_bin returned a null pointer');
+      }
+      return readEvalResult(runtime.module, resultPtr);
+    },
+    async evalBytecodeAsync(
+      bytecode: Uint8Array,
+      mac: string,
+    ): Promise<DeterministicEvalResult> {
+      const trusted = trustedBytecode(bytecode, mac);
+      const artifactPtr = writeBytes(runtime.module, trusted);
+      let resultPtr: number;
+      try {
+        resultPtr = await withSuspendableHostCalls(runtime, () =>
+          ffi.evalBytecodeAsync(live(), artifactPtr, trusted.length),
+        );
+      } finally {
+        runtime.module._free(artifactPtr);
+      }
+      if (resultPtr === 0) {
+        throw new Error('qjs_det_eval_bytecode returned a null pointer');
+      }
+      return readEvalResult(runtime.module, resultPtr);
+    },
+    compile(code: string): Uint8Array {
+      const encoded = UTF8_ENCODER.encode(code);
+      const codePtr = writeCStringBytes(runtime.module, encoded);
+      let resultPtr: number;
+      try {
+        resultPtr = ffi.compile(live(), codePtr, encoded.length);
+      } finally {
+        runtime.module._free(codePtr);
+      }
+      if (resultPtr === 0) {
+        throw new Error('qjs_det_compile returned a null pointer');
+      }
+      const result = readEvalResult(runtime.module, resultPtr);
+      if (result.kind === 'error') {
+        throw new Error(
+          `VM compile failed: ${UTF8_DECODER.decode(result.payload)}`,
+        );
+      }
+      return result.payload.slice();
+    },
     setGasLimit(limit: bigint | number): void {
       const normalized = normalizeGasLimit(limit);
-      const rc = ffi.setGasLimit(normalized);
+      const rc = ffi.setGasLimit(live(), normalized);
       if (rc !== 0) {
         throw new Error('failed to set gas limit');
       }
@@ -118,35 +774,270 @@ export function initializeDeterministicVm(
           `tape capacity must be a non-negative integer (received ${capacity})`,
         );
       }
-      const rc = ffi.enableTape(capacity >>> 0);
+      const rc = ffi.enableTape(live(), capacity >>> 0);
       if (rc !== 0) {
         throw new Error('failed to enable host tape');
       }
+      setTapeSink(runtime, state.handle, null);
+      tapeCapacity = capacity;
     },
     readTape(): string {
-      const ptr = ffi.readTape();
+      const ptr = ffi.readTape(live());
       if (ptr === 0) {
         throw new Error('qjs_det_read_tape returned a null pointer');
       }
       return readAndFreeCString(runtime.module, ptr);
     },
-    enableGasTrace(enabled: boolean): void {
-      const rc = ffi.enableTrace(enabled ? 1 : 0);
+    readTapeRecords(): HostTapeRecord[] {
+      if (tapeCapacity === 0) {
+        return [];
+      }
+      return withScratch(
+        runtime.module,
+        tapeCapacity * TAPE_RECORD_SIZE,
+        (ptr, size) => {
+          const count = ffi.readTapeBin(live(), ptr, size);
+          if (count < 0) {
+            throw new Error('qjs_det_read_tape_bin failed');
+          }
+          return decodeTapeRecords(runtime.module.HEAPU8, ptr, count);
+        },
+      );
+    },
+    streamTape(onRecords: (records: HostTapeRecord[]) => void): void {
+      const handle = live();
+      // Sinks run inside the VM, so failures are held until the next flush.
+      setTapeSink(runtime, handle, (ptr, count) => {
+        if (tapeFailure) {
+          return;
+        }
+        try {
+          onRecords(decodeTapeRecords(runtime.module.HEAPU8, ptr, count));
+        } catch (error) {
+          tapeFailure = { error };
+        }
+      });
+      if (ffi.streamTape(handle, 1) !== 0) {
+        setTapeSink(runtime, handle, null);
+        throw new Error('failed to enable host tape streaming');
+      }
+      tapeCapacity = 0;
+    },
+    flushTape(): void {
+      if (ffi.flushTape(live()) !== 0) {
+        throw new Error('host tape streaming is not enabled');
+      }
+      const failure = tapeFailure;
+      tapeFailure = null;
+      if (failure) {
+        throw failure.error;
+      }
+    },
+    enableGasTrace(enabled: boolean, options?: { hostGas?: boolean }): void {
+      const mode = enabled
+        ? TRACE_MODE_COUNTERS | (options?.hostGas ? TRACE_MODE_HOST_GAS : 0)
+        : 0;
+      const rc = ffi.enableTrace(live(), mode);
       if (rc !== 0) {
-        throw new Error('failed to configure gas trace');
+        throw new Error(
+          mode & TRACE_MODE_HOST_GAS
+            ? 'failed to enable host gas (not available with a ring tape)'
+            : 'failed to configure gas trace',
+        );
       }
     },
     readGasTrace(): string {
-      const ptr = ffi.readTrace();
+      const ptr = ffi.readTrace(live());
       if (ptr === 0) {
         throw new Error('qjs_det_read_trace returned a null pointer');
       }
       return readAndFreeCString(runtime.module, ptr);
     },
+    readGasTraceCounters(): GasTrace {
+      return withScratch(runtime.module, GAS_TRACE_SIZE, (ptr, size) => {
+        if (ffi.readTraceBin(live(), ptr, size) !== GAS_TRACE_SIZE) {
+          throw new Error('qjs_det_read_trace_bin failed');
+        }
+        return decodeGasTrace(runtime.module.HEAPU8, ptr);
+      });
+    },
+    readHostGas(): HostGasBreakdown {
+      const handle = live();
+      const size = ffi.readHostGasBin(handle, 0, 0);
+      if (size < 0) {
+        throw new Error('host gas is not enabled');
+      }
+      return withScratch(runtime.module, size, (ptr, capacity) => {
+        if (ffi.readHostGasBin(handle, ptr, capacity) !== size) {
+          throw new Error('qjs_det_read_host_gas_bin failed');
+        }
+        return decodeHostGasBreakdown(
+          runtime.module.HEAPU8.slice(ptr, ptr + size),
+        );
+      });
+    },
+    readCalibrationCounters(): CalibrationCounters {
+      return withScratch(runtime.module, CALIBRATION_SIZE, (ptr, size) => {
+        if (ffi.readCalibrationBin(live(), ptr, size) !== CALIBRATION_SIZE) {
+          throw new Error(
+            `calibration counters require the calibration build (got ${runtime.buildType})`,
+          );
+        }
+        return decodeCalibrationCounters(runtime.module.HEAPU8, ptr);
+      });
+    },
+    snapshot(): DeterministicVmSnapshot {
+      const top = ffi.snapshot(live()) >>> 0;
+      if (top === 0) {
+        throw new Error(
+          'qjs_det_snapshot requires a freshly initialized VM that is the only live VM in the runtime (call before eval)',
+        );
+      }
+      return {
+        wasmModule: runtime.wasmModule,
+        abiManifestHash,
+        vmHandle: state.handle,
+        image: runtime.module.HEAPU8.slice(0, top),
+      };
+    },
     dispose() {
-      ffi.freeRuntime();
+      if (!state.released) {
+        state.released = true;
+        LIVE_VMS.get(runtime.module)?.delete(state);
+        setTapeSink(runtime, state.handle, null);
+        ffi.free(state.handle);
+      }
     },
   };
+  VM_STATES.set(vm, state);
+  return vm;
+}
+
+function trackVm(module: QuickjsWasmModule, handle: number): VmState {
+  const state: VmState = { handle, released: false };
+  let live = LIVE_VMS.get(module);
+  if (!live) {
+    live = new Set();
+    LIVE_VMS.set(module, live);
+  }
+  live.add(state);
+  return state;
+}
+
+function releaseTrackedVms(module: QuickjsWasmModule, keep?: VmState): void {
+  const live = LIVE_VMS.get(module);
+  if (!live) {
+    return;
+  }
+  for (const state of live) {
+    if (state !== keep) {
+      state.released = true;
+      live.delete(state);
+    }
+  }
+}
+
+/**
+ * Copy the runtime's manifest into the shim once; later inits pass a NULL
+ * manifest pointer. A restored image carries the manifest it was captured
+ * with (same hash, enforced by restoreDeterministicVm), so it counts as
+ * installed too.
+ */
+function installManifest(
+  runtime: RuntimeInstance,
+  ffi: DeterministicExports,
+): void {
+  if (INSTALLED_MANIFESTS.has(runtime.module)) {
+    return;
+  }
+  const manifestBytes = encodeAbiManifest(runtime.manifest);
+  const manifestPtr = writeBytes(runtime.module, manifestBytes);
+  try {
+    if (ffi.setManifest(manifestPtr, manifestBytes.length) !== 0) {
+      throw new Error('qjs_det_set_manifest failed to copy the manifest');
+    }
+  } finally {
+    runtime.module._free(manifestPtr);
+  }
+  INSTALLED_MANIFESTS.add(runtime.module);
+}
+
+const CONTEXT_ENCODER = new DvEncoder();
+const MIN_CONTEXT_CAPACITY = 4096;
+let contextCapacityHint = MIN_CONTEXT_CAPACITY;
+
+/**
+ * Encode the context blob straight into the shim input arena at
+ * `contextOffset`. The first attempt sizes the arena from recent blobs; if the
+ * encoding does not fit, the arena is grown to the DV size limit and the
+ * encode is repeated. Growing does not preserve arena contents, so callers
+ * write anything else into the arena afterwards.
+ */
+function encodeContextIntoArena(
+  runtime: RuntimeInstance,
+  ffi: DeterministicExports,
+  contextOffset: number,
+  context: Record<string, unknown>,
+): { arenaPtr: number; contextLength: number } {
+  const attempt = (capacity: number) => {
+    const arenaPtr = ffi.inputBuffer(contextOffset + capacity);
+    if (arenaPtr === 0) {
+      throw new Error('qjs_det_input_buffer returned a null pointer');
+    }
+    const start = arenaPtr + contextOffset;
+    const target = runtime.module.HEAPU8.subarray(start, start + capacity);
+    const contextLength = CONTEXT_ENCODER.encodeInto(context, target);
+    return { arenaPtr, contextLength };
+  };
+
+  let result: { arenaPtr: number; contextLength: number };
+  try {
+    result = attempt(contextCapacityHint);
+  } catch (error) {
+    if (!(error instanceof RangeError)) {
+      throw error;
+    }
+    result = attempt(DV_LIMIT_DEFAULTS.maxEncodedBytes);
+  }
+  contextCapacityHint = Math.max(
+    MIN_CONTEXT_CAPACITY,
+    Math.min(result.contextLength * 2, DV_LIMIT_DEFAULTS.maxEncodedBytes),
+  );
+  return result;
+}
+
+function alignTo8(value: number): number {
+  return (value + 7) & ~7;
+}
+
+function getManifestHash(manifest: CanonicalAbiManifest): string {
+  let hash = MANIFEST_HASHES.get(manifest);
+  if (!hash) {
+    hash = hashAbiManifest(manifest).hash;
+    MANIFEST_HASHES.set(manifest, hash);
+  }
+  return hash;
+}
+
+/**
+ * Release every deterministic VM held by the runtime (qjs_det_free_all). Safe
+ * to call when no VM is initialized; used by runtime pools before handing a
+ * runtime out.
+ */
+export function freeDeterministicVm(runtime: RuntimeInstance): void {
+  getDeterministicExports(runtime.module).freeAll();
+  releaseTrackedVms(runtime.module);
+}
+
+function getDeterministicExports(
+  module: QuickjsWasmModule,
+): DeterministicExports {
+  let exports = EXPORTS_CACHE.get(module);
+  if (!exports) {
+    exports = createDeterministicExports(module);
+    EXPORTS_CACHE.set(module, exports);
+  }
+  return exports;
 }
 
 function createDeterministicExports(
@@ -160,45 +1051,163 @@ function createDeterministicExports(
     'number',
     'bigint',
   ]) as unknown as DetInitFn;
+  const takeInitError = module.cwrap(
+    'qjs_det_take_init_error',
+    'number',
+    [],
+  ) as unknown as () => number;
+  const inputBuffer = module.cwrap('qjs_det_input_buffer', 'number', [
+    'number',
+  ]) as unknown as DetInputBufferFn;
+  const setManifest = module.cwrap('qjs_det_set_manifest', 'number', [
+    'number',
+    'number',
+  ]) as unknown as DetSetManifestFn;
+  const useArena = module.cwrap('qjs_det_use_arena', 'number', [
+    'number',
+  ]) as unknown as DetUseArenaFn;
 
   const evalFn = module.cwrap('qjs_det_eval', 'number', [
+    'number',
     'string',
   ]) as unknown as DetEvalFn;
+  const evalBin = module.cwrap('qjs_det_eval_bin', 'number', [
+    'number',
+    'number',
+    'number',
+  ]) as unknown as DetEvalBinFn;
+  // `async` cwraps return a Promise that settles once Asyncify has rewound
+  // every suspension; synchronous builds return the plain result.
+  const evalBinAsync = module.cwrap(
+    'qjs_det_eval_bin',
+    'number',
+    ['number', 'number', 'number'],
+    { async: true },
+  ) as unknown as AsyncExport<DetEvalBinFn>;
+  const compile = module.cwrap('qjs_det_compile', 'number', [
+    'number',
+    'number',
+    'number',
+  ]) as unknown as DetCompileFn;
+  const evalBytecode = module.cwrap('qjs_det_eval_bytecode', 'number', [
+    'number',
+    'number',
+    'number',
+  ]) as unknown as DetEvalBytecodeFn;
+  const evalBytecodeAsync = module.cwrap(
+    'qjs_det_eval_bytecode',
+    'number',
+    ['number', 'number', 'number'],
+    { async: true },
+  ) as unknown as AsyncExport<DetEvalBytecodeFn>;
   const setGasLimit = module.cwrap('qjs_det_set_gas_limit', 'number', [
+    'number',
     'bigint',
   ]) as unknown as DetSetGasLimitFn;
+  const memoizeHostFn = module.cwrap('qjs_det_memoize_host_fn', 'number', [
+    'number',
+    'number',
+  ]) as unknown as DetMemoizeHostFnFn;
 
-  const freeRuntime = module.cwrap(
-    'qjs_det_free',
+  const free = module.cwrap('qjs_det_free', null, [
+    'number',
+  ]) as unknown as DetFreeFn;
+  const freeAll = module.cwrap(
+    'qjs_det_free_all',
     null,
     [],
   ) as unknown as () => void;
   const enableTape = module.cwrap('qjs_det_enable_tape', 'number', [
     'number',
+    'number',
   ]) as unknown as EnableTapeFn;
-  const readTape = module.cwrap(
-    'qjs_det_read_tape',
+  const readTape = module.cwrap('qjs_det_read_tape', 'number', [
     'number',
-    [],
-  ) as unknown as ReadTapeFn;
+  ]) as unknown as ReadTapeFn;
+  const readTapeBin = module.cwrap('qjs_det_read_tape_bin', 'number', [
+    'number',
+    'number',
+    'number',
+  ]) as unknown as ReadBinFn;
+  const streamTape = module.cwrap('qjs_det_stream_tape', 'number', [
+    'number',
+    'number',
+  ]) as unknown as StreamTapeFn;
+  const flushTape = module.cwrap('qjs_det_flush_tape', 'number', [
+    'number',
+  ]) as unknown as FlushTapeFn;
   const enableTrace = module.cwrap('qjs_det_enable_trace', 'number', [
     'number',
+    'number',
   ]) as unknown as EnableTraceFn;
-  const readTrace = module.cwrap(
-    'qjs_det_read_trace',
+  const readTrace = module.cwrap('qjs_det_read_trace', 'number', [
+    'number',
+  ]) as unknown as ReadTraceFn;
+  const readTraceBin = module.cwrap('qjs_det_read_trace_bin', 'number', [
+    'number',
+    'number',
+    'number',
+  ]) as unknown as ReadBinFn;
+  const readHostGasBin = module.cwrap('qjs_det_read_host_gas_bin', 'number', [
+    'number',
+    'number',
+    'number',
+  ]) as unknown as ReadBinFn;
+  const readCalibrationBin = module.cwrap(
+    'qjs_det_read_calibration_bin',
+    'number',
+    ['number', 'number', 'number'],
+  ) as unknown as ReadBinFn;
+  const snapshot = module.cwrap('qjs_det_snapshot', 'number', [
+    'number',
+  ]) as unknown as DetSnapshotFn;
+  const restore = module.cwrap('qjs_det_restore', 'number', [
+    'number',
+    'bigint',
+    'number',
+    'number',
+  ]) as unknown as DetRestoreFn;
+  const heapTop = module.cwrap(
+    'qjs_det_heap_top',
     'number',
     [],
-  ) as unknown as ReadTraceFn;
+  ) as unknown as DetHeapTopFn;
+  const sessionBegin = module.cwrap('qjs_det_session_begin', 'number', [
+    'number',
+    'number',
+    'number',
+  ]) as unknown as DetSessionBeginFn;
 
   return {
     init,
+    takeInitError,
+    inputBuffer,
+    setManifest,
+    useArena,
     eval: evalFn,
+    evalBin,
+    evalBinAsync,
+    compile,
+    evalBytecode,
+    evalBytecodeAsync,
     setGasLimit,
-    freeRuntime,
+    memoizeHostFn,
+    free,
+    freeAll,
+    snapshot,
+    restore,
+    heapTop,
+    sessionBegin,
     enableTape,
     readTape,
+    readTapeBin,
+    streamTape,
+    flushTape,
     enableTrace,
     readTrace,
+    readTraceBin,
+    readHostGasBin,
+    readCalibrationBin,
   };
 }
 
@@ -228,6 +1237,16 @@ function normalizeGasLimit(value: bigint | number): bigint {
   return value;
 }
 
+function trustedBytecode(bytecode: Uint8Array, mac: string): Uint8Array {
+  const trusted = authenticateBytecode(bytecode, mac);
+  if (!trusted) {
+    throw new Error(
+      'bytecode MAC does not match; compile it with compileProgram under the current bytecode key',
+    );
+  }
+  return trusted;
+}
+
 function writeBytes(module: QuickjsWasmModule, data: Uint8Array): number {
   const ptr = module._malloc(data.length);
   if (ptr === 0) {
@@ -237,8 +1256,10 @@ function writeBytes(module: QuickjsWasmModule, data: Uint8Array): number {
   return ptr;
 }
 
-function writeCString(module: QuickjsWasmModule, value: string): number {
-  const encoded = UTF8_ENCODER.encode(value);
+function writeCStringBytes(
+  module: QuickjsWasmModule,
+  encoded: Uint8Array,
+): number {
   const ptr = module._malloc(encoded.length + 1);
   if (ptr === 0) {
     throw new Error('malloc returned null for string');
@@ -249,6 +1270,131 @@ function writeCString(module: QuickjsWasmModule, value: string): number {
   return ptr;
 }
 
+// Mirrors DetEvalResult in quickjs_wasm.c.
+const EVAL_RESULT_SIZE = 32;
+const EVAL_STATUS_RESULT = 0;
+const EVAL_STATUS_ERROR = 1;
+
+function readEvalResult(
+  module: QuickjsWasmModule,
+  ptr: number,
+): DeterministicEvalResult {
+  const heap = module.HEAPU8;
+  const view = new DataView(
+    heap.buffer,
+    heap.byteOffset + ptr,
+    EVAL_RESULT_SIZE,
+  );
+  const status = view.getUint32(0, true);
+  if (status !== EVAL_STATUS_RESULT && status !== EVAL_STATUS_ERROR) {
+    throw new Error(`qjs_det_eval_bin returned unknown status ${status}`);
+  }
+  const payloadLength = view.getUint32(4, true);
+  const payloadPtr = view.getUint32(24, true);
+  return {
+    kind: status === EVAL_STATUS_RESULT ? 'result' : 'error',
+    payload: heap.subarray(payloadPtr, payloadPtr + payloadLength),
+    gasRemaining: view.getBigUint64(8, true),
+    gasUsed: view.getBigUint64(16, true),
+  };
+}
+
+// Mirror DetTapeRecordBin, DetGasTraceBin and DetCalibrationBin in
+// quickjs_wasm.c.
+const TAPE_RECORD_SIZE = 104;
+const TAPE_FLAG_IS_ERROR = 1;
+const TAPE_FLAG_CHARGE_FAILED = 2;
+const GAS_TRACE_SIZE = 72;
+const CALIBRATION_SIZE = 48;
+// qjs_det_enable_trace mode bits (DET_TRACE_*).
+const TRACE_MODE_COUNTERS = 1;
+const TRACE_MODE_HOST_GAS = 2;
+
+function withScratch<T>(
+  module: QuickjsWasmModule,
+  size: number,
+  read: (ptr: number, size: number) => T,
+): T {
+  const ptr = module._malloc(size);
+  if (ptr === 0) {
+    throw new Error('malloc returned null for readout buffer');
+  }
+  try {
+    return read(ptr, size);
+  } finally {
+    module._free(ptr);
+  }
+}
+
+// The layout is fixed by the shim, so unlike the JSON readout there is no
+// per-field validation to do.
+function decodeTapeRecords(
+  heap: Uint8Array,
+  ptr: number,
+  count: number,
+): HostTapeRecord[] {
+  const view = new DataView(
+    heap.buffer,
+    heap.byteOffset + ptr,
+    count * TAPE_RECORD_SIZE,
+  );
+  const records: HostTapeRecord[] = [];
+  for (let i = 0; i < count; i += 1) {
+    const base = i * TAPE_RECORD_SIZE;
+    const flags = view.getUint32(base + 32, true);
+    const hashes = base + ptr + 40;
+    records.push({
+      fnId: view.getUint32(base, true),
+      reqLen: view.getUint32(base + 4, true),
+      respLen: view.getUint32(base + 8, true),
+      units: view.getUint32(base + 12, true),
+      gasPre: view.getBigUint64(base + 16, true),
+      gasPost: view.getBigUint64(base + 24, true),
+      isError: (flags & TAPE_FLAG_IS_ERROR) !== 0,
+      chargeFailed: (flags & TAPE_FLAG_CHARGE_FAILED) !== 0,
+      reqHash: bytesToHex(heap.subarray(hashes, hashes + 32)),
+      respHash: bytesToHex(heap.subarray(hashes + 32, hashes + 64)),
+    });
+  }
+  return records;
+}
+
+function decodeGasTrace(heap: Uint8Array, ptr: number): GasTrace {
+  const view = new DataView(heap.buffer, heap.byteOffset + ptr, GAS_TRACE_SIZE);
+  const at = (index: number) => view.getBigUint64(index * 8, true);
+  return {
+    opcodeCount: at(0),
+    opcodeGas: at(1),
+    arrayCbBaseCount: at(2),
+    arrayCbBaseGas: at(3),
+    arrayCbPerElCount: at(4),
+    arrayCbPerElGas: at(5),
+    allocationCount: at(6),
+    allocationBytes: at(7),
+    allocationGas: at(8),
+  };
+}
+
+function decodeCalibrationCounters(
+  heap: Uint8Array,
+  ptr: number,
+): CalibrationCounters {
+  const view = new DataView(
+    heap.buffer,
+    heap.byteOffset + ptr,
+    CALIBRATION_SIZE,
+  );
+  const at = (index: number) => view.getBigUint64(index * 8, true);
+  return {
+    evals: at(0),
+    evalNs: at(1),
+    hostCalls: at(2),
+    hostNs: at(3),
+    gcCheckpoints: at(4),
+    gcNs: at(5),
+  };
+}
+
 function readAndFreeCString(module: QuickjsWasmModule, ptr: number): string {
   try {
     return module.UTF8ToString(ptr);
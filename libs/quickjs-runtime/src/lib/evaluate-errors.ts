@@ -13,6 +13,17 @@ export type EvaluateVmErrorDetail =
       tag: 'vm/out_of_gas';
       message: string;
     }
+  | {
+      /**
+       * An allocation failed against the memory profile's fixed ceiling. On a
+       * fresh runtime the failure point, and with it gasUsed, is a function
+       * of (engineBuildHash, allocator, program, input).
+       */
+      kind: 'out-of-memory';
+      code: 'OOM';
+      tag: 'vm/out_of_memory';
+      message: string;
+    }
   | {
       kind: 'manifest-error';
       code: string;
@@ -68,6 +79,15 @@ export function mapVmError(
     };
   }
 
+  if (name === 'InternalError' && normalizedMessage === 'out of memory') {
+    return {
+      kind: 'out-of-memory',
+      code: 'OOM',
+      tag: 'vm/out_of_memory',
+      message: normalizedMessage,
+    };
+  }
+
   if (name === 'ManifestError') {
     const detailMessage = normalizedMessage || 'manifest error';
     return {
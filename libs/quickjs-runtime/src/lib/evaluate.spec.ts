@@ -1,12 +1,25 @@
+import { loadQuickjsWasmMetadata } from '@blue-quickjs/quickjs-wasm';
 import { HOST_V1_HASH, HOST_V1_MANIFEST } from '@blue-quickjs/test-harness';
 import { vi } from 'vitest';
-import { evaluate } from './evaluate.js';
+import {
+  compileProgram,
+  type HostTapeRecord,
+} from './deterministic-init.js';
+import { evaluate, evaluateBatch } from './evaluate.js';
 import type { HostDispatcherHandlers } from './host-dispatcher.js';
-import type { InputEnvelope, ProgramArtifact } from './quickjs-runtime.js';
+import {
+  type InputEnvelope,
+  type ProgramArtifact,
+  type SourceProgramArtifact,
+  hashBytecode,
+  macBytecode,
+} from './quickjs-runtime.js';
+import { createRuntime } from './runtime.js';
+import { createRuntimePool } from './runtime-pool.js';
 
 const TEST_GAS_LIMIT = 50_000n;
 
-const BASE_PROGRAM: ProgramArtifact = {
+const BASE_PROGRAM: SourceProgramArtifact = {
   code: 'document("path/to/doc")',
   abiId: 'Host.v1',
   abiVersion: 1,
@@ -19,6 +32,18 @@ const BASE_INPUT: InputEnvelope = {
   steps: [{ name: 'first' }],
 };
 
+// The async build type is opt-in (WASM_BUILD_TYPES=...,async).
+const ASYNC_BUILD_AVAILABLE = await loadQuickjsWasmMetadata().then(
+  (metadata) => Boolean(metadata.variants.wasm32?.async),
+  () => false,
+);
+
+// Smaller memory profiles are opt-in (WASM_MEMORY_PROFILES=4mib,...).
+const MEMORY_PROFILE_4MIB_AVAILABLE = await loadQuickjsWasmMetadata().then(
+  (metadata) => Boolean(metadata.memoryProfiles?.['4mib']?.wasm32?.release),
+  () => false,
+);
+
 describe('evaluate', () => {
   it('returns DV results with gas accounting', async () => {
     const handlers = createHandlers();
@@ -194,6 +219,81 @@ describe('evaluate', () => {
     expect(result.error.tag).toBe('vm/out_of_gas');
   });
 
+  it.skipIf(!MEMORY_PROFILE_4MIB_AVAILABLE)(
+    'surfaces out-of-memory deterministically on the 4 MiB profile',
+    async () => {
+      const pool = createRuntimePool({ max: 1, memoryProfile: '4mib' });
+      const options = {
+        program: {
+          ...BASE_PROGRAM,
+          code: 'const a = []; while (true) { a.push("x".repeat(1024) + a.length); }',
+        },
+        input: BASE_INPUT,
+        gasLimit: 100_000_000n,
+        manifest: HOST_V1_MANIFEST,
+        handlers: createHandlers(),
+        memoryProfile: '4mib' as const,
+      };
+
+      const first = await evaluate(options);
+      const second = await evaluate(options);
+      await evaluate({ ...options, program: BASE_PROGRAM, pool });
+      const pooled = await evaluate({ ...options, pool });
+      pool.close();
+
+      expect(first.ok).toBe(false);
+      if (first.ok) {
+        throw new Error('expected OOM');
+      }
+      expect(first.type).toBe('vm-error');
+      expect(first.error).toMatchObject({
+        kind: 'out-of-memory',
+        code: 'OOM',
+        tag: 'vm/out_of_memory',
+      });
+      expect(second.gasUsed).toBe(first.gasUsed);
+      expect(pooled).toMatchObject({
+        ok: false,
+        gasUsed: first.gasUsed,
+        error: { kind: 'out-of-memory' },
+      });
+    },
+  );
+
+  it.skipIf(!MEMORY_PROFILE_4MIB_AVAILABLE)(
+    'reruns pooled OOMs that called handlers only when asked to',
+    async () => {
+      const pool = createRuntimePool({ max: 1, memoryProfile: '4mib' });
+      const run = async (retryOutOfMemory?: boolean) => {
+        const handlers = createHandlers();
+        const result = await evaluate({
+          program: {
+            ...BASE_PROGRAM,
+            code: 'emit(1); const a = []; while (true) { a.push("x".repeat(1024) + a.length); }',
+          },
+          input: BASE_INPUT,
+          gasLimit: 100_000_000n,
+          manifest: HOST_V1_MANIFEST,
+          handlers,
+          pool,
+          retryOutOfMemory,
+        });
+        return { result, emits: vi.mocked(handlers.emit).mock.calls.length };
+      };
+
+      const once = await run();
+      const retried = await run(true);
+      pool.close();
+
+      expect(once.result).toMatchObject({
+        ok: false,
+        error: { kind: 'out-of-memory' },
+      });
+      expect(once.emits).toBe(1);
+      expect(retried.emits).toBe(2);
+    },
+  );
+
   it('rejects engine build hash mismatches', async () => {
     const program: ProgramArtifact = {
       ...BASE_PROGRAM,
@@ -236,6 +336,104 @@ describe('evaluate', () => {
     expect(record.respHash).toHaveLength(64);
   });
 
+  it('streams every tape record past the ring capacity', async () => {
+    const calls = Array.from({ length: 12 }, (_, i) => `document("k${i}")`);
+    const code = `[${calls.join(', ')}].length`;
+    const options = {
+      program: { ...BASE_PROGRAM, code },
+      input: BASE_INPUT,
+      gasLimit: TEST_GAS_LIMIT,
+      manifest: HOST_V1_MANIFEST,
+    };
+
+    const ring = await evaluate({
+      ...options,
+      handlers: createHandlers(),
+      tape: { capacity: 32 },
+    });
+    const batches: HostTapeRecord[][] = [];
+    const streamed = await evaluate({
+      ...options,
+      handlers: createHandlers(),
+      tape: { mode: 'stream', onRecords: (records) => batches.push(records) },
+    });
+
+    expect(ring.ok && streamed.ok).toBe(true);
+    expect(streamed.tape).toBeUndefined();
+    expect(batches.flat()).toEqual(ring.tape);
+    expect(batches.flat()).toHaveLength(12);
+    expect(streamed.gasUsed).toBe(ring.gasUsed);
+  });
+
+  it('replays pure host functions with identical gas and tape', async () => {
+    const pureManifest = {
+      ...HOST_V1_MANIFEST,
+      functions: HOST_V1_MANIFEST.functions.map((fn) =>
+        fn.js_path.join('.') === 'document.get' ? { ...fn, pure: true } : fn,
+      ),
+    };
+    const run = async (manifest: typeof HOST_V1_MANIFEST) => {
+      const handlers = createHandlers();
+      const result = await evaluate({
+        program: {
+          ...BASE_PROGRAM,
+          code: '[1, 2, 3].map(() => document("a")).concat(document("b"))',
+        },
+        input: BASE_INPUT,
+        gasLimit: TEST_GAS_LIMIT,
+        manifest,
+        handlers,
+        tape: { capacity: 8 },
+      });
+      return { result, calls: vi.mocked(handlers.document.get).mock.calls };
+    };
+
+    const plain = await run(HOST_V1_MANIFEST);
+    const pure = await run(pureManifest);
+
+    expect(plain.calls).toHaveLength(4);
+    expect(pure.calls.map(([path]) => path)).toEqual(['a', 'b']);
+    expect(pure.result).toEqual(plain.result);
+  });
+
+  it.skipIf(!ASYNC_BUILD_AVAILABLE)(
+    'awaits async handlers in the async build with unchanged gas and tape',
+    async () => {
+      const run = (
+        buildType: 'release' | 'async',
+        handlers: HostDispatcherHandlers,
+      ) =>
+        evaluate({
+          program: {
+            ...BASE_PROGRAM,
+            code: 'document("a").path + document("b").path',
+          },
+          input: BASE_INPUT,
+          gasLimit: TEST_GAS_LIMIT,
+          manifest: HOST_V1_MANIFEST,
+          handlers,
+          buildType,
+          tape: { capacity: 8 },
+        });
+      const get = vi.fn(async (path: string) => {
+        await new Promise((resolve) => setTimeout(resolve, 1));
+        return { ok: { path }, units: 5 };
+      });
+
+      const expected = await run('release', createHandlers());
+      const result = await run('async', createHandlers({ document: { get } }));
+
+      expect(get).toHaveBeenCalledTimes(2);
+      expect(result.ok).toBe(true);
+      expect(result).toMatchObject({
+        value: 'ab',
+        gasUsed: expected.gasUsed,
+        gasRemaining: expected.gasRemaining,
+        tape: expected.tape,
+      });
+    },
+  );
+
   it('returns gas trace when requested', async () => {
     const result = await evaluate({
       program: { ...BASE_PROGRAM, code: '1 + 2' },
@@ -255,6 +453,240 @@ describe('evaluate', () => {
     expect((result.gasTrace?.opcodeCount ?? 0n) >= 0n).toBe(true);
     expect((result.gasTrace?.allocationBytes ?? 0n) >= 0n).toBe(true);
   });
+
+  it('reports host-call gas per function', async () => {
+    const code = '[document("a"), document("b"), document("c")].length';
+    const options = {
+      program: { ...BASE_PROGRAM, code },
+      input: BASE_INPUT,
+      gasLimit: TEST_GAS_LIMIT,
+      manifest: HOST_V1_MANIFEST,
+    };
+
+    const taped = await evaluate({
+      ...options,
+      handlers: createHandlers(),
+      tape: { capacity: 8 },
+    });
+    const measured = await evaluate({
+      ...options,
+      handlers: createHandlers(),
+      hostGas: true,
+      gasTrace: true,
+    });
+
+    expect(measured.gasUsed).toBe(taped.gasUsed);
+    expect(measured.hostGas?.truncated).toBe(false);
+    expect(measured.hostGas?.functions).toEqual([
+      expect.objectContaining({
+        fnId: getFnId('document.get'),
+        calls: 3,
+        gas: (taped.tape ?? []).reduce(
+          (sum, record) => sum + record.gasPre + record.gasPost,
+          0n,
+        ),
+      }),
+    ]);
+    await expect(
+      evaluate({
+        ...options,
+        handlers: createHandlers(),
+        hostGas: true,
+        tape: {},
+      }),
+    ).rejects.toThrow(/ring tape/);
+  });
+
+  it('matches the text output channel for results and errors', async () => {
+    const programs = ['document("path/to/doc")', '({ a: [1, "x"] })', 'x.y'];
+
+    for (const code of programs) {
+      const run = (textOutput: boolean) =>
+        evaluate({
+          program: { ...BASE_PROGRAM, code },
+          input: BASE_INPUT,
+          gasLimit: TEST_GAS_LIMIT,
+          manifest: HOST_V1_MANIFEST,
+          handlers: createHandlers(),
+          textOutput,
+        });
+
+      const binary = await run(false);
+      const text = await run(true);
+      expect(binary).toEqual(text);
+      expect(binary.raw).toBe(text.raw);
+    }
+  });
+
+  it('reports identical results and gas with the arena allocator', async () => {
+    const programs = [
+      'document("path/to/doc")',
+      '[1, 2, 3].map((v) => ({ v, s: "x".repeat(v * 100) }))',
+      'x.y',
+      'let n = 0; while (true) { n += 1; }',
+    ];
+
+    for (const code of programs) {
+      const run = (allocator: 'system' | 'arena') =>
+        evaluate({
+          program: { ...BASE_PROGRAM, code },
+          input: BASE_INPUT,
+          gasLimit: TEST_GAS_LIMIT,
+          manifest: HOST_V1_MANIFEST,
+          handlers: createHandlers(),
+          gasTrace: true,
+          allocator,
+        });
+
+      expect(await run('arena')).toEqual(await run('system'));
+    }
+  });
+
+  it('evaluates precompiled bytecode programs', async () => {
+    const runtime = await createRuntime({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const compiled = compileProgram(runtime, BASE_PROGRAM);
+    expect(compiled.engineBuildHash).toHaveLength(64);
+
+    const source = await evaluate({
+      program: BASE_PROGRAM,
+      input: BASE_INPUT,
+      gasLimit: TEST_GAS_LIMIT,
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const runs = [];
+    for (let i = 0; i < 2; i += 1) {
+      runs.push(
+        await evaluate({
+          program: compiled,
+          input: BASE_INPUT,
+          gasLimit: TEST_GAS_LIMIT,
+          manifest: HOST_V1_MANIFEST,
+          handlers: createHandlers(),
+        }),
+      );
+    }
+
+    expect(source.ok && runs[0].ok).toBe(true);
+    if (!source.ok || !runs[0].ok) {
+      throw new Error('expected bytecode evaluation to succeed');
+    }
+    expect(runs[0].value).toEqual(source.value);
+    expect(runs[0].gasUsed <= source.gasUsed).toBe(true);
+    expect(runs[1]).toEqual(runs[0]);
+  });
+
+  it('refuses bytecode its MAC does not authenticate', async () => {
+    const runtime = await createRuntime({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const compiled = compileProgram(runtime, BASE_PROGRAM);
+    const run = (bytecode: Uint8Array, bytecodeMac = compiled.bytecodeMac) =>
+      evaluate({
+        program: {
+          ...compiled,
+          bytecode,
+          bytecodeHash: hashBytecode(bytecode),
+          bytecodeMac,
+        },
+        input: BASE_INPUT,
+        gasLimit: TEST_GAS_LIMIT,
+        manifest: HOST_V1_MANIFEST,
+        handlers: createHandlers(),
+      });
+
+    const forged = compiled.bytecode.slice();
+    forged[forged.length - 1] ^= 0xff;
+    await expect(run(forged)).rejects.toThrow(/bytecodeMac does not/);
+    await expect(run(forged, '0'.repeat(64))).rejects.toThrow(
+      /bytecodeMac does not/,
+    );
+    expect(macBytecode(compiled.bytecode.slice())).toBe(compiled.bytecodeMac);
+    expect((await run(compiled.bytecode.slice())).ok).toBe(true);
+  });
+});
+
+describe('evaluateBatch', () => {
+  const inputs: InputEnvelope[] = [1, 2, 3].map((id) => ({
+    ...BASE_INPUT,
+    event: { type: 'create', payload: { id } },
+    eventCanonical: { type: 'create', payload: { id } },
+  }));
+  const program: SourceProgramArtifact = {
+    ...BASE_PROGRAM,
+    code: 'event.payload.id === 2 ? missing.value : ({ id: event.payload.id, doc: document("d") })',
+  };
+
+  it('returns the same items as standalone evaluate() calls', async () => {
+    const batch = await evaluateBatch({
+      program,
+      inputs,
+      gasLimit: TEST_GAS_LIMIT,
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+      tape: { capacity: 4 },
+    });
+
+    expect(batch).toHaveLength(inputs.length);
+    for (let i = 0; i < inputs.length; i += 1) {
+      const standalone = await evaluate({
+        program,
+        input: inputs[i],
+        gasLimit: TEST_GAS_LIMIT,
+        manifest: HOST_V1_MANIFEST,
+        handlers: createHandlers(),
+        tape: { capacity: 4 },
+      });
+      expect(batch[i]).toEqual(standalone);
+      expect(batch[i].raw).toBe(standalone.raw);
+    }
+    expect(batch[1].ok).toBe(false);
+  });
+
+  it('matches standalone runs of the compiled artifact when compile is set', async () => {
+    const runtime = await createRuntime({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const compiled = compileProgram(runtime, program);
+    const batch = await evaluateBatch({
+      program,
+      inputs,
+      gasLimit: TEST_GAS_LIMIT,
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+      compile: true,
+    });
+
+    for (let i = 0; i < inputs.length; i += 1) {
+      const standalone = await evaluate({
+        program: compiled,
+        input: inputs[i],
+        gasLimit: TEST_GAS_LIMIT,
+        manifest: HOST_V1_MANIFEST,
+        handlers: createHandlers(),
+      });
+      expect(batch[i]).toEqual(standalone);
+    }
+  });
+
+  it('rejects the whole batch when any input is invalid', async () => {
+    const handlers = createHandlers();
+    await expect(
+      evaluateBatch({
+        program,
+        inputs: [inputs[0], { ...inputs[1], steps: undefined as never }],
+        gasLimit: TEST_GAS_LIMIT,
+        manifest: HOST_V1_MANIFEST,
+        handlers,
+      }),
+    ).rejects.toThrow(/steps/);
+    expect(handlers.document.get).not.toHaveBeenCalled();
+  });
 });
 
 function createHandlers(
@@ -5,7 +5,14 @@ import {
   type DvLimits,
   decodeDv,
 } from '@blue-quickjs/dv';
-import { initializeDeterministicVm } from './deterministic-init.js';
+import {
+  type DeterministicEvalResult,
+  type DeterministicVm,
+  type GasTrace,
+  type HostTapeRecord,
+  compileProgram,
+  initializeDeterministicVm,
+} from './deterministic-init.js';
 import type {
   HostDispatcherHandlers,
   HostDispatcherOptions,
@@ -14,24 +21,31 @@ import {
   type InputEnvelope,
   type InputValidationOptions,
   type ProgramArtifact,
+  isBytecodeProgram,
   validateInputEnvelope,
   validateProgramArtifact,
 } from './quickjs-runtime.js';
 import {
+  type RuntimeAllocatorOptions,
   type RuntimeArtifactSelection,
   type RuntimeInstance,
   createRuntime,
 } from './runtime.js';
+import type { RuntimePool } from './runtime-pool.js';
 import {
   createInvalidOutputError,
   mapVmError,
   type EvaluateInvalidOutputDetail,
   type EvaluateVmErrorDetail,
 } from './evaluate-errors.js';
-import { parseHexToBytes } from './hex-utils.js';
+import type { HostGasBreakdown } from './host-gas.js';
+import { bytesToHex, parseHexToBytes } from './hex-utils.js';
 
 export interface EvaluateOptions
-  extends RuntimeArtifactSelection, HostDispatcherOptions {
+  extends
+    RuntimeArtifactSelection,
+    RuntimeAllocatorOptions,
+    HostDispatcherOptions {
   program: ProgramArtifact;
   input: InputEnvelope;
   gasLimit: bigint | number;
@@ -43,15 +57,49 @@ export interface EvaluateOptions
    */
   outputDvLimits?: Partial<DvLimits>;
   /**
-   * Enable host-call tape recording (capacity defaults to 128; max 1024).
+   * Enable host-call tape recording. The default ring mode keeps the last
+   * `capacity` records (defaults to 128; max 1024) and returns them as
+   * `result.tape`. Stream mode hands every record to `onRecords` as the run
+   * goes, in call order, with constant VM memory; `result.tape` is then
+   * omitted.
    */
-  tape?: { capacity?: number };
+  tape?: EvaluateTapeOptions;
   /**
    * Enable gas trace recording for the evaluation.
    */
   gasTrace?: boolean;
+  /**
+   * Record host-call gas per function as `result.hostGas`: the part of
+   * `gasUsed` that `gasTrace` leaves out. Not available with a ring `tape`;
+   * use stream mode alongside it.
+   */
+  hostGas?: boolean;
+  /**
+   * Read the result through the legacy text channel (`qjs_det_eval`) instead
+   * of the binary struct. Debug only; results are identical. Ignored for
+   * bytecode programs, which have no text channel, and for the `async` build
+   * type, which only suspends through the binary channel.
+   */
+  textOutput?: boolean;
+  /**
+   * Lease a warm runtime from this pool instead of instantiating one. The
+   * pool's artifact selection, allocator and dvLimits apply; the per-call
+   * artifact selection, allocator and dvLimits options are ignored.
+   */
+  pool?: RuntimePool;
+  /**
+   * A pooled evaluation that runs out of memory is rerun on a fresh runtime
+   * when it had not called any handler yet. Set this to rerun it even after
+   * handlers ran: they are then called again, so only do so when they have
+   * no side effects. Without it such an OOM is returned as it is.
+   */
+  retryOutOfMemory?: boolean;
 }
 
+export type EvaluateTapeOptions =
+  | { mode?: 'ring'; capacity?: number }
+  | { mode: 'stream'; onRecords: (records: HostTapeRecord[]) => void };
+
 export type EvaluateSuccess = {
   ok: true;
   value: DV;
@@ -60,6 +108,7 @@ export type EvaluateSuccess = {
   raw: string;
   tape?: HostTapeRecord[];
   gasTrace?: GasTrace;
+  hostGas?: HostGasBreakdown;
 };
 
 type EvaluateFailureBase = {
@@ -71,6 +120,7 @@ type EvaluateFailureBase = {
   raw: string;
   tape?: HostTapeRecord[];
   gasTrace?: GasTrace;
+  hostGas?: HostGasBreakdown;
 };
 
 export type EvaluateVmError = EvaluateFailureBase & {
@@ -88,6 +138,17 @@ export type EvaluateError = EvaluateVmError | EvaluateInvalidOutputError;
 export type EvaluateResult = EvaluateSuccess | EvaluateError;
 
 const HOST_TAPE_MAX_CAPACITY = 1024;
+const UTF8_DECODER = new TextDecoder();
+
+export interface EvaluateBatchOptions extends Omit<EvaluateOptions, 'input'> {
+  inputs: readonly InputEnvelope[];
+  /**
+   * Compile a source program to bytecode once before the batch. Items then
+   * match standalone `evaluate()` calls of the compiled artifact, which bill
+   * less gas than the source form; leave unset for source-identical results.
+   */
+  compile?: boolean;
+}
 
 export async function evaluate(
   options: EvaluateOptions,
@@ -95,19 +156,261 @@ export async function evaluate(
   const program = validateProgramArtifact(options.program);
   const input = validateInputEnvelope(options.input, options.inputValidation);
 
+  const run = (runtime: RuntimeInstance) => {
+    assertEngineBuildHash(program, runtime);
+    return runItem(runtime, program, input, options);
+  };
+  if (!options.pool) {
+    return withRuntime(options, program, run);
+  }
+
+  const tracked = trackHandlerCalls(options.handlers);
+  const result = await withRuntime(
+    { ...options, handlers: tracked.handlers },
+    program,
+    run,
+  );
+  const called = tracked.take();
+  if (isOutOfMemory(result) && (options.retryOutOfMemory || !called)) {
+    return withRuntime(options, program, run, true);
+  }
+  return result;
+}
+
+/**
+ * Evaluate one program over many input envelopes in a single runtime. The
+ * program and every input are validated up front (any invalid input rejects
+ * the whole batch before anything runs), the runtime is created or leased
+ * once, and each input gets a fresh VM. Item `i` is identical to
+ * `evaluate({ ...options, input: inputs[i] })`: gas and results do not depend
+ * on the runtime's earlier evaluations. Items that run out of memory on the
+ * reused runtime are rerun on a fresh one under the same rules as `evaluate`.
+ */
+export async function evaluateBatch(
+  options: EvaluateBatchOptions,
+): Promise<EvaluateResult[]> {
+  const validated = validateProgramArtifact(options.program);
+  const inputs = options.inputs.map((input) =>
+    validateInputEnvelope(input, options.inputValidation),
+  );
+  if (inputs.length === 0) {
+    return [];
+  }
+
+  let program: ProgramArtifact = validated;
+  const tracked = trackHandlerCalls(options.handlers);
+  const calledHandlers: boolean[] = [];
+  const results = await withRuntime(
+    { ...options, handlers: tracked.handlers },
+    validated,
+    async (runtime) => {
+      assertEngineBuildHash(validated, runtime);
+      if (options.compile && !isBytecodeProgram(validated)) {
+        program = compileProgram(runtime, validated);
+      }
+      // One suspendable evaluation per runtime at a time, so run items in
+      // order; handler calls are attributed to the item that made them.
+      const items: EvaluateResult[] = [];
+      for (const input of inputs) {
+        items.push(await runItem(runtime, program, input, options));
+        calledHandlers.push(tracked.take());
+      }
+      return items;
+    },
+  );
+
+  // Only the first unpooled item ran on a fresh runtime.
+  for (let i = options.pool ? 0 : 1; i < results.length; i++) {
+    if (
+      isOutOfMemory(results[i]) &&
+      (options.retryOutOfMemory || !calledHandlers[i])
+    ) {
+      results[i] = await withRuntime(
+        options,
+        validated,
+        (runtime) => runItem(runtime, program, inputs[i], options),
+        true,
+      );
+    }
+  }
+  return results;
+}
+
+function runItem(
+  runtime: RuntimeInstance,
+  program: ProgramArtifact,
+  input: InputEnvelope,
+  options: Omit<EvaluateOptions, 'input'>,
+): EvaluateResult | Promise<EvaluateResult> {
+  return runtime.buildType === 'async'
+    ? runEvaluationAsync(runtime, program, input, options)
+    : runEvaluation(runtime, program, input, options);
+}
+
+/**
+ * Where an allocation fails depends on the heap layout, which only a fresh
+ * runtime fixes. Reused runtimes can fail earlier, so their OOMs are rerun.
+ */
+function isOutOfMemory(result: EvaluateResult): boolean {
+  return (
+    !result.ok &&
+    result.type === 'vm-error' &&
+    result.error.kind === 'out-of-memory'
+  );
+}
+
+function hasOutOfMemory(result: EvaluateResult | EvaluateResult[]): boolean {
+  return Array.isArray(result)
+    ? result.some(isOutOfMemory)
+    : isOutOfMemory(result);
+}
+
+/**
+ * Wrap the handlers so a rerun can tell whether an attempt reached them.
+ * `take` reports calls since the last `take`.
+ */
+function trackHandlerCalls(handlers: HostDispatcherHandlers): {
+  handlers: HostDispatcherHandlers;
+  take(): boolean;
+} {
+  let called = false;
+  const track =
+    <A extends unknown[], R>(fn: (...args: A) => R) =>
+    (...args: A): R => {
+      called = true;
+      return fn(...args);
+    };
+  const { document, emit } = handlers;
+  return {
+    handlers: {
+      document: {
+        get: track(document.get.bind(document)),
+        getCanonical: track(document.getCanonical.bind(document)),
+        ...(document.getMany && {
+          getMany: track(document.getMany.bind(document)),
+        }),
+      },
+      ...(emit && { emit: track(emit.bind(handlers)) }),
+    },
+    take() {
+      const result = called;
+      called = false;
+      return result;
+    },
+  };
+}
+
+async function withRuntime<T extends EvaluateResult | EvaluateResult[]>(
+  options: Omit<EvaluateOptions, 'input'>,
+  program: ProgramArtifact,
+  run: (runtime: RuntimeInstance) => T | Promise<T>,
+  fresh = false,
+): Promise<T> {
+  if (options.pool) {
+    const lease = await options.pool.acquire({
+      manifest: options.manifest,
+      handlers: options.handlers,
+      expectedAbiId: program.abiId,
+      expectedAbiVersion: program.abiVersion,
+      fresh,
+    });
+    let discard = true;
+    try {
+      const result = await run(lease.runtime);
+      // A runtime that ran out of memory is likely fragmented; retire it.
+      discard = hasOutOfMemory(result);
+      return result;
+    } finally {
+      lease.release({ discard });
+    }
+  }
+
   const runtime = await createRuntime({
     manifest: options.manifest,
     handlers: options.handlers,
+    backend: options.backend,
+    allowNonConsensus: options.allowNonConsensus,
     variant: options.variant,
     buildType: options.buildType,
+    memoryProfile: options.memoryProfile,
     metadata: options.metadata,
     wasmBinary: options.wasmBinary,
+    wasmModule: options.wasmModule,
+    allocator: options.allocator,
     dvLimits: options.dvLimits,
     expectedAbiId: program.abiId,
     expectedAbiVersion: program.abiVersion,
   });
 
-  assertEngineBuildHash(program, runtime);
+  return run(runtime);
+}
+
+function runEvaluation(
+  runtime: RuntimeInstance,
+  program: ProgramArtifact,
+  input: InputEnvelope,
+  options: Omit<EvaluateOptions, 'input'>,
+): EvaluateResult {
+  const vm = startEvaluation(runtime, program, input, options);
+  try {
+    const dvLimits = normalizeDvLimits(options.outputDvLimits);
+    const outcome = isBytecodeProgram(program)
+      ? decodeBinaryOutcome(
+          vm.evalBytecode(program.bytecode, program.bytecodeMac),
+          dvLimits,
+        )
+      : options.textOutput
+        ? runTextEval(vm, program.code, dvLimits)
+        : decodeBinaryOutcome(vm.evalBinary(program.code), dvLimits);
+    return finishEvaluation(runtime, vm, outcome, options);
+  } finally {
+    vm.dispose();
+  }
+}
+
+/**
+ * `runEvaluation` for the `async` build type: host handlers may return
+ * promises while the VM stays suspended. Same gas, tape and result shape.
+ */
+async function runEvaluationAsync(
+  runtime: RuntimeInstance,
+  program: ProgramArtifact,
+  input: InputEnvelope,
+  options: Omit<EvaluateOptions, 'input'>,
+): Promise<EvaluateResult> {
+  const vm = startEvaluation(runtime, program, input, options);
+  try {
+    const dvLimits = normalizeDvLimits(options.outputDvLimits);
+    const output = isBytecodeProgram(program)
+      ? await vm.evalBytecodeAsync(program.bytecode, program.bytecodeMac)
+      : await vm.evalBinaryAsync(program.code);
+    return finishEvaluation(
+      runtime,
+      vm,
+      decodeBinaryOutcome(output, dvLimits),
+      options,
+    );
+  } finally {
+    vm.dispose();
+  }
+}
+
+function startEvaluation(
+  runtime: RuntimeInstance,
+  program: ProgramArtifact,
+  input: InputEnvelope,
+  options: Omit<EvaluateOptions, 'input'>,
+): DeterministicVm {
+  const tape = options.tape;
+  const tapeCapacity =
+    tape && tape.mode !== 'stream'
+      ? normalizeTapeCapacity(tape.capacity ?? 128)
+      : null;
+  if (options.hostGas && tapeCapacity !== null) {
+    throw new Error(
+      "hostGas cannot be combined with a ring tape (use tape: { mode: 'stream' })",
+    );
+  }
 
   const vm = initializeDeterministicVm(
     runtime,
@@ -116,74 +419,172 @@ export async function evaluate(
     options.gasLimit,
   );
 
-  if (options.tape) {
-    const capacity = options.tape.capacity ?? 128;
-    if (!Number.isInteger(capacity) || capacity < 0) {
-      throw new Error('tape capacity must be a non-negative integer');
-    }
-    if (capacity > HOST_TAPE_MAX_CAPACITY) {
-      throw new Error(
-        `tape capacity exceeds max (${HOST_TAPE_MAX_CAPACITY}); received ${capacity}`,
-      );
-    }
-    vm.enableTape(capacity);
+  if (tape?.mode === 'stream') {
+    vm.streamTape(tape.onRecords);
+  } else if (tapeCapacity !== null) {
+    vm.enableTape(tapeCapacity);
   }
 
-  if (options.gasTrace) {
-    vm.enableGasTrace(true);
+  if (options.gasTrace || options.hostGas) {
+    vm.enableGasTrace(true, { hostGas: options.hostGas });
   }
+  return vm;
+}
 
-  try {
-    const raw = vm.eval(program.code);
-    const parsed = parseEvalOutput(raw);
-    const tape = options.tape ? parseTape(vm.readTape()) : undefined;
-    const trace = options.gasTrace
-      ? parseGasTrace(vm.readGasTrace())
-      : undefined;
-
-    if (parsed.kind === 'error') {
-      const error = mapVmError(parsed.payload, runtime.manifest);
-      return {
+function finishEvaluation(
+  runtime: RuntimeInstance,
+  vm: DeterministicVm,
+  outcome: EvalOutcome,
+  options: Omit<EvaluateOptions, 'input'>,
+): EvaluateResult {
+  let tape: HostTapeRecord[] | undefined;
+  if (options.tape?.mode === 'stream') {
+    vm.flushTape();
+  } else if (options.tape) {
+    tape = vm.readTapeRecords();
+  }
+  const trace = options.gasTrace ? vm.readGasTraceCounters() : undefined;
+  const hostGas = options.hostGas ? vm.readHostGas() : undefined;
+
+  if (outcome.kind === 'error') {
+    const error = mapVmError(outcome.message, runtime.manifest);
+    return withRaw<EvaluateVmError>(
+      {
         ok: false,
         type: 'vm-error',
         message: error.message,
         error,
-        gasUsed: parsed.gasUsed,
-        gasRemaining: parsed.gasRemaining,
-        raw,
+        gasUsed: outcome.gasUsed,
+        gasRemaining: outcome.gasRemaining,
         tape,
         gasTrace: trace,
-      };
-    }
+        hostGas,
+      },
+      outcome.raw,
+    );
+  }
 
-    const decoded = decodeResultPayload(parsed.payload, options.outputDvLimits);
-    if (decoded.kind === 'error') {
-      const error = createInvalidOutputError(decoded.message, decoded.cause);
-      return {
+  const decoded = outcome.decoded;
+  if (decoded.kind === 'error') {
+    const error = createInvalidOutputError(decoded.message, decoded.cause);
+    return withRaw<EvaluateInvalidOutputError>(
+      {
         ok: false,
         type: 'invalid-output',
         message: error.message,
         error,
-        gasUsed: parsed.gasUsed,
-        gasRemaining: parsed.gasRemaining,
-        raw,
+        gasUsed: outcome.gasUsed,
+        gasRemaining: outcome.gasRemaining,
         tape,
         gasTrace: trace,
-      };
-    }
+        hostGas,
+      },
+      outcome.raw,
+    );
+  }
 
-    return {
+  return withRaw<EvaluateSuccess>(
+    {
       ok: true,
       value: decoded.value,
-      gasUsed: parsed.gasUsed,
-      gasRemaining: parsed.gasRemaining,
-      raw,
+      gasUsed: outcome.gasUsed,
+      gasRemaining: outcome.gasRemaining,
       tape,
       gasTrace: trace,
+      hostGas,
+    },
+    outcome.raw,
+  );
+}
+
+type EvalOutcome = {
+  gasRemaining: bigint;
+  gasUsed: bigint;
+  raw: () => string;
+} & (
+  | { kind: 'error'; message: string }
+  | { kind: 'result'; decoded: DecodedResultPayload }
+);
+
+function runTextEval(
+  vm: DeterministicVm,
+  code: string,
+  limits: DvLimits,
+): EvalOutcome {
+  const raw = vm.eval(code);
+  const parsed = parseEvalOutput(raw);
+  const base = {
+    gasRemaining: parsed.gasRemaining,
+    gasUsed: parsed.gasUsed,
+    raw: () => raw,
+  };
+  if (parsed.kind === 'error') {
+    return { ...base, kind: 'error', message: parsed.payload };
+  }
+  return {
+    ...base,
+    kind: 'result',
+    decoded: decodeResultPayload(parsed.payload, limits),
+  };
+}
+
+/**
+ * Decode straight from the shim-owned result buffer. Only the `raw` text is
+ * deferred: it keeps a copy of the payload and is formatted on first access.
+ */
+function decodeBinaryOutcome(
+  output: DeterministicEvalResult,
+  limits: DvLimits,
+): EvalOutcome {
+  const { gasRemaining, gasUsed } = output;
+
+  if (output.kind === 'error') {
+    const message = UTF8_DECODER.decode(output.payload);
+    return {
+      kind: 'error',
+      message: message.trim(),
+      gasRemaining,
+      gasUsed,
+      raw: () => formatRawOutput('ERROR', message, gasRemaining, gasUsed),
     };
-  } finally {
-    vm.dispose();
   }
+
+  const decoded = decodeBinaryPayload(output.payload, limits);
+  const payload = output.payload.slice();
+  return {
+    kind: 'result',
+    decoded,
+    gasRemaining,
+    gasUsed,
+    raw: () =>
+      formatRawOutput('RESULT', bytesToHex(payload), gasRemaining, gasUsed),
+  };
+}
+
+function formatRawOutput(
+  kind: 'RESULT' | 'ERROR',
+  payload: string,
+  gasRemaining: bigint,
+  gasUsed: bigint,
+): string {
+  return `${kind} ${payload} GAS remaining=${gasRemaining} used=${gasUsed}`;
+}
+
+/**
+ * Attach `raw` as an enumerable, memoized getter so the text form is only
+ * built when a caller reads it.
+ */
+function withRaw<T extends EvaluateResult>(
+  result: Omit<T, 'raw'>,
+  compute: () => string,
+): T {
+  let cached: string | undefined;
+  Object.defineProperty(result, 'raw', {
+    enumerable: true,
+    configurable: true,
+    get: () => (cached ??= compute()),
+  });
+  return result as T;
 }
 
 type ParsedEvalOutput = {
@@ -238,9 +639,8 @@ type DecodedResultPayload =
 
 function decodeResultPayload(
   payload: string,
-  limits?: Partial<DvLimits>,
+  dvLimits: DvLimits,
 ): DecodedResultPayload {
-  const dvLimits = normalizeDvLimits(limits);
   let bytes: Uint8Array;
   try {
     bytes = parseHexToBytes(payload, dvLimits.maxEncodedBytes);
@@ -252,178 +652,40 @@ function decodeResultPayload(
     };
   }
 
-  try {
-    const value = decodeDv(bytes, { limits: dvLimits });
-    return { kind: 'ok', value };
-  } catch (err) {
-    return {
-      kind: 'error',
-      message: `VM returned non-DV value: ${err instanceof Error ? err.message : String(err)}`,
-      cause: err,
-    };
-  }
-}
-
-export interface HostTapeRecord {
-  fnId: number;
-  reqLen: number;
-  respLen: number;
-  units: number;
-  gasPre: bigint;
-  gasPost: bigint;
-  isError: boolean;
-  chargeFailed: boolean;
-  reqHash: string;
-  respHash: string;
+  return decodeDvPayload(bytes, dvLimits);
 }
 
-function parseTape(raw: string): HostTapeRecord[] {
-  const parsed = parseJson(raw, 'tape');
-  if (!Array.isArray(parsed)) {
-    throw new Error('tape payload is not an array');
+function decodeBinaryPayload(
+  bytes: Uint8Array,
+  dvLimits: DvLimits,
+): DecodedResultPayload {
+  if (bytes.length === 0) {
+    return { kind: 'error', message: 'VM returned an empty DV payload' };
   }
-
-  return parsed.map((record, idx) => {
-    if (record === null || typeof record !== 'object') {
-      throw new Error(`tape record ${idx} is not an object`);
-    }
-
-    const fnId = expectUint32(record.fnId, `tape[${idx}].fnId`);
-    const reqLen = expectUint32(record.reqLen, `tape[${idx}].reqLen`);
-    const respLen = expectUint32(record.respLen, `tape[${idx}].respLen`);
-    const units = expectUint32(record.units, `tape[${idx}].units`);
-    const gasPre = expectBigIntString(record.gasPre, `tape[${idx}].gasPre`);
-    const gasPost = expectBigIntString(record.gasPost, `tape[${idx}].gasPost`);
-    const isError = Boolean(record.isError);
-    const chargeFailed = Boolean(record.chargeFailed);
-    const reqHash = expectHex(record.reqHash, `tape[${idx}].reqHash`, 64);
-    const respHash = expectHex(record.respHash, `tape[${idx}].respHash`, 64);
-
+  if (bytes.length > dvLimits.maxEncodedBytes) {
     return {
-      fnId,
-      reqLen,
-      respLen,
-      units,
-      gasPre,
-      gasPost,
-      isError,
-      chargeFailed,
-      reqHash,
-      respHash,
+      kind: 'error',
+      message: `VM returned oversized DV payload: payload exceeds maxBytes (${bytes.length} > ${dvLimits.maxEncodedBytes})`,
     };
-  });
-}
-
-export interface GasTrace {
-  opcodeCount: bigint;
-  opcodeGas: bigint;
-  arrayCbBaseCount: bigint;
-  arrayCbBaseGas: bigint;
-  arrayCbPerElCount: bigint;
-  arrayCbPerElGas: bigint;
-  allocationCount: bigint;
-  allocationBytes: bigint;
-  allocationGas: bigint;
-}
-
-function parseGasTrace(raw: string): GasTrace {
-  const obj = expectRecord(parseJson(raw, 'gasTrace'), 'gasTrace');
-
-  return {
-    opcodeCount: expectBigIntString(obj.opcodeCount, 'gasTrace.opcodeCount'),
-    opcodeGas: expectBigIntString(obj.opcodeGas, 'gasTrace.opcodeGas'),
-    arrayCbBaseCount: expectBigIntString(
-      obj.arrayCbBaseCount,
-      'gasTrace.arrayCbBaseCount',
-    ),
-    arrayCbBaseGas: expectBigIntString(
-      obj.arrayCbBaseGas,
-      'gasTrace.arrayCbBaseGas',
-    ),
-    arrayCbPerElCount: expectBigIntString(
-      obj.arrayCbPerElCount,
-      'gasTrace.arrayCbPerElCount',
-    ),
-    arrayCbPerElGas: expectBigIntString(
-      obj.arrayCbPerElGas,
-      'gasTrace.arrayCbPerElGas',
-    ),
-    allocationCount: expectBigIntString(
-      obj.allocationCount,
-      'gasTrace.allocationCount',
-    ),
-    allocationBytes: expectBigIntString(
-      obj.allocationBytes,
-      'gasTrace.allocationBytes',
-    ),
-    allocationGas: expectBigIntString(
-      obj.allocationGas,
-      'gasTrace.allocationGas',
-    ),
-  };
-}
-
-function parseJson(raw: string, label: string): unknown {
-  try {
-    return JSON.parse(raw);
-  } catch (err) {
-    throw new Error(
-      `${label} payload is not valid JSON: ${err instanceof Error ? err.message : String(err)}`,
-    );
   }
-}
 
-function expectUint32(value: unknown, path: string): number {
-  if (typeof value !== 'number' || !Number.isInteger(value) || value < 0) {
-    throw new Error(`${path} must be a non-negative integer`);
-  }
-  if (value > 0xffffffff) {
-    throw new Error(`${path} exceeds uint32`);
-  }
-  return value;
+  return decodeDvPayload(bytes, dvLimits);
 }
 
-function expectBigIntString(value: unknown, path: string): bigint {
-  if (typeof value === 'bigint') {
-    if (value < 0n) {
-      throw new Error(`${path} must be non-negative`);
-    }
-    return value;
-  }
-  if (typeof value !== 'string') {
-    throw new Error(`${path} must be a string`);
-  }
+function decodeDvPayload(
+  bytes: Uint8Array,
+  dvLimits: DvLimits,
+): DecodedResultPayload {
   try {
-    const parsed = BigInt(value);
-    if (parsed < 0n) {
-      throw new Error(`${path} must be non-negative`);
-    }
-    return parsed;
+    const value = decodeDv(bytes, { limits: dvLimits });
+    return { kind: 'ok', value };
   } catch (err) {
-    throw new Error(
-      `${path} is not a valid bigint string: ${err instanceof Error ? err.message : String(err)}`,
-    );
-  }
-}
-
-function expectHex(value: unknown, path: string, length: number): string {
-  if (typeof value !== 'string') {
-    throw new Error(`${path} must be a hex string`);
-  }
-  if (value.length !== length) {
-    throw new Error(`${path} must be ${length} hex characters`);
-  }
-  if (!/^[0-9a-f]+$/.test(value)) {
-    throw new Error(`${path} must be lowercase hex`);
-  }
-  return value;
-}
-
-function expectRecord(value: unknown, path: string): Record<string, unknown> {
-  if (value === null || typeof value !== 'object' || Array.isArray(value)) {
-    throw new Error(`${path} payload is not an object`);
+    return {
+      kind: 'error',
+      message: `VM returned non-DV value: ${err instanceof Error ? err.message : String(err)}`,
+      cause: err,
+    };
   }
-  return value as Record<string, unknown>;
 }
 
 function normalizeDvLimits(overrides?: Partial<DvLimits>): DvLimits {
@@ -453,6 +715,18 @@ function parseUint64(text: string, label: string): bigint {
   }
 }
 
+function normalizeTapeCapacity(capacity: number): number {
+  if (!Number.isInteger(capacity) || capacity < 0) {
+    throw new Error('tape capacity must be a non-negative integer');
+  }
+  if (capacity > HOST_TAPE_MAX_CAPACITY) {
+    throw new Error(
+      `tape capacity exceeds max (${HOST_TAPE_MAX_CAPACITY}); received ${capacity}`,
+    );
+  }
+  return capacity;
+}
+
 function assertEngineBuildHash(
   program: ProgramArtifact,
   runtime: RuntimeInstance,
@@ -27,3 +27,33 @@ export function parseHexToBytes(
   }
   return bytes;
 }
+
+const HEX_BYTES = Array.from({ length: 256 }, (_, byte) =>
+  byte.toString(16).padStart(2, '0'),
+);
+
+/**
+ * Render bytes as lowercase hex (the inverse of `parseHexToBytes`).
+ */
+export function bytesToHex(bytes: Uint8Array): string {
+  let out = '';
+  for (let i = 0; i < bytes.length; i += 1) {
+    out += HEX_BYTES[bytes[i]];
+  }
+  return out;
+}
+
+/**
+ * Byte-wise equality of two arrays.
+ */
+export function bytesEqual(a: Uint8Array, b: Uint8Array): boolean {
+  if (a.length !== b.length) {
+    return false;
+  }
+  for (let i = 0; i < a.length; i += 1) {
+    if (a[i] !== b[i]) {
+      return false;
+    }
+  }
+  return true;
+}
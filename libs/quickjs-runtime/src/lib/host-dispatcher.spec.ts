@@ -6,6 +6,8 @@ import {
   type HostDispatchResult,
   type HostDispatcher,
   type HostCallMemory,
+  EncodedDv,
+  createAsyncHostCallImport,
   createHostCallImport,
   createHostDispatcher,
 } from './host-dispatcher.js';
@@ -14,6 +16,34 @@ const DOC_GET_ID = getFnId('document.get');
 const DOC_GET_CANONICAL_ID = getFnId('document.getCanonical');
 const EMIT_ID = getFnId('emit');
 const UINT32_MAX = 0xffffffff;
+const DOC_GET_MANY_ID = 4;
+const BATCH_MANIFEST = {
+  ...HOST_V1_MANIFEST,
+  functions: [
+    ...HOST_V1_MANIFEST.functions,
+    {
+      fn_id: DOC_GET_MANY_ID,
+      js_path: ['document', 'getMany'],
+      effect: 'READ' as const,
+      arity: 1,
+      arg_schema: [{ type: 'dv' as const }],
+      return_schema: { type: 'dv' as const },
+      gas: {
+        schedule_id: 'doc-read-many-v1',
+        base: 20,
+        k_arg_bytes: 1,
+        k_ret_bytes: 1,
+        k_units: 1,
+      },
+      limits: {
+        max_request_bytes: 32768,
+        max_response_bytes: 262144,
+        max_units: 1000,
+      },
+      error_codes: [{ code: 'LIMIT_EXCEEDED', tag: 'host/limit' }],
+    },
+  ],
+};
 
 describe('host dispatcher', () => {
   it('dispatches document.get successfully', () => {
@@ -64,6 +94,136 @@ describe('host dispatcher', () => {
     });
   });
 
+  it('splices pre-encoded document results into the envelope', () => {
+    const stored = new EncodedDv(encodeDv({ title: 'doc', tags: ['a'] }));
+    const handlers = createHandlers({
+      get: vi.fn(() => ({ ok: stored, units: 5 })),
+    });
+    const dispatcher = createHostDispatcher(HOST_V1_MANIFEST, handlers);
+
+    for (let i = 0; i < 2; i += 1) {
+      const result = dispatcher.dispatch(DOC_GET_ID, encodeDv(['doc']));
+      expect(result.kind).toBe('response');
+      expect(
+        (result as Extract<HostDispatchResult, { kind: 'response' }>).envelope,
+      ).toEqual(encodeDv({ ok: { title: 'doc', tags: ['a'] }, units: 5 }));
+    }
+  });
+
+  it('validates pre-encoded results and applies response limits', () => {
+    const invalid = createHostDispatcher(
+      HOST_V1_MANIFEST,
+      createHandlers({
+        get: () => ({
+          ok: new EncodedDv(Uint8Array.from([0x18, 0x01])),
+          units: 1,
+        }),
+      }),
+    );
+    const fatal = expectFatal(invalid.dispatch(DOC_GET_ID, encodeDv(['doc'])));
+    expect(fatal.error.code).toBe('HANDLER_ERROR');
+
+    const oversized = createHostDispatcher(
+      HOST_V1_MANIFEST,
+      createHandlers({
+        get: () => ({
+          ok: new EncodedDv(encodeDv('x'.repeat(262_140)), 'large'),
+          units: 1,
+        }),
+      }),
+    );
+    expect(
+      expectResponse(oversized.dispatch(DOC_GET_ID, encodeDv(['doc']))),
+    ).toEqual({ err: { code: 'LIMIT_EXCEEDED' }, units: 0 });
+  });
+
+  it('revalidates pre-encoded results whose key no longer matches', () => {
+    const valid = encodeDv({ title: 'doc' });
+    const bytes = valid.slice();
+    let hashed = new EncodedDv(valid, 'doc-1');
+    const dispatcher = createHostDispatcher(
+      HOST_V1_MANIFEST,
+      createHandlers({
+        get: (path: string) => ({
+          ok: path === 'hashed' ? hashed : new EncodedDv(bytes),
+          units: 1,
+        }),
+      }),
+    );
+    const get = (path: string) =>
+      dispatcher.dispatch(DOC_GET_ID, encodeDv([path]));
+
+    expect(expectResponse(get('hashed'))).toEqual({
+      ok: { title: 'doc' },
+      units: 1,
+    });
+    hashed = new EncodedDv(Uint8Array.from([0x18, 0x01]), 'doc-1');
+    expect(expectFatal(get('hashed')).error.code).toBe('HANDLER_ERROR');
+
+    expect(expectResponse(get('buffer'))).toEqual({
+      ok: { title: 'doc' },
+      units: 1,
+    });
+    bytes.fill(0xff);
+    expect(expectFatal(get('buffer')).error.code).toBe('HANDLER_ERROR');
+  });
+
+  it('batches document.get requests through document.getMany', async () => {
+    const handlers = createHandlers({
+      get: vi.fn((path: string) =>
+        path === 'missing'
+          ? { err: { code: 'NOT_FOUND', tag: 'host/not_found' }, units: 2 }
+          : { ok: { path }, units: 5 },
+      ),
+    });
+    const dispatcher = createHostDispatcher(BATCH_MANIFEST, handlers);
+    const request = encodeDv([['a', 'missing', 'x'.repeat(3000)]]);
+    const result = dispatcher.dispatch(DOC_GET_MANY_ID, request);
+
+    expect(expectResponse(result)).toEqual({
+      ok: [
+        { ok: { path: 'a' }, units: 5 },
+        { err: { code: 'NOT_FOUND' }, units: 2 },
+        { err: { code: 'LIMIT_EXCEEDED' }, units: 0 },
+      ],
+      units: 7,
+    });
+    expect(handlers.document.get).toHaveBeenCalledTimes(2);
+
+    const getMany = vi.fn(async (paths: string[]) =>
+      paths.map((path) => ({ ok: { path }, units: 400 })),
+    );
+    const bulk = createHostDispatcher(
+      BATCH_MANIFEST,
+      createHandlers({ getMany }),
+    );
+    const pending = bulk.dispatchAsync?.(
+      DOC_GET_MANY_ID,
+      encodeDv([['a', 'b']]),
+    );
+    expect(
+      expectResponse(await (pending as Promise<HostDispatchResult>)),
+    ).toEqual({
+      ok: [
+        { ok: { path: 'a' }, units: 400 },
+        { ok: { path: 'b' }, units: 400 },
+      ],
+      units: 800,
+    });
+    expect(getMany).toHaveBeenCalledWith(['a', 'b']);
+
+    const overBudget = bulk.dispatchAsync?.(
+      DOC_GET_MANY_ID,
+      encodeDv([['a', 'b', 'c']]),
+    );
+    expect(
+      expectResponse(await (overBudget as Promise<HostDispatchResult>)),
+    ).toEqual({
+      err: { code: 'LIMIT_EXCEEDED' },
+      units: 0,
+    });
+  });
+
   it('returns fatal on unknown fn_id', () => {
     const handlers = createHandlers();
     const dispatcher = createHostDispatcher(HOST_V1_MANIFEST, handlers);
@@ -134,6 +294,95 @@ describe('host dispatcher', () => {
     expect(envelope).toEqual({ ok: { path: 'path/to/doc' }, units: 5 });
   });
 
+  it('follows the memory buffer when it is replaced after creation', () => {
+    const dispatcher = createHostDispatcher(HOST_V1_MANIFEST, createHandlers());
+    const memory: HostCallMemory = { buffer: new ArrayBuffer(0) };
+    const hostCall = createHostCallImport(dispatcher, memory);
+    const request = encodeDv(['doc']);
+
+    expect(hostCall(DOC_GET_ID, 0, request.length, 64, 128)).toBe(UINT32_MAX);
+
+    for (const buffer of [createMemory().buffer, createMemory().buffer]) {
+      memory.buffer = buffer;
+      const mem = new Uint8Array(buffer);
+      mem.set(request, 0);
+      const written = hostCall(DOC_GET_ID, 0, request.length, 64, 128);
+      expect(decodeDv(mem.subarray(64, 64 + written))).toEqual({
+        ok: { path: 'doc' },
+        units: 5,
+      });
+    }
+  });
+
+  it('awaits promise-returning handlers only through dispatchAsync', async () => {
+    const handlers = createHandlers({
+      get: vi.fn(async (path: string) => ({ ok: { path }, units: 5 })),
+    });
+    const dispatcher = createHostDispatcher(HOST_V1_MANIFEST, handlers);
+    const request = encodeDv(['path/to/doc']);
+
+    const fatal = expectFatal(dispatcher.dispatch(DOC_GET_ID, request));
+    expect(fatal.error.code).toBe('HANDLER_ERROR');
+
+    const pending = dispatcher.dispatchAsync?.(DOC_GET_ID, request);
+    expect(pending).toBeInstanceOf(Promise);
+    expect(
+      expectResponse(await (pending as Promise<HostDispatchResult>)),
+    ).toEqual({ ok: { path: 'path/to/doc' }, units: 5 });
+
+    // Synchronous handlers still settle without a promise.
+    const settled = dispatcher.dispatchAsync?.(DOC_GET_CANONICAL_ID, request);
+    expect(expectResponse(settled as HostDispatchResult)).toEqual({
+      ok: { canonical: 'path/to/doc' },
+      units: 3,
+    });
+  });
+
+  it('suspends the async host_call import until the handler settles', async () => {
+    let release: () => void = () => undefined;
+    const gate = new Promise<void>((resolve) => {
+      release = resolve;
+    });
+    const handlers = createHandlers({
+      get: vi.fn(async (path: string) => {
+        await gate;
+        return { ok: { path }, units: 5 };
+      }),
+    });
+    const dispatcher = createHostDispatcher(HOST_V1_MANIFEST, handlers);
+    const memory = createMemory();
+    let suspendable = true;
+    const hostCall = createAsyncHostCallImport(
+      dispatcher,
+      memory,
+      () => suspendable,
+    );
+
+    const request = encodeDv(['path/to/doc']);
+    const mem = new Uint8Array(memory.buffer);
+    mem.subarray(64, 64 + request.length).set(request);
+
+    const pending = hostCall(DOC_GET_ID, 64, request.length, 256, 512);
+    expect(pending).toBeInstanceOf(Promise);
+    expect(hostCall(DOC_GET_ID, 64, request.length, 256, 512)).toBe(
+      UINT32_MAX,
+    );
+    release();
+    const written = await pending;
+    expect(
+      decodeDv(mem.subarray(256, 256 + written)) as { ok: unknown },
+    ).toEqual({ ok: { path: 'path/to/doc' }, units: 5 });
+
+    expect(
+      hostCall(DOC_GET_CANONICAL_ID, 64, request.length, 256, 512),
+    ).toBeGreaterThan(0);
+
+    suspendable = false;
+    expect(hostCall(DOC_GET_ID, 64, request.length, 256, 512)).toBe(
+      UINT32_MAX,
+    );
+  });
+
   it('returns transport sentinel on overlapping request/response ranges', () => {
     const handlers = createHandlers();
     const dispatcher = createHostDispatcher(HOST_V1_MANIFEST, handlers);
@@ -217,6 +466,7 @@ function createHandlers(
   overrides?: Partial<{
     get: DocumentHostHandlers['get'];
     getCanonical: DocumentHostHandlers['getCanonical'];
+    getMany: DocumentHostHandlers['getMany'];
     emit: EmitHostHandler['emit'];
   }>,
 ) {
@@ -227,6 +477,7 @@ function createHandlers(
       getCanonical:
         overrides?.getCanonical ??
         vi.fn((path: string) => ({ ok: { canonical: path }, units: 3 })),
+      getMany: overrides?.getMany,
     },
     emit:
       overrides?.emit ??
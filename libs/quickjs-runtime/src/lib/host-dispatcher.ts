@@ -9,13 +9,21 @@ import {
   DV_LIMIT_DEFAULTS,
   type DvLimits,
   DvError,
+  DvView,
   decodeDv,
   encodeDv,
   validateDv,
+  validateEncodedDv,
 } from '@blue-quickjs/dv';
+import { bytesEqual } from './hex-utils.js';
 
 const UINT32_MAX = 0xffffffff;
 const UTF8 = new TextEncoder();
+const ENCODED_DV_CACHE_LIMIT = 1024;
+
+// `{ ok, units }` in canonical key order: map(2), "ok", value, "units", uint.
+const OK_ENVELOPE_HEAD = Uint8Array.from([0xa2, ...encodeDv('ok')]);
+const UNITS_KEY = encodeDv('units');
 
 export interface HostCallError {
   code: string;
@@ -27,13 +35,46 @@ export type HostCallResult<T extends DV | null = DV> =
   | { ok: T; units: number }
   | { err: HostCallError; units: number };
 
+/**
+ * Canonical DV bytes a document handler already holds, e.g. as stored.
+ * Returning `{ ok: new EncodedDv(bytes), units }` splices them into the
+ * response envelope with no decode/re-encode. Each dispatcher validates a
+ * private copy of the bytes once, remembered by `hash` when given or by the
+ * `bytes` buffer otherwise. Later results under the same key are compared
+ * byte for byte with that copy and validated again when they differ, so a
+ * reused hash or a mutated buffer costs a revalidation but is never trusted.
+ */
+export class EncodedDv {
+  constructor(
+    public readonly bytes: Uint8Array,
+    public readonly hash?: string,
+  ) {}
+}
+
+export type DocumentHostResult =
+  | HostCallResult<DV>
+  | { ok: EncodedDv; units: number };
+
+/**
+ * Handlers may return a Promise only when the runtime uses the `async` build
+ * type; the synchronous builds report such results as HANDLER_ERROR.
+ */
+export type MaybePromise<T> = T | PromiseLike<T>;
+
 export interface DocumentHostHandlers {
-  get(path: string): HostCallResult<DV>;
-  getCanonical(path: string): HostCallResult<DV>;
+  get(path: string): MaybePromise<DocumentHostResult>;
+  getCanonical(path: string): MaybePromise<DocumentHostResult>;
+  /**
+   * Optional bulk read for a manifest-declared `document.getMany`. Receives
+   * the paths that passed the per-path `document.get` checks, in request
+   * order, and returns one `document.get` result per path. Without it the
+   * dispatcher calls `get` once per path.
+   */
+  getMany?(paths: string[]): MaybePromise<DocumentHostResult[]>;
 }
 
 export interface EmitHostHandler {
-  emit(value: DV): HostCallResult<null>;
+  emit(value: DV): MaybePromise<HostCallResult<null>>;
 }
 
 export interface HostDispatcherHandlers {
@@ -82,6 +123,16 @@ export interface HostDispatcher {
     fnId: number,
     requestBytes: ArrayBufferView | ArrayBuffer,
   ): HostDispatchResult;
+  /**
+   * Like `dispatch`, but lets handlers return promises. Settles synchronously
+   * when the handler did, so callers only suspend for real I/O. The request
+   * is decoded before this returns, so its bytes may be reused immediately.
+   * Custom dispatchers without it serve async imports through `dispatch`.
+   */
+  dispatchAsync?(
+    fnId: number,
+    requestBytes: ArrayBufferView | ArrayBuffer,
+  ): MaybePromise<HostDispatchResult>;
 }
 
 export interface HostCallMemory {
@@ -96,6 +147,14 @@ export type HostCallImport = (
   respCap: number,
 ) => number;
 
+/**
+ * `host_call` for the `async` build type: a returned Promise suspends the VM
+ * until it settles with the written length or the transport sentinel.
+ */
+export type AsyncHostCallImport = (
+  ...args: Parameters<HostCallImport>
+) => MaybePromise<number>;
+
 export function createHostDispatcher(
   manifest: AbiManifest,
   handlers: HostDispatcherHandlers,
@@ -120,72 +179,94 @@ export function createHostDispatcher(
   const dvLimits = normalizeDvLimits(options?.dvLimits);
   const bindings = buildBindings(canonical.functions, handlers);
 
-  return {
-    manifest: canonical,
-    dispatch(
-      fnId: number,
-      requestBytes: ArrayBufferView | ArrayBuffer,
-    ): HostDispatchResult {
-      const normalizedFnId = toUint32(fnId);
-      const binding = bindings.get(normalizedFnId);
-      if (!binding) {
-        return fatal('UNKNOWN_FUNCTION', `unknown fn_id ${normalizedFnId}`);
-      }
+  const dispatchAsync = (
+    fnId: number,
+    requestBytes: ArrayBufferView | ArrayBuffer,
+  ): MaybePromise<HostDispatchResult> => {
+    const normalizedFnId = toUint32(fnId);
+    const binding = bindings.get(normalizedFnId);
+    if (!binding) {
+      return fatal('UNKNOWN_FUNCTION', `unknown fn_id ${normalizedFnId}`);
+    }
 
-      const request = asUint8Array(requestBytes);
-      if (request.length > binding.fn.limits.max_request_bytes) {
-        if (binding.limitExceededEnvelope) {
-          return encodeEnvelope(
-            binding.fn,
-            binding.limitExceededEnvelope,
-            dvLimits,
-          );
-        }
-        return fatalLimitError(binding.fn);
+    const request = asUint8Array(requestBytes);
+    if (request.length > binding.fn.limits.max_request_bytes) {
+      if (binding.limitExceededEnvelope) {
+        return encodeEnvelope(
+          binding.fn,
+          binding.limitExceededEnvelope,
+          dvLimits,
+        );
       }
+      return fatalLimitError(binding.fn);
+    }
 
-      const decodeLimits = {
-        ...dvLimits,
-        maxEncodedBytes: Math.min(
-          dvLimits.maxEncodedBytes,
-          binding.fn.limits.max_request_bytes,
-        ),
-      };
+    const decodeLimits = {
+      ...dvLimits,
+      maxEncodedBytes: Math.min(
+        dvLimits.maxEncodedBytes,
+        binding.fn.limits.max_request_bytes,
+      ),
+    };
 
-      let args: DV;
-      try {
-        args = decodeDv(request, { limits: decodeLimits });
-      } catch (err) {
-        return fatal(
-          'INVALID_REQUEST',
-          `failed to decode request for fn_id=${normalizedFnId}: ${stringifyError(err)}`,
-          err,
-        );
-      }
+    let args: DV;
+    try {
+      args = decodeDv(request, { limits: decodeLimits });
+    } catch (err) {
+      return fatal(
+        'INVALID_REQUEST',
+        `failed to decode request for fn_id=${normalizedFnId}: ${stringifyError(err)}`,
+        err,
+      );
+    }
 
-      if (!Array.isArray(args)) {
-        return fatal(
-          'INVALID_ARGUMENTS',
-          `request for fn_id=${normalizedFnId} must be a DV array`,
-        );
-      }
-      if (args.length !== binding.fn.arity) {
-        return fatal(
-          'INVALID_ARGUMENTS',
-          `fn_id=${normalizedFnId} expected ${binding.fn.arity} args, received ${args.length}`,
-        );
-      }
+    if (!Array.isArray(args)) {
+      return fatal(
+        'INVALID_ARGUMENTS',
+        `request for fn_id=${normalizedFnId} must be a DV array`,
+      );
+    }
+    if (args.length !== binding.fn.arity) {
+      return fatal(
+        'INVALID_ARGUMENTS',
+        `fn_id=${normalizedFnId} expected ${binding.fn.arity} args, received ${args.length}`,
+      );
+    }
 
-      try {
-        return binding.dispatch(args, dvLimits);
-      } catch (err) {
-        return fatal(
-          'HANDLER_ERROR',
-          `fn_id=${normalizedFnId} handler threw: ${stringifyError(err)}`,
-          err,
-        );
+    const handlerThrew = (err: unknown): HostDispatchResult =>
+      fatal(
+        'HANDLER_ERROR',
+        `fn_id=${normalizedFnId} handler threw: ${stringifyError(err)}`,
+        err,
+      );
+    try {
+      const result = binding.dispatch(args, dvLimits);
+      return isPromiseLike(result)
+        ? Promise.resolve(result).catch(handlerThrew)
+        : result;
+    } catch (err) {
+      return handlerThrew(err);
+    }
+  };
+
+  return {
+    manifest: canonical,
+    dispatch(
+      fnId: number,
+      requestBytes: ArrayBufferView | ArrayBuffer,
+    ): HostDispatchResult {
+      const result = dispatchAsync(fnId, requestBytes);
+      if (!isPromiseLike(result)) {
+        return result;
       }
+      // The VM gets a transport failure; drop any late rejection.
+      Promise.resolve(result).catch(() => undefined);
+      return fatal(
+        'HANDLER_ERROR',
+        `fn_id=${toUint32(fnId)} handler returned a Promise; async handlers require the async build type`,
+      );
     },
+    dispatchAsync,
   };
 }
 
@@ -193,6 +274,7 @@ export function createHostCallImport(
   dispatcher: HostDispatcher,
   memory: HostCallMemory,
 ): HostCallImport {
+  const heap = createHeapView(memory);
   let inProgress = false;
   return (fnId, reqPtr, reqLen, respPtr, respCap) => {
     if (inProgress) {
@@ -200,48 +282,163 @@ export function createHostCallImport(
     }
     inProgress = true;
     try {
-      const mem = new Uint8Array(memory.buffer);
-      const reqOffset = toUint32(reqPtr);
-      const reqLength = toUint32(reqLen);
-      const respOffset = toUint32(respPtr);
-      const respCapacity = toUint32(respCap);
-      const fn = toUint32(fnId);
-
-      if (
-        !withinBounds(mem, reqOffset, reqLength) ||
-        !withinBounds(mem, respOffset, respCapacity)
-      ) {
-        return UINT32_MAX;
-      }
-      if (rangesOverlap(reqOffset, reqLength, respOffset, respCapacity)) {
+      const call = readHostCall(
+        heap(),
+        fnId,
+        reqPtr,
+        reqLen,
+        respPtr,
+        respCap,
+      );
+      if (!call) {
         return UINT32_MAX;
       }
+      return writeHostResponse(
+        heap(),
+        call,
+        dispatcher.dispatch(call.fnId, call.request),
+      );
+    } catch {
+      return UINT32_MAX;
+    } finally {
+      inProgress = false;
+    }
+  };
+}
 
-      const request = mem.subarray(reqOffset, reqOffset + reqLength);
-      const result = dispatcher.dispatch(fn, request);
-      if (result.kind === 'fatal') {
+/**
+ * `host_call` import for the `async` build type. Calls whose handlers answer
+ * synchronously return a length as usual; otherwise the returned Promise keeps
+ * the VM suspended (and further calls rejected) until the response is written.
+ * `canSuspend` reports whether the VM was entered through an async export;
+ * promises seen outside one fail the call instead of unwinding a sync caller.
+ */
+export function createAsyncHostCallImport(
+  dispatcher: HostDispatcher,
+  memory: HostCallMemory,
+  canSuspend: () => boolean,
+): AsyncHostCallImport {
+  const heap = createHeapView(memory);
+  let inProgress = false;
+  return (fnId, reqPtr, reqLen, respPtr, respCap) => {
+    if (inProgress) {
+      return UINT32_MAX;
+    }
+    inProgress = true;
+    let pending = false;
+    try {
+      const call = readHostCall(
+        heap(),
+        fnId,
+        reqPtr,
+        reqLen,
+        respPtr,
+        respCap,
+      );
+      if (!call) {
         return UINT32_MAX;
       }
-
-      if (result.envelope.length > respCapacity) {
+      const result = dispatcher.dispatchAsync
+        ? dispatcher.dispatchAsync(call.fnId, call.request)
+        : dispatcher.dispatch(call.fnId, call.request);
+      if (!isPromiseLike(result)) {
+        return writeHostResponse(heap(), call, result);
+      }
+      if (!canSuspend()) {
+        Promise.resolve(result).catch(() => undefined);
         return UINT32_MAX;
       }
-
-      mem
-        .subarray(respOffset, respOffset + result.envelope.length)
-        .set(result.envelope);
-      return result.envelope.length >>> 0;
+      pending = true;
+      return Promise.resolve(result)
+        .then(
+          (settled) => writeHostResponse(heap(), call, settled),
+          () => UINT32_MAX,
+        )
+        .finally(() => {
+          inProgress = false;
+        });
     } catch {
       return UINT32_MAX;
     } finally {
-      inProgress = false;
+      if (!pending) {
+        inProgress = false;
+      }
     }
   };
 }
 
+/**
+ * Byte view over `memory.buffer`, created once and rebuilt only when the
+ * buffer is replaced (memory growth, or the runtime installing the instance
+ * memory after the import was created), instead of on every host call.
+ */
+function createHeapView(memory: HostCallMemory): () => Uint8Array {
+  let view = new Uint8Array(memory.buffer);
+  return () => {
+    if (view.buffer !== memory.buffer) {
+      view = new Uint8Array(memory.buffer);
+    }
+    return view;
+  };
+}
+
+type HostCallFrame = {
+  fnId: number;
+  request: Uint8Array;
+  respOffset: number;
+  respCapacity: number;
+};
+
+function readHostCall(
+  mem: Uint8Array,
+  fnId: number,
+  reqPtr: number,
+  reqLen: number,
+  respPtr: number,
+  respCap: number,
+): HostCallFrame | null {
+  const reqOffset = toUint32(reqPtr);
+  const reqLength = toUint32(reqLen);
+  const respOffset = toUint32(respPtr);
+  const respCapacity = toUint32(respCap);
+
+  if (
+    !withinBounds(mem, reqOffset, reqLength) ||
+    !withinBounds(mem, respOffset, respCapacity)
+  ) {
+    return null;
+  }
+  if (rangesOverlap(reqOffset, reqLength, respOffset, respCapacity)) {
+    return null;
+  }
+
+  return {
+    fnId: toUint32(fnId),
+    request: mem.subarray(reqOffset, reqOffset + reqLength),
+    respOffset,
+    respCapacity,
+  };
+}
+
+function writeHostResponse(
+  mem: Uint8Array,
+  call: HostCallFrame,
+  result: HostDispatchResult,
+): number {
+  if (result.kind === 'fatal') {
+    return UINT32_MAX;
+  }
+  if (result.envelope.length > call.respCapacity) {
+    return UINT32_MAX;
+  }
+
+  mem.set(result.envelope, call.respOffset);
+  return result.envelope.length >>> 0;
+}
+
 type HostFunctionBinding = {
   fn: CanonicalFunction;
-  dispatch(args: DV[], dvLimits: DvLimits): HostDispatchResult;
+  dispatch(args: DV[], dvLimits: DvLimits): MaybePromise<HostDispatchResult>;
   limitExceededEnvelope?: HostResponseEnvelope;
 };
 
@@ -287,10 +484,20 @@ function buildBindings(
     );
   }
 
-  bindings.set(
-    documentGet.fn_id,
-    buildDocumentBinding(documentGet, handlers.document.get),
-  );
+  const getBinding = buildDocumentBinding(documentGet, handlers.document.get);
+  bindings.set(documentGet.fn_id, getBinding);
+  const documentGetMany = byPath.get('document.getMany');
+  if (documentGetMany) {
+    bindings.set(
+      documentGetMany.fn_id,
+      buildDocumentBatchBinding(
+        documentGetMany,
+        getBinding,
+        handlers.document.get,
+        handlers.document.getMany,
+      ),
+    );
+  }
   bindings.set(
     documentGetCanonical.fn_id,
     buildDocumentBinding(documentGetCanonical, handlers.document.getCanonical),
@@ -312,44 +519,218 @@ function buildBindings(
   return bindings;
 }
 
+type DocumentBinding = HostFunctionBinding & {
+  /**
+   * Pre-handler checks for one path; a result answers it without a handler.
+   */
+  checkPath(path: DV, dvLimits: DvLimits): HostDispatchResult | null;
+  encode(result: DocumentHostResult, dvLimits: DvLimits): HostDispatchResult;
+};
+
 function buildDocumentBinding(
   fn: CanonicalFunction,
   handler: DocumentHostHandlers['get'],
-): HostFunctionBinding {
+): DocumentBinding {
   assertDocumentShape(fn);
   const limitExceededEnvelope = createLimitEnvelope(fn);
+  const validatedEncoded = createEncodedDvCache();
+  const checkPath = (
+    path: DV,
+    dvLimits: DvLimits,
+  ): HostDispatchResult | null => {
+    if (typeof path !== 'string') {
+      return fatal(
+        'INVALID_ARGUMENTS',
+        `fn_id=${fn.fn_id} expected string path argument`,
+      );
+    }
+
+    const utf8Max = fn.limits.arg_utf8_max?.[0];
+    if (utf8Max !== undefined) {
+      const byteLen = UTF8.encode(path).byteLength;
+      if (byteLen > utf8Max) {
+        if (limitExceededEnvelope) {
+          return encodeEnvelope(fn, limitExceededEnvelope, dvLimits);
+        }
+        return fatal(
+          'INVALID_ARGUMENTS',
+          `fn_id=${fn.fn_id} path exceeds utf8 limit (${byteLen} > ${utf8Max})`,
+        );
+      }
+    }
+    return null;
+  };
+  const encode = (
+    result: DocumentHostResult,
+    dvLimits: DvLimits,
+  ): HostDispatchResult =>
+    encodeResult(fn, result, dvLimits, limitExceededEnvelope, validatedEncoded);
   return {
     fn,
     limitExceededEnvelope,
-    dispatch(args: DV[], dvLimits: DvLimits): HostDispatchResult {
+    checkPath,
+    encode,
+    dispatch(args: DV[], dvLimits: DvLimits): MaybePromise<HostDispatchResult> {
       const [path] = args;
-      if (typeof path !== 'string') {
+      const checked = checkPath(path, dvLimits);
+      if (checked) {
+        return checked;
+      }
+      return whenSettled(handler(path as string), (result) =>
+        encode(result, dvLimits),
+      );
+    },
+  };
+}
+
+/**
+ * `document.getMany(paths)`: one host call carrying many `document.get`
+ * requests. Each path is checked, handled and encoded exactly as a single
+ * `document.get` call would be, and the batch answers with
+ * `{ ok: [envelope, ...], units: <sum of item units> }` under the batch
+ * function's own limits. Any fatal item fails the whole call.
+ */
+function buildDocumentBatchBinding(
+  fn: CanonicalFunction,
+  item: DocumentBinding,
+  handler: DocumentHostHandlers['get'],
+  batchHandler: DocumentHostHandlers['getMany'],
+): HostFunctionBinding {
+  assertDocumentBatchShape(fn);
+  const limitExceededEnvelope = createLimitEnvelope(fn);
+  return {
+    fn,
+    limitExceededEnvelope,
+    dispatch(args: DV[], dvLimits: DvLimits): MaybePromise<HostDispatchResult> {
+      const [paths] = args;
+      if (!Array.isArray(paths)) {
         return fatal(
           'INVALID_ARGUMENTS',
-          `fn_id=${fn.fn_id} expected string path argument`,
+          `fn_id=${fn.fn_id} expected an array of paths`,
         );
       }
 
-      const utf8Max = fn.limits.arg_utf8_max?.[0];
-      if (utf8Max !== undefined) {
-        const byteLen = UTF8.encode(path).byteLength;
-        if (byteLen > utf8Max) {
-          if (limitExceededEnvelope) {
-            return encodeEnvelope(fn, limitExceededEnvelope, dvLimits);
-          }
+      // Items nest two levels deeper than a single response (envelope, array).
+      const itemLimits = { ...dvLimits, maxDepth: dvLimits.maxDepth - 2 };
+      const items = paths.map((path) => item.checkPath(path, itemLimits));
+      const pending: string[] = [];
+      for (let i = 0; i < paths.length; i += 1) {
+        if (items[i] === null) {
+          pending.push(paths[i] as string);
+        }
+      }
+
+      const finish = (
+        results: readonly DocumentHostResult[],
+      ): HostDispatchResult => {
+        if (results.length !== pending.length) {
           return fatal(
-            'INVALID_ARGUMENTS',
-            `fn_id=${fn.fn_id} path exceeds utf8 limit (${byteLen} > ${utf8Max})`,
+            'HANDLER_ERROR',
+            `fn_id=${fn.fn_id} getMany returned ${results.length} results for ${pending.length} paths`,
           );
         }
-      }
+        let next = 0;
+        const envelopes = items.map(
+          (checked) => checked ?? item.encode(results[next++], itemLimits),
+        );
+        return encodeBatchEnvelope(
+          fn,
+          envelopes,
+          dvLimits,
+          limitExceededEnvelope,
+        );
+      };
 
-      const result = handler(path);
-      return encodeResult(fn, result, dvLimits, limitExceededEnvelope);
+      if (batchHandler) {
+        return pending.length === 0
+          ? finish([])
+          : whenSettled(batchHandler(pending), finish);
+      }
+      const results = pending.map((path) => handler(path));
+      return results.some(isPromiseLike)
+        ? Promise.all(results).then(finish)
+        : finish(results as DocumentHostResult[]);
     },
   };
 }
 
+function encodeBatchEnvelope(
+  fn: CanonicalFunction,
+  items: readonly HostDispatchResult[],
+  dvLimits: DvLimits,
+  limitExceededEnvelope?: HostResponseEnvelope,
+): HostDispatchResult {
+  const envelopes: Uint8Array[] = [];
+  let units = 0;
+  for (const result of items) {
+    if (result.kind === 'fatal') {
+      return result;
+    }
+    envelopes.push(result.envelope);
+    units += DvView.from(result.envelope).get('units')?.toValue() as number;
+  }
+
+  const limits = cappedDvLimits(dvLimits, fn.limits.max_response_bytes);
+  if (units > fn.limits.max_units || items.length > limits.maxArrayLength) {
+    if (limitExceededEnvelope) {
+      return encodeEnvelope(fn, limitExceededEnvelope, dvLimits);
+    }
+    return fatal(
+      'RESPONSE_LIMIT',
+      `fn_id=${fn.fn_id} batch exceeds max_units or array length (${units} units, ${items.length} items)`,
+    );
+  }
+
+  const head = arrayHeader(envelopes.length);
+  const unitsBytes = encodeDv(units);
+  let length =
+    OK_ENVELOPE_HEAD.length +
+    head.length +
+    UNITS_KEY.length +
+    unitsBytes.length;
+  for (const envelope of envelopes) {
+    length += envelope.length;
+  }
+  if (length > limits.maxEncodedBytes) {
+    if (limitExceededEnvelope) {
+      return encodeEnvelope(fn, limitExceededEnvelope, dvLimits);
+    }
+    return fatal(
+      'RESPONSE_LIMIT',
+      `fn_id=${fn.fn_id} failed to encode response: encoded DV exceeds maxEncodedBytes (${length} > ${limits.maxEncodedBytes})`,
+    );
+  }
+
+  const envelope = new Uint8Array(length);
+  let offset = 0;
+  for (const part of [OK_ENVELOPE_HEAD, head, ...envelopes, UNITS_KEY]) {
+    envelope.set(part, offset);
+    offset += part.length;
+  }
+  envelope.set(unitsBytes, offset);
+  return { kind: 'response', envelope };
+}
+
+// Canonical CBOR array header (major type 4) for an array of `length` items.
+function arrayHeader(length: number): Uint8Array {
+  if (length < 24) {
+    return Uint8Array.of(0x80 | length);
+  }
+  if (length <= 0xff) {
+    return Uint8Array.of(0x98, length);
+  }
+  if (length <= 0xffff) {
+    return Uint8Array.of(0x99, length >>> 8, length & 0xff);
+  }
+  return Uint8Array.of(
+    0x9a,
+    length >>> 24,
+    (length >>> 16) & 0xff,
+    (length >>> 8) & 0xff,
+    length & 0xff,
+  );
+}
+
 function buildEmitBinding(
   fn: CanonicalFunction,
   handler: EmitHostHandler['emit'],
@@ -359,19 +740,21 @@ function buildEmitBinding(
   return {
     fn,
     limitExceededEnvelope,
-    dispatch(args: DV[], dvLimits: DvLimits): HostDispatchResult {
+    dispatch(args: DV[], dvLimits: DvLimits): MaybePromise<HostDispatchResult> {
       const [value] = args;
-      const result = handler(value);
-      return encodeResult(fn, result, dvLimits, limitExceededEnvelope);
+      return whenSettled(handler(value), (result) =>
+        encodeResult(fn, result, dvLimits, limitExceededEnvelope),
+      );
     },
   };
 }
 
 function encodeResult(
   fn: CanonicalFunction,
-  result: HostCallResult,
+  result: DocumentHostResult,
   dvLimits: DvLimits,
   limitExceededEnvelope?: HostResponseEnvelope,
+  validatedEncoded?: EncodedDvCache,
 ): HostDispatchResult {
   if (result === null || typeof result !== 'object') {
     return fatal('HANDLER_ERROR', `fn_id=${fn.fn_id} returned invalid result`);
@@ -421,6 +804,22 @@ function encodeResult(
         `fn_id=${fn.fn_id} must return null for return_schema "null"`,
       );
     }
+    if (result.ok instanceof EncodedDv) {
+      if (!validatedEncoded) {
+        return fatal(
+          'HANDLER_ERROR',
+          `fn_id=${fn.fn_id} does not accept pre-encoded DV results`,
+        );
+      }
+      return spliceEncodedEnvelope(
+        fn,
+        result.ok,
+        units,
+        dvLimits,
+        validatedEncoded,
+        limitExceededEnvelope,
+      );
+    }
     if (fn.return_schema.type === 'dv') {
       try {
         validateDv(result.ok, {
@@ -525,6 +924,93 @@ function encodeEnvelope(
   }
 }
 
+/**
+ * Build `{ ok: <encoded>, units }` around pre-encoded bytes, applying the same
+ * limits as `encodeEnvelope`. The value sits one level inside the envelope, so
+ * it is validated with one less level of depth.
+ */
+function spliceEncodedEnvelope(
+  fn: CanonicalFunction,
+  value: EncodedDv,
+  units: number,
+  dvLimits: DvLimits,
+  validated: EncodedDvCache,
+  limitExceededEnvelope?: HostResponseEnvelope,
+): HostDispatchResult {
+  const limits = cappedDvLimits(dvLimits, fn.limits.max_response_bytes);
+  let bytes = validated.lookup(value);
+  if (!bytes) {
+    // Validate and splice a snapshot, so the caller cannot change the bytes
+    // after they were checked.
+    const snapshot = value.bytes.slice();
+    try {
+      validateEncodedDv(snapshot, {
+        limits: { ...limits, maxDepth: limits.maxDepth - 1 },
+      });
+    } catch (err) {
+      return handleDvValidationError(fn, err, limitExceededEnvelope, dvLimits);
+    }
+    validated.add(value, snapshot);
+    bytes = snapshot;
+  }
+
+  const unitsBytes = encodeDv(units);
+  const length =
+    OK_ENVELOPE_HEAD.length +
+    bytes.length +
+    UNITS_KEY.length +
+    unitsBytes.length;
+  if (length > limits.maxEncodedBytes) {
+    if (limitExceededEnvelope) {
+      return encodeEnvelope(fn, limitExceededEnvelope, dvLimits);
+    }
+    return fatal(
+      'RESPONSE_LIMIT',
+      `fn_id=${fn.fn_id} failed to encode response: encoded DV exceeds maxEncodedBytes (${length} > ${limits.maxEncodedBytes})`,
+    );
+  }
+
+  const envelope = new Uint8Array(length);
+  let offset = 0;
+  for (const part of [OK_ENVELOPE_HEAD, bytes, UNITS_KEY, unitsBytes]) {
+    envelope.set(part, offset);
+    offset += part.length;
+  }
+  return { kind: 'response', envelope };
+}
+
+type EncodedDvCache = {
+  /** The validated copy of `value.bytes`, if it still matches them. */
+  lookup(value: EncodedDv): Uint8Array | undefined;
+  add(value: EncodedDv, snapshot: Uint8Array): void;
+};
+
+function createEncodedDvCache(): EncodedDvCache {
+  const byBuffer = new WeakMap<Uint8Array, Uint8Array>();
+  const byHash = new Map<string, Uint8Array>();
+  return {
+    lookup(value) {
+      const snapshot =
+        value.hash === undefined
+          ? byBuffer.get(value.bytes)
+          : byHash.get(value.hash);
+      return snapshot && bytesEqual(snapshot, value.bytes)
+        ? snapshot
+        : undefined;
+    },
+    add(value, snapshot) {
+      if (value.hash === undefined) {
+        byBuffer.set(value.bytes, snapshot);
+        return;
+      }
+      if (byHash.size >= ENCODED_DV_CACHE_LIMIT) {
+        byHash.clear();
+      }
+      byHash.set(value.hash, snapshot);
+    },
+  };
+}
+
 function createLimitEnvelope(
   fn: CanonicalFunction,
 ): HostResponseEnvelope | undefined {
@@ -555,6 +1041,26 @@ function assertDocumentShape(fn: CanonicalFunction): void {
   }
 }
 
+function assertDocumentBatchShape(fn: CanonicalFunction): void {
+  if (fn.effect !== 'READ') {
+    throw new HostDispatcherError(
+      'INVALID_REQUEST',
+      `document.getMany must be a READ function (fn_id=${fn.fn_id})`,
+    );
+  }
+  if (
+    fn.arity !== 1 ||
+    fn.arg_schema.length !== 1 ||
+    fn.arg_schema[0]?.type !== 'dv' ||
+    fn.return_schema.type !== 'dv'
+  ) {
+    throw new HostDispatcherError(
+      'INVALID_REQUEST',
+      `document.getMany must take one DV argument and return DV (fn_id=${fn.fn_id})`,
+    );
+  }
+}
+
 function assertEmitShape(fn: CanonicalFunction): void {
   if (fn.arity !== 1 || fn.arg_schema.length !== 1) {
     throw new HostDispatcherError(
@@ -697,6 +1203,21 @@ function withErrorTags(fn: AbiFunction): CanonicalFunction {
   return { ...fn, errorTagMap };
 }
 
+function isPromiseLike<T>(value: MaybePromise<T>): value is PromiseLike<T> {
+  return (
+    value !== null &&
+    typeof value === 'object' &&
+    typeof (value as { then?: unknown }).then === 'function'
+  );
+}
+
+function whenSettled<T, R>(
+  value: MaybePromise<T>,
+  next: (settled: T) => R,
+): MaybePromise<R> {
+  return isPromiseLike(value) ? Promise.resolve(value).then(next) : next(value);
+}
+
 function stringifyError(err: unknown): string {
   if (err instanceof Error) {
     return err.message;
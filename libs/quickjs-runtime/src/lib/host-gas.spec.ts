@@ -0,0 +1,69 @@
+import { decodeHostGasBreakdown } from './host-gas.js';
+
+describe('decodeHostGasBreakdown', () => {
+  it('decodes the packed per-function entries', () => {
+    const breakdown = decodeHostGasBreakdown(
+      buildBreakdown({ flags: 0b1, hosts: [{ fnId: 1, calls: 2, gas: 120n }] }),
+    );
+
+    expect(breakdown).toEqual({
+      truncated: true,
+      functions: [
+        {
+          fnId: 1,
+          calls: 2,
+          errors: 0,
+          chargeFailed: 0,
+          reqBytes: 20n,
+          respBytes: 30n,
+          units: 2n,
+          gas: 120n,
+        },
+      ],
+    });
+  });
+
+  it('decodes an empty table', () => {
+    expect(decodeHostGasBreakdown(buildBreakdown({}))).toEqual({
+      truncated: false,
+      functions: [],
+    });
+  });
+
+  it('rejects foreign and truncated buffers', () => {
+    const bytes = buildBreakdown({ hosts: [{ fnId: 1 }] });
+    const truncated = bytes.subarray(0, bytes.length - 1);
+    expect(() => decodeHostGasBreakdown(truncated)).toThrow(/truncated/);
+    bytes[0] = 0;
+    expect(() => decodeHostGasBreakdown(bytes)).toThrow(/magic/);
+  });
+});
+
+interface BreakdownFixture {
+  flags?: number;
+  hosts?: { fnId: number; calls?: number; gas?: bigint }[];
+}
+
+// Writes the qjs_det_read_host_gas_bin layout (see quickjs_wasm.c).
+function buildBreakdown(fixture: BreakdownFixture): Uint8Array {
+  const hosts = fixture.hosts ?? [];
+  const bytes = new Uint8Array(16 + hosts.length * 48);
+  const view = new DataView(bytes.buffer);
+
+  [0x47484a51, 1, fixture.flags ?? 0, hosts.length].forEach((value, i) =>
+    view.setUint32(i * 4, value, true),
+  );
+
+  let at = 16;
+  for (const host of hosts) {
+    const calls = host.calls ?? 1;
+    view.setUint32(at, host.fnId, true);
+    view.setUint32(at + 4, calls, true);
+    view.setBigUint64(at + 16, BigInt(calls * 10), true);
+    view.setBigUint64(at + 24, BigInt(calls * 15), true);
+    view.setBigUint64(at + 32, BigInt(calls), true);
+    view.setBigUint64(at + 40, host.gas ?? 0n, true);
+    at += 48;
+  }
+  return bytes;
+}
@@ -0,0 +1,76 @@
+// Mirror DetHostGasHeaderBin and DetHostGasBin in quickjs_wasm.c.
+const HOST_GAS_MAGIC = 0x47484a51;
+const HOST_GAS_VERSION = 1;
+const HOST_GAS_HEADER_SIZE = 16;
+const HOST_GAS_ENTRY_SIZE = 48;
+const HOST_GAS_FLAG_TRUNCATED = 1;
+
+export interface HostGasEntry {
+  fnId: number;
+  calls: number;
+  errors: number;
+  chargeFailed: number;
+  reqBytes: bigint;
+  respBytes: bigint;
+  units: bigint;
+  /** Tape `gasPre + gasPost` summed over calls (`gasPre` if post failed). */
+  gas: bigint;
+}
+
+/**
+ * Host-call gas per function: the part of `gasUsed` the gas trace leaves
+ * out. This is not an interpreter profiler; opcode gas is only reported in
+ * aggregate, by the gas trace, because the engine keeps no per-opcode or
+ * per-line counters.
+ */
+export interface HostGasBreakdown {
+  /** More distinct host functions were called than the VM table holds. */
+  truncated: boolean;
+  functions: HostGasEntry[];
+}
+
+/**
+ * Decode a `qjs_det_read_host_gas_bin` buffer. Throws on a foreign magic,
+ * an unknown version or a buffer shorter than its header claims.
+ */
+export function decodeHostGasBreakdown(bytes: Uint8Array): HostGasBreakdown {
+  if (bytes.length < HOST_GAS_HEADER_SIZE) {
+    throw new Error(`host gas breakdown is truncated (${bytes.length} bytes)`);
+  }
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.length);
+  if (view.getUint32(0, true) !== HOST_GAS_MAGIC) {
+    throw new Error('host gas breakdown has an invalid magic');
+  }
+  const version = view.getUint32(4, true);
+  if (version !== HOST_GAS_VERSION) {
+    throw new Error(`unsupported host gas breakdown version ${version}`);
+  }
+  const flags = view.getUint32(8, true);
+  const count = view.getUint32(12, true);
+  const size = HOST_GAS_HEADER_SIZE + count * HOST_GAS_ENTRY_SIZE;
+  if (size > bytes.length) {
+    throw new Error(
+      `host gas breakdown is truncated (${bytes.length} of ${size} bytes)`,
+    );
+  }
+
+  const functions: HostGasEntry[] = [];
+  for (let i = 0; i < count; i += 1) {
+    const base = HOST_GAS_HEADER_SIZE + i * HOST_GAS_ENTRY_SIZE;
+    functions.push({
+      fnId: view.getUint32(base, true),
+      calls: view.getUint32(base + 4, true),
+      errors: view.getUint32(base + 8, true),
+      chargeFailed: view.getUint32(base + 12, true),
+      reqBytes: view.getBigUint64(base + 16, true),
+      respBytes: view.getBigUint64(base + 24, true),
+      units: view.getBigUint64(base + 32, true),
+      gas: view.getBigUint64(base + 40, true),
+    });
+  }
+
+  return {
+    truncated: (flags & HOST_GAS_FLAG_TRUNCATED) !== 0,
+    functions,
+  };
+}
@@ -0,0 +1,164 @@
+import { HOST_V1_HASH, HOST_V1_MANIFEST } from '@blue-quickjs/test-harness';
+import { vi } from 'vitest';
+import { evaluate } from './evaluate.js';
+import type { HostDispatcherHandlers } from './host-dispatcher.js';
+import {
+  type ParallelEvaluateJob,
+  type ParallelWorkerEndpoint,
+  createParallelEvaluator,
+  serveParallelWorker,
+} from './parallel-evaluator.js';
+import {
+  type InputEnvelope,
+  type ProgramArtifact,
+  RuntimeValidationError,
+} from './quickjs-runtime.js';
+
+const TEST_GAS_LIMIT = 50_000n;
+
+const PROGRAM: ProgramArtifact = {
+  code: 'const doc = document("path/to/doc"); ({ doc, event, steps })',
+  abiId: 'Host.v1',
+  abiVersion: 1,
+  abiManifestHash: HOST_V1_HASH,
+};
+
+function createInput(id: number): InputEnvelope {
+  return {
+    event: { type: 'create', payload: { id } },
+    eventCanonical: { type: 'create', payload: { id } },
+    steps: [{ name: 'first' }],
+  };
+}
+
+describe('createParallelEvaluator', () => {
+  it('returns results in input order matching standalone evaluate()', async () => {
+    const evaluator = createParallelEvaluator({
+      manifest: HOST_V1_MANIFEST,
+      workers: 3,
+      createWorker: () => createInProcessWorker(),
+    });
+    const jobs: ParallelEvaluateJob[] = Array.from({ length: 7 }, (_, i) => ({
+      program: PROGRAM,
+      input: createInput(i),
+      gasLimit: TEST_GAS_LIMIT,
+      tape: { capacity: 4 },
+    }));
+
+    const results = await evaluator.evaluateAll(jobs);
+    await evaluator.close();
+
+    expect(results).toHaveLength(jobs.length);
+    for (let i = 0; i < jobs.length; i += 1) {
+      const standalone = await evaluate({
+        ...jobs[i],
+        manifest: HOST_V1_MANIFEST,
+        handlers: createHandlers(),
+      });
+      expect(results[i]).toEqual({ ...standalone });
+    }
+  });
+
+  it('lets an idle worker steal jobs queued for a busy one', async () => {
+    let startSlowWorker: () => void = () => undefined;
+    const slowWorker = new Promise<ParallelWorkerEndpoint>((resolve) => {
+      startSlowWorker = () => resolve(createInProcessWorker());
+    });
+    const evaluator = createParallelEvaluator({
+      manifest: HOST_V1_MANIFEST,
+      workers: 2,
+      maxInFlight: 1,
+      createWorker: (_url, index) =>
+        index === 0 ? slowWorker : createInProcessWorker(),
+    });
+
+    const results = await evaluator.evaluateAll(
+      Array.from({ length: 4 }, (_, i) => ({
+        program: PROGRAM,
+        input: createInput(i),
+        gasLimit: TEST_GAS_LIMIT,
+      })),
+    );
+
+    expect(results.every((result) => result.ok)).toBe(true);
+    expect(evaluator.stats()).toMatchObject({ completed: 4, stolen: 2 });
+    startSlowWorker();
+    await evaluator.close();
+  });
+
+  it('rejects jobs that fail validation inside the worker', async () => {
+    const evaluator = createParallelEvaluator({
+      manifest: HOST_V1_MANIFEST,
+      workers: 1,
+      createWorker: () => createInProcessWorker(),
+    });
+
+    const failure = evaluator.evaluate({
+      program: { ...PROGRAM, abiId: '' },
+      input: createInput(0),
+      gasLimit: TEST_GAS_LIMIT,
+    });
+    await expect(failure).rejects.toBeInstanceOf(RuntimeValidationError);
+
+    await evaluator.close();
+    await expect(
+      evaluator.evaluate({
+        program: PROGRAM,
+        input: createInput(0),
+        gasLimit: TEST_GAS_LIMIT,
+      }),
+    ).rejects.toThrow(/closed/);
+  });
+});
+
+/**
+ * Pair a coordinator endpoint with a worker port on the current thread,
+ * cloning every message the way a real worker boundary would.
+ */
+function createInProcessWorker(): ParallelWorkerEndpoint {
+  const toWorker: Array<(message: unknown) => void> = [];
+  const toMain: Array<(message: unknown) => void> = [];
+  let terminated = false;
+  const deliver =
+    (listeners: Array<(message: unknown) => void>) => (message: unknown) => {
+      const copy = structuredClone(message);
+      setTimeout(() => {
+        if (!terminated) {
+          listeners.forEach((listener) => listener(copy));
+        }
+      }, 0);
+    };
+
+  serveParallelWorker(
+    {
+      postMessage: deliver(toMain),
+      onMessage: (listener) => toWorker.push(listener),
+    },
+    { createHandlers: () => createHandlers() },
+  );
+
+  return {
+    postMessage: deliver(toWorker),
+    onMessage: (listener) => toMain.push(listener),
+    onError: () => undefined,
+    terminate: () => {
+      terminated = true;
+    },
+  };
+}
+
+function createHandlers(): HostDispatcherHandlers {
+  return {
+    document: {
+      get: vi.fn((path: string) => ({ ok: { path }, units: 5 })),
+      getCanonical: vi.fn((path: string) => ({
+        ok: { canonical: path },
+        units: 3,
+      })),
+    },
+    emit: vi.fn(() => ({
+      ok: null,
+      units: 1,
+    })),
+  };
+}
@@ -0,0 +1,646 @@
+import type { AbiManifest } from '@blue-quickjs/abi-manifest';
+import {
+  type EvaluateOptions,
+  type EvaluateTapeOptions,
+  type EvaluateResult,
+  evaluate,
+} from './evaluate.js';
+import type {
+  HostDispatcherHandlers,
+  HostDispatcherOptions,
+} from './host-dispatcher.js';
+import {
+  RuntimeValidationError,
+  type RuntimeValidationErrorCode,
+  setBytecodeKey,
+} from './quickjs-runtime.js';
+import {
+  type RuntimePool,
+  type RuntimePoolOptions,
+  createRuntimePool,
+} from './runtime-pool.js';
+
+const DEFAULT_MAX_IN_FLIGHT = 2;
+const WORKER_NAME = 'blue-quickjs-parallel-worker';
+
+/**
+ * One evaluation shipped to a worker. Everything must be structured-cloneable;
+ * the manifest, handlers and artifact selection are fixed per evaluator, and
+ * the tape can only be returned as a ring (a stream callback cannot cross).
+ */
+export type ParallelEvaluateJob = Omit<
+  EvaluateOptions,
+  | 'tape'
+  | 'manifest'
+  | 'handlers'
+  | 'pool'
+  | 'backend'
+  | 'allowNonConsensus'
+  | 'variant'
+  | 'buildType'
+  | 'memoryProfile'
+  | 'metadata'
+  | 'wasmBinary'
+  | 'wasmModule'
+  | 'allocator'
+  | 'dvLimits'
+  | 'expectedAbiId'
+  | 'expectedAbiVersion'
+> & {
+  tape?: Exclude<EvaluateTapeOptions, { mode: 'stream' }>;
+};
+
+/**
+ * Host handlers cannot cross a thread boundary, so each worker builds its own
+ * by importing `module` and calling `exportName` (default `createHandlers`)
+ * with the structured-cloneable `options`. Use an absolute URL
+ * (`new URL('./handlers.js', import.meta.url)`) or a package specifier; the
+ * worker resolves relative paths against its own entry script.
+ */
+export interface ParallelHandlersModule {
+  module: string | URL;
+  exportName?: string;
+  options?: unknown;
+}
+
+/**
+ * Transport to one worker. The default factory wraps `node:worker_threads` in
+ * Node and module Web Workers in browsers.
+ */
+export interface ParallelWorkerEndpoint {
+  postMessage(message: unknown): void;
+  onMessage(listener: (message: unknown) => void): void;
+  onError(listener: (error: unknown) => void): void;
+  terminate(): void | Promise<unknown>;
+}
+
+/**
+ * Worker-side half of the transport (`parentPort` in Node, `self` in a Web
+ * Worker).
+ */
+export interface ParallelWorkerPort {
+  postMessage(message: unknown): void;
+  onMessage(listener: (message: unknown) => void): void;
+}
+
+export interface ParallelEvaluatorOptions extends Pick<
+  HostDispatcherOptions,
+  'expectedAbiId' | 'expectedAbiVersion'
+> {
+  manifest: AbiManifest;
+  /**
+   * Where workers load their host handlers from. May be omitted when
+   * `workerUrl` points at a custom entry that passes `createHandlers` to
+   * `serveParallelWorker`.
+   */
+  handlers?: ParallelHandlersModule;
+  /**
+   * Number of workers (default: `navigator.hardwareConcurrency`, else 1).
+   */
+  workers?: number;
+  /**
+   * Jobs posted to a worker ahead of its results (default 2). Higher values
+   * hide message latency; lower values leave more jobs available to steal.
+   */
+  maxInFlight?: number;
+  /**
+   * Options for the runtime pool each worker owns. Values must be
+   * structured-cloneable (a compiled `wasmModule` is).
+   */
+  pool?: RuntimePoolOptions;
+  /**
+   * Key passed to `setBytecodeKey` in every worker. Without it each worker
+   * draws its own random key, so only source programs (or bytecode compiled
+   * under a shared key) can be shipped as jobs.
+   */
+  bytecodeKey?: Uint8Array;
+  /**
+   * Worker entry script (default: the bundled `parallel-worker.js`).
+   */
+  workerUrl?: string | URL;
+  /**
+   * Override worker creation, e.g. to supply bundler-specific workers.
+   */
+  createWorker?: (
+    url: URL,
+    index: number,
+  ) => ParallelWorkerEndpoint | Promise<ParallelWorkerEndpoint>;
+}
+
+export interface ParallelEvaluatorStats {
+  workers: number;
+  queued: number;
+  inFlight: number;
+  completed: number;
+  stolen: number;
+}
+
+export interface ParallelEvaluator {
+  evaluate(job: ParallelEvaluateJob): Promise<EvaluateResult>;
+  /**
+   * Evaluate every job; results are returned in input order regardless of
+   * which worker ran them or when they finished.
+   */
+  evaluateAll(jobs: readonly ParallelEvaluateJob[]): Promise<EvaluateResult[]>;
+  stats(): ParallelEvaluatorStats;
+  close(): Promise<void>;
+}
+
+type WorkerInitMessage = {
+  type: 'init';
+  manifest: AbiManifest;
+  handlers?: ParallelHandlersModule;
+  pool?: RuntimePoolOptions;
+  bytecodeKey?: Uint8Array;
+  expectedAbiId?: string;
+  expectedAbiVersion?: number;
+};
+
+type WorkerJobMessage = {
+  type: 'job';
+  id: number;
+  job: ParallelEvaluateJob;
+};
+
+type WorkerReply =
+  | { type: 'init-error'; error: SerializedError }
+  | { type: 'result'; id: number; result: EvaluateResult }
+  | { type: 'failure'; id: number; error: SerializedError };
+
+type SerializedError = {
+  name: string;
+  message: string;
+  code?: string;
+  path?: string;
+};
+
+type PendingJob = {
+  id: number;
+  job: ParallelEvaluateJob;
+  resolve(result: EvaluateResult): void;
+  reject(error: unknown): void;
+};
+
+type WorkerSlot = {
+  index: number;
+  endpoint: ParallelWorkerEndpoint | null;
+  deque: PendingJob[];
+  inFlight: Map<number, PendingJob>;
+  dead: boolean;
+};
+
+/**
+ * Shard `evaluate()` jobs across worker threads.
+ *
+ * Every worker owns a warm `RuntimePool` and its own host handlers, so each
+ * job behaves exactly like a standalone pooled `evaluate()`: results, gas,
+ * tape and trace do not depend on which worker ran the job. Submitted jobs
+ * are spread over per-worker deques; a worker with spare capacity takes from
+ * the head of its own deque and, once that is empty, steals from the tail of
+ * the longest other deque.
+ */
+export function createParallelEvaluator(
+  options: ParallelEvaluatorOptions,
+): ParallelEvaluator {
+  const workerCount = normalizeCount(
+    options.workers ?? defaultWorkerCount(),
+    'workers',
+  );
+  const maxInFlight = normalizeCount(
+    options.maxInFlight ?? DEFAULT_MAX_IN_FLIGHT,
+    'maxInFlight',
+  );
+  const workerUrl = new URL(
+    options.workerUrl ?? new URL('./parallel-worker.js', import.meta.url),
+  );
+  const createWorker = options.createWorker ?? createDefaultWorker;
+  const init: WorkerInitMessage = {
+    type: 'init',
+    manifest: options.manifest,
+    handlers: options.handlers,
+    pool: options.pool,
+    bytecodeKey: options.bytecodeKey,
+    expectedAbiId: options.expectedAbiId,
+    expectedAbiVersion: options.expectedAbiVersion,
+  };
+
+  const slots: WorkerSlot[] = [];
+  let nextId = 0;
+  let nextSlot = 0;
+  let completed = 0;
+  let stolen = 0;
+  let closed = false;
+  let lastWorkerError: unknown = null;
+
+  const liveSlots = () => slots.filter((slot) => !slot.dead);
+
+  const pump = (slot: WorkerSlot): void => {
+    const endpoint = slot.endpoint;
+    if (!endpoint || slot.dead) {
+      return;
+    }
+    while (slot.inFlight.size < maxInFlight) {
+      let job = slot.deque.shift();
+      if (!job) {
+        const victim = findVictim(slot);
+        if (!victim) {
+          return;
+        }
+        job = victim.deque.pop() as PendingJob;
+        stolen += 1;
+      }
+      slot.inFlight.set(job.id, job);
+      const message: WorkerJobMessage = {
+        type: 'job',
+        id: job.id,
+        job: job.job,
+      };
+      endpoint.postMessage(message);
+    }
+  };
+
+  const findVictim = (thief: WorkerSlot): WorkerSlot | null => {
+    let victim: WorkerSlot | null = null;
+    for (const slot of slots) {
+      if (slot === thief || slot.deque.length === 0) {
+        continue;
+      }
+      if (!victim || slot.deque.length > victim.deque.length) {
+        victim = slot;
+      }
+    }
+    return victim;
+  };
+
+  const pumpAll = (): void => {
+    for (const slot of slots) {
+      pump(slot);
+    }
+  };
+
+  const retire = (slot: WorkerSlot, error: unknown): void => {
+    if (slot.dead) {
+      return;
+    }
+    slot.dead = true;
+    lastWorkerError = error;
+    void slot.endpoint?.terminate();
+    for (const job of slot.inFlight.values()) {
+      job.reject(error);
+    }
+    slot.inFlight.clear();
+    const orphans = slot.deque.splice(0);
+    const survivors = liveSlots();
+    if (survivors.length === 0) {
+      for (const job of orphans) {
+        job.reject(error);
+      }
+      return;
+    }
+    orphans.forEach((job, i) => {
+      survivors[i % survivors.length].deque.push(job);
+    });
+    pumpAll();
+  };
+
+  const onReply = (slot: WorkerSlot, message: unknown): void => {
+    const reply = message as WorkerReply;
+    if (reply.type === 'init-error') {
+      retire(slot, deserializeError(reply.error));
+      return;
+    }
+    const job = slot.inFlight.get(reply.id);
+    if (!job) {
+      return;
+    }
+    slot.inFlight.delete(reply.id);
+    completed += 1;
+    if (reply.type === 'result') {
+      job.resolve(reply.result);
+    } else {
+      job.reject(deserializeError(reply.error));
+    }
+    pump(slot);
+  };
+
+  for (let index = 0; index < workerCount; index += 1) {
+    const slot: WorkerSlot = {
+      index,
+      endpoint: null,
+      deque: [],
+      inFlight: new Map(),
+      dead: false,
+    };
+    slots.push(slot);
+    Promise.resolve()
+      .then(() => createWorker(workerUrl, index))
+      .then(
+        (endpoint) => {
+          if (closed) {
+            void endpoint.terminate();
+            return;
+          }
+          slot.endpoint = endpoint;
+          endpoint.onMessage((message) => onReply(slot, message));
+          endpoint.onError((error) => retire(slot, error));
+          endpoint.postMessage(init);
+          pump(slot);
+        },
+        (error) => retire(slot, error),
+      );
+  }
+
+  const submit = (job: ParallelEvaluateJob): Promise<EvaluateResult> => {
+    if (closed) {
+      return Promise.reject(new Error('parallel evaluator is closed'));
+    }
+    const survivors = liveSlots();
+    if (survivors.length === 0) {
+      return Promise.reject(
+        lastWorkerError ?? new Error('parallel evaluator has no live workers'),
+      );
+    }
+    return new Promise<EvaluateResult>((resolve, reject) => {
+      const slot = survivors[nextSlot % survivors.length];
+      nextSlot += 1;
+      slot.deque.push({ id: nextId, job, resolve, reject });
+      nextId += 1;
+      pumpAll();
+    });
+  };
+
+  return {
+    evaluate: submit,
+
+    evaluateAll(jobs) {
+      return Promise.all(jobs.map((job) => submit(job)));
+    },
+
+    stats() {
+      let queued = 0;
+      let inFlight = 0;
+      for (const slot of slots) {
+        queued += slot.deque.length;
+        inFlight += slot.inFlight.size;
+      }
+      return {
+        workers: liveSlots().length,
+        queued,
+        inFlight,
+        completed,
+        stolen,
+      };
+    },
+
+    async close() {
+      if (closed) {
+        return;
+      }
+      closed = true;
+      const error = new Error('parallel evaluator is closed');
+      const terminations: Array<void | Promise<unknown>> = [];
+      for (const slot of slots) {
+        const pending = [...slot.deque.splice(0), ...slot.inFlight.values()];
+        for (const job of pending) {
+          job.reject(error);
+        }
+        slot.inFlight.clear();
+        slot.dead = true;
+        if (slot.endpoint) {
+          terminations.push(slot.endpoint.terminate());
+        }
+      }
+      await Promise.all(terminations);
+    },
+  };
+}
+
+export interface ServeParallelWorkerOptions {
+  /**
+   * Build host handlers inside the worker. Takes precedence over the
+   * evaluator's `handlers` module; receives its `options`.
+   */
+  createHandlers?: (
+    options: unknown,
+  ) => HostDispatcherHandlers | Promise<HostDispatcherHandlers>;
+}
+
+/**
+ * Worker-side loop: wait for the init message, build handlers and a runtime
+ * pool, then answer each job with the result of a pooled `evaluate()`. Custom
+ * worker entries (e.g. bundled browser workers) call this with statically
+ * imported handlers.
+ */
+export function serveParallelWorker(
+  port: ParallelWorkerPort,
+  serveOptions: ServeParallelWorkerOptions = {},
+): void {
+  let ready: Promise<WorkerContext> | null = null;
+
+  port.onMessage((message) => {
+    const request = message as WorkerInitMessage | WorkerJobMessage;
+    if (request.type === 'init') {
+      ready = createWorkerContext(request, serveOptions);
+      ready.catch((error: unknown) => {
+        const reply: WorkerReply = {
+          type: 'init-error',
+          error: serializeError(error),
+        };
+        port.postMessage(reply);
+      });
+      return;
+    }
+    if (request.type !== 'job') {
+      return;
+    }
+
+    const context =
+      ready ?? Promise.reject(new Error('parallel worker was not initialized'));
+    context
+      .then((ctx) =>
+        evaluate({
+          ...request.job,
+          manifest: ctx.manifest,
+          handlers: ctx.handlers,
+          expectedAbiId: ctx.expectedAbiId,
+          expectedAbiVersion: ctx.expectedAbiVersion,
+          pool: ctx.pool,
+        }),
+      )
+      .then(
+        (result) => {
+          const reply: WorkerReply = {
+            type: 'result',
+            id: request.id,
+            // Spreading materializes the lazy `raw` getter for cloning.
+            result: { ...result },
+          };
+          port.postMessage(reply);
+        },
+        (error: unknown) => {
+          const reply: WorkerReply = {
+            type: 'failure',
+            id: request.id,
+            error: serializeError(error),
+          };
+          port.postMessage(reply);
+        },
+      );
+  });
+}
+
+type WorkerContext = {
+  manifest: AbiManifest;
+  handlers: HostDispatcherHandlers;
+  pool: RuntimePool;
+  expectedAbiId?: string;
+  expectedAbiVersion?: number;
+};
+
+async function createWorkerContext(
+  init: WorkerInitMessage,
+  serveOptions: ServeParallelWorkerOptions,
+): Promise<WorkerContext> {
+  if (init.bytecodeKey) {
+    setBytecodeKey(init.bytecodeKey);
+  }
+  const handlers = await loadWorkerHandlers(init.handlers, serveOptions);
+  const pool = createRuntimePool({
+    ...init.pool,
+    max: init.pool?.max ?? 1,
+  });
+  await pool.prewarm({
+    manifest: init.manifest,
+    expectedAbiId: init.expectedAbiId,
+    expectedAbiVersion: init.expectedAbiVersion,
+  });
+  return {
+    manifest: init.manifest,
+    handlers,
+    pool,
+    expectedAbiId: init.expectedAbiId,
+    expectedAbiVersion: init.expectedAbiVersion,
+  };
+}
+
+async function loadWorkerHandlers(
+  source: ParallelHandlersModule | undefined,
+  serveOptions: ServeParallelWorkerOptions,
+): Promise<HostDispatcherHandlers> {
+  if (serveOptions.createHandlers) {
+    return serveOptions.createHandlers(source?.options);
+  }
+  if (!source) {
+    throw new Error(
+      'parallel worker has no host handlers: pass `handlers` to createParallelEvaluator or `createHandlers` to serveParallelWorker',
+    );
+  }
+  const exportName = source.exportName ?? 'createHandlers';
+  const loaded = (await import(String(source.module))) as Record<
+    string,
+    unknown
+  >;
+  const factory = loaded[exportName];
+  if (typeof factory !== 'function') {
+    throw new Error(
+      `handlers module ${String(source.module)} does not export a ${exportName}() function`,
+    );
+  }
+  return (await factory(source.options)) as HostDispatcherHandlers;
+}
+
+function serializeError(error: unknown): SerializedError {
+  if (error instanceof RuntimeValidationError) {
+    return {
+      name: error.name,
+      message: error.message,
+      code: error.code,
+      path: error.path,
+    };
+  }
+  if (error instanceof Error) {
+    const code = (error as { code?: unknown }).code;
+    return {
+      name: error.name,
+      message: error.message,
+      code: typeof code === 'string' ? code : undefined,
+    };
+  }
+  return { name: 'Error', message: String(error) };
+}
+
+function deserializeError(error: SerializedError): Error {
+  if (error.name === 'RuntimeValidationError' && error.code) {
+    return new RuntimeValidationError(
+      error.code as RuntimeValidationErrorCode,
+      error.message,
+      error.path,
+    );
+  }
+  const restored = new Error(error.message) as Error & { code?: string };
+  restored.name = error.name;
+  if (error.code !== undefined) {
+    restored.code = error.code;
+  }
+  return restored;
+}
+
+async function createDefaultWorker(url: URL): Promise<ParallelWorkerEndpoint> {
+  if (typeof process !== 'undefined' && process.versions?.node) {
+    const { Worker } = await import('node:worker_threads');
+    const worker = new Worker(url, { name: WORKER_NAME });
+    return {
+      postMessage: (message) => worker.postMessage(message),
+      onMessage: (listener) => worker.on('message', listener),
+      onError: (listener) => {
+        worker.on('error', listener);
+        worker.on('exit', (code) => {
+          if (code !== 0) {
+            listener(new Error(`parallel worker exited with code ${code}`));
+          }
+        });
+      },
+      terminate: () => worker.terminate(),
+    };
+  }
+
+  const WebWorker = (globalThis as { Worker?: WebWorkerConstructor }).Worker;
+  if (!WebWorker) {
+    throw new Error('no worker implementation is available in this runtime');
+  }
+  const worker = new WebWorker(url, { type: 'module', name: WORKER_NAME });
+  return {
+    postMessage: (message) => worker.postMessage(message),
+    onMessage: (listener) =>
+      worker.addEventListener('message', (event) =>
+        listener((event as { data: unknown }).data),
+      ),
+    onError: (listener) => worker.addEventListener('error', listener),
+    terminate: () => worker.terminate(),
+  };
+}
+
+type WebWorkerConstructor = new (
+  url: URL,
+  options: { type: 'module'; name: string },
+) => {
+  postMessage(message: unknown): void;
+  addEventListener(type: string, listener: (event: unknown) => void): void;
+  terminate(): void;
+};
+
+function defaultWorkerCount(): number {
+  const navigator = (
+    globalThis as { navigator?: { hardwareConcurrency?: number } }
+  ).navigator;
+  return Math.max(1, navigator?.hardwareConcurrency ?? 1);
+}
+
+function normalizeCount(value: number, label: string): number {
+  if (!Number.isInteger(value) || value < 1) {
+    throw new Error(
+      `parallel evaluator ${label} must be a positive integer (received ${value})`,
+    );
+  }
+  return value;
+}
@@ -0,0 +1,36 @@
+import {
+  type ParallelWorkerPort,
+  serveParallelWorker,
+} from './parallel-evaluator.js';
+
+/**
+ * Default worker entry for `createParallelEvaluator`: `parentPort` under
+ * `node:worker_threads`, `self` inside a module Web Worker.
+ */
+async function resolvePort(): Promise<ParallelWorkerPort> {
+  if (typeof process !== 'undefined' && process.versions?.node) {
+    const { parentPort } = await import('node:worker_threads');
+    if (!parentPort) {
+      throw new Error('parallel-worker must run inside a worker thread');
+    }
+    return {
+      postMessage: (message) => parentPort.postMessage(message),
+      onMessage: (listener) => parentPort.on('message', listener),
+    };
+  }
+
+  const scope = globalThis as unknown as {
+    postMessage(message: unknown): void;
+    addEventListener(
+      type: 'message',
+      listener: (event: { data: unknown }) => void,
+    ): void;
+  };
+  return {
+    postMessage: (message) => scope.postMessage(message),
+    onMessage: (listener) =>
+      scope.addEventListener('message', (event) => listener(event.data)),
+  };
+}
+
+serveParallelWorker(await resolvePort());
@@ -1,9 +1,14 @@
 import { DvError } from '@blue-quickjs/dv';
 import {
+  BYTECODE_FORMAT_VERSION,
+  BytecodeProgramArtifact,
   InputEnvelope,
   PROGRAM_LIMIT_DEFAULTS,
   ProgramArtifact,
   RuntimeValidationError,
+  hashBytecode,
+  macBytecode,
+  setBytecodeKey,
   validateInputEnvelope,
   validateProgramArtifact,
 } from './quickjs-runtime.js';
@@ -60,6 +65,87 @@ describe('validateProgramArtifact', () => {
   });
 });
 
+describe('validateProgramArtifact (bytecode)', () => {
+  const bytecode = createBytecode([0x13, 0x37]);
+  const baseProgram: BytecodeProgramArtifact = {
+    bytecode,
+    bytecodeHash: hashBytecode(bytecode),
+    bytecodeMac: macBytecode(bytecode),
+    gasVersion: 1,
+    abiId: 'Host.v1',
+    abiVersion: 1,
+    abiManifestHash: SAMPLE_HASH,
+    engineBuildHash: SAMPLE_HASH,
+  };
+
+  it('accepts a well-formed bytecode artifact', () => {
+    expect(validateProgramArtifact(baseProgram)).toEqual(baseProgram);
+  });
+
+  it('requires engineBuildHash', () => {
+    const program: Partial<BytecodeProgramArtifact> = { ...baseProgram };
+    delete program.engineBuildHash;
+    expect(() => validateProgramArtifact(program)).toThrow(
+      /engineBuildHash is required/,
+    );
+  });
+
+  it('rejects bytecode that does not match its hash', () => {
+    expect(() =>
+      validateProgramArtifact({
+        ...baseProgram,
+        bytecode: createBytecode([0x13, 0x38]),
+      }),
+    ).toThrow(/bytecodeHash mismatch/);
+  });
+
+  it('rejects bytecode its MAC does not authenticate', () => {
+    const forged = createBytecode([0x13, 0x38]);
+    expect(() =>
+      validateProgramArtifact({
+        ...baseProgram,
+        bytecode: forged,
+        bytecodeHash: hashBytecode(forged),
+      }),
+    ).toThrow(/bytecodeMac does not authenticate/);
+  });
+
+  it('rejects malformed headers and gas version mismatches', () => {
+    const truncated = bytecode.subarray(0, 8);
+    expect(() =>
+      validateProgramArtifact({
+        ...baseProgram,
+        bytecode: truncated,
+        bytecodeHash: hashBytecode(truncated),
+      }),
+    ).toThrow(RuntimeValidationError);
+
+    expect(() =>
+      validateProgramArtifact({ ...baseProgram, gasVersion: 2 }),
+    ).toThrow(/gas version/);
+  });
+
+  it('rejects artifacts that mix code and bytecode', () => {
+    expect(() =>
+      validateProgramArtifact({ ...baseProgram, code: '1' }),
+    ).toThrow(/unknown field "code"/);
+  });
+
+  it('accepts artifacts signed elsewhere under a shared key', () => {
+    const key = new Uint8Array(32).fill(7);
+    setBytecodeKey(key);
+    const signed = { ...baseProgram, bytecodeMac: macBytecode(bytecode) };
+    setBytecodeKey(new Uint8Array(32).fill(9));
+    expect(() => validateProgramArtifact(signed)).toThrow(
+      /bytecodeMac does not authenticate/,
+    );
+    setBytecodeKey(key);
+    const copy = { ...signed, bytecode: bytecode.slice() };
+    expect(validateProgramArtifact(copy)).toEqual(copy);
+    expect(() => setBytecodeKey(new Uint8Array(16))).toThrow(/at least 32/);
+  });
+});
+
 describe('validateInputEnvelope', () => {
   const baseInput: InputEnvelope = {
     event: { type: 'create', payload: { id: 1 } },
@@ -116,3 +202,14 @@ describe('validateInputEnvelope', () => {
     throw new Error('expected RuntimeValidationError');
   });
 });
+
+function createBytecode(body: number[]): Uint8Array {
+  const bytes = new Uint8Array(16 + body.length);
+  const view = new DataView(bytes.buffer);
+  view.setUint32(0, 0x42444a51, true);
+  view.setUint32(4, BYTECODE_FORMAT_VERSION, true);
+  view.setUint32(8, 1, true);
+  view.setUint32(12, body.length, true);
+  bytes.set(body, 16);
+  return bytes;
+}
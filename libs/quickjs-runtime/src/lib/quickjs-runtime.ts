@@ -5,11 +5,30 @@ import {
   DvLimits,
   validateDv,
 } from '@blue-quickjs/dv';
+import { hmac } from '@noble/hashes/hmac';
+import { sha256 } from '@noble/hashes/sha2';
+import { randomBytes } from '@noble/hashes/utils';
+import { bytesEqual, bytesToHex } from './hex-utils.js';
 
 const UINT32_MAX = 0xffffffff;
 const SHA256_HEX_LENGTH = 64;
 const HEX_RE = /^[0-9a-f]+$/;
-export interface ProgramArtifact {
+const BYTECODE_MAGIC = 0x42444a51; // "QJDB"
+const BYTECODE_HEADER_SIZE = 16;
+const VERIFIED_BYTECODE = new WeakMap<Uint8Array, string>();
+const BYTECODE_KEY_MIN_BYTES = 32;
+
+let bytecodeKey = randomBytes(BYTECODE_KEY_MIN_BYTES);
+// Private copies of authenticated artifacts, keyed by the caller's array.
+// Replaced whenever the key changes.
+let authenticatedBytecode = new WeakMap<
+  Uint8Array,
+  { mac: string; bytes: Uint8Array }
+>();
+
+export const BYTECODE_FORMAT_VERSION = 1;
+
+export interface SourceProgramArtifact {
   code: string;
   abiId: string;
   abiVersion: number;
@@ -17,13 +36,35 @@ export interface ProgramArtifact {
   engineBuildHash?: string;
 }
 
+/**
+ * Precompiled program produced by `compileProgram`. The bytecode only runs on
+ * the engine build that wrote it, so `engineBuildHash` is mandatory, and
+ * `bytecodeHash` (sha256 of `bytecode`) pins the exact bytes. `bytecodeMac`
+ * (HMAC-SHA256 of `bytecode` under the bytecode key) proves the SDK wrote
+ * them; see `setBytecodeKey`.
+ */
+export interface BytecodeProgramArtifact {
+  bytecode: Uint8Array;
+  bytecodeHash: string;
+  bytecodeMac: string;
+  gasVersion: number;
+  abiId: string;
+  abiVersion: number;
+  abiManifestHash: string;
+  engineBuildHash: string;
+}
+
+export type ProgramArtifact = SourceProgramArtifact | BytecodeProgramArtifact;
+
 export interface ProgramArtifactLimits {
   maxCodeUnits: number;
+  maxBytecodeBytes: number;
   maxAbiIdLength: number;
 }
 
 export const PROGRAM_LIMIT_DEFAULTS: Readonly<ProgramArtifactLimits> = {
   maxCodeUnits: 1_048_576, // 1 MiB in UTF-16 code units
+  maxBytecodeBytes: 4_194_304, // 4 MiB
   maxAbiIdLength: 128,
 };
 
@@ -49,7 +90,10 @@ export type RuntimeValidationErrorCode =
   | 'EXCEEDS_LIMIT'
   | 'INVALID_HEX'
   | 'OUT_OF_RANGE'
-  | 'DV_INVALID';
+  | 'DV_INVALID'
+  | 'INVALID_BYTECODE'
+  | 'HASH_MISMATCH'
+  | 'MAC_MISMATCH';
 
 export class RuntimeValidationError extends Error {
   constructor(
@@ -63,12 +107,21 @@ export class RuntimeValidationError extends Error {
   }
 }
 
+export function isBytecodeProgram(
+  program: ProgramArtifact,
+): program is BytecodeProgramArtifact {
+  return 'bytecode' in program;
+}
+
 export function validateProgramArtifact(
   value: unknown,
   options?: ProgramValidationOptions,
 ): ProgramArtifact {
   const limits = normalizeProgramLimits(options?.limits);
   const program = expectPlainObject(value, 'program');
+  if ('bytecode' in program) {
+    return validateBytecodeProgram(program, limits);
+  }
   enforceExactKeys(
     program,
     ['code', 'abiId', 'abiVersion', 'abiManifestHash', 'engineBuildHash'],
@@ -79,6 +132,109 @@ export function validateProgramArtifact(
     maxLength: limits.maxCodeUnits,
     allowEmpty: true,
   });
+  const identity = validateProgramIdentity(program, limits);
+  const engineBuildHash =
+    program.engineBuildHash !== undefined
+      ? expectHexString(program.engineBuildHash, 'program.engineBuildHash', {
+          exactLength: SHA256_HEX_LENGTH,
+        })
+      : undefined;
+
+  return {
+    code,
+    ...identity,
+    engineBuildHash,
+  };
+}
+
+function validateBytecodeProgram(
+  program: Record<string, unknown>,
+  limits: ProgramArtifactLimits,
+): BytecodeProgramArtifact {
+  enforceExactKeys(
+    program,
+    [
+      'bytecode',
+      'bytecodeHash',
+      'bytecodeMac',
+      'gasVersion',
+      'abiId',
+      'abiVersion',
+      'abiManifestHash',
+      'engineBuildHash',
+    ],
+    'program',
+  );
+
+  const bytecode = program.bytecode;
+  if (!(bytecode instanceof Uint8Array)) {
+    throw runtimeError(
+      'INVALID_TYPE',
+      'program.bytecode must be a Uint8Array',
+      'program.bytecode',
+    );
+  }
+  if (bytecode.length > limits.maxBytecodeBytes) {
+    throw runtimeError(
+      'EXCEEDS_LIMIT',
+      `program.bytecode exceeds maxBytecodeBytes (${bytecode.length} > ${limits.maxBytecodeBytes})`,
+      'program.bytecode',
+    );
+  }
+  const bytecodeHash = expectHexString(
+    program.bytecodeHash,
+    'program.bytecodeHash',
+    { exactLength: SHA256_HEX_LENGTH },
+  );
+  const bytecodeMac = expectHexString(
+    program.bytecodeMac,
+    'program.bytecodeMac',
+    { exactLength: SHA256_HEX_LENGTH },
+  );
+  const gasVersion = expectUint(
+    program.gasVersion,
+    1,
+    UINT32_MAX,
+    'program.gasVersion',
+  );
+  const identity = validateProgramIdentity(program, limits);
+  if (program.engineBuildHash === undefined) {
+    throw runtimeError(
+      'MISSING_FIELD',
+      'program.engineBuildHash is required for bytecode programs',
+      'program.engineBuildHash',
+    );
+  }
+  const engineBuildHash = expectHexString(
+    program.engineBuildHash,
+    'program.engineBuildHash',
+    { exactLength: SHA256_HEX_LENGTH },
+  );
+
+  verifyBytecodeHeader(bytecode, gasVersion);
+  verifyBytecodeHash(bytecode, bytecodeHash);
+  if (!authenticateBytecode(bytecode, bytecodeMac)) {
+    throw runtimeError(
+      'MAC_MISMATCH',
+      'program.bytecodeMac does not authenticate program.bytecode under the current bytecode key',
+      'program.bytecodeMac',
+    );
+  }
+
+  return {
+    bytecode,
+    bytecodeHash,
+    bytecodeMac,
+    gasVersion,
+    ...identity,
+    engineBuildHash,
+  };
+}
+
+function validateProgramIdentity(
+  program: Record<string, unknown>,
+  limits: ProgramArtifactLimits,
+): Pick<ProgramArtifact, 'abiId' | 'abiVersion' | 'abiManifestHash'> {
   const abiId = expectString(program.abiId, 'program.abiId', {
     maxLength: limits.maxAbiIdLength,
   });
@@ -93,20 +249,140 @@ export function validateProgramArtifact(
     'program.abiManifestHash',
     { exactLength: SHA256_HEX_LENGTH },
   );
-  const engineBuildHash =
-    program.engineBuildHash !== undefined
-      ? expectHexString(program.engineBuildHash, 'program.engineBuildHash', {
-          exactLength: SHA256_HEX_LENGTH,
-        })
-      : undefined;
+  return { abiId, abiVersion, abiManifestHash };
+}
 
-  return {
-    code,
-    abiId,
-    abiVersion,
-    abiManifestHash,
-    engineBuildHash,
-  };
+/**
+ * Mirror of the shim's header checks (see qjs_det_compile) so malformed
+ * artifacts fail validation instead of surfacing as VM errors.
+ */
+function verifyBytecodeHeader(bytecode: Uint8Array, gasVersion: number): void {
+  if (bytecode.length < BYTECODE_HEADER_SIZE) {
+    throw runtimeError(
+      'INVALID_BYTECODE',
+      'program.bytecode is shorter than the artifact header',
+      'program.bytecode',
+    );
+  }
+  const header = new DataView(
+    bytecode.buffer,
+    bytecode.byteOffset,
+    BYTECODE_HEADER_SIZE,
+  );
+  if (header.getUint32(0, true) !== BYTECODE_MAGIC) {
+    throw runtimeError(
+      'INVALID_BYTECODE',
+      'program.bytecode is not a bytecode artifact',
+      'program.bytecode',
+    );
+  }
+  const format = header.getUint32(4, true);
+  if (format !== BYTECODE_FORMAT_VERSION) {
+    throw runtimeError(
+      'INVALID_BYTECODE',
+      `program.bytecode format ${format} is not supported (expected ${BYTECODE_FORMAT_VERSION})`,
+      'program.bytecode',
+    );
+  }
+  const headerGasVersion = header.getUint32(8, true);
+  if (headerGasVersion !== gasVersion) {
+    throw runtimeError(
+      'INVALID_BYTECODE',
+      `program.bytecode was compiled for gas version ${headerGasVersion}, not ${gasVersion}`,
+      'program.gasVersion',
+    );
+  }
+  if (header.getUint32(12, true) !== bytecode.length - BYTECODE_HEADER_SIZE) {
+    throw runtimeError(
+      'INVALID_BYTECODE',
+      'program.bytecode length does not match its header',
+      'program.bytecode',
+    );
+  }
+}
+
+/**
+ * Hashing is memoized per Uint8Array so hot paths that re-validate the same
+ * artifact do not rehash it. Artifacts must not be mutated after validation.
+ */
+function verifyBytecodeHash(bytecode: Uint8Array, expected: string): void {
+  let actual = VERIFIED_BYTECODE.get(bytecode);
+  if (actual === undefined) {
+    actual = hashBytecode(bytecode);
+    VERIFIED_BYTECODE.set(bytecode, actual);
+  }
+  if (actual !== expected) {
+    throw runtimeError(
+      'HASH_MISMATCH',
+      `program.bytecodeHash mismatch: expected ${expected}, computed ${actual}`,
+      'program.bytecodeHash',
+    );
+  }
+}
+
+export function hashBytecode(bytecode: Uint8Array): string {
+  return bytesToHex(sha256(bytecode));
+}
+
+/**
+ * Set the key bytecode artifacts are authenticated with (at least 32 bytes).
+ * QuickJS's bytecode reader is not memory-safe on crafted input, so only
+ * artifacts carrying a valid `bytecodeMac` are loaded. The default key is
+ * random per process; processes, workers and stores that should accept each
+ * other's artifacts must share one. Artifacts signed under a previous key stop
+ * loading.
+ */
+export function setBytecodeKey(key: Uint8Array): void {
+  if (!(key instanceof Uint8Array) || key.length < BYTECODE_KEY_MIN_BYTES) {
+    throw new Error(
+      `bytecode key must be a Uint8Array of at least ${BYTECODE_KEY_MIN_BYTES} bytes`,
+    );
+  }
+  bytecodeKey = key.slice();
+  authenticatedBytecode = new WeakMap();
+}
+
+export function macBytecode(bytecode: Uint8Array): string {
+  return bytesToHex(hmac(sha256, bytecodeKey, bytecode));
+}
+
+/**
+ * Return a private copy of `bytecode` if `mac` authenticates it under the
+ * current key, else null. The copy is what the VM loads, so later writes to
+ * the caller's array cannot reach the reader; repeat calls compare bytes
+ * against it instead of recomputing the MAC.
+ */
+export function authenticateBytecode(
+  bytecode: Uint8Array,
+  mac: string,
+): Uint8Array | null {
+  const known = authenticatedBytecode.get(bytecode);
+  if (
+    known &&
+    macEqual(known.mac, mac) &&
+    bytesEqual(known.bytes, bytecode)
+  ) {
+    return known.bytes;
+  }
+  if (!macEqual(macBytecode(bytecode), mac)) {
+    return null;
+  }
+  const bytes = bytecode.slice();
+  authenticatedBytecode.set(bytecode, { mac, bytes });
+  return bytes;
+}
+
+// Constant-time over equal-length inputs, so a forger cannot learn the MAC
+// byte by byte from rejection timing.
+function macEqual(a: string, b: string): boolean {
+  if (a.length !== b.length) {
+    return false;
+  }
+  let diff = 0;
+  for (let i = 0; i < a.length; i += 1) {
+    diff |= a.charCodeAt(i) ^ b.charCodeAt(i);
+  }
+  return diff === 0;
 }
 
 export function validateInputEnvelope(
@@ -262,6 +538,8 @@ function normalizeProgramLimits(
   return {
     maxCodeUnits:
       overrides?.maxCodeUnits ?? PROGRAM_LIMIT_DEFAULTS.maxCodeUnits,
+    maxBytecodeBytes:
+      overrides?.maxBytecodeBytes ?? PROGRAM_LIMIT_DEFAULTS.maxBytecodeBytes,
     maxAbiIdLength:
       overrides?.maxAbiIdLength ?? PROGRAM_LIMIT_DEFAULTS.maxAbiIdLength,
   };
@@ -0,0 +1,256 @@
+import { HOST_V1_HASH, HOST_V1_MANIFEST } from '@blue-quickjs/test-harness';
+import { vi } from 'vitest';
+import { evaluate } from './evaluate.js';
+import type { HostDispatcherHandlers } from './host-dispatcher.js';
+import type { InputEnvelope, ProgramArtifact } from './quickjs-runtime.js';
+import { createRuntimePool } from './runtime-pool.js';
+
+const TEST_GAS_LIMIT = 50_000n;
+
+const PROGRAM: ProgramArtifact = {
+  code: 'const doc = document("path/to/doc"); ({ doc, event, steps })',
+  abiId: 'Host.v1',
+  abiVersion: 1,
+  abiManifestHash: HOST_V1_HASH,
+};
+
+const INPUT: InputEnvelope = {
+  event: { type: 'create', payload: { id: 1 } },
+  eventCanonical: { type: 'create', payload: { id: 1 } },
+  steps: [{ name: 'first' }],
+};
+
+describe('createRuntimePool', () => {
+  it('reuses a warm runtime across sequential acquisitions', async () => {
+    const pool = createRuntimePool({ max: 1 });
+
+    const first = await pool.acquire({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const runtime = first.runtime;
+    first.release();
+
+    const second = await pool.acquire({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    expect(second.runtime).toBe(runtime);
+    second.release();
+
+    pool.close();
+  });
+
+  it('matches standalone evaluate() results and gas', async () => {
+    const pool = createRuntimePool({ max: 1 });
+    const standalone = await evaluate({
+      program: PROGRAM,
+      input: INPUT,
+      gasLimit: TEST_GAS_LIMIT,
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+
+    for (let i = 0; i < 3; i += 1) {
+      const pooled = await evaluate({
+        program: PROGRAM,
+        input: INPUT,
+        gasLimit: TEST_GAS_LIMIT,
+        manifest: HOST_V1_MANIFEST,
+        handlers: createHandlers(),
+        pool,
+      });
+      expect(pooled).toEqual(standalone);
+    }
+
+    pool.close();
+  });
+
+  it('does not leak global state between leases', async () => {
+    const pool = createRuntimePool({ max: 1 });
+    const run = (code: string) =>
+      evaluate({
+        program: { ...PROGRAM, code },
+        input: INPUT,
+        gasLimit: TEST_GAS_LIMIT,
+        manifest: HOST_V1_MANIFEST,
+        handlers: createHandlers(),
+        pool,
+      });
+
+    await run('globalThis.leaked = 1; 0');
+    const result = await run('typeof globalThis.leaked');
+    expect(result.ok).toBe(true);
+    if (!result.ok) {
+      throw new Error(result.message);
+    }
+    expect(result.value).toBe('undefined');
+
+    pool.close();
+  });
+
+  it('routes host calls to the handlers of the current lease', async () => {
+    const pool = createRuntimePool({ max: 1 });
+    const firstHandlers = createHandlers();
+    const secondHandlers = createHandlers();
+
+    await evaluate({
+      program: PROGRAM,
+      input: INPUT,
+      gasLimit: TEST_GAS_LIMIT,
+      manifest: HOST_V1_MANIFEST,
+      handlers: firstHandlers,
+      pool,
+    });
+    await evaluate({
+      program: PROGRAM,
+      input: INPUT,
+      gasLimit: TEST_GAS_LIMIT,
+      manifest: HOST_V1_MANIFEST,
+      handlers: secondHandlers,
+      pool,
+    });
+
+    expect(firstHandlers.document.get).toHaveBeenCalledTimes(1);
+    expect(secondHandlers.document.get).toHaveBeenCalledTimes(1);
+
+    pool.close();
+  });
+
+  it('instantiates a new runtime for fresh acquisitions', async () => {
+    const pool = createRuntimePool({ max: 1 });
+
+    const first = await pool.acquire({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const runtime = first.runtime;
+    first.release();
+
+    const fresh = await pool.acquire({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+      fresh: true,
+    });
+    expect(fresh.runtime).not.toBe(runtime);
+    expect(pool.stats()).toEqual([
+      expect.objectContaining({ idle: 0, leased: 1 }),
+    ]);
+    fresh.release();
+
+    pool.close();
+  });
+
+  it('gives a queued fresh acquisition a new runtime', async () => {
+    const pool = createRuntimePool({ max: 1 });
+    const first = await pool.acquire({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const pending = pool.acquire({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+      fresh: true,
+    });
+
+    first.release();
+    const fresh = await pending;
+    expect(fresh.runtime).not.toBe(first.runtime);
+    expect(pool.stats()[0]).toMatchObject({ idle: 0, leased: 1, waiting: 0 });
+    fresh.release();
+
+    pool.close();
+  });
+
+  it('queues acquisitions beyond max until a runtime is released', async () => {
+    const pool = createRuntimePool({ max: 1 });
+    const first = await pool.acquire({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+
+    let resolved = false;
+    const pending = pool
+      .acquire({ manifest: HOST_V1_MANIFEST, handlers: createHandlers() })
+      .then((lease) => {
+        resolved = true;
+        return lease;
+      });
+
+    await Promise.resolve();
+    expect(resolved).toBe(false);
+    expect(pool.stats()[0]).toMatchObject({ leased: 1, waiting: 1 });
+
+    first.release();
+    const second = await pending;
+    expect(second.runtime).toBe(first.runtime);
+    second.release();
+
+    pool.close();
+  });
+
+  it('prewarms min runtimes and retires them after maxUses', async () => {
+    const pool = createRuntimePool({ min: 2, max: 2, maxUses: 1 });
+    await pool.prewarm({ manifest: HOST_V1_MANIFEST });
+    expect(pool.stats()[0]).toMatchObject({ idle: 2, leased: 0 });
+
+    const lease = await pool.acquire({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    lease.release();
+    expect(pool.stats()[0]).toMatchObject({ idle: 1, leased: 0 });
+
+    pool.close();
+  });
+
+  it('drops idle runtimes on close, including prewarms in flight', async () => {
+    const pool = createRuntimePool({ min: 2, max: 2 });
+    const lease = await pool.acquire({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const prewarm = pool.prewarm({ manifest: HOST_V1_MANIFEST });
+    pool.close();
+    await prewarm;
+    lease.release();
+
+    expect(pool.stats()[0]).toMatchObject({ idle: 0, leased: 0 });
+  });
+
+  it('rejects handlers that do not match the manifest shape', async () => {
+    const pool = createRuntimePool();
+    const handlers = { document: createHandlers().document };
+
+    await expect(
+      pool.acquire({ manifest: HOST_V1_MANIFEST, handlers }),
+    ).rejects.toThrow(/emit handler/);
+
+    pool.close();
+  });
+
+  it('rejects acquisitions after close', async () => {
+    const pool = createRuntimePool();
+    pool.close();
+
+    await expect(
+      pool.acquire({ manifest: HOST_V1_MANIFEST, handlers: createHandlers() }),
+    ).rejects.toThrow(/closed/);
+  });
+});
+
+function createHandlers(): HostDispatcherHandlers {
+  return {
+    document: {
+      get: vi.fn((path: string) => ({ ok: { path }, units: 5 })),
+      getCanonical: vi.fn((path: string) => ({
+        ok: { canonical: path },
+        units: 3,
+      })),
+    },
+    emit: vi.fn(() => ({
+      ok: null,
+      units: 1,
+    })),
+  };
+}
@@ -0,0 +1,450 @@
+import {
+  type AbiManifest,
+  hashAbiManifest,
+} from '@blue-quickjs/abi-manifest';
+import type { DvLimits } from '@blue-quickjs/dv';
+import { freeDeterministicVm } from './deterministic-init.js';
+import {
+  type DocumentHostHandlers,
+  type DocumentHostResult,
+  HostDispatcherError,
+  type HostDispatcherHandlers,
+  type HostDispatcherOptions,
+} from './host-dispatcher.js';
+import {
+  type RuntimeAllocatorOptions,
+  type RuntimeArtifactSelection,
+  type RuntimeInstance,
+  createRuntime,
+} from './runtime.js';
+
+const DEFAULT_POOL_MIN = 0;
+const DEFAULT_POOL_MAX = 4;
+
+export interface RuntimePoolOptions
+  extends RuntimeArtifactSelection, RuntimeAllocatorOptions {
+  /**
+   * Runtimes `prewarm()` instantiates per manifest key (default 0).
+   */
+  min?: number;
+  /**
+   * Upper bound of live runtimes per manifest key (default 4). Acquisitions
+   * beyond this wait for a release.
+   */
+  max?: number;
+  /**
+   * Retire a runtime after this many leases (default: unlimited). Bounds heap
+   * fragmentation in the fixed-size wasm memory for long-lived pools.
+   */
+  maxUses?: number;
+  /**
+   * DV limits applied by every pooled dispatcher.
+   */
+  dvLimits?: Partial<DvLimits>;
+}
+
+export interface RuntimePoolKeyOptions extends Pick<
+  HostDispatcherOptions,
+  'expectedAbiId' | 'expectedAbiVersion'
+> {
+  manifest: AbiManifest;
+}
+
+export interface RuntimePoolAcquireOptions extends RuntimePoolKeyOptions {
+  handlers: HostDispatcherHandlers;
+  /**
+   * Lease a newly instantiated runtime instead of a recycled one, retiring an
+   * idle runtime if the key is at `max`. Out-of-memory points are only
+   * canonical on a fresh instance, so `evaluate` reruns pooled OOMs this way.
+   */
+  fresh?: boolean;
+}
+
+export interface PooledRuntime {
+  readonly runtime: RuntimeInstance;
+  /**
+   * Return the runtime to the pool. Pass `discard: true` when the wasm
+   * instance may be in an unknown state (e.g. an exception escaped a VM call).
+   */
+  release(options?: { discard?: boolean }): void;
+}
+
+export interface RuntimePoolStats {
+  key: string;
+  idle: number;
+  leased: number;
+  waiting: number;
+}
+
+export interface RuntimePool {
+  acquire(options: RuntimePoolAcquireOptions): Promise<PooledRuntime>;
+  prewarm(options: RuntimePoolKeyOptions): Promise<void>;
+  stats(): RuntimePoolStats[];
+  close(): void;
+}
+
+type PoolEntry = {
+  runtime: RuntimeInstance;
+  handlers: DelegatingHandlers;
+  uses: number;
+};
+
+type PoolWaiter = {
+  fresh: boolean;
+  resolve(entry: PoolEntry): void;
+  reject(error: unknown): void;
+};
+
+type PoolBucket = {
+  key: string;
+  manifest: AbiManifest;
+  expectedAbiId?: string;
+  expectedAbiVersion?: number;
+  declaresEmit: boolean;
+  idle: PoolEntry[];
+  live: number;
+  leased: number;
+  waiters: PoolWaiter[];
+};
+
+/**
+ * Keep instantiated wasm runtimes warm across evaluations.
+ *
+ * Runtimes are keyed by (abi id, abi version, manifest hash). Every lease gets
+ * a runtime with no deterministic VM initialized: `qjs_det_free` runs on
+ * release, so the next `initializeDeterministicVm` starts from a fresh
+ * `JS_NewDeterministicRuntime`. Gas and results do not depend on the state of
+ * linear memory, so a pooled evaluation is identical to a standalone one. The
+ * exception is where an evaluation runs out of memory, which fragmentation
+ * can move; `evaluate` reruns those on a `fresh` lease when no handler ran
+ * (or with `retryOutOfMemory`) and otherwise returns them as they are.
+ */
+export function createRuntimePool(
+  options: RuntimePoolOptions = {},
+): RuntimePool {
+  const min = normalizePoolSize(options.min ?? DEFAULT_POOL_MIN, 'min');
+  const max = normalizePoolSize(options.max ?? DEFAULT_POOL_MAX, 'max');
+  if (max < 1) {
+    throw new Error('runtime pool max must be at least 1');
+  }
+  if (min > max) {
+    throw new Error(`runtime pool min (${min}) exceeds max (${max})`);
+  }
+  const maxUses =
+    options.maxUses === undefined
+      ? Number.POSITIVE_INFINITY
+      : normalizePoolSize(options.maxUses, 'maxUses');
+  if (maxUses < 1) {
+    throw new Error('runtime pool maxUses must be at least 1');
+  }
+
+  const buckets = new Map<string, PoolBucket>();
+  const manifestKeys = new WeakMap<
+    AbiManifest,
+    { key: string; declaresEmit: boolean }
+  >();
+  let closed = false;
+
+  const resolveBucket = (key: RuntimePoolKeyOptions): PoolBucket => {
+    let manifestKey = manifestKeys.get(key.manifest);
+    if (!manifestKey) {
+      const { hash, manifest } = hashAbiManifest(key.manifest);
+      manifestKey = {
+        key: `${manifest.abi_id}@${manifest.abi_version}:${hash}`,
+        declaresEmit: manifest.functions.some(
+          (fn) => fn.js_path.join('.') === 'emit',
+        ),
+      };
+      manifestKeys.set(key.manifest, manifestKey);
+    }
+
+    const bucketKey = `${manifestKey.key}|${key.expectedAbiId ?? ''}|${key.expectedAbiVersion ?? ''}`;
+    let bucket = buckets.get(bucketKey);
+    if (!bucket) {
+      bucket = {
+        key: bucketKey,
+        manifest: key.manifest,
+        expectedAbiId: key.expectedAbiId,
+        expectedAbiVersion: key.expectedAbiVersion,
+        declaresEmit: manifestKey.declaresEmit,
+        idle: [],
+        live: 0,
+        leased: 0,
+        waiters: [],
+      };
+      buckets.set(bucketKey, bucket);
+    }
+    return bucket;
+  };
+
+  const spawn = async (bucket: PoolBucket): Promise<PoolEntry> => {
+    bucket.live += 1;
+    try {
+      const handlers = createDelegatingHandlers(bucket.declaresEmit);
+      const runtime = await createRuntime({
+        manifest: bucket.manifest,
+        handlers: handlers.handlers,
+        backend: options.backend,
+        allowNonConsensus: options.allowNonConsensus,
+        variant: options.variant,
+        buildType: options.buildType,
+        memoryProfile: options.memoryProfile,
+        metadata: options.metadata,
+        wasmBinary: options.wasmBinary,
+        wasmModule: options.wasmModule,
+        allocator: options.allocator,
+        dvLimits: options.dvLimits,
+        expectedAbiId: bucket.expectedAbiId,
+        expectedAbiVersion: bucket.expectedAbiVersion,
+      });
+      return { runtime, handlers, uses: 0 };
+    } catch (err) {
+      bucket.live -= 1;
+      throw err;
+    }
+  };
+
+  const lease = (
+    bucket: PoolBucket,
+    entry: PoolEntry,
+    handlers: HostDispatcherHandlers,
+  ): PooledRuntime => {
+    entry.uses += 1;
+    entry.handlers.bind(handlers);
+    let released = false;
+    return {
+      runtime: entry.runtime,
+      release(releaseOptions?: { discard?: boolean }) {
+        if (released) {
+          return;
+        }
+        released = true;
+        entry.handlers.unbind();
+        bucket.leased -= 1;
+
+        let reusable = !releaseOptions?.discard;
+        try {
+          freeDeterministicVm(entry.runtime);
+        } catch {
+          reusable = false;
+        }
+        if (reusable && entry.uses < maxUses) {
+          returnEntry(bucket, entry);
+          return;
+        }
+
+        bucket.live -= 1;
+        refillForWaiter(bucket);
+      },
+    };
+  };
+
+  // Frees an entry leaving the pool: releases into a closed pool, in-flight
+  // prewarms, and runtimes evicted to make room for a fresh one.
+  const discardEntry = (bucket: PoolBucket, entry: PoolEntry): void => {
+    bucket.live -= 1;
+    entry.handlers.unbind();
+    try {
+      freeDeterministicVm(entry.runtime);
+    } catch {
+      // The runtime is unreachable from here on either way.
+    }
+  };
+
+  const returnEntry = (bucket: PoolBucket, entry: PoolEntry): void => {
+    if (closed) {
+      discardEntry(bucket, entry);
+      return;
+    }
+    const waiter = bucket.waiters.shift();
+    if (waiter) {
+      bucket.leased += 1;
+      if (waiter.fresh) {
+        discardEntry(bucket, entry);
+        spawnForWaiter(bucket, waiter);
+        return;
+      }
+      waiter.resolve(entry);
+      return;
+    }
+    bucket.idle.push(entry);
+  };
+
+  const refillForWaiter = (bucket: PoolBucket): void => {
+    if (closed || bucket.waiters.length === 0 || bucket.live >= max) {
+      return;
+    }
+    const waiter = bucket.waiters.shift() as PoolWaiter;
+    bucket.leased += 1;
+    spawnForWaiter(bucket, waiter);
+  };
+
+  const spawnForWaiter = (bucket: PoolBucket, waiter: PoolWaiter): void => {
+    spawn(bucket).then(waiter.resolve, (err) => {
+      bucket.leased -= 1;
+      waiter.reject(err);
+    });
+  };
+
+  return {
+    async acquire(acquireOptions: RuntimePoolAcquireOptions) {
+      assertOpen(closed);
+      const bucket = resolveBucket(acquireOptions);
+      assertHandlerShape(bucket, acquireOptions.handlers);
+      const fresh = acquireOptions.fresh ?? false;
+
+      if (!fresh) {
+        const idle = bucket.idle.pop();
+        if (idle) {
+          bucket.leased += 1;
+          return lease(bucket, idle, acquireOptions.handlers);
+        }
+      } else if (bucket.live >= max) {
+        const evicted = bucket.idle.shift();
+        if (evicted) {
+          discardEntry(bucket, evicted);
+        }
+      }
+
+      if (bucket.live < max) {
+        bucket.leased += 1;
+        try {
+          const entry = await spawn(bucket);
+          return lease(bucket, entry, acquireOptions.handlers);
+        } catch (err) {
+          bucket.leased -= 1;
+          throw err;
+        }
+      }
+
+      const entry = await new Promise<PoolEntry>((resolve, reject) => {
+        bucket.waiters.push({ fresh, resolve, reject });
+      });
+      return lease(bucket, entry, acquireOptions.handlers);
+    },
+
+    async prewarm(keyOptions: RuntimePoolKeyOptions) {
+      assertOpen(closed);
+      const bucket = resolveBucket(keyOptions);
+      const pending: Array<Promise<void>> = [];
+      while (bucket.live < min) {
+        pending.push(spawn(bucket).then((entry) => returnEntry(bucket, entry)));
+      }
+      await Promise.all(pending);
+    },
+
+    stats() {
+      return [...buckets.values()].map((bucket) => ({
+        key: bucket.key,
+        idle: bucket.idle.length,
+        leased: bucket.leased,
+        waiting: bucket.waiters.length,
+      }));
+    },
+
+    close() {
+      if (closed) {
+        return;
+      }
+      closed = true;
+      const error = new Error('runtime pool is closed');
+      for (const bucket of buckets.values()) {
+        for (const entry of bucket.idle.splice(0)) {
+          discardEntry(bucket, entry);
+        }
+        for (const waiter of bucket.waiters.splice(0)) {
+          waiter.reject(error);
+        }
+      }
+    },
+  };
+}
+
+type DelegatingHandlers = {
+  handlers: HostDispatcherHandlers;
+  bind(target: HostDispatcherHandlers): void;
+  unbind(): void;
+};
+
+/**
+ * Pooled dispatchers are built once per runtime, so they call through to the
+ * handlers of the current lease. Calls outside a lease throw, which the
+ * dispatcher reports as a HANDLER_ERROR transport failure.
+ */
+function createDelegatingHandlers(declaresEmit: boolean): DelegatingHandlers {
+  let current: HostDispatcherHandlers | null = null;
+  const active = (): HostDispatcherHandlers => {
+    if (!current) {
+      throw new Error('pooled runtime invoked a host handler without a lease');
+    }
+    return current;
+  };
+
+  const document: DocumentHostHandlers = {
+    get: (path) => active().document.get(path),
+    getCanonical: (path) => active().document.getCanonical(path),
+    // Always present so a lease's bulk handler is reachable; leases without
+    // one are answered path by path, as the dispatcher itself would.
+    getMany: (paths) => {
+      const target = active().document;
+      if (target.getMany) {
+        return target.getMany(paths);
+      }
+      const results = paths.map((path) => target.get(path));
+      return results.some((result) => 'then' in result)
+        ? Promise.all(results)
+        : (results as DocumentHostResult[]);
+    },
+  };
+
+  return {
+    handlers: declaresEmit
+      ? {
+          document,
+          emit: (value) =>
+            (active().emit as NonNullable<HostDispatcherHandlers['emit']>)(
+              value,
+            ),
+        }
+      : { document },
+    bind(target) {
+      current = target;
+    },
+    unbind() {
+      current = null;
+    },
+  };
+}
+
+function assertHandlerShape(
+  bucket: PoolBucket,
+  handlers: HostDispatcherHandlers,
+): void {
+  if (bucket.declaresEmit && !handlers.emit) {
+    throw new HostDispatcherError(
+      'INVALID_REQUEST',
+      'manifest declares emit but no emit handler was provided',
+    );
+  }
+  if (!bucket.declaresEmit && handlers.emit) {
+    throw new HostDispatcherError(
+      'INVALID_REQUEST',
+      'emit handler provided but manifest does not declare emit',
+    );
+  }
+}
+
+function assertOpen(closed: boolean): void {
+  if (closed) {
+    throw new Error('runtime pool is closed');
+  }
+}
+
+function normalizePoolSize(value: number, label: string): number {
+  if (!Number.isInteger(value) || value < 0) {
+    throw new Error(
+      `runtime pool ${label} must be a non-negative integer (received ${value})`,
+    );
+  }
+  return value;
+}
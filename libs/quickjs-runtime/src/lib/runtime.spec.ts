@@ -72,6 +72,31 @@ describe('createRuntime', () => {
     runtime.module._free(reqPtr);
     runtime.module._free(respPtr);
   });
+
+  it('shares one compiled module across runtimes', async () => {
+    const first = await createRuntime({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+    const second = await createRuntime({
+      manifest: HOST_V1_MANIFEST,
+      handlers: createHandlers(),
+    });
+
+    expect(second.wasmModule).toBe(first.wasmModule);
+    expect(second.module).not.toBe(first.module);
+    expect(second.module.HEAPU8.buffer).not.toBe(first.module.HEAPU8.buffer);
+  });
+
+  it('requires an explicit opt-in for the non-consensus native backend', async () => {
+    await expect(
+      createRuntime({
+        manifest: HOST_V1_MANIFEST,
+        handlers: createHandlers(),
+        backend: 'native',
+      }),
+    ).rejects.toThrow(/allowNonConsensus/);
+  });
 });
 
 const DOC_GET_ID = getFnId('document.get');
@@ -6,14 +6,25 @@ import {
   type QuickjsWasmArtifact,
   type QuickjsWasmBuildMetadata,
   type QuickjsWasmBuildType,
+  type QuickjsWasmCompiledModule,
+  type QuickjsWasmInstance,
+  type QuickjsWasmMemoryProfile,
   type QuickjsWasmVariant,
+  compileQuickjsWasmBinary,
   getQuickjsWasmArtifact,
-  loadQuickjsWasmBinary,
+  instantiateQuickjsWasmModule,
   loadQuickjsWasmMetadata,
+  loadQuickjsWasmModule,
 } from '@blue-quickjs/quickjs-wasm';
+import type {
+  QuickjsNativeArtifact,
+  QuickjsNativeBuildMetadata,
+} from '@blue-quickjs/quickjs-native';
 import {
+  createAsyncHostCallImport,
   createHostCallImport,
   createHostDispatcher,
+  type AsyncHostCallImport,
   type HostCallImport,
   type HostCallMemory,
   type HostDispatcher,
@@ -24,6 +35,20 @@ import {
 const UINT32_MAX = 0xffffffff;
 const DEFAULT_VARIANT: QuickjsWasmVariant = 'wasm32';
 const DEFAULT_BUILD_TYPE: QuickjsWasmBuildType = 'release';
+const DEFAULT_MEMORY_PROFILE: QuickjsWasmMemoryProfile = '32mib';
+const COMPILED_BINARIES = new WeakMap<
+  Uint8Array,
+  Promise<QuickjsWasmCompiledModule>
+>();
+const SUSPEND_GATES = new WeakMap<RuntimeInstance, { open: boolean }>();
+const TAPE_SINKS = new WeakMap<RuntimeInstance, Map<number, TapeSink>>();
+
+/**
+ * Receives `count` packed tape records at `ptr` streamed by one VM handle
+ * (`qjs_det_stream_tape`). The bytes are only valid during the call, and the
+ * sink must not throw or call back into the instance.
+ */
+export type TapeSink = (ptr: number, count: number) => void;
 
 export interface QuickjsWasmModule {
   HEAPU8: Uint8Array;
@@ -31,6 +56,7 @@ export interface QuickjsWasmModule {
     ident: string,
     returnType: string | null,
     argTypes: Array<string | null>,
+    opts?: { async?: boolean },
   ): T;
   UTF8ToString(ptr: number, maxBytesToRead?: number): string;
   _malloc(size: number): number;
@@ -39,15 +65,64 @@ export interface QuickjsWasmModule {
   ready?: Promise<unknown>;
 }
 
+/**
+ * Engine backing a runtime. `native` runs the same fork and shim as the
+ * wasm32 release build through the `@blue-quickjs/quickjs-native` addon
+ * (Node only). Allocation gas follows 64-bit struct sizes there, so it is not
+ * consensus-equivalent and needs `allowNonConsensus`.
+ */
+export type RuntimeBackend = 'wasm' | 'native';
+
 export interface RuntimeArtifactSelection {
+  /**
+   * Engine to run on (default `wasm`). `native` supports the `release` build
+   * type and `32mib` memory profile only and ignores the wasm options below.
+   */
+  backend?: RuntimeBackend;
+  /**
+   * Required with `backend: 'native'`. Its gas, out-of-memory points and
+   * gas-bounded results differ from the wasm32 build that defines consensus,
+   * so only set this where results are not compared across backends.
+   */
+  allowNonConsensus?: boolean;
   variant?: QuickjsWasmVariant;
   buildType?: QuickjsWasmBuildType;
+  /**
+   * Fixed wasm memory size (default `32mib`). Each profile is a separate build
+   * with its own `engineBuildHash`; allocations beyond it fail with `OOM`.
+   */
+  memoryProfile?: QuickjsWasmMemoryProfile;
   metadata?: QuickjsWasmBuildMetadata;
+  /**
+   * Raw wasm bytes; compiled once per Uint8Array instance.
+   */
   wasmBinary?: Uint8Array;
+  /**
+   * Precompiled module to instantiate (takes precedence over wasmBinary).
+   * Defaults to the shared module from `loadQuickjsWasmModule`.
+   */
+  wasmModule?: QuickjsWasmCompiledModule;
+}
+
+/**
+ * Heap used by the VMs of one runtime. `arena` gives each VM its own chunked
+ * arena inside the wasm memory, so freeing a VM releases its chunks instead
+ * of tearing the heap down object by object. Gas is identical in both modes.
+ */
+export type RuntimeAllocator = 'system' | 'arena';
+
+export interface RuntimeAllocatorOptions {
+  /**
+   * Allocator for VMs created on this runtime (default `system`).
+   */
+  allocator?: RuntimeAllocator;
 }
 
 export interface CreateRuntimeOptions
-  extends HostDispatcherOptions, RuntimeArtifactSelection {
+  extends
+    HostDispatcherOptions,
+    RuntimeArtifactSelection,
+    RuntimeAllocatorOptions {
   manifest: AbiManifest;
   handlers: HostDispatcherHandlers;
 }
@@ -55,18 +130,38 @@ export interface CreateRuntimeOptions
 export interface RuntimeInstance {
   module: QuickjsWasmModule;
   dispatcher: HostDispatcher;
-  hostCall: HostCallImport;
+  /**
+   * The installed `host_call`; returns a Promise only in the `async` build.
+   */
+  hostCall: AsyncHostCallImport;
   manifest: CanonicalAbiManifest;
-  artifact: QuickjsWasmArtifact;
-  metadata: QuickjsWasmBuildMetadata;
+  backend: RuntimeBackend;
+  artifact: QuickjsWasmArtifact | QuickjsNativeArtifact;
+  metadata: QuickjsWasmBuildMetadata | QuickjsNativeBuildMetadata;
+  /**
+   * Identifies the engine image; snapshots only restore into runtimes with
+   * the same one. Native runtimes use their own module object.
+   */
+  wasmModule: QuickjsWasmCompiledModule;
   variant: QuickjsWasmVariant;
   buildType: QuickjsWasmBuildType;
+  memoryProfile: QuickjsWasmMemoryProfile;
+  allocator: RuntimeAllocator;
 }
 
 type QuickjsWasmModuleFactory = (opts: {
-  host: { host_call: HostCallImport };
+  host: {
+    host_call: AsyncHostCallImport;
+    tape_sink: (handle: number, ptr: number, count: number) => void;
+  };
   locateFile?: (path: string, scriptDirectory?: string) => string;
-  wasmBinary?: ArrayBufferView | ArrayBuffer;
+  instantiateWasm?: (
+    imports: object,
+    receiveInstance: (
+      instance: QuickjsWasmInstance,
+      module?: QuickjsWasmCompiledModule,
+    ) => void,
+  ) => object;
 }) => Promise<QuickjsWasmModule>;
 
 export async function createRuntime(
@@ -74,24 +169,157 @@ export async function createRuntime(
 ): Promise<RuntimeInstance> {
   const variant = options.variant ?? DEFAULT_VARIANT;
   const buildType = options.buildType ?? DEFAULT_BUILD_TYPE;
+  const memoryProfile = options.memoryProfile ?? DEFAULT_MEMORY_PROFILE;
 
   if (variant !== 'wasm32') {
     throw new Error(
       `quickjs-runtime supports wasm32 only; host_call pointers are 32-bit (received variant=${variant})`,
     );
   }
+  if (options.backend === 'native') {
+    if (!options.allowNonConsensus) {
+      throw new Error(
+        "backend 'native' is not consensus-equivalent to wasm32 (allocation gas follows 64-bit struct sizes); pass allowNonConsensus: true to use it",
+      );
+    }
+    return createNativeRuntime(options, buildType, memoryProfile);
+  }
 
   const metadata =
     options.metadata ??
     (await loadQuickjsWasmMetadata().catch((error) => {
       throw new Error(`Failed to load QuickJS wasm metadata: ${String(error)}`);
     }));
-  const artifact = await getQuickjsWasmArtifact(variant, buildType, metadata);
+  const artifact = await getQuickjsWasmArtifact(
+    variant,
+    buildType,
+    metadata,
+    memoryProfile,
+  );
+
+  const wasmModule =
+    options.wasmModule ??
+    (options.wasmBinary
+      ? await compileWasmBinary(options.wasmBinary)
+      : await loadQuickjsWasmModule(
+          variant,
+          buildType,
+          metadata,
+          memoryProfile,
+        ));
+
+  const {
+    dispatcher,
+    hostMemory,
+    hostCall,
+    guardedHostCall,
+    suspendGate,
+    tapeSinks,
+    tapeSink,
+  } = createHostImports(options, buildType);
 
-  const wasmBinary =
-    options.wasmBinary ??
-    (await loadQuickjsWasmBinary(variant, buildType, metadata));
+  const moduleFactory = (await import(artifact.loaderUrl.href))
+    .default as QuickjsWasmModuleFactory;
+
+  // The loader only reports synchronous instantiateWasm failures, so surface
+  // asynchronous ones by racing the factory.
+  let rejectInstantiation: (error: unknown) => void = () => undefined;
+  const instantiationFailed = new Promise<never>((_, reject) => {
+    rejectInstantiation = reject;
+  });
+  const module = await Promise.race([
+    moduleFactory({
+      host: { host_call: guardedHostCall, tape_sink: tapeSink },
+      locateFile: (path: string) =>
+        path.endsWith('.wasm') ? artifact.wasmUrl.href : path,
+      instantiateWasm: (imports, receiveInstance) => {
+        instantiateQuickjsWasmModule(wasmModule, imports).then(
+          (instance) => receiveInstance(instance, wasmModule),
+          rejectInstantiation,
+        );
+        return {};
+      },
+    }),
+    instantiationFailed,
+  ]);
 
+  const buffer = module?.HEAPU8?.buffer as ArrayBuffer | undefined;
+  if (!buffer) {
+    throw new Error('QuickJS wasm module did not expose linear memory');
+  }
+  hostMemory.buffer = buffer;
+
+  const runtime: RuntimeInstance = {
+    module,
+    dispatcher,
+    hostCall,
+    manifest: dispatcher.manifest,
+    backend: 'wasm',
+    artifact,
+    metadata,
+    wasmModule,
+    variant,
+    buildType,
+    memoryProfile,
+    allocator: options.allocator ?? 'system',
+  };
+  if (buildType === 'async') {
+    SUSPEND_GATES.set(runtime, suspendGate);
+  }
+  TAPE_SINKS.set(runtime, tapeSinks);
+  return runtime;
+}
+
+/**
+ * Route the tape records streamed by VM `handle` to `sink`, or stop routing
+ * them when `sink` is null.
+ */
+export function setTapeSink(
+  runtime: RuntimeInstance,
+  handle: number,
+  sink: TapeSink | null,
+): void {
+  const sinks = TAPE_SINKS.get(runtime);
+  if (!sink) {
+    sinks?.delete(handle);
+    return;
+  }
+  if (!sinks) {
+    throw new Error('tape streaming requires a runtime from createRuntime');
+  }
+  sinks.set(handle, sink);
+}
+
+/**
+ * Run `call` (an async-export invocation) with host calls allowed to suspend
+ * the VM. Asyncify keeps a single saved stack per instance, so an `async`
+ * runtime runs one suspendable call at a time; other build types just await.
+ */
+export async function withSuspendableHostCalls<T>(
+  runtime: RuntimeInstance,
+  call: () => Promise<T>,
+): Promise<T> {
+  const gate = SUSPEND_GATES.get(runtime);
+  if (!gate) {
+    return call();
+  }
+  if (gate.open) {
+    throw new Error(
+      'async runtime is already running an evaluation; await it before starting another',
+    );
+  }
+  gate.open = true;
+  try {
+    return await call();
+  } finally {
+    gate.open = false;
+  }
+}
+
+function createHostImports(
+  options: CreateRuntimeOptions,
+  buildType: QuickjsWasmBuildType,
+) {
   const dispatcher = createHostDispatcher(
     options.manifest,
     options.handlers,
@@ -99,45 +327,109 @@ export async function createRuntime(
   );
 
   const hostMemory: HostCallMemory = { buffer: new ArrayBuffer(0) };
-  const hostCall = createHostCallImport(dispatcher, hostMemory);
-  const guardedHostCall: HostCallImport = (...args) => {
+  const suspendGate = { open: false };
+  const hostCall: AsyncHostCallImport =
+    buildType === 'async'
+      ? createAsyncHostCallImport(
+          dispatcher,
+          hostMemory,
+          () => suspendGate.open,
+        )
+      : createHostCallImport(dispatcher, hostMemory);
+  const guardedHostCall: AsyncHostCallImport = (...args) => {
     if (hostMemory.buffer.byteLength === 0) {
       return UINT32_MAX;
     }
     return hostCall(...args);
   };
 
-  const moduleFactory = (await import(artifact.loaderUrl.href))
-    .default as QuickjsWasmModuleFactory;
+  const tapeSinks = new Map<number, TapeSink>();
+  const tapeSink = (handle: number, ptr: number, count: number): void => {
+    tapeSinks.get(handle >>> 0)?.(ptr >>> 0, count >>> 0);
+  };
+  return {
+    dispatcher,
+    hostMemory,
+    hostCall,
+    guardedHostCall,
+    suspendGate,
+    tapeSinks,
+    tapeSink,
+  };
+}
 
-  const module = await moduleFactory({
-    host: { host_call: guardedHostCall },
-    wasmBinary: toArrayBuffer(wasmBinary),
-    locateFile: (path: string) =>
-      path.endsWith('.wasm') ? artifact.wasmUrl.href : path,
-  });
+async function createNativeRuntime(
+  options: CreateRuntimeOptions,
+  buildType: QuickjsWasmBuildType,
+  memoryProfile: QuickjsWasmMemoryProfile,
+): Promise<RuntimeInstance> {
+  if (buildType !== 'release' || memoryProfile !== DEFAULT_MEMORY_PROFILE) {
+    throw new Error(
+      `native backend supports the release build with the ${DEFAULT_MEMORY_PROFILE} profile only (received buildType=${buildType}, memoryProfile=${memoryProfile})`,
+    );
+  }
 
-  const buffer = module?.HEAPU8?.buffer as ArrayBuffer | undefined;
-  if (!buffer) {
-    throw new Error('QuickJS wasm module did not expose linear memory');
+  // Loaded lazily so that wasm-only (and browser) consumers never touch it.
+  // It is an optional peer dependency, so it may not be installed at all.
+  let native: typeof import('@blue-quickjs/quickjs-native');
+  try {
+    native = await import('@blue-quickjs/quickjs-native');
+  } catch (error) {
+    throw new Error(
+      `backend 'native' requires the optional @blue-quickjs/quickjs-native package: ${String(error)}`,
+    );
   }
-  hostMemory.buffer = buffer;
+  let metadata: QuickjsNativeBuildMetadata;
+  try {
+    metadata = native.readQuickjsNativeMetadata();
+  } catch (error) {
+    throw new Error(`Failed to load QuickJS native metadata: ${String(error)}`);
+  }
+  const artifact = native.getQuickjsNativeArtifact(metadata);
+  const {
+    dispatcher,
+    hostMemory,
+    hostCall,
+    guardedHostCall,
+    tapeSinks,
+    tapeSink,
+  } = createHostImports(options, buildType);
 
-  return {
+  // Release builds never suspend, so the import always returns a number.
+  const module = native.createQuickjsNativeModule({
+    host: {
+      host_call: guardedHostCall as HostCallImport,
+      tape_sink: tapeSink,
+    },
+    addonPath: artifact.addonPath,
+  });
+  hostMemory.buffer = module.HEAPU8.buffer as ArrayBuffer;
+
+  const runtime: RuntimeInstance = {
     module,
     dispatcher,
     hostCall,
     manifest: dispatcher.manifest,
+    backend: 'native',
     artifact,
     metadata,
-    variant,
+    wasmModule: module,
+    variant: DEFAULT_VARIANT,
     buildType,
+    memoryProfile,
+    allocator: options.allocator ?? 'system',
   };
+  TAPE_SINKS.set(runtime, tapeSinks);
+  return runtime;
 }
 
-function toArrayBuffer(view: Uint8Array): ArrayBuffer {
-  if (view.byteOffset === 0 && view.byteLength === view.buffer.byteLength) {
-    return view.buffer as ArrayBuffer;
+function compileWasmBinary(
+  wasmBinary: Uint8Array,
+): Promise<QuickjsWasmCompiledModule> {
+  let compiled = COMPILED_BINARIES.get(wasmBinary);
+  if (!compiled) {
+    compiled = compileQuickjsWasmBinary(wasmBinary);
+    COMPILED_BINARIES.set(wasmBinary, compiled);
   }
-  return view.slice().buffer;
+  return compiled;
 }
@@ -9,10 +9,14 @@ OUT_DIR="${PROJECT_ROOT}/dist"
 METADATA_BASENAME="quickjs-wasm-build.metadata.json"
 VARIANTS_RAW="${WASM_VARIANTS:-wasm32}"
 BUILD_TYPES_RAW="${WASM_BUILD_TYPES:-release,debug}"
+MEMORY_PROFILES_RAW="${WASM_MEMORY_PROFILES:-32mib}"
+# Default memory profile; build.memory and the unsuffixed artifacts describe it.
 WASM_INITIAL_MEMORY_BYTES=$((32 * 1024 * 1024))
 WASM_STACK_SIZE_BYTES=$((1 * 1024 * 1024))
 ALLOW_MEMORY_GROWTH=0
 SOURCE_DATE_EPOCH_DEFAULT=1704067200
+# Optional clang profile for the optimized build type (see docs/toolchain.md).
+PGO_PROFILE_RAW="${WASM_PGO_PROFILE:-}"
 
 ENV_SCRIPT="${REPO_ROOT}/tools/emsdk/emsdk_env.sh"
 if [[ ! -f "${ENV_SCRIPT}" ]]; then
@@ -81,8 +85,6 @@ BASE_EMCC_FLAGS=(
   -sEXPORT_ES6=1
   -sENVIRONMENT=node,web
   -sNO_EXIT_RUNTIME=1
-  -sINITIAL_MEMORY="${WASM_INITIAL_MEMORY_BYTES}"
-  -sMAXIMUM_MEMORY="${WASM_INITIAL_MEMORY_BYTES}"
   -sALLOW_MEMORY_GROWTH="${ALLOW_MEMORY_GROWTH}"
   -sALLOW_TABLE_GROWTH=0
   -sSTACK_SIZE="${WASM_STACK_SIZE_BYTES}"
@@ -91,7 +93,7 @@ BASE_EMCC_FLAGS=(
   -sERROR_ON_UNDEFINED_SYMBOLS=0
   -sEXPORT_NAME=QuickJSGasWasm
   -sWASM_BIGINT=1
-  "-sEXPORTED_FUNCTIONS=['_qjs_det_init','_qjs_det_eval','_qjs_det_set_gas_limit','_qjs_det_free','_qjs_det_enable_tape','_qjs_det_read_tape','_qjs_det_enable_trace','_qjs_det_read_trace','_malloc','_free']"
+  "-sEXPORTED_FUNCTIONS=['_qjs_det_init','_qjs_det_take_init_error','_qjs_det_input_buffer','_qjs_det_set_manifest','_qjs_det_use_arena','_qjs_det_eval','_qjs_det_eval_bin','_qjs_det_compile','_qjs_det_eval_bytecode','_qjs_det_set_gas_limit','_qjs_det_memoize_host_fn','_qjs_det_free','_qjs_det_free_all','_qjs_det_snapshot','_qjs_det_restore','_qjs_det_session_begin','_qjs_det_heap_top','_qjs_det_enable_tape','_qjs_det_read_tape','_qjs_det_read_tape_bin','_qjs_det_stream_tape','_qjs_det_flush_tape','_qjs_det_enable_trace','_qjs_det_read_trace','_qjs_det_read_trace_bin','_qjs_det_read_host_gas_bin','_qjs_det_read_calibration_bin','_malloc','_free']"
 "-sEXPORTED_RUNTIME_METHODS=['cwrap','ccall','UTF8ToString','lengthBytesUTF8']"
 )
 
@@ -106,26 +108,114 @@ DEBUG_FLAGS=(
   -sSTACK_OVERFLOW_CHECK=2
 )
 
+# Opt-in build where host_call may return a Promise: Asyncify unwinds the wasm
+# stack while the host awaits and rewinds it with the response. The VM code is
+# unchanged, so gas and tape match the release build. The unwind buffer covers
+# the whole C stack so any call depth the release build reaches can suspend.
+ASYNC_FLAGS=(
+  -O2
+  -sASSERTIONS=0
+  -sASYNCIFY=1
+  "-sASYNCIFY_IMPORTS=['host.host_call']"
+  -sASYNCIFY_STACK_SIZE="${WASM_STACK_SIZE_BYTES}"
+)
+
+# Release tuned for throughput: -O3 with link-time optimization across the
+# engine, DV codec and shim, then a pinned binaryen pass over the linked wasm
+# (WASM_OPT_PASSES, run with the emsdk's own wasm-opt so its version follows
+# emsdk-version.txt). Wasm has no fused multiply-add outside relaxed-simd and
+# binaryen never assumes fast-math, so results and gas match release. The
+# optional WASM_PGO_PROFILE only moves code layout and inlining decisions.
+OPTIMIZED_FLAGS=(
+  -O3
+  -flto
+  -sASSERTIONS=0
+)
+
+# Feature flags match what emcc 3.1.56 emits by default; wasm-opt fails
+# validation rather than guess if the linked module uses anything else.
+WASM_OPT_PASSES=(
+  -O3
+  --converge
+  --enable-sign-ext
+  --enable-mutable-globals
+)
+
+# Out-of-band build for tuning the gas schedule (see apps/benchmarks): the shim
+# times evaluations, host calls and GC checkpoints (QJS_DET_CALIBRATION), and
+# -sDETERMINISTIC=0 gives it real clocks. Gas is unchanged, but the binary is
+# flagged outOfBand in the metadata and never serves consensus evaluations.
+CALIBRATION_FLAGS=(
+  -O2
+  -sASSERTIONS=0
+  -sDETERMINISTIC=0
+  -DQJS_DET_CALIBRATION=1
+)
+
 BUILT_VARIANTS=()
+WASM_OPT_BIN=""
+PGO_PROFILE_PATH=""
+PGO_FLAGS=()
+
+resolve_optimized_tools() {
+  if [[ -n "${WASM_OPT_BIN}" ]]; then
+    return
+  fi
+  WASM_OPT_BIN="${EMSDK:-${REPO_ROOT}/tools/emsdk}/upstream/bin/wasm-opt"
+  if [[ ! -x "${WASM_OPT_BIN}" ]]; then
+    echo "wasm-opt not found at ${WASM_OPT_BIN}; the optimized build type needs the emsdk binaryen." >&2
+    exit 1
+  fi
+  export QJS_WASM_OPT_VERSION="$("${WASM_OPT_BIN}" --version)"
+
+  if [[ -n "${PGO_PROFILE_RAW}" ]]; then
+    if [[ "${PGO_PROFILE_RAW}" = /* ]]; then
+      PGO_PROFILE_PATH="${PGO_PROFILE_RAW}"
+    else
+      PGO_PROFILE_PATH="${REPO_ROOT}/${PGO_PROFILE_RAW}"
+    fi
+    if [[ ! -f "${PGO_PROFILE_PATH}" ]]; then
+      echo "WASM_PGO_PROFILE not found: ${PGO_PROFILE_PATH}" >&2
+      exit 1
+    fi
+    # Kept out of buildFlags so the metadata does not embed a local path; the
+    # profile is recorded by name and hash instead. The profile comes from a
+    # native build, so functions behind __EMSCRIPTEN__ do not match it.
+    PGO_FLAGS=(
+      "-fprofile-use=${PGO_PROFILE_PATH}"
+      -Wno-profile-instr-out-of-date
+      -Wno-profile-instr-unprofiled
+    )
+    export QJS_WASM_PGO_PROFILE="${PGO_PROFILE_PATH}"
+  fi
+}
 
 inject_host_imports() {
   local js_file="$1"
+  local mode="${2:-sync}"
   node -e "
     const fs = require('fs');
-    const file = process.argv[1];
+    const [file, mode] = process.argv.slice(1);
     let source = fs.readFileSync(file, 'utf8');
     if (!source.includes('var info={\"env\":wasmImports,\"wasi_snapshot_preview1\":wasmImports};')) {
       throw new Error(\`Unable to find wasm import object in \${file} for host injection\`);
     }
     if (!source.includes('info[\"host\"]=')) {
       const marker = 'var info={\"env\":wasmImports,\"wasi_snapshot_preview1\":wasmImports};';
-      source = source.replace(
-        marker,
-        \`\${marker}info[\"host\"]=Module[\"host\"]||{host_call:function(){return 0xffffffff;}};\`,
-      );
+      // Async builds hand a thenable result to Asyncify, which suspends the
+      // caller until it settles. Plain numbers return without unwinding, and a
+      // rewind replays the settled value instead of calling the host again.
+      // tape_sink is optional for embedders; a missing one drops the records.
+      const sink =
+        'tape_sink:(Module[\"host\"]&&Module[\"host\"].tape_sink)||function(){}';
+      const host =
+        mode === 'async'
+          ? 'info[\"host\"]={host_call:function(a,b,c,d,e){if(Asyncify.state!==Asyncify.State.Normal){return Asyncify.handleAsync(function(){});}var h=Module[\"host\"]&&Module[\"host\"].host_call;if(!h){return 0xffffffff;}var r=h(a,b,c,d,e);if(r===null||typeof r!==\"object\"||typeof r.then!==\"function\"){return r;}return Asyncify.handleAsync(function(){return r;});},' + sink + '};'
+          : 'info[\"host\"]={host_call:(Module[\"host\"]&&Module[\"host\"].host_call)||function(){return 0xffffffff;},' + sink + '};';
+      source = source.replace(marker, \`\${marker}\${host}\`);
       fs.writeFileSync(file, source);
     }
-  " -- "${js_file}"
+  " -- "${js_file}" "${mode}"
 }
 
 rm -rf "${OUT_DIR}"
@@ -137,6 +227,12 @@ if [[ ${#REQUESTED_VARIANTS[@]} -eq 0 ]]; then
   REQUESTED_VARIANTS=("wasm32")
 fi
 
+MEMORY_PROFILES_RAW_CLEAN="${MEMORY_PROFILES_RAW//[[:space:]]/}"
+IFS=',' read -ra REQUESTED_MEMORY_PROFILES <<< "${MEMORY_PROFILES_RAW_CLEAN}"
+if [[ ${#REQUESTED_MEMORY_PROFILES[@]} -eq 0 ]]; then
+  REQUESTED_MEMORY_PROFILES=("32mib")
+fi
+
 BUILD_TYPES_RAW_CLEAN="${BUILD_TYPES_RAW//[[:space:]]/}"
 IFS=',' read -ra REQUESTED_BUILD_TYPES <<< "${BUILD_TYPES_RAW_CLEAN}"
 if [[ ${#REQUESTED_BUILD_TYPES[@]} -eq 0 ]]; then
@@ -181,32 +277,93 @@ for variant in "${REQUESTED_VARIANTS[@]}"; do
         build_type_flags+=("${DEBUG_FLAGS[@]}")
         build_suffix="-debug"
         ;;
+      async)
+        build_type_flags+=("${ASYNC_FLAGS[@]}")
+        build_suffix="-async"
+        ;;
+      optimized)
+        resolve_optimized_tools
+        build_type_flags+=("${OPTIMIZED_FLAGS[@]}")
+        build_suffix="-optimized"
+        ;;
+      calibration)
+        build_type_flags+=("${CALIBRATION_FLAGS[@]}")
+        build_suffix="-calibration"
+        ;;
       *)
-        echo "Unknown WASM build type '${build_type}'. Expected release or debug." >&2
+        echo "Unknown WASM build type '${build_type}'. Expected release, debug, async, optimized or calibration." >&2
         exit 1
         ;;
     esac
 
-    emcc_args=("${SRC_FILES[@]}" "${BASE_EMCC_FLAGS[@]}")
-    if [[ ${#variant_flags[@]} -gt 0 ]]; then
-      emcc_args+=("${variant_flags[@]}")
-    fi
-    if [[ ${#build_type_flags[@]} -gt 0 ]]; then
-      emcc_args+=("${build_type_flags[@]}")
-    fi
-
-    emcc "${emcc_args[@]}" -o "${OUT_DIR}/quickjs-eval${suffix}${build_suffix}.js"
-    inject_host_imports "${OUT_DIR}/quickjs-eval${suffix}${build_suffix}.js"
-
-    build_flags_str=""
-    if [[ ${#build_type_flags[@]} -gt 0 ]]; then
-      build_flags_str="$(IFS=','; echo "${build_type_flags[*]}")"
-    fi
-
-    BUILT_VARIANTS+=("${normalized_variant}:${normalized_build_type}:${OUT_DIR}/quickjs-eval${suffix}${build_suffix}.wasm:${OUT_DIR}/quickjs-eval${suffix}${build_suffix}.js:${variant_flags_str}:${build_flags_str}")
-    echo "Built QuickJS wasm harness (${normalized_variant}/${normalized_build_type}):"
-    echo "  JS:   ${OUT_DIR}/quickjs-eval${suffix}${build_suffix}.js"
-    echo "  Wasm: ${OUT_DIR}/quickjs-eval${suffix}${build_suffix}.wasm"
+    for memory_profile in "${REQUESTED_MEMORY_PROFILES[@]}"; do
+      normalized_profile="$(echo "${memory_profile}" | tr '[:upper:]' '[:lower:]')"
+      profile_suffix=""
+
+      # Only the heap size changes between profiles. The stack stays at 1 MiB
+      # so recursion limits match, and growth stays off so every profile hits
+      # out-of-memory at a fixed ceiling.
+      case "${normalized_profile}" in
+        4mib | 8mib | 16mib)
+          profile_suffix="-${normalized_profile}"
+          ;;
+        32mib)
+          ;;
+        *)
+          echo "Unknown WASM memory profile '${memory_profile}'. Expected 4mib, 8mib, 16mib or 32mib." >&2
+          exit 1
+          ;;
+      esac
+      memory_bytes=$((${normalized_profile%mib} * 1024 * 1024))
+      profile_flags=(
+        -sINITIAL_MEMORY="${memory_bytes}"
+        -sMAXIMUM_MEMORY="${memory_bytes}"
+        "-DQJS_DET_MEMORY_BYTES=${memory_bytes}u"
+      )
+      artifact_suffix="${suffix}${build_suffix}${profile_suffix}"
+
+      emcc_args=("${SRC_FILES[@]}" "${BASE_EMCC_FLAGS[@]}" "${profile_flags[@]}")
+      if [[ ${#variant_flags[@]} -gt 0 ]]; then
+        emcc_args+=("${variant_flags[@]}")
+      fi
+      if [[ ${#build_type_flags[@]} -gt 0 ]]; then
+        emcc_args+=("${build_type_flags[@]}")
+      fi
+      if [[ "${normalized_build_type}" == "optimized" && ${#PGO_FLAGS[@]} -gt 0 ]]; then
+        emcc_args+=("${PGO_FLAGS[@]}")
+      fi
+
+      emcc "${emcc_args[@]}" -o "${OUT_DIR}/quickjs-eval${artifact_suffix}.js"
+
+      # The loader only refers to imports and exports, which wasm-opt keeps, so
+      # rewriting the wasm in place leaves the JS valid.
+      wasm_opt_str=""
+      if [[ "${normalized_build_type}" == "optimized" ]]; then
+        wasm_opt_args=("${WASM_OPT_PASSES[@]}")
+        if [[ "${normalized_variant}" == "wasm64" ]]; then
+          wasm_opt_args+=(--enable-memory64)
+        fi
+        wasm_file="${OUT_DIR}/quickjs-eval${artifact_suffix}.wasm"
+        "${WASM_OPT_BIN}" "${wasm_file}" "${wasm_opt_args[@]}" -o "${wasm_file}.opt"
+        mv "${wasm_file}.opt" "${wasm_file}"
+        wasm_opt_str="$(IFS=','; echo "${wasm_opt_args[*]}")"
+      fi
+      host_import_mode="sync"
+      if [[ "${normalized_build_type}" == "async" ]]; then
+        host_import_mode="async"
+      fi
+      inject_host_imports "${OUT_DIR}/quickjs-eval${artifact_suffix}.js" "${host_import_mode}"
+
+      build_flags_str=""
+      if [[ ${#build_type_flags[@]} -gt 0 ]]; then
+        build_flags_str="$(IFS=','; echo "${build_type_flags[*]}")"
+      fi
+
+      BUILT_VARIANTS+=("${normalized_variant}:${normalized_build_type}:${normalized_profile}:${memory_bytes}:${OUT_DIR}/quickjs-eval${artifact_suffix}.wasm:${OUT_DIR}/quickjs-eval${artifact_suffix}.js:${variant_flags_str}:${build_flags_str}:${wasm_opt_str}")
+      echo "Built QuickJS wasm harness (${normalized_variant}/${normalized_build_type}/${normalized_profile}):"
+      echo "  JS:   ${OUT_DIR}/quickjs-eval${artifact_suffix}.js"
+      echo "  Wasm: ${OUT_DIR}/quickjs-eval${artifact_suffix}.wasm"
+    done
   done
 done
 
@@ -259,12 +416,15 @@ const variants = variantArgs
     const [
       variant,
       buildType,
+      memoryProfile,
+      memoryBytesRaw,
       wasmPath,
       loaderPath,
       variantFlagsRaw = '',
       buildTypeFlagsRaw = '',
+      wasmOptPassesRaw = '',
     ] = entry.split(':');
-    if (!variant || !buildType || !wasmPath || !loaderPath) {
+    if (!variant || !buildType || !memoryProfile || !wasmPath || !loaderPath) {
       throw new Error(`Invalid variant entry: ${entry}`);
     }
     const variantFlags = variantFlagsRaw
@@ -273,16 +433,48 @@ const variants = variantArgs
     const buildTypeFlags = buildTypeFlagsRaw
       ? buildTypeFlagsRaw.split(',').map((flag) => flag.trim()).filter(Boolean)
       : [];
-    return { variant, buildType, wasmPath, loaderPath, variantFlags, buildTypeFlags };
+    const wasmOptPasses = wasmOptPassesRaw
+      ? wasmOptPassesRaw.split(',').map((flag) => flag.trim()).filter(Boolean)
+      : [];
+    const memoryBytes = Number.parseInt(memoryBytesRaw, 10);
+    return {
+      variant,
+      buildType,
+      memoryProfile,
+      memoryBytes,
+      wasmPath,
+      loaderPath,
+      variantFlags,
+      buildTypeFlags,
+      wasmOptPasses,
+    };
   })
   .sort((a, b) => {
-    if (a.variant === b.variant) {
+    if (a.variant !== b.variant) {
+      return a.variant.localeCompare(b.variant);
+    }
+    if (a.buildType !== b.buildType) {
       return a.buildType.localeCompare(b.buildType);
     }
-    return a.variant.localeCompare(b.variant);
+    return a.memoryBytes - b.memoryBytes;
   });
 
+const DEFAULT_MEMORY_PROFILE = '32mib';
+// Builds that read clocks; never pinned as a consensus engineBuildHash.
+const OUT_OF_BAND_BUILD_TYPES = new Set(['calibration']);
+const stackSize = parseUintEnv('QJS_WASM_STACK_SIZE_BYTES');
+const pgoProfile = process.env.QJS_WASM_PGO_PROFILE
+  ? {
+      filename: path.basename(process.env.QJS_WASM_PGO_PROFILE),
+      sha256: sha256File(process.env.QJS_WASM_PGO_PROFILE),
+    }
+  : null;
+const allowGrowth = process.env.QJS_WASM_ALLOW_MEMORY_GROWTH === '1';
+
+// The default profile stays under `variants` so existing readers are
+// unaffected; smaller profiles are keyed by profile name first.
 const variantsMeta = {};
+const memoryProfilesMeta = {};
 for (const entry of variants) {
   const wasm = {
     filename: path.basename(entry.wasmPath),
@@ -294,39 +486,62 @@ for (const entry of variants) {
     sha256: sha256File(entry.loaderPath),
     size: statSize(entry.loaderPath),
   };
-  if (!variantsMeta[entry.variant]) {
-    variantsMeta[entry.variant] = {};
+  let target = variantsMeta;
+  if (entry.memoryProfile !== DEFAULT_MEMORY_PROFILE) {
+    memoryProfilesMeta[entry.memoryProfile] ??= {};
+    target = memoryProfilesMeta[entry.memoryProfile];
+  }
+  if (!target[entry.variant]) {
+    target[entry.variant] = {};
   }
-  variantsMeta[entry.variant][entry.buildType] = {
+  target[entry.variant][entry.buildType] = {
     buildType: entry.buildType,
+    memoryProfile: entry.memoryProfile,
     engineBuildHash: wasm.sha256,
     wasm,
     loader,
+    memory: {
+      initial: entry.memoryBytes,
+      maximum: entry.memoryBytes,
+      stackSize,
+      allowGrowth,
+    },
     variantFlags: entry.variantFlags,
     buildFlags: entry.buildTypeFlags,
   };
+  if (OUT_OF_BAND_BUILD_TYPES.has(entry.buildType)) {
+    target[entry.variant][entry.buildType].outOfBand = true;
+  }
+  if (entry.buildType === 'optimized') {
+    target[entry.variant][entry.buildType].wasmOpt = {
+      version: process.env.QJS_WASM_OPT_VERSION ?? null,
+      passes: entry.wasmOptPasses,
+    };
+    target[entry.variant][entry.buildType].pgo = pgoProfile;
+  }
 }
 
 let engineBuildHash = null;
 if (variantsMeta.wasm32?.release?.engineBuildHash) {
   engineBuildHash = variantsMeta.wasm32.release.engineBuildHash;
 } else if (variantsMeta.wasm32) {
-  const firstBuildType = Object.values(variantsMeta.wasm32)[0];
+  const firstBuildType = Object.values(variantsMeta.wasm32).find((meta) => !meta.outOfBand);
   engineBuildHash = firstBuildType?.engineBuildHash ?? null;
 } else if (variantsMeta.wasm64) {
-  const firstBuildType = Object.values(variantsMeta.wasm64)[0];
+  const firstBuildType = Object.values(variantsMeta.wasm64).find((meta) => !meta.outOfBand);
   engineBuildHash = firstBuildType?.engineBuildHash ?? null;
 } else if (variants.length > 0) {
-  const first = variants[0];
-  engineBuildHash =
-    variantsMeta[first.variant]?.[first.buildType]?.engineBuildHash ?? null;
+  const first = variants.find((entry) => !OUT_OF_BAND_BUILD_TYPES.has(entry.buildType));
+  engineBuildHash = first
+    ? variantsMeta[first.variant]?.[first.buildType]?.engineBuildHash ?? null
+    : null;
 }
 
 const buildMemory = {
   initial: parseUintEnv('QJS_WASM_INITIAL_MEMORY_BYTES'),
   maximum: parseUintEnv('QJS_WASM_MAX_MEMORY_BYTES'),
-  stackSize: parseUintEnv('QJS_WASM_STACK_SIZE_BYTES'),
-  allowGrowth: process.env.QJS_WASM_ALLOW_MEMORY_GROWTH === '1',
+  stackSize,
+  allowGrowth,
 };
 
 const determinism = {
@@ -345,6 +560,9 @@ const metadata = {
   },
   variants: variantsMeta,
 };
+if (Object.keys(memoryProfilesMeta).length > 0) {
+  metadata.memoryProfiles = memoryProfilesMeta;
+}
 
 const outPath = path.join(outDir, metadataBasename);
 fs.writeFileSync(outPath, `${JSON.stringify(metadata, null, 2)}\n`, 'utf8');
@@ -42,6 +42,45 @@ describe('getQuickjsWasmArtifacts', () => {
     );
   });
 
+  it('returns stable dist paths (wasm32 async)', () => {
+    const artifacts = getQuickjsWasmArtifacts('wasm32', 'async');
+    const wasm = normalize(artifacts.wasmPath);
+    const loader = normalize(artifacts.loaderPath);
+
+    expect(wasm).toMatch(
+      /libs\/quickjs-wasm-build\/dist\/quickjs-eval-async\.wasm$/,
+    );
+    expect(loader).toMatch(
+      /libs\/quickjs-wasm-build\/dist\/quickjs-eval-async\.js$/,
+    );
+  });
+
+  it('returns stable dist paths (wasm32 optimized)', () => {
+    const artifacts = getQuickjsWasmArtifacts('wasm32', 'optimized');
+    const wasm = normalize(artifacts.wasmPath);
+    const loader = normalize(artifacts.loaderPath);
+
+    expect(wasm).toMatch(
+      /libs\/quickjs-wasm-build\/dist\/quickjs-eval-optimized\.wasm$/,
+    );
+    expect(loader).toMatch(
+      /libs\/quickjs-wasm-build\/dist\/quickjs-eval-optimized\.js$/,
+    );
+  });
+
+  it('returns stable dist paths (wasm32 calibration)', () => {
+    const artifacts = getQuickjsWasmArtifacts('wasm32', 'calibration');
+    const wasm = normalize(artifacts.wasmPath);
+    const loader = normalize(artifacts.loaderPath);
+
+    expect(wasm).toMatch(
+      /libs\/quickjs-wasm-build\/dist\/quickjs-eval-calibration\.wasm$/,
+    );
+    expect(loader).toMatch(
+      /libs\/quickjs-wasm-build\/dist\/quickjs-eval-calibration\.js$/,
+    );
+  });
+
   it('returns stable dist paths (wasm64)', () => {
     const artifacts = getQuickjsWasmArtifacts('wasm64');
     const wasm = normalize(artifacts.wasmPath);
@@ -68,6 +107,19 @@ describe('getQuickjsWasmArtifacts', () => {
     );
   });
 
+  it('suffixes non-default memory profiles', () => {
+    const small = getQuickjsWasmArtifacts('wasm32', 'debug', '8mib');
+    expect(normalize(small.wasmPath)).toMatch(
+      /libs\/quickjs-wasm-build\/dist\/quickjs-eval-debug-8mib\.wasm$/,
+    );
+    expect(normalize(small.loaderPath)).toMatch(
+      /libs\/quickjs-wasm-build\/dist\/quickjs-eval-debug-8mib\.js$/,
+    );
+    expect(getQuickjsWasmArtifacts('wasm32', 'release', '32mib')).toEqual(
+      getQuickjsWasmArtifacts(),
+    );
+  });
+
   it('exports the artifact basenames', () => {
     expect(QUICKJS_WASM_BASENAME).toBe('quickjs-eval.wasm');
     expect(QUICKJS_WASM_LOADER_BASENAME).toBe('quickjs-eval.js');
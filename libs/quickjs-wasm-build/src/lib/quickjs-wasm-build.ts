@@ -2,17 +2,32 @@ import fs from 'node:fs';
 import path from 'node:path';
 import { fileURLToPath } from 'node:url';
 import {
+  QUICKJS_WASM64_ASYNC_BASENAME,
+  QUICKJS_WASM64_ASYNC_LOADER_BASENAME,
+  QUICKJS_WASM64_CALIBRATION_BASENAME,
+  QUICKJS_WASM64_CALIBRATION_LOADER_BASENAME,
+  QUICKJS_WASM64_OPTIMIZED_BASENAME,
+  QUICKJS_WASM64_OPTIMIZED_LOADER_BASENAME,
   QUICKJS_WASM64_BASENAME,
   QUICKJS_WASM64_DEBUG_BASENAME,
   QUICKJS_WASM64_DEBUG_LOADER_BASENAME,
   QUICKJS_WASM64_LOADER_BASENAME,
+  QUICKJS_WASM_ASYNC_BASENAME,
+  QUICKJS_WASM_ASYNC_LOADER_BASENAME,
+  QUICKJS_WASM_CALIBRATION_BASENAME,
+  QUICKJS_WASM_CALIBRATION_LOADER_BASENAME,
+  QUICKJS_WASM_OPTIMIZED_BASENAME,
+  QUICKJS_WASM_OPTIMIZED_LOADER_BASENAME,
   QUICKJS_WASM_BASENAME,
   QUICKJS_WASM_DEBUG_BASENAME,
   QUICKJS_WASM_DEBUG_LOADER_BASENAME,
   QUICKJS_WASM_LOADER_BASENAME,
   QUICKJS_WASM_METADATA_BASENAME,
+  QUICKJS_WASM_DEFAULT_MEMORY_PROFILE,
+  memoryProfileFilename,
   type QuickjsWasmBuildMetadata,
   type QuickjsWasmBuildType,
+  type QuickjsWasmMemoryProfile,
   type QuickjsWasmVariant,
 } from './quickjs-wasm-constants.js';
 
@@ -41,6 +56,18 @@ const ARTIFACTS: Record<
       wasm: QUICKJS_WASM_DEBUG_BASENAME,
       loader: QUICKJS_WASM_DEBUG_LOADER_BASENAME,
     },
+    async: {
+      wasm: QUICKJS_WASM_ASYNC_BASENAME,
+      loader: QUICKJS_WASM_ASYNC_LOADER_BASENAME,
+    },
+    optimized: {
+      wasm: QUICKJS_WASM_OPTIMIZED_BASENAME,
+      loader: QUICKJS_WASM_OPTIMIZED_LOADER_BASENAME,
+    },
+    calibration: {
+      wasm: QUICKJS_WASM_CALIBRATION_BASENAME,
+      loader: QUICKJS_WASM_CALIBRATION_LOADER_BASENAME,
+    },
   },
   wasm64: {
     release: {
@@ -51,17 +78,36 @@ const ARTIFACTS: Record<
       wasm: QUICKJS_WASM64_DEBUG_BASENAME,
       loader: QUICKJS_WASM64_DEBUG_LOADER_BASENAME,
     },
+    async: {
+      wasm: QUICKJS_WASM64_ASYNC_BASENAME,
+      loader: QUICKJS_WASM64_ASYNC_LOADER_BASENAME,
+    },
+    optimized: {
+      wasm: QUICKJS_WASM64_OPTIMIZED_BASENAME,
+      loader: QUICKJS_WASM64_OPTIMIZED_LOADER_BASENAME,
+    },
+    calibration: {
+      wasm: QUICKJS_WASM64_CALIBRATION_BASENAME,
+      loader: QUICKJS_WASM64_CALIBRATION_LOADER_BASENAME,
+    },
   },
 };
 
 export function getQuickjsWasmArtifacts(
   variant: QuickjsWasmVariant = 'wasm32',
   buildType: QuickjsWasmBuildType = 'release',
+  memoryProfile: QuickjsWasmMemoryProfile = QUICKJS_WASM_DEFAULT_MEMORY_PROFILE,
 ) {
   const entry = ARTIFACTS[variant][buildType];
   return {
-    wasmPath: path.join(artifactDir, entry.wasm),
-    loaderPath: path.join(artifactDir, entry.loader),
+    wasmPath: path.join(
+      artifactDir,
+      memoryProfileFilename(entry.wasm, memoryProfile),
+    ),
+    loaderPath: path.join(
+      artifactDir,
+      memoryProfileFilename(entry.loader, memoryProfile),
+    ),
   };
 }
 
@@ -86,9 +132,13 @@ export {
   QUICKJS_WASM_LOADER_BASENAME,
   QUICKJS_WASM_DEBUG_BASENAME,
   QUICKJS_WASM_DEBUG_LOADER_BASENAME,
+  QUICKJS_WASM_ASYNC_BASENAME,
+  QUICKJS_WASM_ASYNC_LOADER_BASENAME,
   QUICKJS_WASM64_BASENAME,
   QUICKJS_WASM64_LOADER_BASENAME,
   QUICKJS_WASM64_DEBUG_BASENAME,
   QUICKJS_WASM64_DEBUG_LOADER_BASENAME,
+  QUICKJS_WASM64_ASYNC_BASENAME,
+  QUICKJS_WASM64_ASYNC_LOADER_BASENAME,
   QUICKJS_WASM_METADATA_BASENAME,
 };
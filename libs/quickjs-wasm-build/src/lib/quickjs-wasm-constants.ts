@@ -1,15 +1,69 @@
 export type QuickjsWasmVariant = 'wasm32' | 'wasm64';
-export type QuickjsWasmBuildType = 'release' | 'debug';
+/**
+ * `async` is the opt-in Asyncify build whose `host_call` may return a Promise.
+ * `optimized` is `release` with `-O3 -flto`, a pinned `wasm-opt` pass and
+ * optional profile guidance (see `wasmOpt` and `pgo`); results are identical.
+ * `calibration` is an out-of-band build that also measures wall-clock time
+ * (see `outOfBand`); it computes the same gas but must never serve consensus.
+ */
+export type QuickjsWasmBuildType =
+  | 'release'
+  | 'debug'
+  | 'async'
+  | 'optimized'
+  | 'calibration';
+/**
+ * Fixed linear-memory size of a build. Smaller profiles fit more VMs per host
+ * but fail allocations sooner; `32mib` is the default and unsuffixed build.
+ */
+export type QuickjsWasmMemoryProfile = '4mib' | '8mib' | '16mib' | '32mib';
+
+export const QUICKJS_WASM_DEFAULT_MEMORY_PROFILE: QuickjsWasmMemoryProfile =
+  '32mib';
+
+/**
+ * Inserts the `-<profile>` suffix the build gives non-default profiles, e.g.
+ * `quickjs-eval-debug.wasm` becomes `quickjs-eval-debug-8mib.wasm`.
+ */
+export function memoryProfileFilename(
+  filename: string,
+  memoryProfile: QuickjsWasmMemoryProfile,
+): string {
+  if (memoryProfile === QUICKJS_WASM_DEFAULT_MEMORY_PROFILE) {
+    return filename;
+  }
+  return filename.replace(/(\.[a-z]+)$/, `-${memoryProfile}$1`);
+}
 
 export const QUICKJS_WASM_BASENAME = 'quickjs-eval.wasm';
 export const QUICKJS_WASM_LOADER_BASENAME = 'quickjs-eval.js';
 export const QUICKJS_WASM_DEBUG_BASENAME = 'quickjs-eval-debug.wasm';
 export const QUICKJS_WASM_DEBUG_LOADER_BASENAME = 'quickjs-eval-debug.js';
+export const QUICKJS_WASM_ASYNC_BASENAME = 'quickjs-eval-async.wasm';
+export const QUICKJS_WASM_ASYNC_LOADER_BASENAME = 'quickjs-eval-async.js';
+export const QUICKJS_WASM_OPTIMIZED_BASENAME = 'quickjs-eval-optimized.wasm';
+export const QUICKJS_WASM_OPTIMIZED_LOADER_BASENAME =
+  'quickjs-eval-optimized.js';
+export const QUICKJS_WASM_CALIBRATION_BASENAME =
+  'quickjs-eval-calibration.wasm';
+export const QUICKJS_WASM_CALIBRATION_LOADER_BASENAME =
+  'quickjs-eval-calibration.js';
 export const QUICKJS_WASM64_BASENAME = 'quickjs-eval-wasm64.wasm';
 export const QUICKJS_WASM64_LOADER_BASENAME = 'quickjs-eval-wasm64.js';
 export const QUICKJS_WASM64_DEBUG_BASENAME = 'quickjs-eval-wasm64-debug.wasm';
 export const QUICKJS_WASM64_DEBUG_LOADER_BASENAME =
   'quickjs-eval-wasm64-debug.js';
+export const QUICKJS_WASM64_ASYNC_BASENAME = 'quickjs-eval-wasm64-async.wasm';
+export const QUICKJS_WASM64_ASYNC_LOADER_BASENAME =
+  'quickjs-eval-wasm64-async.js';
+export const QUICKJS_WASM64_OPTIMIZED_BASENAME =
+  'quickjs-eval-wasm64-optimized.wasm';
+export const QUICKJS_WASM64_OPTIMIZED_LOADER_BASENAME =
+  'quickjs-eval-wasm64-optimized.js';
+export const QUICKJS_WASM64_CALIBRATION_BASENAME =
+  'quickjs-eval-wasm64-calibration.wasm';
+export const QUICKJS_WASM64_CALIBRATION_LOADER_BASENAME =
+  'quickjs-eval-wasm64-calibration.js';
 export const QUICKJS_WASM_METADATA_BASENAME =
   'quickjs-wasm-build.metadata.json';
 
@@ -26,8 +80,38 @@ export interface QuickjsWasmBuildVariantMetadata {
   variantFlags?: string[];
   buildType: QuickjsWasmBuildType;
   buildFlags?: string[];
+  /** Absent in metadata written before memory profiles existed. */
+  memoryProfile?: QuickjsWasmMemoryProfile;
+  memory?: QuickjsWasmMemoryConfig;
+  /**
+   * Set on builds that read clocks or otherwise break determinism
+   * (`calibration`). Their results are for measurement only.
+   */
+  outOfBand?: boolean;
+  /** Post-link binaryen pass of the `optimized` build. */
+  wasmOpt?: QuickjsWasmOptConfig;
+  /** Profile the `optimized` build was compiled with, or null without one. */
+  pgo?: QuickjsWasmPgoConfig | null;
+}
+
+export interface QuickjsWasmOptConfig {
+  /** `wasm-opt --version` of the emsdk's binaryen. */
+  version: string | null;
+  passes: string[];
 }
 
+export interface QuickjsWasmPgoConfig {
+  filename: string;
+  sha256: string;
+}
+
+export type QuickjsWasmVariantsMetadata = Partial<
+  Record<
+    QuickjsWasmVariant,
+    Partial<Record<QuickjsWasmBuildType, QuickjsWasmBuildVariantMetadata>>
+  >
+>;
+
 export interface QuickjsWasmMemoryConfig {
   initial: number | null;
   maximum: number | null;
@@ -51,10 +135,10 @@ export interface QuickjsWasmBuildMetadata {
   emscriptenVersion: string;
   engineBuildHash: string | null;
   build: QuickjsWasmBuildConfig;
-  variants: Partial<
-    Record<
-      QuickjsWasmVariant,
-      Partial<Record<QuickjsWasmBuildType, QuickjsWasmBuildVariantMetadata>>
-    >
+  /** Artifacts of the default `32mib` profile. */
+  variants: QuickjsWasmVariantsMetadata;
+  /** Artifacts of the other profiles, present only when they were built. */
+  memoryProfiles?: Partial<
+    Record<QuickjsWasmMemoryProfile, QuickjsWasmVariantsMetadata>
   >;
 }
@@ -1,37 +1,949 @@
 #include "quickjs.h"
 #include "quickjs-host.h"
+#ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
+#include <emscripten/heap.h>
+#else
+#include "quickjs_det_native.h"
+#include <sys/mman.h>
+#ifndef QUICKJS_DET_NATIVE_ALLOC_H
+#error "compile with -include quickjs_det_native_alloc.h (see libs/quickjs-native)"
+#endif
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+#endif
 #include <inttypes.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef QJS_DET_CALIBRATION
+#include <time.h>
+#endif
+#include <unistd.h>
+
+/* The same shim backs the native Node addon (libs/quickjs-native). There the
+   host imports are plain functions supplied by the addon glue, and every
+   pointer crossing the ABI is a 32-bit offset into the instance's region (see
+   DET_PTR32), so embedders see the wasm32 ABI either way. */
+#ifdef __EMSCRIPTEN__
+#define DET_HOST_IMPORT(name) __attribute__((import_module("host"), import_name(name)))
+#else
+#define DET_HOST_IMPORT(name)
+#endif
 
 /* The wasm module imports a single host_call symbol provided by the embedder.
    Keep the signature aligned with docs/host-call-abi.md (all uint32 params). */
-__attribute__((import_module("host"), import_name("host_call")))
+DET_HOST_IMPORT("host_call")
 extern uint32_t host_call(uint32_t fn_id,
                           uint32_t req_ptr,
                           uint32_t req_len,
                           uint32_t resp_ptr,
                           uint32_t resp_capacity);
 
-static JSRuntime *det_rt = NULL;
-static JSContext *det_ctx = NULL;
-static uint64_t det_gas_limit = JS_GAS_UNLIMITED;
+/* Receives streamed tape records (qjs_det_stream_tape): count packed
+   DetTapeRecordBin structs at records_ptr, valid only for the duration of the
+   call. The embedder must not call back into the instance from it. */
+DET_HOST_IMPORT("tape_sink")
+extern void tape_sink(uint32_t handle, uint32_t records_ptr, uint32_t count);
+
+/* Binary result channel written by qjs_det_eval_bin. Fixed little-endian
+   layout shared by every variant (offsets in bytes):
+     0  uint32 status         0 = RESULT, 1 = ERROR
+     4  uint32 payload_len
+     8  uint64 gas_remaining
+    16  uint64 gas_used
+    24  uint32 payload_ptr    DV bytes (RESULT) or UTF-8 message (ERROR)
+    28  uint32 reserved
+   The struct and payload stay owned by the VM instance until its next eval or
+   qjs_det_free, so the embedder can read them in place. */
+typedef struct DetEvalResult {
+  uint32_t status;
+  uint32_t payload_len;
+  uint64_t gas_remaining;
+  uint64_t gas_used;
+  uint32_t payload_ptr;
+  uint32_t reserved;
+} DetEvalResult;
+
+_Static_assert(sizeof(DetEvalResult) == 32, "DetEvalResult layout is part of the ABI");
+
+enum {
+  DET_EVAL_STATUS_RESULT = 0,
+  DET_EVAL_STATUS_ERROR = 1,
+};
+
+/* Binary tape readout written by qjs_det_read_tape_bin: one record per host
+   call, in tape order, each a fixed little-endian struct:
+     0  uint32 fn_id
+     4  uint32 req_len
+     8  uint32 resp_len
+    12  uint32 units
+    16  uint64 gas_pre
+    24  uint64 gas_post
+    32  uint32 flags          bit 0 = is_error, bit 1 = charge_failed
+    36  uint32 reserved
+    40  uint8  req_hash[32]   SHA-256 of the request bytes
+    72  uint8  resp_hash[32]  SHA-256 of the response bytes */
+typedef struct {
+  uint32_t fn_id;
+  uint32_t req_len;
+  uint32_t resp_len;
+  uint32_t units;
+  uint64_t gas_pre;
+  uint64_t gas_post;
+  uint32_t flags;
+  uint32_t reserved;
+  uint8_t req_hash[32];
+  uint8_t resp_hash[32];
+} DetTapeRecordBin;
+
+_Static_assert(sizeof(DetTapeRecordBin) == 104, "DetTapeRecordBin layout is part of the ABI");
+
+/* Ring capacity used while streaming. Each host call appends at most one
+   record and the ring is drained before the next one, so this only needs
+   headroom, not run length. */
+#define DET_TAPE_STREAM_RING 8u
+
+enum {
+  DET_TAPE_FLAG_IS_ERROR = 1u << 0,
+  DET_TAPE_FLAG_CHARGE_FAILED = 1u << 1,
+};
+
+/* Binary gas trace written by qjs_det_read_trace_bin: the JSGasTrace counters
+   as nine little-endian uint64 values, in this order. */
+typedef struct {
+  uint64_t opcode_count;
+  uint64_t opcode_gas;
+  uint64_t array_cb_base_count;
+  uint64_t array_cb_base_gas;
+  uint64_t array_cb_per_element_count;
+  uint64_t array_cb_per_element_gas;
+  uint64_t allocation_count;
+  uint64_t allocation_bytes;
+  uint64_t allocation_gas;
+} DetGasTraceBin;
+
+_Static_assert(sizeof(DetGasTraceBin) == 72, "DetGasTraceBin layout is part of the ABI");
+
+/* qjs_det_enable_trace mode bits. Any nonzero mode records the aggregate gas
+   trace; DET_TRACE_HOST_GAS additionally records host-call gas per fn_id. */
+enum {
+  DET_TRACE_COUNTERS = 1u << 0,
+  DET_TRACE_HOST_GAS = 1u << 1,
+};
+
+/* Host-call gas breakdown written by qjs_det_read_host_gas_bin, all
+   little-endian:
+     0  uint32 magic          "QJHG"
+     4  uint32 version        DET_HOST_GAS_VERSION
+     8  uint32 flags          DET_HOST_GAS_*
+    12  uint32 host_count
+   followed by host_count DetHostGasBin, filled by the shim from the host
+   tape. This is not an interpreter profiler: the pinned engine keeps no
+   per-opcode or per-pc counters, so interpreter gas is only available in
+   aggregate, through the gas trace. */
+#define DET_HOST_GAS_MAGIC 0x47484a51u
+#define DET_HOST_GAS_VERSION 1u
+#define DET_HOST_GAS_MAX_FNS 64u
+
+enum {
+  /* More distinct fn_ids than DET_HOST_GAS_MAX_FNS; later ones are
+     dropped. */
+  DET_HOST_GAS_TRUNCATED = 1u << 0,
+};
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t flags;
+  uint32_t host_count;
+} DetHostGasHeaderBin;
+
+/* Host-call gas per fn_id: gas_pre plus gas_post of every tape record (only
+   gas_pre when the post-charge failed). */
+typedef struct {
+  uint32_t fn_id;
+  uint32_t calls;
+  uint32_t errors;
+  uint32_t charge_failed;
+  uint64_t req_bytes;
+  uint64_t resp_bytes;
+  uint64_t units;
+  uint64_t gas;
+} DetHostGasBin;
+
+_Static_assert(sizeof(DetHostGasHeaderBin) == 16, "DetHostGasHeaderBin layout is part of the ABI");
+_Static_assert(sizeof(DetHostGasBin) == 48, "DetHostGasBin layout is part of the ABI");
+
+/* Wall-clock counters of the out-of-band `calibration` build type
+   (QJS_DET_CALIBRATION), read by qjs_det_read_calibration_bin as six
+   little-endian uint64 values in this order. eval_ns spans each eval export
+   from its opening GC checkpoint to the encoded result, so it includes
+   host_ns (time inside the host_call import; memo hits excluded) and gc_ns.
+   Times come from CLOCK_MONOTONIC; they never feed back into gas, and
+   consensus builds compile none of this. */
+typedef struct {
+  uint64_t evals;
+  uint64_t eval_ns;
+  uint64_t host_calls;
+  uint64_t host_ns;
+  uint64_t gc_checkpoints;
+  uint64_t gc_ns;
+} DetCalibrationBin;
+
+_Static_assert(sizeof(DetCalibrationBin) == 48, "DetCalibrationBin layout is part of the ABI");
+
+/* Allocated by qjs_det_enable_trace only while host gas is recorded, so a VM
+   that does not record it pays one NULL check per host call. */
+typedef struct {
+  uint32_t flags;
+  uint32_t host_count;
+  DetHostGasBin hosts[DET_HOST_GAS_MAX_FNS];
+} DetHostGas;
+
+/* Per-evaluation replay cache for host functions the embedder marked pure
+   (qjs_det_memoize_host_fn). An identical request (same fn_id and request
+   bytes) is answered from here instead of crossing into the embedder. The VM
+   still sees the same response bytes, so gas charging and the tape are
+   unchanged. Entries are dropped at the start of every evaluation; once the
+   table or byte budget is full, new responses are simply not stored. */
+#define DET_MEMO_MAX_FNS 16u
+#define DET_MEMO_MAX_ENTRIES 64u
+#define DET_MEMO_MAX_BYTES (1u << 20)
+
+typedef struct {
+  uint32_t fn_id;
+  uint32_t hash;
+  uint32_t req_len;
+  uint32_t resp_len;
+  uint8_t *bytes; /* request bytes followed by response bytes */
+} DetMemoEntry;
+
+typedef struct {
+  uint32_t fn_ids[DET_MEMO_MAX_FNS];
+  uint32_t fn_count;
+  DetMemoEntry entries[DET_MEMO_MAX_ENTRIES];
+  uint32_t entry_count;
+  uint32_t bytes_used;
+} DetMemo;
+
+/* Optional per-VM arena (qjs_det_use_arena). While an export runs on behalf
+   of an arena VM, every malloc made by QuickJS or by the shim is carved from
+   that VM's 64 KiB chunks: size-classed free lists first, then a bump
+   pointer, with requests above DET_ARENA_SMALL_MAX in dedicated spans.
+   qjs_det_free then hands the chunks back instead of walking the heap object
+   by object. Gas is charged by the engine on requested sizes, so the schedule
+   does not depend on the allocator. A page map records which arena owns each
+   chunk, so free() and realloc() find the right arena from the pointer,
+   whatever export is running. */
+#ifndef QJS_DET_MEMORY_BYTES
+#define QJS_DET_MEMORY_BYTES (32u << 20) /* INITIAL_MEMORY in build-wasm.sh */
+#endif
+#define DET_ARENA_CHUNK_SHIFT 16u
+#define DET_ARENA_CHUNK_SIZE (1u << DET_ARENA_CHUNK_SHIFT)
+#define DET_ARENA_PAGES (QJS_DET_MEMORY_BYTES >> DET_ARENA_CHUNK_SHIFT)
+#define DET_ARENA_ALIGN (2u * sizeof(void *))
+#define DET_ARENA_SMALL_MAX 16384u
+/* 16-byte steps up to 512, then four classes per power of two. */
+#define DET_ARENA_CLASSES 52u
+#define DET_ARENA_LARGE UINT32_MAX
+
+typedef struct DetArenaSpan {
+  struct DetArenaSpan *next;
+  struct DetArenaSpan *prev;
+  uint32_t pages;
+} DetArenaSpan;
+
+/* Precedes every arena block; padded to DET_ARENA_ALIGN. */
+typedef struct {
+  uint32_t cls;  /* size class, or DET_ARENA_LARGE for a dedicated span */
+  uint32_t size; /* usable bytes */
+} DetArenaBlock;
+
+#define DET_ARENA_SPAN_HEADER \
+  ((sizeof(DetArenaSpan) + DET_ARENA_ALIGN - 1) & ~(DET_ARENA_ALIGN - 1))
+#define DET_ARENA_HEADER \
+  ((sizeof(DetArenaBlock) + DET_ARENA_ALIGN - 1) & ~(DET_ARENA_ALIGN - 1))
+
+typedef struct {
+  uint16_t owner; /* instance slot + 1; 0 when the VM uses the system heap */
+  DetArenaSpan *chunks;
+  DetArenaSpan *large;
+  uint8_t *bump;
+  uint8_t *bump_end;
+  void *free_lists[DET_ARENA_CLASSES];
+} DetArena;
+
+/* One deterministic VM. Every export takes the opaque handle returned by
+   qjs_det_init, so several small VMs can share one linear memory and one
+   compiled module. Result buffers are per instance: a payload stays valid
+   until the next eval on the same handle or its qjs_det_free. */
+typedef struct {
+  uint32_t handle;
+  JSRuntime *rt;
+  JSContext *ctx;
+  uint64_t gas_limit;
+  /* Set once user code has run; snapshots must capture a fresh init only. */
+  int evaluated;
+  DetEvalResult eval_result;
+  JSDvBuffer eval_dv;
+  char *eval_error;
+  uint8_t *compiled;
+  DetMemo memo;
+  /* Streaming tape (qjs_det_stream_tape): the ring is drained through the
+     tape_sink import at every host-call boundary, so it never wraps and a
+     small fixed ring covers runs of any length. */
+  int tape_stream;
+  JSHostTapeRecord tape_stream_records[DET_TAPE_STREAM_RING];
+  DetTapeRecordBin tape_stream_out[DET_TAPE_STREAM_RING];
+  /* Ring tape enabled through qjs_det_enable_tape; profiling drains the
+     tape, so the two cannot be combined. */
+  int tape_ring;
+  DetHostGas *host_gas;
+#ifdef QJS_DET_CALIBRATION
+  DetCalibrationBin calibration;
+#endif
+  DetArena arena;
+} DetInstance;
+
+/* Handles are (generation << 8) | slot, so a freed slot's old handle never
+   resolves to the VM that reuses it. 0 is never a valid handle. */
+#define DET_MAX_INSTANCES 256u
+#define DET_HANDLE_SLOT_BITS 8u
+/* Page-map owner of the native system heap (see det_heap_malloc). */
+#define DET_SYSTEM_OWNER (DET_MAX_INSTANCES + 1u)
+
+static const char DET_OOM_MESSAGE[] = "InternalError: out of memory";
+static const char DET_INVALID_HANDLE[] = "<invalid handle>";
+
+/* Everything the shim keeps between calls. The wasm build has one state in
+   linear memory; the native build places one at the start of each region and
+   points det_state at it for the duration of every call. */
+typedef struct DetState {
+  DetInstance *instances[DET_MAX_INSTANCES];
+  uint32_t live_instances;
+  uint32_t generation;
+  char *init_error;
+  /* Error struct for calls with an unknown handle; there is no instance to own
+     it. Result payloads are read through the heap, so the fixed messages they
+     point at are copied here rather than referenced in rodata. */
+  DetEvalResult invalid_result;
+  char invalid_handle[sizeof(DET_INVALID_HANDLE)];
+  char oom_message[sizeof(DET_OOM_MESSAGE)];
+  int use_arena;
+  /* Set by the allocator entry points when a request cannot be met; cleared
+     before each init and evaluation. Any failure reported after it is set is
+     reported as DET_OOM_MESSAGE, whatever exception the engine managed to
+     build (or catch and rethrow) with the memory that was left. */
+  int out_of_memory;
+  DetArena *arena_active;
+  uint16_t arena_owner[DET_ARENA_PAGES];
+  /* Input staging shared by every VM. The embedder installs the manifest once
+     (qjs_det_set_manifest) and writes each init's hash and context blob into
+     the persistent input arena (qjs_det_input_buffer), so an init does no
+     malloc/free round-trips of its own. Both are only read during
+     qjs_det_init. */
+  uint8_t *input_arena;
+  uint32_t input_capacity;
+  uint8_t *manifest;
+  uint32_t manifest_size;
+#ifndef __EMSCRIPTEN__
+  DetArena system_arena;
+#endif
+} DetState;
+
+#ifdef __EMSCRIPTEN__
+static DetState det_state_storage;
+static DetState *const det_state = &det_state_storage;
+/* Offset of p in the heap the embedder sees: its linear-memory address. */
+#define DET_ADDR(p) ((uintptr_t)(p))
+#else
+/* Per thread, so addon instances on different worker threads never meet. */
+static _Thread_local DetState *det_state;
+#define DET_ADDR(p) ((uintptr_t)(p) - (uintptr_t)det_state)
+#endif
+/* Pointer as passed across the ABI (host imports, result structs). */
+#define DET_PTR32(p) ((p) ? (uint32_t)DET_ADDR(p) : 0u)
+
+static DetArena *arena_owner(const void *ptr) {
+  uintptr_t addr = DET_ADDR(ptr);
+  if (addr >= QJS_DET_MEMORY_BYTES) {
+    return NULL;
+  }
+  uint16_t owner = det_state->arena_owner[addr >> DET_ARENA_CHUNK_SHIFT];
+  if (!owner) {
+    return NULL;
+  }
+#ifndef __EMSCRIPTEN__
+  if (owner == DET_SYSTEM_OWNER) {
+    return &det_state->system_arena;
+  }
+#endif
+  return &det_state->instances[owner - 1]->arena;
+}
+
+#ifdef __EMSCRIPTEN__
+#define det_heap_malloc emscripten_builtin_malloc
+#define det_heap_calloc emscripten_builtin_calloc
+#define det_heap_realloc emscripten_builtin_realloc
+#define det_heap_memalign emscripten_builtin_memalign
+#define det_heap_free emscripten_builtin_free
+#else
+/* The native region has no allocator underneath: spans are runs of pages that
+   are free in the page map, and the system heap is one more arena, owned by
+   DET_SYSTEM_OWNER. Pointers outside the region were allocated by libc and
+   go back to it. */
+static void *arena_alloc(DetArena *arena, size_t size);
+
+static void *det_heap_memalign(size_t alignment, size_t size) {
+  uint32_t pages = (uint32_t)(size >> DET_ARENA_CHUNK_SHIFT);
+  uint32_t run = 0;
+  (void)alignment; /* every page is chunk-aligned within the region */
+  for (uint32_t page = 0; page < DET_ARENA_PAGES; page++) {
+    run = det_state->arena_owner[page] ? 0 : run + 1;
+    if (run == pages) {
+      return (uint8_t *)det_state + ((size_t)(page + 1 - pages) << DET_ARENA_CHUNK_SHIFT);
+    }
+  }
+  return NULL;
+}
+
+static void det_heap_free(void *ptr) {
+  /* Region pages are released by clearing their page-map entries. */
+  if (DET_ADDR(ptr) >= QJS_DET_MEMORY_BYTES) {
+    det_libc_free(ptr);
+  }
+}
+
+static void *det_heap_malloc(size_t size) {
+  return arena_alloc(&det_state->system_arena, size);
+}
+
+static void *det_heap_calloc(size_t count, size_t size) {
+  if (size && count > SIZE_MAX / size) {
+    return NULL;
+  }
+  void *ptr = det_heap_malloc(count * size);
+  if (ptr) {
+    memset(ptr, 0, count * size);
+  }
+  return ptr;
+}
+
+static void *det_heap_realloc(void *ptr, size_t size) { return det_libc_realloc(ptr, size); }
+#endif
+
+static uint32_t arena_class(size_t size, uint32_t *class_size) {
+  if (size <= 512) {
+    uint32_t cls = size ? (uint32_t)(size + 15) / 16 - 1 : 0;
+    *class_size = (cls + 1) * 16;
+    return cls;
+  }
+  /* size is in (2^shift, 2^(shift+1)]; round up to a quarter of 2^shift. */
+  uint32_t shift = 31u - (uint32_t)__builtin_clz((uint32_t)size - 1);
+  uint32_t step = 1u << (shift - 2);
+  uint32_t rounded = ((uint32_t)size + step - 1) & ~(step - 1);
+  *class_size = rounded;
+  return 32u + (shift - 9) * 4 + (rounded >> (shift - 2)) - 5;
+}
+
+static DetArenaSpan *arena_span(DetArena *arena, size_t bytes) {
+  if (bytes > QJS_DET_MEMORY_BYTES) {
+    return NULL;
+  }
+  size_t size = (bytes + DET_ARENA_CHUNK_SIZE - 1) & ~(size_t)(DET_ARENA_CHUNK_SIZE - 1);
+  DetArenaSpan *span = det_heap_memalign(DET_ARENA_CHUNK_SIZE, size);
+  if (!span) {
+    return NULL;
+  }
+  uintptr_t first = DET_ADDR(span) >> DET_ARENA_CHUNK_SHIFT;
+  span->pages = (uint32_t)(size >> DET_ARENA_CHUNK_SHIFT);
+  if (first + span->pages > DET_ARENA_PAGES) {
+    det_heap_free(span);
+    return NULL;
+  }
+  for (uint32_t i = 0; i < span->pages; i++) {
+    det_state->arena_owner[first + i] = arena->owner;
+  }
+  return span;
+}
+
+static void arena_release_span(DetArenaSpan *span) {
+  uintptr_t first = DET_ADDR(span) >> DET_ARENA_CHUNK_SHIFT;
+  for (uint32_t i = 0; i < span->pages; i++) {
+    det_state->arena_owner[first + i] = 0;
+  }
+  det_heap_free(span);
+}
+
+static void *arena_alloc(DetArena *arena, size_t size) {
+  DetArenaBlock *block;
+  if (size > DET_ARENA_SMALL_MAX) {
+    DetArenaSpan *span = arena_span(arena, DET_ARENA_SPAN_HEADER + DET_ARENA_HEADER + size);
+    if (!span) {
+      return NULL;
+    }
+    span->prev = NULL;
+    span->next = arena->large;
+    if (arena->large) {
+      arena->large->prev = span;
+    }
+    arena->large = span;
+    block = (DetArenaBlock *)((uint8_t *)span + DET_ARENA_SPAN_HEADER);
+    block->cls = DET_ARENA_LARGE;
+    block->size = (uint32_t)size;
+    return (uint8_t *)block + DET_ARENA_HEADER;
+  }
+
+  uint32_t class_size;
+  uint32_t cls = arena_class(size, &class_size);
+  void *head = arena->free_lists[cls];
+  if (head) {
+    arena->free_lists[cls] = *(void **)head;
+    return head;
+  }
+
+  size_t need = DET_ARENA_HEADER + class_size;
+  if ((size_t)(arena->bump_end - arena->bump) < need) {
+    DetArenaSpan *chunk = arena_span(arena, DET_ARENA_CHUNK_SIZE);
+    if (!chunk) {
+      return NULL;
+    }
+    chunk->prev = NULL;
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+    arena->bump = (uint8_t *)chunk + DET_ARENA_SPAN_HEADER;
+    arena->bump_end = (uint8_t *)chunk + DET_ARENA_CHUNK_SIZE;
+  }
+  block = (DetArenaBlock *)arena->bump;
+  arena->bump += need;
+  block->cls = cls;
+  block->size = class_size;
+  return (uint8_t *)block + DET_ARENA_HEADER;
+}
+
+static void arena_free(DetArena *arena, void *ptr) {
+  DetArenaBlock *block = (DetArenaBlock *)((uint8_t *)ptr - DET_ARENA_HEADER);
+  if (block->cls == DET_ARENA_LARGE) {
+    DetArenaSpan *span = (DetArenaSpan *)((uint8_t *)block - DET_ARENA_SPAN_HEADER);
+    if (span->prev) {
+      span->prev->next = span->next;
+    } else {
+      arena->large = span->next;
+    }
+    if (span->next) {
+      span->next->prev = span->prev;
+    }
+    arena_release_span(span);
+    return;
+  }
+  *(void **)ptr = arena->free_lists[block->cls];
+  arena->free_lists[block->cls] = ptr;
+}
+
+/* Drop everything the VM allocated: one release per chunk or large span. */
+static void arena_reset(DetArena *arena) {
+  DetArenaSpan *lists[2] = {arena->chunks, arena->large};
+  for (int i = 0; i < 2; i++) {
+    for (DetArenaSpan *span = lists[i]; span;) {
+      DetArenaSpan *next = span->next;
+      arena_release_span(span);
+      span = next;
+    }
+  }
+  memset(arena, 0, sizeof(*arena));
+}
+
+static void *note_alloc(void *ptr, size_t size) {
+  if (!ptr && size) {
+    det_state->out_of_memory = 1;
+  }
+  return ptr;
+}
+
+/* The system allocator entry points are weak in Emscripten's dlmalloc; these
+   route to the active arena and fall back to the builtin allocator. The native
+   build compiles every source with quickjs_det_native_alloc.h, which renames
+   them so that the rest of the addon process keeps its libc allocator. */
+void *malloc(size_t size) {
+  if (det_state->arena_active) {
+    return note_alloc(arena_alloc(det_state->arena_active, size), size);
+  }
+  return note_alloc(det_heap_malloc(size), size);
+}
+
+void free(void *ptr) {
+  if (!ptr) {
+    return;
+  }
+  DetArena *arena = arena_owner(ptr);
+  if (arena) {
+    arena_free(arena, ptr);
+  } else {
+    det_heap_free(ptr);
+  }
+}
+
+void *calloc(size_t count, size_t size) {
+  if (!det_state->arena_active) {
+    return note_alloc(det_heap_calloc(count, size), count * size);
+  }
+  if (size && count > SIZE_MAX / size) {
+    return note_alloc(NULL, 1);
+  }
+  void *ptr = note_alloc(arena_alloc(det_state->arena_active, count * size), count * size);
+  if (ptr) {
+    memset(ptr, 0, count * size);
+  }
+  return ptr;
+}
+
+void *realloc(void *ptr, size_t size) {
+  if (!ptr) {
+    return malloc(size);
+  }
+  DetArena *arena = arena_owner(ptr);
+  if (!arena) {
+    return note_alloc(det_heap_realloc(ptr, size), size);
+  }
+  if (size == 0) {
+    arena_free(arena, ptr);
+    return NULL;
+  }
+  const DetArenaBlock *block = (const DetArenaBlock *)((uint8_t *)ptr - DET_ARENA_HEADER);
+  if (size <= block->size) {
+    return ptr;
+  }
+  void *next = note_alloc(arena_alloc(arena, size), size);
+  if (!next) {
+    return NULL;
+  }
+  memcpy(next, ptr, block->size);
+  arena_free(arena, ptr);
+  return next;
+}
+
+#ifndef __EMSCRIPTEN__
+/* QuickJS asks the allocator for usable sizes on Linux. */
+size_t malloc_usable_size(void *ptr) {
+  DetArena *arena = ptr ? arena_owner(ptr) : NULL;
+  if (!arena) {
+    return ptr ? det_libc_usable_size(ptr) : 0;
+  }
+  return ((const DetArenaBlock *)((uint8_t *)ptr - DET_ARENA_HEADER))->size;
+}
+#endif
+
+/* Opened at the top of every export that calls into the engine for a VM, so
+   allocations land in that VM's arena until the export returns. */
+static DetArena *arena_enter(DetInstance *det) {
+  DetArena *prev = det_state->arena_active;
+  det_state->arena_active = det && det->arena.owner ? &det->arena : NULL;
+  return prev;
+}
+
+static void arena_exit(DetArena **prev) { det_state->arena_active = *prev; }
+
+#define DET_ARENA_SCOPE(det) \
+  DetArena *det_arena_scope_ __attribute__((cleanup(arena_exit))) = arena_enter(det)
+
+/* Strings handed to the embedder may outlive the VM that produced them, so
+   they are moved out of its arena. */
+static char *det_export_string(char *str) {
+  DetArena *arena = str ? arena_owner(str) : NULL;
+  if (!arena || arena->owner == DET_SYSTEM_OWNER) {
+    return str;
+  }
+  size_t len = strlen(str) + 1;
+  char *out = det_heap_malloc(len);
+  if (out) {
+    memcpy(out, str, len);
+  }
+  arena_free(arena, str);
+  return out;
+}
+
+/* Smallest input arena handed out by qjs_det_input_buffer. */
+#define DET_INPUT_ARENA_MIN 4096u
+
+/* Bytecode artifact emitted by qjs_det_compile: a 16-byte little-endian header
+   followed by the JS_WriteObject(JS_WRITE_OBJ_BYTECODE) body.
+     0  uint32 magic          "QJDB"
+     4  uint32 format         DET_BYTECODE_FORMAT_VERSION
+     8  uint32 gas_version    JS_GAS_VERSION_LATEST at compile time
+    12  uint32 body_len
+   The body itself is only meaningful to the engine build that wrote it; the
+   embedder pins that build (engine build hash) and the body hash.
+
+   Trust boundary: JS_ReadObject is not memory-safe on crafted input, and the
+   header checks below are not a validator. qjs_det_eval_bytecode must only be
+   given artifacts that qjs_det_compile wrote; the SDK enforces this by loading
+   only artifacts carrying a valid keyed MAC (HMAC-SHA256). Loading is
+   unmetered, so artifacts above DET_BYTECODE_MAX_BYTES (the SDK's
+   maxBytecodeBytes) are refused before the engine reads them. */
+#define DET_BYTECODE_MAGIC 0x42444a51u
+#define DET_BYTECODE_FORMAT_VERSION 1u
+#define DET_BYTECODE_HEADER_SIZE 16u
+#define DET_BYTECODE_MAX_BYTES (4u << 20)
+
+static void release_eval_result(DetInstance *det) {
+  if (det->eval_dv.data && det->ctx) {
+    JS_FreeDVBuffer(det->ctx, &det->eval_dv);
+  }
+  memset(&det->eval_dv, 0, sizeof(det->eval_dv));
+  free(det->eval_error);
+  det->eval_error = NULL;
+  free(det->compiled);
+  det->compiled = NULL;
+  memset(&det->eval_result, 0, sizeof(det->eval_result));
+  det_state->out_of_memory = 0;
+}
+
+static void memo_clear(DetMemo *memo) {
+  for (uint32_t i = 0; i < memo->entry_count; i++) {
+    free(memo->entries[i].bytes);
+  }
+  memset(memo->entries, 0, sizeof(memo->entries));
+  memo->entry_count = 0;
+  memo->bytes_used = 0;
+}
+
+static int memo_is_pure(const DetMemo *memo, uint32_t fn_id) {
+  for (uint32_t i = 0; i < memo->fn_count; i++) {
+    if (memo->fn_ids[i] == fn_id) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* FNV-1a over fn_id and the request bytes; entries are confirmed with memcmp. */
+static uint32_t memo_hash(uint32_t fn_id, const uint8_t *req, uint32_t req_len) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < 4; i++) {
+    hash = (hash ^ ((fn_id >> (i * 8)) & 0xffu)) * 16777619u;
+  }
+  for (uint32_t i = 0; i < req_len; i++) {
+    hash = (hash ^ req[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static const DetMemoEntry *memo_find(const DetMemo *memo, uint32_t fn_id, uint32_t hash,
+                                     const uint8_t *req, uint32_t req_len) {
+  for (uint32_t i = 0; i < memo->entry_count; i++) {
+    const DetMemoEntry *entry = &memo->entries[i];
+    if (entry->hash == hash && entry->fn_id == fn_id && entry->req_len == req_len &&
+        (req_len == 0 || memcmp(entry->bytes, req, req_len) == 0)) {
+      return entry;
+    }
+  }
+  return NULL;
+}
 
-static void free_det_runtime(void) {
-  if (det_ctx) {
-    JS_FreeContext(det_ctx);
-    det_ctx = NULL;
+static void memo_store(DetMemo *memo, uint32_t fn_id, uint32_t hash, const uint8_t *req,
+                       uint32_t req_len, const uint8_t *resp, uint32_t resp_len) {
+  uint64_t size = (uint64_t)req_len + resp_len;
+  if (memo->entry_count >= DET_MEMO_MAX_ENTRIES ||
+      memo->bytes_used + size > DET_MEMO_MAX_BYTES) {
+    return;
   }
-  if (det_rt) {
-    JS_FreeRuntime(det_rt);
-    det_rt = NULL;
+
+  uint8_t *bytes = malloc(size ? (size_t)size : 1);
+  if (!bytes) {
+    return;
+  }
+  if (req_len) {
+    memcpy(bytes, req, req_len);
+  }
+  if (resp_len) {
+    memcpy(bytes + req_len, resp, resp_len);
+  }
+
+  DetMemoEntry *entry = &memo->entries[memo->entry_count++];
+  entry->fn_id = fn_id;
+  entry->hash = hash;
+  entry->req_len = req_len;
+  entry->resp_len = resp_len;
+  entry->bytes = bytes;
+  memo->bytes_used += (uint32_t)size;
+}
+
+static DetInstance *det_lookup(uint32_t handle) {
+  DetInstance *det = det_state->instances[handle & (DET_MAX_INSTANCES - 1)];
+  if (!det || handle == 0 || det->handle != handle || !det->ctx || !det->rt) {
+    return NULL;
+  }
+  return det;
+}
+
+static DetInstance *alloc_instance(void) {
+  for (uint32_t slot = 0; slot < DET_MAX_INSTANCES; slot++) {
+    if (det_state->instances[slot]) {
+      continue;
+    }
+    DetInstance *det = calloc(1, sizeof(DetInstance));
+    if (!det) {
+      return NULL;
+    }
+    det_state->generation = (det_state->generation + 1) & (UINT32_MAX >> DET_HANDLE_SLOT_BITS);
+    if (det_state->generation == 0) {
+      det_state->generation = 1;
+    }
+    det->handle = (det_state->generation << DET_HANDLE_SLOT_BITS) | slot;
+    det->gas_limit = JS_GAS_UNLIMITED;
+    det_state->instances[slot] = det;
+    det_state->live_instances++;
+    return det;
+  }
+  return NULL;
+}
+
+static void free_instance(DetInstance *det) {
+  if (det->arena.owner) {
+    /* The runtime, context and per-VM shim buffers all live in the arena. */
+    if (det_state->arena_active == &det->arena) {
+      det_state->arena_active = NULL;
+    }
+    arena_reset(&det->arena);
+    det->ctx = NULL;
+    det->rt = NULL;
+  } else {
+    release_eval_result(det);
+    memo_clear(&det->memo);
+    free(det->host_gas);
+    det->host_gas = NULL;
+    if (det->ctx) {
+      JS_FreeContext(det->ctx);
+      det->ctx = NULL;
+    }
+    if (det->rt) {
+      JS_FreeRuntime(det->rt);
+      det->rt = NULL;
+    }
+  }
+  det_state->instances[det->handle & (DET_MAX_INSTANCES - 1)] = NULL;
+  det_state->live_instances--;
+  free(det);
+}
+
+static void pack_tape_record(const JSHostTapeRecord *record, uint8_t *out) {
+  DetTapeRecordBin bin = {0};
+  bin.fn_id = record->fn_id;
+  bin.req_len = record->req_len;
+  bin.resp_len = record->resp_len;
+  bin.units = record->units;
+  bin.gas_pre = record->gas_pre;
+  bin.gas_post = record->gas_post;
+  bin.flags = (record->is_error ? DET_TAPE_FLAG_IS_ERROR : 0) |
+              (record->charge_failed ? DET_TAPE_FLAG_CHARGE_FAILED : 0);
+  memcpy(bin.req_hash, record->req_hash, sizeof(bin.req_hash));
+  memcpy(bin.resp_hash, record->resp_hash, sizeof(bin.resp_hash));
+  memcpy(out, &bin, sizeof(bin));
+}
+
+static void host_gas_note(DetHostGas *table, const JSHostTapeRecord *record) {
+  DetHostGasBin *entry = NULL;
+  for (uint32_t i = 0; i < table->host_count; i++) {
+    if (table->hosts[i].fn_id == record->fn_id) {
+      entry = &table->hosts[i];
+      break;
+    }
+  }
+  if (!entry) {
+    if (table->host_count == DET_HOST_GAS_MAX_FNS) {
+      table->flags |= DET_HOST_GAS_TRUNCATED;
+      return;
+    }
+    entry = &table->hosts[table->host_count++];
+    entry->fn_id = record->fn_id;
+  }
+  entry->calls++;
+  entry->errors += record->is_error ? 1 : 0;
+  entry->charge_failed += record->charge_failed ? 1 : 0;
+  entry->req_bytes += record->req_len;
+  entry->resp_bytes += record->resp_len;
+  entry->units += record->units;
+  entry->gas += record->gas_pre + (record->charge_failed ? 0 : record->gas_post);
+}
+
+/* Empties the ring into the host-gas table and hands every record to
+   tape_sink when streaming. Records are appended only after a host call
+   completes (see docs/observability.md), so at a host-call boundary the ring
+   holds finished records only. Reading and resetting the tape does not touch
+   gas. */
+static void stream_tape(DetInstance *det) {
+  size_t count = 0;
+
+  if ((!det->tape_stream && !det->host_gas) || JS_GetHostTapeLength(det->ctx) == 0)
+    return;
+  if (JS_ReadHostTape(det->ctx, det->tape_stream_records, DET_TAPE_STREAM_RING, &count) != 0)
+    return;
+  JS_ResetHostTape(det->ctx);
+
+  if (det->host_gas) {
+    for (size_t i = 0; i < count; i++) {
+      host_gas_note(det->host_gas, &det->tape_stream_records[i]);
+    }
+  }
+  if (!det->tape_stream)
+    return;
+  for (size_t i = 0; i < count; i++) {
+    pack_tape_record(&det->tape_stream_records[i], (uint8_t *)&det->tape_stream_out[i]);
   }
-  det_gas_limit = JS_GAS_UNLIMITED;
+  if (count > 0)
+    tape_sink(det->handle, DET_PTR32(det->tape_stream_out), (uint32_t)count);
+}
+
+#ifdef QJS_DET_CALIBRATION
+static uint64_t calibration_now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void calibration_add(uint64_t *count, uint64_t *ns, uint64_t start) {
+  (*count)++;
+  *ns += calibration_now() - start;
 }
 
+#define DET_CALIBRATION_START() uint64_t det_calibration_start_ = calibration_now()
+#define DET_CALIBRATION_STOP(det, count, ns) \
+  calibration_add(&(det)->calibration.count, &(det)->calibration.ns, det_calibration_start_)
+#else
+#define DET_CALIBRATION_START() ((void)0)
+#define DET_CALIBRATION_STOP(det, count, ns) ((void)(det))
+#endif
+
+/* True when [ptr, ptr + len) lies in the heap the embedder reads. Always the
+   case for wasm memory; the native region is the only memory it can see. */
+static int det_addressable(const void *ptr, uint32_t len) {
+  return ptr ? DET_ADDR(ptr) + len <= QJS_DET_MEMORY_BYTES : len == 0;
+}
+
+static uint32_t call_host(DetInstance *det,
+                          uint32_t fn_id,
+                          const uint8_t *req_ptr,
+                          uint32_t req_len,
+                          uint8_t *resp_ptr,
+                          uint32_t resp_capacity) {
+  DET_CALIBRATION_START();
+  uint32_t written = host_call(fn_id,
+                               DET_PTR32(req_ptr),
+                               req_len,
+                               DET_PTR32(resp_ptr),
+                               resp_capacity);
+  if (det)
+    DET_CALIBRATION_STOP(det, host_calls, host_ns);
+  return written;
+}
+
+/* req_ptr and resp_ptr are allocated by the engine for this call and passed
+   through as they are; the shim allocates nothing here except the memo copy
+   of a pure response. The fork takes no caller-owned scratch region, so the
+   buffers cannot be replaced by one kept from qjs_det_init. */
 static uint32_t wasm_host_call(JSContext *ctx,
                                uint32_t fn_id,
                                const uint8_t *req_ptr,
@@ -39,18 +951,32 @@ static uint32_t wasm_host_call(JSContext *ctx,
                                uint8_t *resp_ptr,
                                uint32_t resp_capacity,
                                void *opaque) {
+  DetInstance *det = (DetInstance *)opaque;
   (void)ctx;
-  (void)opaque;
 
-  if (!req_ptr && req_len > 0) {
+  if (!det_addressable(req_ptr, req_len) || !det_addressable(resp_ptr, resp_capacity)) {
     return JS_HOST_CALL_TRANSPORT_ERROR;
   }
 
-  return host_call(fn_id,
-                   (uint32_t)(uintptr_t)req_ptr,
-                   req_len,
-                   (uint32_t)(uintptr_t)resp_ptr,
-                   resp_capacity);
+  if (det)
+    stream_tape(det);
+
+  if (!det || !memo_is_pure(&det->memo, fn_id)) {
+    return call_host(det, fn_id, req_ptr, req_len, resp_ptr, resp_capacity);
+  }
+
+  uint32_t hash = memo_hash(fn_id, req_ptr, req_len);
+  const DetMemoEntry *hit = memo_find(&det->memo, fn_id, hash, req_ptr, req_len);
+  if (hit && hit->resp_len <= resp_capacity) {
+    memcpy(resp_ptr, hit->bytes + hit->req_len, hit->resp_len);
+    return hit->resp_len;
+  }
+
+  uint32_t written = call_host(det, fn_id, req_ptr, req_len, resp_ptr, resp_capacity);
+  if (written != JS_HOST_CALL_TRANSPORT_ERROR && written <= resp_capacity) {
+    memo_store(&det->memo, fn_id, hash, req_ptr, req_len, resp_ptr, written);
+  }
+  return written;
 }
 
 static char *dup_printf(const char *fmt, ...) {
@@ -105,7 +1031,7 @@ static char *format_exception(JSContext *ctx, uint64_t gas_limit, const char *fa
   const char *msg = JS_ToCString(ctx, exception);
   uint64_t remaining = JS_GetGasRemaining(ctx);
 
-  const char *payload = msg ? msg : fallback;
+  const char *payload = det_state->out_of_memory ? DET_OOM_MESSAGE : msg ? msg : fallback;
   char *out = format_with_gas("ERROR", payload, gas_limit, remaining, trace);
 
   if (msg) {
@@ -115,7 +1041,180 @@ static char *format_exception(JSContext *ctx, uint64_t gas_limit, const char *fa
   return out;
 }
 
-static int run_gc_checkpoint(JSContext *ctx) { return JS_RunGCCheckpoint(ctx); }
+static int run_gc_checkpoint(DetInstance *det) {
+  DET_CALIBRATION_START();
+  int rc = JS_RunGCCheckpoint(det->ctx);
+  DET_CALIBRATION_STOP(det, gc_checkpoints, gc_ns);
+  return rc;
+}
+
+static char *take_exception_message(JSContext *ctx, const char *fallback) {
+  JSValue exception = JS_GetException(ctx);
+  const char *msg = JS_ToCString(ctx, exception);
+  char *out = dup_printf("%s", det_state->out_of_memory ? DET_OOM_MESSAGE : msg ? msg : fallback);
+
+  if (msg) {
+    JS_FreeCString(ctx, msg);
+  }
+  JS_FreeValue(ctx, exception);
+  return out;
+}
+
+/* Compilation and bytecode loading run with charging suspended so the metered
+   run starts from the same remaining gas; only execution is billed. */
+static uint64_t suspend_gas(DetInstance *det) {
+  uint64_t remaining = JS_GetGasRemaining(det->ctx);
+  JS_SetGasLimit(det->ctx, JS_GAS_UNLIMITED);
+  return remaining;
+}
+
+static void resume_gas(DetInstance *det, uint64_t remaining) {
+  JS_SetGasLimit(det->ctx, remaining);
+}
+
+/* Shared tail of every evaluation: takes ownership of result, encodes it as DV
+   and runs the post-eval checkpoint. On failure *error receives a malloc'd
+   message (the exception text or the fallback label) and dv holds nothing. */
+static int result_to_dv(DetInstance *det, JSValue result, JSDvBuffer *dv, char **error) {
+  if (JS_IsException(result)) {
+    JS_FreeValue(det->ctx, result);
+    *error = take_exception_message(det->ctx, "<exception>");
+    return -1;
+  }
+
+  if (JS_EncodeDV(det->ctx, result, &JS_DV_LIMIT_DEFAULTS, dv) != 0) {
+    JS_FreeValue(det->ctx, result);
+    *error = take_exception_message(det->ctx, "<dv encode>");
+    JS_FreeDVBuffer(det->ctx, dv);
+    return -1;
+  }
+
+  JS_FreeValue(det->ctx, result);
+
+  if (run_gc_checkpoint(det) != 0) {
+    JS_FreeDVBuffer(det->ctx, dv);
+    *error = take_exception_message(det->ctx, "<gc checkpoint>");
+    return -1;
+  }
+
+  return 0;
+}
+
+/* Evaluation core shared by the text and binary channels so both charge the
+   same gas. */
+static int eval_to_dv(DetInstance *det, const char *code, size_t code_len, JSDvBuffer *dv,
+                      char **error) {
+  *error = NULL;
+  det->evaluated = 1;
+  memo_clear(&det->memo);
+
+  if (run_gc_checkpoint(det) != 0) {
+    *error = take_exception_message(det->ctx, "<gc checkpoint>");
+    return -1;
+  }
+
+  JSValue result = JS_Eval(det->ctx, code, code_len, "<eval>", JS_EVAL_TYPE_GLOBAL);
+  return result_to_dv(det, result, dv, error);
+}
+
+static uint32_t read_u32le(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+static void write_u32le(uint8_t *p, uint32_t value) {
+  p[0] = (uint8_t)value;
+  p[1] = (uint8_t)(value >> 8);
+  p[2] = (uint8_t)(value >> 16);
+  p[3] = (uint8_t)(value >> 24);
+}
+
+/* Bytecode counterpart of eval_to_dv: the artifact is loaded unmetered, then
+   executed under the same checkpoints as source evaluation. */
+static int eval_bytecode_to_dv(DetInstance *det, const uint8_t *artifact, size_t artifact_len,
+                               JSDvBuffer *dv, char **error) {
+  *error = NULL;
+
+  if (!artifact || artifact_len < DET_BYTECODE_HEADER_SIZE ||
+      read_u32le(artifact) != DET_BYTECODE_MAGIC) {
+    *error = dup_printf("<bytecode header>");
+    return -1;
+  }
+  if (artifact_len > DET_BYTECODE_MAX_BYTES) {
+    *error = dup_printf("<bytecode size>");
+    return -1;
+  }
+  if (read_u32le(artifact + 4) != DET_BYTECODE_FORMAT_VERSION) {
+    *error = dup_printf("<bytecode format %" PRIu32 ">", read_u32le(artifact + 4));
+    return -1;
+  }
+  if (read_u32le(artifact + 8) != JS_GAS_VERSION_LATEST) {
+    *error = dup_printf("<bytecode gas version %" PRIu32 ">", read_u32le(artifact + 8));
+    return -1;
+  }
+  if (read_u32le(artifact + 12) != artifact_len - DET_BYTECODE_HEADER_SIZE) {
+    *error = dup_printf("<bytecode length>");
+    return -1;
+  }
+
+  det->evaluated = 1;
+  memo_clear(&det->memo);
+
+  uint64_t remaining = suspend_gas(det);
+  JSValue fn = JS_ReadObject(det->ctx, artifact + DET_BYTECODE_HEADER_SIZE,
+                             artifact_len - DET_BYTECODE_HEADER_SIZE, JS_READ_OBJ_BYTECODE);
+  resume_gas(det, remaining);
+  if (JS_IsException(fn)) {
+    *error = take_exception_message(det->ctx, "<bytecode load>");
+    return -1;
+  }
+
+  if (run_gc_checkpoint(det) != 0) {
+    JS_FreeValue(det->ctx, fn);
+    *error = take_exception_message(det->ctx, "<gc checkpoint>");
+    return -1;
+  }
+
+  JSValue result = JS_EvalFunction(det->ctx, fn);
+  return result_to_dv(det, result, dv, error);
+}
+
+static const DetEvalResult *eval_result_error(DetInstance *det, char *error) {
+  uint64_t remaining = JS_GetGasRemaining(det->ctx);
+  det->eval_error = error;
+  det->eval_result.status = DET_EVAL_STATUS_ERROR;
+  det->eval_result.gas_remaining = remaining;
+  det->eval_result.gas_used = gas_used(det->gas_limit, remaining);
+  if (error) {
+    det->eval_result.payload_ptr = DET_PTR32(error);
+    det->eval_result.payload_len = (uint32_t)strlen(error);
+  } else if (det_state->out_of_memory) {
+    /* No memory was left to copy the message into. */
+    memcpy(det_state->oom_message, DET_OOM_MESSAGE, sizeof(DET_OOM_MESSAGE));
+    det->eval_result.payload_ptr = DET_PTR32(det_state->oom_message);
+    det->eval_result.payload_len = (uint32_t)(sizeof(DET_OOM_MESSAGE) - 1);
+  }
+  return &det->eval_result;
+}
+
+static const DetEvalResult *eval_result_invalid_handle(void) {
+  memcpy(det_state->invalid_handle, DET_INVALID_HANDLE, sizeof(DET_INVALID_HANDLE));
+  memset(&det_state->invalid_result, 0, sizeof(det_state->invalid_result));
+  det_state->invalid_result.status = DET_EVAL_STATUS_ERROR;
+  det_state->invalid_result.payload_ptr = DET_PTR32(det_state->invalid_handle);
+  det_state->invalid_result.payload_len = (uint32_t)(sizeof(DET_INVALID_HANDLE) - 1);
+  return &det_state->invalid_result;
+}
+
+static const DetEvalResult *eval_result_ok(DetInstance *det) {
+  uint64_t remaining = JS_GetGasRemaining(det->ctx);
+  det->eval_result.status = DET_EVAL_STATUS_RESULT;
+  det->eval_result.gas_remaining = remaining;
+  det->eval_result.gas_used = gas_used(det->gas_limit, remaining);
+  det->eval_result.payload_ptr = DET_PTR32(det->eval_dv.data);
+  det->eval_result.payload_len = (uint32_t)det->eval_dv.length;
+  return &det->eval_result;
+}
 
 static char *hex32(const uint8_t *bytes, size_t length)
 {
@@ -169,23 +1268,99 @@ static int js_set_prop(JSContext *ctx, JSValue obj, const char *name, JSValue va
   return 0;
 }
 
+/* Return the input arena, grown (contents not preserved) to hold at least
+   `capacity` bytes. The pointer stays valid until the next call that grows it;
+   NULL on allocation failure. */
+EMSCRIPTEN_KEEPALIVE
+uint8_t *qjs_det_input_buffer(uint32_t capacity) {
+  if (det_state->input_arena && capacity <= det_state->input_capacity) {
+    return det_state->input_arena;
+  }
+
+  uint32_t next = det_state->input_capacity ? det_state->input_capacity : DET_INPUT_ARENA_MIN;
+  while (next < capacity) {
+    if (next > UINT32_MAX / 2) {
+      next = capacity;
+      break;
+    }
+    next *= 2;
+  }
+
+  free(det_state->input_arena);
+  det_state->input_arena = malloc(next);
+  det_state->input_capacity = det_state->input_arena ? next : 0;
+  return det_state->input_arena;
+}
+
+/* Copy the manifest bytes used by every later qjs_det_init called with a NULL
+   manifest pointer. Returns 0 on success, -1 on allocation failure. */
+EMSCRIPTEN_KEEPALIVE
+int qjs_det_set_manifest(const uint8_t *manifest_bytes, uint32_t manifest_size) {
+  uint8_t *copy = malloc(manifest_size ? manifest_size : 1);
+  if (!copy) {
+    return -1;
+  }
+  if (manifest_size) {
+    memcpy(copy, manifest_bytes, manifest_size);
+  }
+  free(det_state->manifest);
+  det_state->manifest = copy;
+  det_state->manifest_size = manifest_size;
+  return 0;
+}
+
+/* Choose the allocator for VMs created by later qjs_det_init calls: the
+   per-VM arena (enabled != 0) or the system heap (the default). Live VMs keep
+   the allocator they were created with. Always returns 0. */
+EMSCRIPTEN_KEEPALIVE
+int qjs_det_use_arena(int enabled) {
+  det_state->use_arena = enabled ? 1 : 0;
+  return 0;
+}
+
+/* Pass manifest_bytes = NULL to use the manifest installed with
+   qjs_det_set_manifest. */
 EMSCRIPTEN_KEEPALIVE
-char *qjs_det_init(const uint8_t *manifest_bytes,
-                   uint32_t manifest_size,
-                   const char *manifest_hash_hex,
-                   const uint8_t *context_blob,
-                   uint32_t context_blob_size,
-                   uint64_t gas_limit) {
-  free_det_runtime();
-  det_gas_limit = gas_limit;
+uint32_t qjs_det_init(const uint8_t *manifest_bytes,
+                      uint32_t manifest_size,
+                      const char *manifest_hash_hex,
+                      const uint8_t *context_blob,
+                      uint32_t context_blob_size,
+                      uint64_t gas_limit) {
+  free(det_state->init_error);
+  det_state->init_error = NULL;
+  det_state->out_of_memory = 0;
+
+  if (!manifest_bytes) {
+    if (!det_state->manifest) {
+      det_state->init_error = dup_printf("ERROR <manifest not set> GAS remaining=0 used=0");
+      return 0;
+    }
+    manifest_bytes = det_state->manifest;
+    manifest_size = det_state->manifest_size;
+  }
 
-  if (JS_NewDeterministicRuntime(&det_rt, &det_ctx) != 0) {
-    return dup_printf("ERROR <init> GAS remaining=0 used=0");
+  DetInstance *det = alloc_instance();
+  if (!det) {
+    det_state->init_error = dup_printf("ERROR <instance limit> GAS remaining=0 used=0");
+    return 0;
+  }
+  det->gas_limit = gas_limit;
+  if (det_state->use_arena) {
+    det->arena.owner = (uint16_t)((det->handle & (DET_MAX_INSTANCES - 1)) + 1);
+  }
+  DET_ARENA_SCOPE(det);
+
+  if (JS_NewDeterministicRuntime(&det->rt, &det->ctx) != 0) {
+    free_instance(det);
+    det_state->init_error = dup_printf("ERROR <init> GAS remaining=0 used=0");
+    return 0;
   }
 
-  if (JS_SetHostCallDispatcher(det_rt, wasm_host_call, NULL) != 0) {
-    free_det_runtime();
-    return dup_printf("ERROR <host dispatcher> GAS remaining=0 used=0");
+  if (JS_SetHostCallDispatcher(det->rt, wasm_host_call, det) != 0) {
+    free_instance(det);
+    det_state->init_error = dup_printf("ERROR <host dispatcher> GAS remaining=0 used=0");
+    return 0;
   }
 
   JSDeterministicInitOptions opts = {
@@ -197,91 +1372,442 @@ char *qjs_det_init(const uint8_t *manifest_bytes,
       .gas_limit = gas_limit,
   };
 
-  if (JS_InitDeterministicContext(det_ctx, &opts) != 0) {
-    char *out = format_exception(det_ctx, det_gas_limit, "<init>", NULL);
-    free_det_runtime();
-    return out;
+  if (JS_InitDeterministicContext(det->ctx, &opts) != 0) {
+    det_state->init_error =
+        det_export_string(format_exception(det->ctx, det->gas_limit, "<init>", NULL));
+    free_instance(det);
+    return 0;
   }
 
-  if (run_gc_checkpoint(det_ctx) != 0) {
-    char *out = format_exception(det_ctx, det_gas_limit, "<gc checkpoint>", NULL);
-    free_det_runtime();
-    return out;
+  if (run_gc_checkpoint(det) != 0) {
+    det_state->init_error =
+        det_export_string(format_exception(det->ctx, det->gas_limit, "<gc checkpoint>", NULL));
+    free_instance(det);
+    return 0;
   }
 
-  return NULL;
+  return det->handle;
+}
+
+/* Failure text of the last qjs_det_init that returned 0, in the
+   `ERROR <msg> GAS …` format. Ownership passes to the caller (free it);
+   returns NULL when there is nothing to report. */
+EMSCRIPTEN_KEEPALIVE
+char *qjs_det_take_init_error(void) {
+  char *out = det_state->init_error;
+  det_state->init_error = NULL;
+  return out;
 }
 
 EMSCRIPTEN_KEEPALIVE
-char *qjs_det_eval(const char *code) {
-  if (!det_ctx || !det_rt) {
+char *qjs_det_eval(uint32_t handle, const char *code) {
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
+  if (!det) {
     return dup_printf("ERROR <uninitialized> GAS remaining=0 used=0");
   }
 
-  if (run_gc_checkpoint(det_ctx) != 0) {
-    return format_exception(det_ctx, det_gas_limit, "<gc checkpoint>", NULL);
+  release_eval_result(det);
+
+  JSDvBuffer dv = {0};
+  char *error = NULL;
+  DET_CALIBRATION_START();
+  int rc = eval_to_dv(det, code, strlen(code), &dv, &error);
+  DET_CALIBRATION_STOP(det, evals, eval_ns);
+  if (rc != 0) {
+    uint64_t remaining = JS_GetGasRemaining(det->ctx);
+    char *out = format_with_gas("ERROR", error ? error : "<exception>", det->gas_limit, remaining,
+                                NULL);
+    free(error);
+    return det_export_string(out);
   }
 
-  JSValue result = JS_Eval(det_ctx, code, strlen(code), "<eval>", JS_EVAL_TYPE_GLOBAL);
-  if (JS_IsException(result)) {
-    JS_FreeValue(det_ctx, result);
-    return format_exception(det_ctx, det_gas_limit, "<exception>", NULL);
+  char *hex = hex_bytes(dv.data, dv.length);
+  JS_FreeDVBuffer(det->ctx, &dv);
+  if (!hex) {
+    uint64_t remaining = JS_GetGasRemaining(det->ctx);
+    return det_export_string(
+        format_with_gas("ERROR", "<dv encode>", det->gas_limit, remaining, NULL));
   }
 
-  JSDvBuffer dv = {0};
-  if (JS_EncodeDV(det_ctx, result, &JS_DV_LIMIT_DEFAULTS, &dv) != 0) {
-    JS_FreeValue(det_ctx, result);
-    char *out = format_exception(det_ctx, det_gas_limit, "<dv encode>", NULL);
-    JS_FreeDVBuffer(det_ctx, &dv);
-    return out;
+  uint64_t remaining = JS_GetGasRemaining(det->ctx);
+  char *out = format_with_gas("RESULT", hex, det->gas_limit, remaining, NULL);
+  free(hex);
+  return det_export_string(out);
+}
+
+/* Binary counterpart of qjs_det_eval: code must be NUL-terminated at
+   code[code_len]. Returns the instance-owned result struct described above. */
+EMSCRIPTEN_KEEPALIVE
+const DetEvalResult *qjs_det_eval_bin(uint32_t handle, const char *code, uint32_t code_len) {
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
+  if (!det || !code) {
+    return eval_result_invalid_handle();
   }
 
-  JS_FreeValue(det_ctx, result);
+  release_eval_result(det);
 
-  if (run_gc_checkpoint(det_ctx) != 0) {
-    JS_FreeDVBuffer(det_ctx, &dv);
-    return format_exception(det_ctx, det_gas_limit, "<gc checkpoint>", NULL);
+  char *error = NULL;
+  DET_CALIBRATION_START();
+  int rc = eval_to_dv(det, code, code_len, &det->eval_dv, &error);
+  DET_CALIBRATION_STOP(det, evals, eval_ns);
+  if (rc != 0) {
+    return eval_result_error(det, error);
   }
+  return eval_result_ok(det);
+}
 
-  char *hex = hex_bytes(dv.data, dv.length);
-  JS_FreeDVBuffer(det_ctx, &dv);
-  if (!hex) {
-    uint64_t remaining = JS_GetGasRemaining(det_ctx);
-    return format_with_gas("ERROR", "<dv encode>", det_gas_limit, remaining, NULL);
+/* Compile code (NUL-terminated at code[code_len]) into a bytecode artifact
+   without running it. Reports through the eval result struct: RESULT carries
+   the artifact bytes, ERROR the compile error. Gas is not charged and the
+   remaining budget is left untouched. */
+EMSCRIPTEN_KEEPALIVE
+const DetEvalResult *qjs_det_compile(uint32_t handle, const char *code, uint32_t code_len) {
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
+  if (!det || !code) {
+    return eval_result_invalid_handle();
   }
 
-  uint64_t remaining = JS_GetGasRemaining(det_ctx);
-  char *out = format_with_gas("RESULT", hex, det_gas_limit, remaining, NULL);
-  free(hex);
-  return out;
+  release_eval_result(det);
+  det->evaluated = 1;
+
+  uint64_t remaining = suspend_gas(det);
+  JSValue fn = JS_Eval(det->ctx, code, code_len, "<eval>",
+                       JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+  if (JS_IsException(fn)) {
+    resume_gas(det, remaining);
+    return eval_result_error(det, take_exception_message(det->ctx, "<compile>"));
+  }
+
+  size_t body_len = 0;
+  uint8_t *body = JS_WriteObject(det->ctx, &body_len, fn, JS_WRITE_OBJ_BYTECODE);
+  JS_FreeValue(det->ctx, fn);
+  resume_gas(det, remaining);
+  if (!body) {
+    return eval_result_error(det, take_exception_message(det->ctx, "<bytecode write>"));
+  }
+
+  det->compiled = malloc(DET_BYTECODE_HEADER_SIZE + body_len);
+  if (!det->compiled) {
+    js_free(det->ctx, body);
+    return eval_result_error(det, dup_printf("<oom>"));
+  }
+  write_u32le(det->compiled, DET_BYTECODE_MAGIC);
+  write_u32le(det->compiled + 4, DET_BYTECODE_FORMAT_VERSION);
+  write_u32le(det->compiled + 8, JS_GAS_VERSION_LATEST);
+  write_u32le(det->compiled + 12, (uint32_t)body_len);
+  memcpy(det->compiled + DET_BYTECODE_HEADER_SIZE, body, body_len);
+  js_free(det->ctx, body);
+
+  det->eval_result.status = DET_EVAL_STATUS_RESULT;
+  det->eval_result.gas_remaining = remaining;
+  det->eval_result.gas_used = gas_used(det->gas_limit, remaining);
+  det->eval_result.payload_ptr = DET_PTR32(det->compiled);
+  det->eval_result.payload_len = (uint32_t)(DET_BYTECODE_HEADER_SIZE + body_len);
+  return &det->eval_result;
+}
+
+/* Run a qjs_det_compile artifact. Same result struct and gas accounting as
+   qjs_det_eval_bin, except that parsing/compilation is not billed. The
+   artifact must come from qjs_det_compile (see DET_BYTECODE_MAGIC). */
+EMSCRIPTEN_KEEPALIVE
+const DetEvalResult *qjs_det_eval_bytecode(uint32_t handle, const uint8_t *artifact,
+                                           uint32_t artifact_len) {
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
+  if (!det) {
+    return eval_result_invalid_handle();
+  }
+
+  release_eval_result(det);
+
+  char *error = NULL;
+  DET_CALIBRATION_START();
+  int rc = eval_bytecode_to_dv(det, artifact, artifact_len, &det->eval_dv, &error);
+  DET_CALIBRATION_STOP(det, evals, eval_ns);
+  if (rc != 0) {
+    return eval_result_error(det, error);
+  }
+  return eval_result_ok(det);
+}
+
+/* Mark fn_id as pure for this VM so repeated identical requests within one
+   evaluation are replayed from the memo table. Returns 0 on success, -1 for
+   an unknown handle or when DET_MEMO_MAX_FNS functions are already marked. */
+EMSCRIPTEN_KEEPALIVE
+int qjs_det_memoize_host_fn(uint32_t handle, uint32_t fn_id) {
+  DetInstance *det = det_lookup(handle);
+  if (!det) {
+    return -1;
+  }
+  if (memo_is_pure(&det->memo, fn_id)) {
+    return 0;
+  }
+  if (det->memo.fn_count >= DET_MEMO_MAX_FNS) {
+    return -1;
+  }
+  det->memo.fn_ids[det->memo.fn_count++] = fn_id;
+  return 0;
 }
 
 EMSCRIPTEN_KEEPALIVE
-int qjs_det_set_gas_limit(uint64_t gas_limit) {
-  if (!det_ctx || !det_rt) {
+int qjs_det_set_gas_limit(uint32_t handle, uint64_t gas_limit) {
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
+  if (!det) {
     return -1;
   }
 
-  det_gas_limit = gas_limit;
-  JS_SetGasLimit(det_ctx, gas_limit);
+  det->gas_limit = gas_limit;
+  JS_SetGasLimit(det->ctx, gas_limit);
   return 0;
 }
 
 EMSCRIPTEN_KEEPALIVE
-void qjs_det_free(void) { free_det_runtime(); }
+void qjs_det_free(uint32_t handle) {
+  DetInstance *det = det_lookup(handle);
+  if (det) {
+    free_instance(det);
+  }
+}
 
+/* Release every VM in this instance (used when a pooled wasm instance is
+   handed to a new owner). */
 EMSCRIPTEN_KEEPALIVE
-int qjs_det_enable_tape(uint32_t capacity)
+void qjs_det_free_all(void) {
+  for (uint32_t slot = 0; slot < DET_MAX_INSTANCES; slot++) {
+    if (det_state->instances[slot]) {
+      free_instance(det_state->instances[slot]);
+    }
+  }
+}
+
+/* End of the heap in use: the sbrk break in wasm, the end of the highest
+   allocated page in a native region. */
+static uint32_t det_heap_break(void) {
+#ifdef __EMSCRIPTEN__
+  return (uint32_t)(uintptr_t)sbrk(0);
+#else
+  uint32_t pages = DET_ARENA_PAGES;
+  while (pages > 0 && !det_state->arena_owner[pages - 1]) {
+    pages--;
+  }
+  return pages << DET_ARENA_CHUNK_SHIFT;
+#endif
+}
+
+/* Snapshot support: every piece of VM state (the instance table, the QuickJS
+   heaps and the allocator bookkeeping, including the sbrk pointer) lives in
+   linear memory below the current break. Between exported calls the shadow
+   stack is unwound, so the embedder can copy [0, qjs_det_snapshot()) and later
+   write it back into an instance of the same wasm module to resume from that
+   point. The image covers the whole memory, so only a handle that is the sole
+   live VM can be snapshotted. A native region holds absolute pointers, so its
+   image can only be written back into the same region. */
+EMSCRIPTEN_KEEPALIVE
+uint32_t qjs_det_snapshot(uint32_t handle)
+{
+  DetInstance *det = det_lookup(handle);
+  if (!det || det->evaluated || det_state->live_instances != 1)
+    return 0;
+
+  return det_heap_break();
+}
+
+static const char *const DET_CONTEXT_GLOBALS[] = {"event", "eventCanonical", "steps"};
+#define DET_CONTEXT_GLOBAL_COUNT (sizeof(DET_CONTEXT_GLOBALS) / sizeof(DET_CONTEXT_GLOBALS[0]))
+
+/* Replace the ergonomic globals JS_InitDeterministicContext installed from the
+   snapshot's context blob with the entries of `blob` (missing keys become
+   null), deep-frozen through canon.unwrap like the originals. Every global is
+   checked before any is replaced: one that is missing or non-configurable
+   fails the call, and the embedder then needs one snapshot per context. */
+static int reinject_context(DetInstance *det, const uint8_t *blob, uint32_t size)
 {
-  if (!det_ctx || !det_rt)
+  JSContext *ctx = det->ctx;
+  JSValue global = JS_GetGlobalObject(ctx);
+  JSValue canon = JS_GetPropertyStr(ctx, global, "canon");
+  JSValue unwrap = JS_IsException(canon) ? JS_EXCEPTION : JS_GetPropertyStr(ctx, canon, "unwrap");
+  JSValue decoded = JS_DecodeDV(ctx, blob, size, &JS_DV_LIMIT_DEFAULTS);
+  JSAtom atoms[DET_CONTEXT_GLOBAL_COUNT] = {0};
+  int flags[DET_CONTEXT_GLOBAL_COUNT];
+  int rc = -1;
+
+  if (JS_IsException(unwrap) || JS_IsException(decoded) || !JS_IsObject(decoded))
+    goto done;
+
+  for (size_t i = 0; i < DET_CONTEXT_GLOBAL_COUNT; i++) {
+    JSPropertyDescriptor desc;
+
+    atoms[i] = JS_NewAtom(ctx, DET_CONTEXT_GLOBALS[i]);
+    if (JS_GetOwnProperty(ctx, &desc, global, atoms[i]) <= 0)
+      goto done;
+    JS_FreeValue(ctx, desc.value);
+    JS_FreeValue(ctx, desc.getter);
+    JS_FreeValue(ctx, desc.setter);
+    if (!(desc.flags & JS_PROP_CONFIGURABLE))
+      goto done;
+    flags[i] = desc.flags;
+  }
+
+  for (size_t i = 0; i < DET_CONTEXT_GLOBAL_COUNT; i++) {
+    JSValue entry = JS_GetPropertyStr(ctx, decoded, DET_CONTEXT_GLOBALS[i]);
+    JSValue frozen;
+
+    if (JS_IsException(entry))
+      goto done;
+    if (JS_IsUndefined(entry))
+      entry = JS_NULL;
+    frozen = JS_Call(ctx, unwrap, canon, 1, &entry);
+    JS_FreeValue(ctx, entry);
+    if (JS_IsException(frozen) ||
+        JS_DefinePropertyValue(ctx, global, atoms[i], frozen, flags[i]) < 0)
+      goto done;
+  }
+  rc = 0;
+
+done:
+  for (size_t i = 0; i < DET_CONTEXT_GLOBAL_COUNT; i++) {
+    if (atoms[i])
+      JS_FreeAtom(ctx, atoms[i]);
+  }
+  if (rc != 0)
+    JS_FreeValue(ctx, JS_GetException(ctx));
+  JS_FreeValue(ctx, decoded);
+  JS_FreeValue(ctx, unwrap);
+  JS_FreeValue(ctx, canon);
+  JS_FreeValue(ctx, global);
+  return rc;
+}
+
+/* Called after the embedder restored a snapshot image; re-arms the gas limit
+   so the restored VM starts metering from a full budget. A non-NULL
+   `context_blob` replaces the context the snapshot was taken with, so one
+   image can serve every input envelope; NULL keeps the baked-in context.
+   Re-injection runs under the new limit and is followed by a GC checkpoint
+   before the budget is re-armed. */
+EMSCRIPTEN_KEEPALIVE
+int qjs_det_restore(uint32_t handle, uint64_t gas_limit,
+                    const uint8_t *context_blob, uint32_t context_blob_size)
+{
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
+  if (!det || det->evaluated)
     return -1;
 
-  return JS_EnableHostTape(det_ctx, capacity);
+  det->gas_limit = gas_limit;
+  JS_SetGasLimit(det->ctx, gas_limit);
+  if (context_blob) {
+    if (reinject_context(det, context_blob, context_blob_size) != 0 ||
+        run_gc_checkpoint(det) != 0)
+      return -1;
+    JS_SetGasLimit(det->ctx, gas_limit);
+  }
+  return 0;
+}
+
+/* Session baseline: optionally run a prelude (e.g. entrypoint definitions)
+   under the current gas limit, discard its completion value, run a GC
+   checkpoint and mark the resulting state as restorable. The embedder then
+   snapshots it and restores it before every session step, which resets global
+   and lexical scope deterministically while re-arming per-step gas through
+   qjs_det_restore. Reports through the eval result struct (empty RESULT on
+   success). */
+EMSCRIPTEN_KEEPALIVE
+const DetEvalResult *qjs_det_session_begin(uint32_t handle, const char *prelude,
+                                           uint32_t prelude_len)
+{
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
+  if (!det)
+    return eval_result_invalid_handle();
+
+  release_eval_result(det);
+
+  if (prelude) {
+    det->evaluated = 1;
+    if (run_gc_checkpoint(det) != 0)
+      return eval_result_error(det, take_exception_message(det->ctx, "<gc checkpoint>"));
+
+    JSValue result = JS_Eval(det->ctx, prelude, prelude_len, "<prelude>", JS_EVAL_TYPE_GLOBAL);
+    if (JS_IsException(result)) {
+      JS_FreeValue(det->ctx, result);
+      return eval_result_error(det, take_exception_message(det->ctx, "<exception>"));
+    }
+    JS_FreeValue(det->ctx, result);
+  }
+
+  if (run_gc_checkpoint(det) != 0)
+    return eval_result_error(det, take_exception_message(det->ctx, "<gc checkpoint>"));
+
+  det->evaluated = 0;
+  return eval_result_ok(det);
 }
 
 EMSCRIPTEN_KEEPALIVE
-char *qjs_det_read_tape(void)
+uint32_t qjs_det_heap_top(void) { return det_heap_break(); }
+
+EMSCRIPTEN_KEEPALIVE
+int qjs_det_enable_tape(uint32_t handle, uint32_t capacity)
 {
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
+  if (!det)
+    return -1;
+
+  if (det->host_gas) {
+    /* The host-gas table keeps its own ring; a second ring reader would lose
+       it records. */
+    if (capacity > 0)
+      return -1;
+    det->tape_stream = 0;
+    return 0;
+  }
+  if (JS_EnableHostTape(det->ctx, capacity) != 0)
+    return -1;
+  det->tape_stream = 0;
+  det->tape_ring = capacity > 0;
+  return 0;
+}
+
+/* Streaming alternative to qjs_det_enable_tape (enabled = 0 turns the tape
+   off). Records reach the tape_sink import at each host-call boundary; call
+   qjs_det_flush_tape after an eval to deliver the last ones. */
+EMSCRIPTEN_KEEPALIVE
+int qjs_det_stream_tape(uint32_t handle, int enabled)
+{
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
+  if (!det)
+    return -1;
+
+  if (det->host_gas)
+    stream_tape(det);
+  if (JS_EnableHostTape(det->ctx, enabled || det->host_gas ? DET_TAPE_STREAM_RING : 0) != 0)
+    return -1;
+  det->tape_stream = enabled ? 1 : 0;
+  det->tape_ring = 0;
+  return 0;
+}
+
+EMSCRIPTEN_KEEPALIVE
+int qjs_det_flush_tape(uint32_t handle)
+{
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
+  if (!det || !det->tape_stream)
+    return -1;
+
+  stream_tape(det);
+  return 0;
+}
+
+static char *read_tape_json(uint32_t handle)
+{
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
   JSHostTapeRecord *records = NULL;
   size_t count = 0;
   size_t to_read = 0;
@@ -290,29 +1816,29 @@ char *qjs_det_read_tape(void)
   const char *json_str = NULL;
   char *out = NULL;
 
-  if (!det_ctx || !det_rt)
+  if (!det)
     return dup_printf("[]");
 
-  count = JS_GetHostTapeLength(det_ctx);
+  count = JS_GetHostTapeLength(det->ctx);
   if (count == 0)
     return dup_printf("[]");
 
   to_read = count > JS_HOST_TAPE_MAX_CAPACITY ? JS_HOST_TAPE_MAX_CAPACITY : count;
-  records = js_mallocz(det_ctx, sizeof(JSHostTapeRecord) * to_read);
+  records = js_mallocz(det->ctx, sizeof(JSHostTapeRecord) * to_read);
   if (!records)
     return dup_printf("[]");
 
-  if (JS_ReadHostTape(det_ctx, records, to_read, &count) != 0) {
-    js_free(det_ctx, records);
+  if (JS_ReadHostTape(det->ctx, records, to_read, &count) != 0) {
+    js_free(det->ctx, records);
     return dup_printf("[]");
   }
 
-  arr = JS_NewArray(det_ctx);
+  arr = JS_NewArray(det->ctx);
   if (JS_IsException(arr))
     goto done;
 
   for (size_t i = 0; i < count; i++) {
-    JSValue obj = JS_NewObjectProto(det_ctx, JS_NULL);
+    JSValue obj = JS_NewObjectProto(det->ctx, JS_NULL);
     char *req_hex = NULL;
     char *resp_hex = NULL;
     char gas_pre_buf[32];
@@ -321,23 +1847,23 @@ char *qjs_det_read_tape(void)
     if (JS_IsException(obj))
       goto loop_error;
 
-    if (js_set_prop(det_ctx, obj, "fnId", JS_NewUint32(det_ctx, records[i].fn_id)) < 0)
+    if (js_set_prop(det->ctx, obj, "fnId", JS_NewUint32(det->ctx, records[i].fn_id)) < 0)
       goto loop_error;
-    if (js_set_prop(det_ctx, obj, "reqLen", JS_NewUint32(det_ctx, records[i].req_len)) < 0)
+    if (js_set_prop(det->ctx, obj, "reqLen", JS_NewUint32(det->ctx, records[i].req_len)) < 0)
       goto loop_error;
-    if (js_set_prop(det_ctx, obj, "respLen", JS_NewUint32(det_ctx, records[i].resp_len)) < 0)
+    if (js_set_prop(det->ctx, obj, "respLen", JS_NewUint32(det->ctx, records[i].resp_len)) < 0)
       goto loop_error;
-    if (js_set_prop(det_ctx, obj, "units", JS_NewUint32(det_ctx, records[i].units)) < 0)
+    if (js_set_prop(det->ctx, obj, "units", JS_NewUint32(det->ctx, records[i].units)) < 0)
       goto loop_error;
     snprintf(gas_pre_buf, sizeof(gas_pre_buf), "%" PRIu64, records[i].gas_pre);
     snprintf(gas_post_buf, sizeof(gas_post_buf), "%" PRIu64, records[i].gas_post);
-    if (js_set_prop(det_ctx, obj, "gasPre", JS_NewString(det_ctx, gas_pre_buf)) < 0)
+    if (js_set_prop(det->ctx, obj, "gasPre", JS_NewString(det->ctx, gas_pre_buf)) < 0)
       goto loop_error;
-    if (js_set_prop(det_ctx, obj, "gasPost", JS_NewString(det_ctx, gas_post_buf)) < 0)
+    if (js_set_prop(det->ctx, obj, "gasPost", JS_NewString(det->ctx, gas_post_buf)) < 0)
       goto loop_error;
-    if (js_set_prop(det_ctx, obj, "isError", JS_NewBool(det_ctx, records[i].is_error)) < 0)
+    if (js_set_prop(det->ctx, obj, "isError", JS_NewBool(det->ctx, records[i].is_error)) < 0)
       goto loop_error;
-    if (js_set_prop(det_ctx, obj, "chargeFailed", JS_NewBool(det_ctx, records[i].charge_failed)) < 0)
+    if (js_set_prop(det->ctx, obj, "chargeFailed", JS_NewBool(det->ctx, records[i].charge_failed)) < 0)
       goto loop_error;
 
     req_hex = hex32(records[i].req_hash, sizeof(records[i].req_hash));
@@ -350,12 +1876,12 @@ char *qjs_det_read_tape(void)
       goto loop_error;
     }
 
-    if (js_set_prop(det_ctx, obj, "reqHash", JS_NewString(det_ctx, req_hex)) < 0) {
+    if (js_set_prop(det->ctx, obj, "reqHash", JS_NewString(det->ctx, req_hex)) < 0) {
       free(req_hex);
       free(resp_hex);
       goto loop_error;
     }
-    if (js_set_prop(det_ctx, obj, "respHash", JS_NewString(det_ctx, resp_hex)) < 0) {
+    if (js_set_prop(det->ctx, obj, "respHash", JS_NewString(det->ctx, resp_hex)) < 0) {
       free(req_hex);
       free(resp_hex);
       goto loop_error;
@@ -364,36 +1890,36 @@ char *qjs_det_read_tape(void)
     free(req_hex);
     free(resp_hex);
 
-    if (JS_SetPropertyUint32(det_ctx, arr, (uint32_t)i, obj) < 0) {
-      JS_FreeValue(det_ctx, obj);
+    if (JS_SetPropertyUint32(det->ctx, arr, (uint32_t)i, obj) < 0) {
+      JS_FreeValue(det->ctx, obj);
       goto done;
     }
 
     continue;
 
   loop_error:
-    JS_FreeValue(det_ctx, obj);
+    JS_FreeValue(det->ctx, obj);
     goto done;
   }
 
-  json = JS_JSONStringify(det_ctx, arr, JS_UNDEFINED, JS_UNDEFINED);
+  json = JS_JSONStringify(det->ctx, arr, JS_UNDEFINED, JS_UNDEFINED);
   if (JS_IsException(json))
     goto done;
 
-  json_str = JS_ToCString(det_ctx, json);
+  json_str = JS_ToCString(det->ctx, json);
   if (!json_str)
     goto done;
 
   out = dup_printf("%s", json_str);
-  JS_FreeCString(det_ctx, json_str);
+  JS_FreeCString(det->ctx, json_str);
 
 done:
   if (records)
-    js_free(det_ctx, records);
+    js_free(det->ctx, records);
   if (!JS_IsUndefined(arr))
-    JS_FreeValue(det_ctx, arr);
+    JS_FreeValue(det->ctx, arr);
   if (!JS_IsUndefined(json))
-    JS_FreeValue(det_ctx, json);
+    JS_FreeValue(det->ctx, json);
 
   if (!out)
     return dup_printf("[]");
@@ -401,33 +1927,114 @@ done:
 }
 
 EMSCRIPTEN_KEEPALIVE
-int qjs_det_enable_trace(int enabled)
+char *qjs_det_read_tape(uint32_t handle)
+{
+  return det_export_string(read_tape_json(handle));
+}
+
+/* Copies up to capacity / sizeof(DetTapeRecordBin) tape records into out and
+   returns how many were written (-1 on an unknown handle or read failure).
+   Unlike qjs_det_read_tape this builds no JS values and allocates nothing in
+   the VM heap; size out for the capacity passed to qjs_det_enable_tape. */
+EMSCRIPTEN_KEEPALIVE
+int32_t qjs_det_read_tape_bin(uint32_t handle, uint8_t *out, uint32_t capacity)
+{
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
+  JSHostTapeRecord *records = NULL;
+  size_t count = 0;
+  size_t to_read = 0;
+
+  if (!det || (!out && capacity > 0))
+    return -1;
+
+  to_read = JS_GetHostTapeLength(det->ctx);
+  if (to_read > JS_HOST_TAPE_MAX_CAPACITY)
+    to_read = JS_HOST_TAPE_MAX_CAPACITY;
+  if (to_read > capacity / sizeof(DetTapeRecordBin))
+    to_read = capacity / sizeof(DetTapeRecordBin);
+  if (to_read == 0)
+    return 0;
+
+  records = malloc(sizeof(JSHostTapeRecord) * to_read);
+  if (!records)
+    return -1;
+  if (JS_ReadHostTape(det->ctx, records, to_read, &count) != 0) {
+    free(records);
+    return -1;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    pack_tape_record(&records[i], out + i * sizeof(DetTapeRecordBin));
+  }
+
+  free(records);
+  return (int32_t)count;
+}
+
+/* mode 0 turns tracing off; any other value enables and resets the gas
+   trace, and DET_TRACE_HOST_GAS also starts a fresh host-gas table (see
+   qjs_det_read_host_gas_bin). The table reads host-call gas from the tape:
+   it drains a small ring of its own, or the stream ring, so it is refused
+   while a qjs_det_enable_tape ring is active. */
+EMSCRIPTEN_KEEPALIVE
+int qjs_det_enable_trace(uint32_t handle, int mode)
 {
-  if (!det_ctx || !det_rt)
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
+  if (!det)
+    return -1;
+
+  int host_gas = (mode & DET_TRACE_HOST_GAS) != 0;
+  if (host_gas && det->tape_ring)
     return -1;
 
-  if (JS_EnableGasTrace(det_ctx, enabled ? 1 : 0) != 0)
+  if (JS_EnableGasTrace(det->ctx, mode ? 1 : 0) != 0)
     return -1;
 
-  if (enabled) {
-    if (JS_ResetGasTrace(det_ctx) != 0)
+  if (mode) {
+    if (JS_ResetGasTrace(det->ctx) != 0)
       return -1;
   }
+
+  if (det->host_gas) {
+    /* Deliver pending records before the table they belong to goes. */
+    stream_tape(det);
+    if (host_gas) {
+      memset(det->host_gas, 0, sizeof(*det->host_gas));
+    } else {
+      free(det->host_gas);
+      det->host_gas = NULL;
+      if (!det->tape_stream && JS_EnableHostTape(det->ctx, 0) != 0)
+        return -1;
+    }
+  } else if (host_gas) {
+    DetHostGas *fresh = calloc(1, sizeof(DetHostGas));
+    if (!fresh)
+      return -1;
+    if (!det->tape_stream && JS_EnableHostTape(det->ctx, DET_TAPE_STREAM_RING) != 0) {
+      free(fresh);
+      return -1;
+    }
+    det->host_gas = fresh;
+  }
   return 0;
 }
 
 EMSCRIPTEN_KEEPALIVE
-char *qjs_det_read_trace(void)
+char *qjs_det_read_trace(uint32_t handle)
 {
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
   JSGasTrace trace = {0};
 
-  if (det_ctx && det_rt) {
-    if (JS_ReadGasTrace(det_ctx, &trace) != 0) {
+  if (det) {
+    if (JS_ReadGasTrace(det->ctx, &trace) != 0) {
       memset(&trace, 0, sizeof(trace));
     }
   }
 
-  return dup_printf(
+  return det_export_string(dup_printf(
       "{\"opcodeCount\":\"%" PRIu64 "\",\"opcodeGas\":\"%" PRIu64
       "\",\"arrayCbBaseCount\":\"%" PRIu64 "\",\"arrayCbBaseGas\":\"%" PRIu64
       "\",\"arrayCbPerElCount\":\"%" PRIu64
@@ -437,5 +2044,126 @@ char *qjs_det_read_trace(void)
       trace.opcode_count, trace.opcode_gas, trace.builtin_array_cb_base_count,
       trace.builtin_array_cb_base_gas, trace.builtin_array_cb_per_element_count,
       trace.builtin_array_cb_per_element_gas, trace.allocation_count,
-      trace.allocation_bytes, trace.allocation_gas);
+      trace.allocation_bytes, trace.allocation_gas));
 }
+
+/* Writes the gas trace counters into out as a DetGasTraceBin and returns its
+   size, or -1 on an unknown handle or when capacity is too small. */
+EMSCRIPTEN_KEEPALIVE
+int32_t qjs_det_read_trace_bin(uint32_t handle, uint8_t *out, uint32_t capacity)
+{
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
+  JSGasTrace trace = {0};
+  DetGasTraceBin bin;
+
+  if (!det || !out || capacity < sizeof(bin))
+    return -1;
+
+  if (JS_ReadGasTrace(det->ctx, &trace) != 0) {
+    memset(&trace, 0, sizeof(trace));
+  }
+
+  bin.opcode_count = trace.opcode_count;
+  bin.opcode_gas = trace.opcode_gas;
+  bin.array_cb_base_count = trace.builtin_array_cb_base_count;
+  bin.array_cb_base_gas = trace.builtin_array_cb_base_gas;
+  bin.array_cb_per_element_count = trace.builtin_array_cb_per_element_count;
+  bin.array_cb_per_element_gas = trace.builtin_array_cb_per_element_gas;
+  bin.allocation_count = trace.allocation_count;
+  bin.allocation_bytes = trace.allocation_bytes;
+  bin.allocation_gas = trace.allocation_gas;
+  memcpy(out, &bin, sizeof(bin));
+  return (int32_t)sizeof(bin);
+}
+
+/* Writes the host-gas breakdown (layout above DetHostGasHeaderBin) into out
+   and returns its size in bytes. Nothing is written when capacity is smaller
+   than that size, so a call with out = NULL sizes the buffer. Pending tape
+   records are folded in first (and streamed, when streaming). Returns -1 on
+   an unknown handle or when host gas is not being recorded. */
+EMSCRIPTEN_KEEPALIVE
+int32_t qjs_det_read_host_gas_bin(uint32_t handle, uint8_t *out, uint32_t capacity)
+{
+  DetInstance *det = det_lookup(handle);
+  DET_ARENA_SCOPE(det);
+  DetHostGasHeaderBin header = {0};
+
+  if (!det || !det->host_gas)
+    return -1;
+
+  stream_tape(det);
+  header.magic = DET_HOST_GAS_MAGIC;
+  header.version = DET_HOST_GAS_VERSION;
+  header.flags = det->host_gas->flags;
+  header.host_count = det->host_gas->host_count;
+
+  uint32_t hosts_len = header.host_count * (uint32_t)sizeof(DetHostGasBin);
+  uint32_t size = (uint32_t)sizeof(header) + hosts_len;
+  if (!out || capacity < size)
+    return (int32_t)size;
+
+  memcpy(out, &header, sizeof(header));
+  memcpy(out + sizeof(header), det->host_gas->hosts, hosts_len);
+  return (int32_t)size;
+}
+
+/* Copies the calibration counters into out as a DetCalibrationBin, zeroes
+   them and returns its size. Returns -1 on an unknown handle, a short buffer,
+   or in any build other than `calibration`. */
+EMSCRIPTEN_KEEPALIVE
+int32_t qjs_det_read_calibration_bin(uint32_t handle, uint8_t *out, uint32_t capacity)
+{
+#ifdef QJS_DET_CALIBRATION
+  DetInstance *det = det_lookup(handle);
+  if (!det || !out || capacity < sizeof(DetCalibrationBin))
+    return -1;
+
+  memcpy(out, &det->calibration, sizeof(DetCalibrationBin));
+  memset(&det->calibration, 0, sizeof(DetCalibrationBin));
+  return (int32_t)sizeof(DetCalibrationBin);
+#else
+  (void)handle;
+  (void)out;
+  (void)capacity;
+  return -1;
+#endif
+}
+
+#ifndef __EMSCRIPTEN__
+/* Native instances: one mmap'd region per state, zero-filled like fresh wasm
+   memory. The state occupies the first page, so no allocation ever sits at
+   offset 0 and DET_PTR32 keeps 0 for NULL. */
+DetState *qjs_det_native_state_new(void) {
+  void *region = mmap(NULL, QJS_DET_MEMORY_BYTES, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (region == MAP_FAILED) {
+    return NULL;
+  }
+  DetState *state = region;
+  uint32_t pages = (uint32_t)((sizeof(DetState) + DET_ARENA_CHUNK_SIZE - 1) >> DET_ARENA_CHUNK_SHIFT);
+  for (uint32_t i = 0; i < pages; i++) {
+    state->arena_owner[i] = DET_SYSTEM_OWNER;
+  }
+  state->system_arena.owner = DET_SYSTEM_OWNER;
+  return state;
+}
+
+/* Make state the target of later calls on this thread; returns the previous
+   one so nested calls (a host function calling another instance) can restore
+   it. */
+DetState *qjs_det_native_enter(DetState *state) {
+  DetState *prev = det_state;
+  det_state = state;
+  return prev;
+}
+
+void qjs_det_native_state_free(DetState *state) {
+  DetState *prev = qjs_det_native_enter(state);
+  qjs_det_free_all();
+  qjs_det_native_enter(prev == state ? NULL : prev);
+  munmap(state, QJS_DET_MEMORY_BYTES);
+}
+
+uint32_t qjs_det_native_region_size(void) { return QJS_DET_MEMORY_BYTES; }
+#endif
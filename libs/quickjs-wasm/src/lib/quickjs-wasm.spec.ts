@@ -1,9 +1,11 @@
 import {
   getQuickjsWasmArtifact,
   listAvailableQuickjsWasmBuildTargets,
+  listAvailableQuickjsWasmMemoryProfiles,
   loadQuickjsWasmBinary,
   loadQuickjsWasmLoaderSource,
   loadQuickjsWasmMetadata,
+  loadQuickjsWasmModule,
 } from './quickjs-wasm.js';
 import { decodeDv, encodeDv } from '@blue-quickjs/dv';
 import {
@@ -59,6 +61,53 @@ describe('quickjs wasm artifacts', () => {
     }
   });
 
+  it('loads the release build of each available memory profile', async () => {
+    const metadata = await loadQuickjsWasmMetadata();
+    const profiles = listAvailableQuickjsWasmMemoryProfiles(metadata);
+    expect(profiles.length).toBeGreaterThan(0);
+
+    for (const memoryProfile of profiles) {
+      const artifact = await getQuickjsWasmArtifact(
+        'wasm32',
+        'release',
+        metadata,
+        memoryProfile,
+      );
+      expect(artifact.memoryProfile).toBe(memoryProfile);
+      if (artifact.variantMetadata.memory) {
+        expect(artifact.variantMetadata.memory.maximum).toBe(
+          Number.parseInt(memoryProfile, 10) * 1024 * 1024,
+        );
+      }
+      const bytes = await loadQuickjsWasmBinary(
+        'wasm32',
+        'release',
+        metadata,
+        memoryProfile,
+      );
+      expect(Array.from(bytes.slice(0, WASM_MAGIC_HEADER.length))).toEqual(
+        WASM_MAGIC_HEADER,
+      );
+    }
+  });
+
+  it('compiles each build target once and shares the module', async () => {
+    const metadata = await loadQuickjsWasmMetadata();
+    const targets = listAvailableQuickjsWasmBuildTargets(metadata);
+    expect(targets.length).toBeGreaterThan(0);
+
+    for (const { variant, buildType } of targets) {
+      const [first, second] = await Promise.all([
+        loadQuickjsWasmModule(variant, buildType, metadata),
+        loadQuickjsWasmModule(variant, buildType, metadata),
+      ]);
+      expect(second).toBe(first);
+      expect(await loadQuickjsWasmModule(variant, buildType, metadata)).toBe(
+        first,
+      );
+    }
+  });
+
   it('resolves loader source for each available variant', async () => {
     const metadata = await loadQuickjsWasmMetadata();
     const targets = listAvailableQuickjsWasmBuildTargets(metadata);
@@ -103,8 +152,15 @@ describe('quickjs wasm artifacts', () => {
           host_call: () => HOST_TRANSPORT_SENTINEL,
         },
       });
-      const { init, evalFn, freeRuntime, malloc, free, readCString } =
-        createDeterministicFns(module, variant);
+      const {
+        init,
+        takeInitError,
+        evalFn,
+        freeRuntime,
+        malloc,
+        free,
+        readCString,
+      } = createDeterministicFns(module, variant);
 
       const manifestPtr = writeBytes(module, malloc, HOST_V1_BYTES);
       const contextPtr =
@@ -144,8 +200,9 @@ describe('quickjs wasm artifacts', () => {
         }
       }
 
+      let handle = 0;
       try {
-        const errorPtr = init(
+        handle = init(
           manifestPtr,
           HOST_V1_BYTES.length,
           hashPtr,
@@ -153,13 +210,14 @@ describe('quickjs wasm artifacts', () => {
           CONTEXT_BLOB.length,
           500n,
         );
-        if (errorPtr !== 0) {
+        if (handle === 0) {
+          const errorPtr = takeInitError();
           const message = readCString(errorPtr);
           free(errorPtr);
           throw new Error(`init failed: ${message}`);
         }
 
-        const resultPtr = evalFn('1 + 2');
+        const resultPtr = evalFn(handle, '1 + 2');
         const parsed = parseDeterministicOutput(readCString(resultPtr));
         free(resultPtr);
 
@@ -181,7 +239,9 @@ describe('quickjs wasm artifacts', () => {
         if (contextPtr) {
           free(contextPtr);
         }
-        freeRuntime();
+        if (handle !== 0) {
+          freeRuntime(handle);
+        }
       }
     }
   });
@@ -189,7 +249,7 @@ describe('quickjs wasm artifacts', () => {
 
 function createDeterministicFns(module: WasmModuleWithCwrap, variant: string) {
   const ptrType = variant === 'wasm64' ? 'bigint' : 'number';
-  const init = module.cwrap('qjs_det_init', ptrType, [
+  const init = module.cwrap('qjs_det_init', 'number', [
     ptrType,
     'number',
     ptrType,
@@ -203,11 +263,19 @@ function createDeterministicFns(module: WasmModuleWithCwrap, variant: string) {
     contextPtr: WasmPtr,
     contextSize: number,
     gasLimit: bigint,
-  ) => WasmPtr;
-  const evalFn = module.cwrap('qjs_det_eval', ptrType, ['string']) as (
-    code: string,
-  ) => WasmPtr;
-  const freeRuntime = module.cwrap('qjs_det_free', null, []) as () => void;
+  ) => number;
+  const takeInitError = module.cwrap(
+    'qjs_det_take_init_error',
+    ptrType,
+    [],
+  ) as () => WasmPtr;
+  const evalFn = module.cwrap('qjs_det_eval', ptrType, [
+    'number',
+    'string',
+  ]) as (handle: number, code: string) => WasmPtr;
+  const freeRuntime = module.cwrap('qjs_det_free', null, ['number']) as (
+    handle: number,
+  ) => void;
   const malloc = module.cwrap('malloc', ptrType, ['number']) as (
     size: number,
   ) => WasmPtr;
@@ -217,6 +285,7 @@ function createDeterministicFns(module: WasmModuleWithCwrap, variant: string) {
 
   return {
     init,
+    takeInitError,
     evalFn,
     freeRuntime,
     malloc,
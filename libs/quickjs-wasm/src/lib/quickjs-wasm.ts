@@ -1,32 +1,72 @@
 import {
+  QUICKJS_WASM64_ASYNC_BASENAME,
+  QUICKJS_WASM64_ASYNC_LOADER_BASENAME,
+  QUICKJS_WASM64_CALIBRATION_BASENAME,
+  QUICKJS_WASM64_CALIBRATION_LOADER_BASENAME,
+  QUICKJS_WASM64_OPTIMIZED_BASENAME,
+  QUICKJS_WASM64_OPTIMIZED_LOADER_BASENAME,
   QUICKJS_WASM64_BASENAME,
   QUICKJS_WASM64_LOADER_BASENAME,
   QUICKJS_WASM64_DEBUG_BASENAME,
   QUICKJS_WASM64_DEBUG_LOADER_BASENAME,
+  QUICKJS_WASM_ASYNC_BASENAME,
+  QUICKJS_WASM_ASYNC_LOADER_BASENAME,
+  QUICKJS_WASM_CALIBRATION_BASENAME,
+  QUICKJS_WASM_CALIBRATION_LOADER_BASENAME,
+  QUICKJS_WASM_OPTIMIZED_BASENAME,
+  QUICKJS_WASM_OPTIMIZED_LOADER_BASENAME,
   QUICKJS_WASM_BASENAME,
   QUICKJS_WASM_LOADER_BASENAME,
   QUICKJS_WASM_DEBUG_BASENAME,
   QUICKJS_WASM_DEBUG_LOADER_BASENAME,
   QUICKJS_WASM_METADATA_BASENAME,
+  QUICKJS_WASM_DEFAULT_MEMORY_PROFILE,
+  memoryProfileFilename,
   type QuickjsWasmBuildMetadata,
   type QuickjsWasmBuildVariantMetadata,
   type QuickjsWasmBuildType,
+  type QuickjsWasmMemoryProfile,
   type QuickjsWasmVariant,
+  type QuickjsWasmVariantsMetadata,
 } from '@blue-quickjs/quickjs-wasm-build/constants';
 
 export interface QuickjsWasmArtifact {
   variant: QuickjsWasmVariant;
   buildType: QuickjsWasmBuildType;
+  memoryProfile: QuickjsWasmMemoryProfile;
   wasmUrl: URL;
   loaderUrl: URL;
   variantMetadata: QuickjsWasmBuildVariantMetadata;
 }
 
+/**
+ * A compiled `WebAssembly.Module`. Typed opaquely because the libraries build
+ * without the DOM lib; pass it back to `instantiateQuickjsWasmModule`.
+ */
+export type QuickjsWasmCompiledModule = object;
+
+/**
+ * A `WebAssembly.Instance` produced from a compiled QuickJS module.
+ */
+export type QuickjsWasmInstance = object;
+
+interface WebAssemblyApi {
+  compile(bytes: Uint8Array): Promise<QuickjsWasmCompiledModule>;
+  compileStreaming?(
+    source: ReturnType<typeof fetch>,
+  ): Promise<QuickjsWasmCompiledModule>;
+  instantiate(
+    module: QuickjsWasmCompiledModule,
+    imports: object,
+  ): Promise<QuickjsWasmInstance>;
+}
+
 export type {
   QuickjsWasmBuildArtifactInfo,
   QuickjsWasmBuildMetadata,
   QuickjsWasmBuildVariantMetadata,
   QuickjsWasmBuildType,
+  QuickjsWasmMemoryProfile,
   QuickjsWasmVariant,
 } from '@blue-quickjs/quickjs-wasm-build';
 
@@ -35,6 +75,11 @@ const FALLBACK_BUILD_DIR = '../../../quickjs-wasm-build/dist';
 const DEFAULT_VARIANT: QuickjsWasmVariant = 'wasm32';
 const DEFAULT_BUILD_TYPE: QuickjsWasmBuildType = 'release';
 
+const COMPILED_MODULES = new Map<
+  string,
+  Promise<QuickjsWasmCompiledModule>
+>();
+
 const PACKAGE_ASSET_URLS: Record<string, URL> = {
   [QUICKJS_WASM_METADATA_BASENAME]: new URL(
     `${PACKAGE_WASM_DIR}/${QUICKJS_WASM_METADATA_BASENAME}`,
@@ -56,6 +101,30 @@ const PACKAGE_ASSET_URLS: Record<string, URL> = {
     `${PACKAGE_WASM_DIR}/${QUICKJS_WASM_DEBUG_LOADER_BASENAME}`,
     import.meta.url,
   ),
+  [QUICKJS_WASM_ASYNC_BASENAME]: new URL(
+    `${PACKAGE_WASM_DIR}/${QUICKJS_WASM_ASYNC_BASENAME}`,
+    import.meta.url,
+  ),
+  [QUICKJS_WASM_ASYNC_LOADER_BASENAME]: new URL(
+    `${PACKAGE_WASM_DIR}/${QUICKJS_WASM_ASYNC_LOADER_BASENAME}`,
+    import.meta.url,
+  ),
+  [QUICKJS_WASM_OPTIMIZED_BASENAME]: new URL(
+    `${PACKAGE_WASM_DIR}/${QUICKJS_WASM_OPTIMIZED_BASENAME}`,
+    import.meta.url,
+  ),
+  [QUICKJS_WASM_OPTIMIZED_LOADER_BASENAME]: new URL(
+    `${PACKAGE_WASM_DIR}/${QUICKJS_WASM_OPTIMIZED_LOADER_BASENAME}`,
+    import.meta.url,
+  ),
+  [QUICKJS_WASM_CALIBRATION_BASENAME]: new URL(
+    `${PACKAGE_WASM_DIR}/${QUICKJS_WASM_CALIBRATION_BASENAME}`,
+    import.meta.url,
+  ),
+  [QUICKJS_WASM_CALIBRATION_LOADER_BASENAME]: new URL(
+    `${PACKAGE_WASM_DIR}/${QUICKJS_WASM_CALIBRATION_LOADER_BASENAME}`,
+    import.meta.url,
+  ),
   [QUICKJS_WASM64_BASENAME]: new URL(
     `${PACKAGE_WASM_DIR}/${QUICKJS_WASM64_BASENAME}`,
     import.meta.url,
@@ -72,6 +141,30 @@ const PACKAGE_ASSET_URLS: Record<string, URL> = {
     `${PACKAGE_WASM_DIR}/${QUICKJS_WASM64_DEBUG_LOADER_BASENAME}`,
     import.meta.url,
   ),
+  [QUICKJS_WASM64_ASYNC_BASENAME]: new URL(
+    `${PACKAGE_WASM_DIR}/${QUICKJS_WASM64_ASYNC_BASENAME}`,
+    import.meta.url,
+  ),
+  [QUICKJS_WASM64_ASYNC_LOADER_BASENAME]: new URL(
+    `${PACKAGE_WASM_DIR}/${QUICKJS_WASM64_ASYNC_LOADER_BASENAME}`,
+    import.meta.url,
+  ),
+  [QUICKJS_WASM64_OPTIMIZED_BASENAME]: new URL(
+    `${PACKAGE_WASM_DIR}/${QUICKJS_WASM64_OPTIMIZED_BASENAME}`,
+    import.meta.url,
+  ),
+  [QUICKJS_WASM64_OPTIMIZED_LOADER_BASENAME]: new URL(
+    `${PACKAGE_WASM_DIR}/${QUICKJS_WASM64_OPTIMIZED_LOADER_BASENAME}`,
+    import.meta.url,
+  ),
+  [QUICKJS_WASM64_CALIBRATION_BASENAME]: new URL(
+    `${PACKAGE_WASM_DIR}/${QUICKJS_WASM64_CALIBRATION_BASENAME}`,
+    import.meta.url,
+  ),
+  [QUICKJS_WASM64_CALIBRATION_LOADER_BASENAME]: new URL(
+    `${PACKAGE_WASM_DIR}/${QUICKJS_WASM64_CALIBRATION_LOADER_BASENAME}`,
+    import.meta.url,
+  ),
 };
 
 const VARIANT_FILENAMES: Record<
@@ -87,6 +180,18 @@ const VARIANT_FILENAMES: Record<
       wasm: QUICKJS_WASM_DEBUG_BASENAME,
       loader: QUICKJS_WASM_DEBUG_LOADER_BASENAME,
     },
+    async: {
+      wasm: QUICKJS_WASM_ASYNC_BASENAME,
+      loader: QUICKJS_WASM_ASYNC_LOADER_BASENAME,
+    },
+    optimized: {
+      wasm: QUICKJS_WASM_OPTIMIZED_BASENAME,
+      loader: QUICKJS_WASM_OPTIMIZED_LOADER_BASENAME,
+    },
+    calibration: {
+      wasm: QUICKJS_WASM_CALIBRATION_BASENAME,
+      loader: QUICKJS_WASM_CALIBRATION_LOADER_BASENAME,
+    },
   },
   wasm64: {
     release: {
@@ -97,6 +202,18 @@ const VARIANT_FILENAMES: Record<
       wasm: QUICKJS_WASM64_DEBUG_BASENAME,
       loader: QUICKJS_WASM64_DEBUG_LOADER_BASENAME,
     },
+    async: {
+      wasm: QUICKJS_WASM64_ASYNC_BASENAME,
+      loader: QUICKJS_WASM64_ASYNC_LOADER_BASENAME,
+    },
+    optimized: {
+      wasm: QUICKJS_WASM64_OPTIMIZED_BASENAME,
+      loader: QUICKJS_WASM64_OPTIMIZED_LOADER_BASENAME,
+    },
+    calibration: {
+      wasm: QUICKJS_WASM64_CALIBRATION_BASENAME,
+      loader: QUICKJS_WASM64_CALIBRATION_LOADER_BASENAME,
+    },
   },
 };
 
@@ -116,31 +233,41 @@ export async function getQuickjsWasmArtifact(
   variant: QuickjsWasmVariant = DEFAULT_VARIANT,
   buildType: QuickjsWasmBuildType = DEFAULT_BUILD_TYPE,
   metadata?: QuickjsWasmBuildMetadata,
+  memoryProfile: QuickjsWasmMemoryProfile = QUICKJS_WASM_DEFAULT_MEMORY_PROFILE,
 ): Promise<QuickjsWasmArtifact> {
   const resolvedMetadata = metadata ?? (await loadQuickjsWasmMetadata());
-  const buildMatrix = resolvedMetadata.variants?.[variant];
+  const matrix = getVariantsMetadata(resolvedMetadata, memoryProfile);
+  const buildMatrix = matrix?.[variant];
   const variantMetadata = buildMatrix?.[buildType];
   if (!variantMetadata) {
     const available =
       buildMatrix && Object.keys(buildMatrix).length > 0
         ? ` Available build types: ${Object.keys(buildMatrix).join(', ')}.`
         : '';
+    const profiles = listAvailableQuickjsWasmMemoryProfiles(resolvedMetadata);
+    const availableProfiles =
+      memoryProfile !== QUICKJS_WASM_DEFAULT_MEMORY_PROFILE
+        ? ` Available memory profiles: ${profiles.join(', ')}.`
+        : '';
     throw new Error(
-      `Wasm variant "${variant}" (${buildType}) is not available.${available} Run "pnpm nx build quickjs-wasm-build" to regenerate artifacts.`,
+      `Wasm variant "${variant}" (${buildType}, ${memoryProfile}) is not available.${available}${availableProfiles} Run "pnpm nx build quickjs-wasm-build" to regenerate artifacts.`,
     );
   }
 
   const filenames = VARIANT_FILENAMES[variant][buildType];
   const wasmUrl = await resolveArtifactUrl(
-    variantMetadata.wasm?.filename ?? filenames.wasm,
+    variantMetadata.wasm?.filename ??
+      memoryProfileFilename(filenames.wasm, memoryProfile),
   );
   const loaderUrl = await resolveArtifactUrl(
-    variantMetadata.loader?.filename ?? filenames.loader,
+    variantMetadata.loader?.filename ??
+      memoryProfileFilename(filenames.loader, memoryProfile),
   );
 
   return {
     variant,
     buildType,
+    memoryProfile,
     wasmUrl,
     loaderUrl,
     variantMetadata,
@@ -151,17 +278,79 @@ export async function loadQuickjsWasmBinary(
   variant: QuickjsWasmVariant = DEFAULT_VARIANT,
   buildType: QuickjsWasmBuildType = DEFAULT_BUILD_TYPE,
   metadata?: QuickjsWasmBuildMetadata,
+  memoryProfile: QuickjsWasmMemoryProfile = QUICKJS_WASM_DEFAULT_MEMORY_PROFILE,
 ): Promise<Uint8Array> {
-  const artifact = await getQuickjsWasmArtifact(variant, buildType, metadata);
+  const artifact = await getQuickjsWasmArtifact(
+    variant,
+    buildType,
+    metadata,
+    memoryProfile,
+  );
   return readUrlBinary(artifact.wasmUrl);
 }
 
+/**
+ * Compile the wasm artifact once per (variant, buildType, memoryProfile,
+ * engineBuildHash) and share the resulting WebAssembly.Module. Concurrent
+ * callers await the same compilation; failed compilations are evicted so they
+ * can be retried.
+ */
+export async function loadQuickjsWasmModule(
+  variant: QuickjsWasmVariant = DEFAULT_VARIANT,
+  buildType: QuickjsWasmBuildType = DEFAULT_BUILD_TYPE,
+  metadata?: QuickjsWasmBuildMetadata,
+  memoryProfile: QuickjsWasmMemoryProfile = QUICKJS_WASM_DEFAULT_MEMORY_PROFILE,
+): Promise<QuickjsWasmCompiledModule> {
+  const artifact = await getQuickjsWasmArtifact(
+    variant,
+    buildType,
+    metadata,
+    memoryProfile,
+  );
+  const key = `${variant}:${buildType}:${memoryProfile}:${artifact.variantMetadata.engineBuildHash ?? artifact.wasmUrl.href}`;
+
+  let compiled = COMPILED_MODULES.get(key);
+  if (!compiled) {
+    compiled = compileUrlModule(artifact.wasmUrl);
+    COMPILED_MODULES.set(key, compiled);
+    compiled.catch(() => {
+      if (COMPILED_MODULES.get(key) === compiled) {
+        COMPILED_MODULES.delete(key);
+      }
+    });
+  }
+  return compiled;
+}
+
+export function clearQuickjsWasmModuleCache(): void {
+  COMPILED_MODULES.clear();
+}
+
+export function compileQuickjsWasmBinary(
+  bytes: Uint8Array,
+): Promise<QuickjsWasmCompiledModule> {
+  return getWebAssembly().compile(bytes);
+}
+
+export function instantiateQuickjsWasmModule(
+  module: QuickjsWasmCompiledModule,
+  imports: object,
+): Promise<QuickjsWasmInstance> {
+  return getWebAssembly().instantiate(module, imports);
+}
+
 export async function loadQuickjsWasmLoaderSource(
   variant: QuickjsWasmVariant = DEFAULT_VARIANT,
   buildType: QuickjsWasmBuildType = DEFAULT_BUILD_TYPE,
   metadata?: QuickjsWasmBuildMetadata,
+  memoryProfile: QuickjsWasmMemoryProfile = QUICKJS_WASM_DEFAULT_MEMORY_PROFILE,
 ): Promise<string> {
-  const artifact = await getQuickjsWasmArtifact(variant, buildType, metadata);
+  const artifact = await getQuickjsWasmArtifact(
+    variant,
+    buildType,
+    metadata,
+    memoryProfile,
+  );
   return readUrlText(artifact.loaderUrl);
 }
 
@@ -198,6 +387,32 @@ export function listAvailableQuickjsWasmBuildTargets(
   return entries;
 }
 
+/**
+ * Profiles whose artifacts are recorded in the metadata, smallest first. The
+ * default profile is listed whenever any default-profile build exists.
+ */
+export function listAvailableQuickjsWasmMemoryProfiles(
+  metadata: QuickjsWasmBuildMetadata,
+): QuickjsWasmMemoryProfile[] {
+  const profiles = Object.keys(
+    metadata.memoryProfiles ?? {},
+  ) as QuickjsWasmMemoryProfile[];
+  if (Object.keys(metadata.variants ?? {}).length > 0) {
+    profiles.push(QUICKJS_WASM_DEFAULT_MEMORY_PROFILE);
+  }
+  return profiles.sort((a, b) => parseInt(a, 10) - parseInt(b, 10));
+}
+
+function getVariantsMetadata(
+  metadata: QuickjsWasmBuildMetadata,
+  memoryProfile: QuickjsWasmMemoryProfile,
+): QuickjsWasmVariantsMetadata | undefined {
+  if (memoryProfile === QUICKJS_WASM_DEFAULT_MEMORY_PROFILE) {
+    return metadata.variants;
+  }
+  return metadata.memoryProfiles?.[memoryProfile];
+}
+
 async function resolveArtifactUrl(filename: string): Promise<URL> {
   const packageUrl = getPackageAssetUrl(filename);
   if (!isFileUrl(packageUrl) || (await fileExists(packageUrl))) {
@@ -265,6 +480,35 @@ async function readUrlBinary(url: URL): Promise<Uint8Array> {
   return new Uint8Array(arrayBuffer);
 }
 
+async function compileUrlModule(
+  url: URL,
+): Promise<QuickjsWasmCompiledModule> {
+  const wasm = getWebAssembly();
+  // Streaming compilation lets browsers reuse their cached machine code for
+  // the same response; fall back to buffered compilation when the server does
+  // not send application/wasm.
+  if (
+    !isFileUrl(url) &&
+    typeof fetch === 'function' &&
+    typeof wasm.compileStreaming === 'function'
+  ) {
+    try {
+      return await wasm.compileStreaming(fetch(url));
+    } catch {
+      // fall through to buffered compilation
+    }
+  }
+  return wasm.compile(await readUrlBinary(url));
+}
+
+function getWebAssembly(): WebAssemblyApi {
+  const wasm = (globalThis as { WebAssembly?: WebAssemblyApi }).WebAssembly;
+  if (!wasm) {
+    throw new Error('WebAssembly is not available in this environment');
+  }
+  return wasm;
+}
+
 async function readUrlText(url: URL): Promise<string> {
   const bytes = await readUrlBinary(url);
   const decoder = new TextDecoder('utf-8', { fatal: true });
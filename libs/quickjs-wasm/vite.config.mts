@@ -58,7 +58,11 @@ function copyWasmArtifactsPlugin(): Plugin {
       };
 
       await copyArtifact(QUICKJS_WASM_METADATA_BASENAME);
-      for (const builds of Object.values(metadata.variants ?? {})) {
+      const matrices = [
+        metadata.variants,
+        ...Object.values(metadata.memoryProfiles ?? {}),
+      ];
+      for (const builds of matrices.flatMap((m) => Object.values(m ?? {}))) {
         if (!builds) continue;
         for (const variant of Object.values(builds ?? {})) {
           if (!variant) continue;
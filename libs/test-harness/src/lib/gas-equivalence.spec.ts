@@ -9,6 +9,10 @@ import {
   type QuickjsWasmVariant,
   getQuickjsWasmArtifacts,
 } from '@blue-quickjs/quickjs-wasm-build';
+import {
+  createQuickjsNativeModule,
+  getQuickjsNativeAddonPath,
+} from '@blue-quickjs/quickjs-native';
 import { HOST_V1_BYTES, HOST_V1_HASH } from './abi-manifest-fixtures.js';
 import { DETERMINISM_INPUT } from './determinism-fixtures.js';
 import {
@@ -20,6 +24,7 @@ import {
   readCString,
   writeBytes,
   writeCString,
+  type WasmModuleWithCwrap,
   type WasmPtr,
 } from './wasm-memory.js';
 
@@ -142,21 +147,24 @@ const wasm32Expectations: Record<string, ExpectedResult> = {
   },
 };
 
-let wasmInit:
-  | ((
-      manifestPtr: WasmPtr,
-      manifestLength: number,
-      hashPtr: WasmPtr,
-      contextPtr: WasmPtr,
-      contextLength: number,
-      gasLimit: bigint,
-    ) => WasmPtr)
-  | null = null;
-let wasmEval: ((code: string) => WasmPtr) | null = null;
-let wasmFreeRuntime: (() => void) | null = null;
-let wasmMalloc: ((size: number) => WasmPtr) | null = null;
-let wasmFree: ((ptr: WasmPtr) => void) | null = null;
-let wasmModule: any = null;
+interface HarnessBindings {
+  module: WasmModuleWithCwrap;
+  init: (
+    manifestPtr: WasmPtr,
+    manifestLength: number,
+    hashPtr: WasmPtr,
+    contextPtr: WasmPtr,
+    contextLength: number,
+    gasLimit: bigint,
+  ) => number;
+  takeInitError: () => WasmPtr;
+  eval: (handle: number, code: string) => WasmPtr;
+  freeRuntime: (handle: number) => void;
+  malloc: (size: number) => WasmPtr;
+  free: (ptr: WasmPtr) => void;
+}
+
+let wasmBindings: HarnessBindings | null = null;
 
 beforeAll(async () => {
   const { loaderPath } = getQuickjsWasmArtifacts(wasmVariant, wasmBuildType);
@@ -166,27 +174,50 @@ beforeAll(async () => {
     );
   }
   const moduleFactory = (await import(pathToFileURL(loaderPath).href)).default;
-  wasmModule = await moduleFactory({
+  const wasmModule = await moduleFactory({
     host: {
       host_call: () => HOST_TRANSPORT_SENTINEL,
     },
   });
-  const ptrReturnType = wasmVariant === 'wasm64' ? 'bigint' : 'number';
-  const ptrArgType = wasmVariant === 'wasm64' ? 'bigint' : 'number';
-  wasmInit = wasmModule.cwrap('qjs_det_init', ptrReturnType, [
-    ptrArgType,
-    'number',
-    ptrArgType,
-    ptrArgType,
-    'number',
-    'bigint',
-  ]);
-  wasmEval = wasmModule.cwrap('qjs_det_eval', ptrReturnType, ['string']);
-  wasmFreeRuntime = wasmModule.cwrap('qjs_det_free', null, []);
-  wasmMalloc = wasmModule.cwrap('malloc', ptrReturnType, ['number']);
-  wasmFree = wasmModule.cwrap('free', null, [ptrArgType]);
+  wasmBindings = bindHarness(
+    wasmModule,
+    wasmVariant === 'wasm64' ? 'bigint' : 'number',
+  );
 });
 
+function bindHarness(
+  module: WasmModuleWithCwrap,
+  ptrType: 'number' | 'bigint',
+): HarnessBindings {
+  return {
+    module,
+    init: module.cwrap('qjs_det_init', 'number', [
+      ptrType,
+      'number',
+      ptrType,
+      ptrType,
+      'number',
+      'bigint',
+    ]) as HarnessBindings['init'],
+    takeInitError: module.cwrap(
+      'qjs_det_take_init_error',
+      ptrType,
+      [],
+    ) as HarnessBindings['takeInitError'],
+    eval: module.cwrap('qjs_det_eval', ptrType, [
+      'number',
+      'string',
+    ]) as HarnessBindings['eval'],
+    freeRuntime: module.cwrap('qjs_det_free', null, [
+      'number',
+    ]) as HarnessBindings['freeRuntime'],
+    malloc: module.cwrap('malloc', ptrType, [
+      'number',
+    ]) as HarnessBindings['malloc'],
+    free: module.cwrap('free', null, [ptrType]) as HarnessBindings['free'],
+  };
+}
+
 function runNative(code: string, gasLimit: bigint): DeterministicOutput {
   const args = [
     '--gas-limit',
@@ -211,26 +242,27 @@ function runNative(code: string, gasLimit: bigint): DeterministicOutput {
 }
 
 function runWasm(code: string, gasLimit: bigint): DeterministicOutput {
-  if (
-    !wasmEval ||
-    !wasmInit ||
-    !wasmFreeRuntime ||
-    !wasmMalloc ||
-    !wasmFree ||
-    !wasmModule
-  ) {
+  if (!wasmBindings) {
     throw new Error('Wasm harness not initialized');
   }
+  return runHarness(wasmBindings, code, gasLimit);
+}
+
+function runHarness(
+  bindings: HarnessBindings,
+  code: string,
+  gasLimit: bigint,
+): DeterministicOutput {
+  const { module, malloc, free } = bindings;
 
-  const manifestPtr = writeBytes(wasmModule, wasmMalloc, MANIFEST_BYTES);
+  const manifestPtr = writeBytes(module, malloc, MANIFEST_BYTES);
   const contextPtr =
-    CONTEXT_BLOB.length > 0
-      ? writeBytes(wasmModule, wasmMalloc, CONTEXT_BLOB)
-      : 0;
-  const hashPtr = writeCString(wasmModule, wasmMalloc, MANIFEST_HASH);
+    CONTEXT_BLOB.length > 0 ? writeBytes(module, malloc, CONTEXT_BLOB) : 0;
+  const hashPtr = writeCString(module, malloc, MANIFEST_HASH);
 
+  let handle = 0;
   try {
-    const errorPtr = wasmInit(
+    handle = bindings.init(
       manifestPtr,
       MANIFEST_BYTES.length,
       hashPtr,
@@ -238,23 +270,26 @@ function runWasm(code: string, gasLimit: bigint): DeterministicOutput {
       CONTEXT_BLOB.length,
       gasLimit,
     );
-    if (errorPtr !== 0) {
-      const message = readCString(wasmModule, errorPtr);
-      wasmFree(errorPtr);
-      throw new Error(`wasm init failed: ${message}`);
+    if (handle === 0) {
+      const errorPtr = bindings.takeInitError();
+      const message = readCString(module, errorPtr);
+      free(errorPtr);
+      throw new Error(`init failed: ${message}`);
     }
 
-    const ptr = wasmEval(code);
-    const raw = readCString(wasmModule, ptr);
-    wasmFree(ptr);
+    const ptr = bindings.eval(handle, code);
+    const raw = readCString(module, ptr);
+    free(ptr);
     return parseDeterministicOutput(raw);
   } finally {
-    wasmFree(manifestPtr);
-    wasmFree(hashPtr);
+    free(manifestPtr);
+    free(hashPtr);
     if (contextPtr) {
-      wasmFree(contextPtr);
+      free(contextPtr);
+    }
+    if (handle !== 0) {
+      bindings.freeRuntime(handle);
     }
-    wasmFreeRuntime();
   }
 }
 
@@ -277,6 +312,32 @@ describe('wasm gas outputs', () => {
   });
 });
 
+// The addon runs the wasm32 shim on a 64-bit host, so allocation gas follows
+// the native harness (like wasm64) rather than the wasm32 expectations.
+describe.skipIf(
+  !existsSync(getQuickjsNativeAddonPath()) || !existsSync(nativeHarnessPath),
+)('native addon gas outputs', () => {
+  let addonBindings: HarnessBindings;
+
+  beforeAll(() => {
+    const module = createQuickjsNativeModule({
+      host: { host_call: () => HOST_TRANSPORT_SENTINEL },
+    });
+    addonBindings = bindHarness(module, 'number');
+  });
+
+  test.each(cases)(
+    '$name matches the native harness',
+    ({ fixture, gasLimit }) => {
+      const code = readFileSync(path.join(fixturesRoot, fixture), 'utf8');
+      expectHarnessResult(
+        runHarness(addonBindings, code, gasLimit),
+        runNative(code, gasLimit),
+      );
+    },
+  );
+});
+
 function expectHarnessResult(
   actual: DeterministicOutput,
   expected: ExpectedResult,
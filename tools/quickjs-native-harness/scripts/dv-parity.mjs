@@ -1,10 +1,10 @@
 #!/usr/bin/env node
 import assert from 'node:assert/strict';
 import { existsSync, readFileSync } from 'node:fs';
-import { spawnSync } from 'node:child_process';
 import path from 'node:path';
 import { fileURLToPath } from 'node:url';
 import jiti from 'jiti';
+import { startHarness } from './harness-serve.mjs';
 
 const __dirname = path.dirname(fileURLToPath(import.meta.url));
 const repoRoot = path.resolve(__dirname, '../../..');
@@ -140,17 +140,13 @@ const toHex = (bytes) =>
     .map((b) => b.toString(16).padStart(2, '0'))
     .join('');
 
-const runHarness = (args, label) => {
-  const result = spawnSync(harnessPath, [...manifestArgs, ...args], {
-    encoding: 'utf8',
-  });
-  if (result.error) {
-    throw result.error;
-  }
+const harness = startHarness(harnessPath);
+
+const runHarness = async (args, label) => {
+  const result = await harness.run([...manifestArgs, ...args]);
   return {
-    stdout: (result.stdout ?? '').trim(),
-    stderr: (result.stderr ?? '').trim(),
-    status: result.status ?? 0,
+    stdout: result.stdout.trim(),
+    status: result.status,
     label,
   };
 };
@@ -158,12 +154,12 @@ const runHarness = (args, label) => {
 const expectSuccess = (result, prefix) => {
   if (result.status !== 0) {
     throw new Error(
-      `${result.label ?? 'harness'} exited with ${result.status}: stdout="${result.stdout}" stderr="${result.stderr}"`,
+      `${result.label ?? 'harness'} exited with ${result.status}: stdout="${result.stdout}"`,
     );
   }
   if (!result.stdout.startsWith(prefix)) {
     throw new Error(
-      `Unexpected output for ${result.label ?? 'harness'}: stdout="${result.stdout}" stderr="${result.stderr}"`,
+      `Unexpected output for ${result.label ?? 'harness'}: stdout="${result.stdout}"`,
     );
   }
 };
@@ -171,44 +167,50 @@ const expectSuccess = (result, prefix) => {
 const expectError = (result, context) => {
   if (result.status === 0) {
     throw new Error(
-      `Expected harness error for ${context}, got status=0 stdout="${result.stdout}" stderr="${result.stderr}"`,
+      `Expected harness error for ${context}, got status=0 stdout="${result.stdout}"`,
     );
   }
   const prefix = 'ERROR ';
   if (!result.stdout.startsWith(prefix)) {
     throw new Error(
-      `Expected error output for ${context}: stdout="${result.stdout}" stderr="${result.stderr}" status=${result.status}`,
+      `Expected error output for ${context}: stdout="${result.stdout}" status=${result.status}`,
     );
   }
   return result.stdout.slice(prefix.length);
 };
 
-const runHarnessEncode = (expr) => {
-  const result = runHarness(['--dv-encode', '--eval', expr], `encode ${expr}`);
+const runHarnessEncode = async (expr) => {
+  const result = await runHarness(
+    ['--dv-encode', '--eval', expr],
+    `encode ${expr}`,
+  );
   expectSuccess(result, 'DV ');
   return result.stdout.slice('DV '.length);
 };
 
-const runHarnessDecode = (hex) => {
-  const result = runHarness(['--dv-decode', hex], `decode ${hex}`);
+const runHarnessDecode = async (hex) => {
+  const result = await runHarness(['--dv-decode', hex], `decode ${hex}`);
   expectSuccess(result, 'DVRESULT ');
   return result.stdout.slice('DVRESULT '.length);
 };
 
-const runHarnessEncodeError = (expr) => {
-  const result = runHarness(['--dv-encode', '--eval', expr], `encode ${expr}`);
+const runHarnessEncodeError = async (expr) => {
+  const result = await runHarness(
+    ['--dv-encode', '--eval', expr],
+    `encode ${expr}`,
+  );
   return expectError(result, `encode ${expr}`);
 };
 
-const runHarnessDecodeError = (hex) => {
-  const result = runHarness(['--dv-decode', hex], `decode ${hex}`);
+const runHarnessDecodeError = async (hex) => {
+  const result = await runHarness(['--dv-decode', hex], `decode ${hex}`);
   return expectError(result, `decode ${hex}`);
 };
 
 for (const fixture of encodeFixtures) {
   const encoded = encodeDv(fixture.value);
   const expectedHex = toHex(encoded);
-  const harnessHex = runHarnessEncode(fixture.expr);
+  const harnessHex = await runHarnessEncode(fixture.expr);
   assert.strictEqual(
     harnessHex,
     expectedHex,
@@ -216,7 +218,7 @@ for (const fixture of encodeFixtures) {
   );
 
   const expectedJson = JSON.stringify(decodeDv(encoded));
-  const harnessJson = runHarnessDecode(expectedHex);
+  const harnessJson = await runHarnessDecode(expectedHex);
   assert.strictEqual(
     harnessJson,
     expectedJson,
@@ -230,7 +232,7 @@ for (const fixture of encodeErrorFixtures) {
     new RegExp(fixture.errorContains),
     `TS encode should reject ${fixture.name}`,
   );
-  const harnessError = runHarnessEncodeError(fixture.expr);
+  const harnessError = await runHarnessEncodeError(fixture.expr);
   assert.ok(
     harnessError.includes(fixture.errorContains),
     `encode error mismatch for ${fixture.name}: ${harnessError}`,
@@ -243,12 +245,14 @@ for (const fixture of decodeErrorFixtures) {
     new RegExp(fixture.errorContains),
     `TS decode should reject ${fixture.name}`,
   );
-  const harnessError = runHarnessDecodeError(fixture.hex);
+  const harnessError = await runHarnessDecodeError(fixture.hex);
   assert.ok(
     harnessError.includes(fixture.errorContains),
     `decode error mismatch for ${fixture.name}: ${harnessError}`,
   );
 }
 
+await harness.close();
+
 console.log('DV parity against TS reference: ok');
 console.log('DV rejection parity cases: ok');
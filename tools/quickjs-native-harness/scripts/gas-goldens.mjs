@@ -2,7 +2,7 @@
 import { readFileSync, existsSync } from 'fs';
 import { fileURLToPath } from 'url';
 import { dirname, join, resolve } from 'path';
-import { spawnSync } from 'child_process';
+import { startHarness } from './harness-serve.mjs';
 
 const scriptDir = dirname(fileURLToPath(import.meta.url));
 const repoRoot = resolve(scriptDir, '..', '..', '..');
@@ -47,31 +47,40 @@ if (!existsSync(binPath)) {
 const cases = JSON.parse(readFileSync(fixturesPath, 'utf8'));
 
 const failures = [];
+const harness = startHarness(binPath);
 
-for (const testCase of cases) {
-  const codePath = join(fixturesRoot, testCase.fixture);
-  const code = readFileSync(codePath, 'utf8');
-  const args = [...manifestArgs, ...(testCase.args || []), '--eval', code];
+const results = await Promise.all(
+  cases.map((testCase) => {
+    const codePath = join(fixturesRoot, testCase.fixture);
+    const code = readFileSync(codePath, 'utf8');
+    const args = [...manifestArgs, ...(testCase.args || []), '--eval', code];
+    return harness.run(args).then(
+      (result) => ({ stdout: result.stdout.trim() }),
+      (error) => ({ error }),
+    );
+  }),
+);
+await harness.close();
 
-  const result = spawnSync(binPath, args, { encoding: 'utf8' });
-  const stdout = (result.stdout || '').trim();
+cases.forEach((testCase, index) => {
+  const result = results[index];
   if (result.error) {
     failures.push({
       name: testCase.name,
       expected: testCase.expected,
-      actual: `spawn error: ${result.error.message}`,
+      actual: `harness error: ${result.error.message}`,
     });
-    continue;
+    return;
   }
 
-  if (stdout !== testCase.expected) {
+  if (result.stdout !== testCase.expected) {
     failures.push({
       name: testCase.name,
       expected: testCase.expected,
-      actual: stdout,
+      actual: result.stdout,
     });
   }
-}
+});
 
 if (failures.length > 0) {
   console.error('Gas golden mismatches:');
@@ -0,0 +1,74 @@
+import { spawn } from 'child_process';
+
+/**
+ * Starts `quickjs-native-harness --serve` and returns a client that sends
+ * one-shot argv lists over its length-prefixed protocol. Requests are
+ * pipelined; responses resolve in order as `{ status, stdout }`, where
+ * `status` is the exit code the one-shot run would have returned.
+ */
+export function startHarness(binPath) {
+  const child = spawn(binPath, ['--serve'], {
+    stdio: ['pipe', 'pipe', 'inherit'],
+  });
+  const pending = [];
+  let buffered = Buffer.alloc(0);
+  let failure = null;
+
+  const fail = (error) => {
+    failure ??= error;
+    while (pending.length > 0) {
+      pending.shift().reject(failure);
+    }
+  };
+
+  child.on('error', fail);
+  child.on('exit', (code, signal) => {
+    fail(new Error(`harness --serve exited (code=${code}, signal=${signal})`));
+  });
+
+  child.stdout.on('data', (chunk) => {
+    buffered = Buffer.concat([buffered, chunk]);
+    while (buffered.length >= 8) {
+      const length = buffered.readUInt32LE(4);
+      if (buffered.length < 8 + length) {
+        break;
+      }
+      const status = buffered.readUInt32LE(0);
+      const stdout = buffered.subarray(8, 8 + length).toString('utf8');
+      buffered = buffered.subarray(8 + length);
+      pending.shift()?.resolve({ status, stdout });
+    }
+  });
+
+  const run = (args) => {
+    if (failure) {
+      return Promise.reject(failure);
+    }
+    for (const arg of args) {
+      if (arg.includes('\0')) {
+        return Promise.reject(
+          new Error('harness arguments cannot contain NUL'),
+        );
+      }
+    }
+    const body = Buffer.from(args.map((arg) => `${arg}\0`).join(''), 'utf8');
+    const header = Buffer.alloc(4);
+    header.writeUInt32LE(body.length, 0);
+    return new Promise((resolve, reject) => {
+      pending.push({ resolve, reject });
+      child.stdin.write(Buffer.concat([header, body]));
+    });
+  };
+
+  const close = () =>
+    new Promise((resolve) => {
+      if (child.exitCode !== null || child.signalCode !== null) {
+        resolve();
+        return;
+      }
+      child.once('exit', () => resolve());
+      child.stdin.end();
+    });
+
+  return { run, close };
+}
@@ -1,8 +1,8 @@
 #!/usr/bin/env node
 import { existsSync, readFileSync } from 'fs';
-import { spawnSync } from 'child_process';
 import { dirname, join, resolve } from 'path';
 import { fileURLToPath } from 'url';
+import { startHarness } from './harness-serve.mjs';
 
 const scriptDir = dirname(fileURLToPath(import.meta.url));
 const repoRoot = resolve(scriptDir, '..', '..', '..');
@@ -62,14 +62,11 @@ const cases = [
   },
 ];
 
-function dvLength(expr) {
-  const result = spawnSync(binPath, ['--dv-encode', '--eval', expr], {
-    encoding: 'utf8',
-  });
-  if (result.error) {
-    throw new Error(`dv encode spawn error: ${result.error.message}`);
-  }
-  const stdout = (result.stdout || '').trim();
+const harness = startHarness(binPath);
+
+async function dvLength(expr) {
+  const result = await harness.run(['--dv-encode', '--eval', expr]);
+  const stdout = result.stdout.trim();
   const match = stdout.match(/^DV\s+([0-9a-fA-F]+)$/);
   if (!match) {
     throw new Error(`Unexpected dv encode output: ${stdout}`);
@@ -78,7 +75,7 @@ function dvLength(expr) {
   return hex.length / 2;
 }
 
-function runHarness(code) {
+async function runHarness(code) {
   const args = [
     ...manifestArgs,
     '--gas-limit',
@@ -88,11 +85,8 @@ function runHarness(code) {
     '--eval',
     code,
   ];
-  const result = spawnSync(binPath, args, { encoding: 'utf8' });
-  if (result.error) {
-    throw new Error(`harness spawn error: ${result.error.message}`);
-  }
-  const stdout = (result.stdout || '').trim();
+  const result = await harness.run(args);
+  const stdout = result.stdout.trim();
   if (!stdout) {
     throw new Error('Harness produced no stdout');
   }
@@ -118,15 +112,15 @@ function computeNonHostGas(trace) {
 const failures = [];
 
 for (const test of cases) {
-  const reqLen = dvLength(test.requestExpr);
-  const respLen = dvLength(test.responseExpr);
+  const reqLen = await dvLength(test.requestExpr);
+  const respLen = await dvLength(test.responseExpr);
   const expectedHostGas =
     test.gas.base +
     test.gas.kArg * reqLen +
     test.gas.kRet * respLen +
     test.gas.kUnits * test.units;
 
-  const run = runHarness(test.code);
+  const run = await runHarness(test.code);
   const nonHost = computeNonHostGas(run.trace);
   const hostGas = run.used - nonHost;
 
@@ -139,6 +133,7 @@ for (const test of cases) {
     });
   }
 }
+await harness.close();
 
 if (failures.length > 0) {
   console.error('Host gas mismatches:');
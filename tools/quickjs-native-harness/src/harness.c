@@ -60,6 +60,10 @@ typedef struct {
   size_t count;
 } HostErrorTable;
 
+/* Response stream: stdout for one-shot runs, a per-request memory stream in
+   --serve mode. Diagnostics always go to stderr. */
+static FILE *harness_out;
+
 static int print_exception(JSContext *ctx, const HarnessOptions *options);
 static void free_runtime(HarnessRuntime *runtime);
 static int run_sha256(const HarnessOptions *options);
@@ -386,7 +390,7 @@ static char *read_file_to_string(const char *path) {
 
 static void print_hex_buffer(const uint8_t *data, size_t len) {
   for (size_t i = 0; i < len; i++) {
-    fprintf(stdout, "%02x", data[i]);
+    fprintf(harness_out, "%02x", data[i]);
   }
 }
 
@@ -404,7 +408,7 @@ static int run_sha256(const HarnessOptions *options) {
   js_sha256_to_hex(hash, hex);
   free(bytes);
 
-  fprintf(stdout, "SHA256 %s\n", hex);
+  fprintf(harness_out, "SHA256 %s\n", hex);
   return 0;
 }
 
@@ -528,10 +532,10 @@ static void print_gas_suffix(const HarnessOptions *options, const HarnessSnapsho
 
   uint64_t remaining = snapshot->gas_remaining;
   if (options->gas_limit == JS_GAS_UNLIMITED) {
-    fprintf(stdout, " GAS remaining=%" PRIu64, remaining);
+    fprintf(harness_out, " GAS remaining=%" PRIu64, remaining);
   } else {
     uint64_t used = options->gas_limit - remaining;
-    fprintf(stdout, " GAS remaining=%" PRIu64 " used=%" PRIu64, remaining, used);
+    fprintf(harness_out, " GAS remaining=%" PRIu64 " used=%" PRIu64, remaining, used);
   }
 }
 
@@ -542,14 +546,14 @@ static void print_state_suffix(JSContext *ctx, const HarnessOptions *options) {
 
   JSValue global = JS_GetGlobalObject(ctx);
   if (JS_IsException(global)) {
-    fprintf(stdout, " STATE <global unavailable>");
+    fprintf(harness_out, " STATE <global unavailable>");
     return;
   }
 
   JSValue value = JS_GetPropertyStr(ctx, global, options->dump_global);
   JS_FreeValue(ctx, global);
   if (JS_IsException(value)) {
-    fprintf(stdout, " STATE <read error>");
+    fprintf(harness_out, " STATE <read error>");
     JS_FreeValue(ctx, value);
     return;
   }
@@ -557,25 +561,25 @@ static void print_state_suffix(JSContext *ctx, const HarnessOptions *options) {
   JSValue json = JS_JSONStringify(ctx, value, JS_UNDEFINED, JS_UNDEFINED);
   JS_FreeValue(ctx, value);
   if (JS_IsException(json)) {
-    fprintf(stdout, " STATE <stringify error>");
+    fprintf(harness_out, " STATE <stringify error>");
     JS_FreeValue(ctx, json);
     return;
   }
 
   if (JS_IsUndefined(json)) {
-    fprintf(stdout, " STATE undefined");
+    fprintf(harness_out, " STATE undefined");
     JS_FreeValue(ctx, json);
     return;
   }
 
   const char *json_str = JS_ToCString(ctx, json);
   if (!json_str) {
-    fprintf(stdout, " STATE <stringify error>");
+    fprintf(harness_out, " STATE <stringify error>");
     JS_FreeValue(ctx, json);
     return;
   }
 
-  fprintf(stdout, " STATE %s", json_str);
+  fprintf(harness_out, " STATE %s", json_str);
   JS_FreeCString(ctx, json_str);
   JS_FreeValue(ctx, json);
 }
@@ -586,11 +590,11 @@ static void print_trace_suffix(const HarnessOptions *options, const HarnessSnaps
   }
 
   if (!snapshot->has_trace) {
-    fprintf(stdout, " TRACE <unavailable>");
+    fprintf(harness_out, " TRACE <unavailable>");
     return;
   }
 
-  fprintf(stdout,
+  fprintf(harness_out,
           " TRACE {\"opcodeCount\":%" PRIu64 ",\"opcodeGas\":%" PRIu64
           ",\"arrayCbBase\":{\"count\":%" PRIu64 ",\"gas\":%" PRIu64
           "},\"arrayCbPerEl\":{\"count\":%" PRIu64 ",\"gas\":%" PRIu64
@@ -601,7 +605,7 @@ static void print_trace_suffix(const HarnessOptions *options, const HarnessSnaps
           snapshot->trace.builtin_array_cb_per_element_gas, snapshot->trace.allocation_count,
           snapshot->trace.allocation_bytes, snapshot->trace.allocation_gas);
 
-  fputc('}', stdout);
+  fputc('}', harness_out);
 }
 
 static int print_exception(JSContext *ctx, const HarnessOptions *options) {
@@ -613,18 +617,18 @@ static int print_exception(JSContext *ctx, const HarnessOptions *options) {
     snapshot.has_trace = JS_ReadGasTrace(ctx, &snapshot.trace) == 0;
   }
   if (msg) {
-    fprintf(stdout, "ERROR %s", msg);
+    fprintf(harness_out, "ERROR %s", msg);
     print_gas_suffix(options, &snapshot);
     print_state_suffix(ctx, options);
     print_trace_suffix(options, &snapshot);
-    fprintf(stdout, "\n");
+    fprintf(harness_out, "\n");
     JS_FreeCString(ctx, msg);
   } else {
-    fprintf(stdout, "ERROR <exception>");
+    fprintf(harness_out, "ERROR <exception>");
     print_gas_suffix(options, &snapshot);
     print_state_suffix(ctx, options);
     print_trace_suffix(options, &snapshot);
-    fprintf(stdout, "\n");
+    fprintf(harness_out, "\n");
   }
   JS_FreeValue(ctx, exception);
   return 1;
@@ -676,11 +680,11 @@ static int encode_dv_source(JSContext *ctx, const HarnessOptions *options) {
     snapshot.has_trace = JS_ReadGasTrace(ctx, &snapshot.trace) == 0;
   }
 
-  fprintf(stdout, "DV ");
+  fprintf(harness_out, "DV ");
   print_hex_buffer(buffer.data, buffer.length);
   print_gas_suffix(options, &snapshot);
   print_trace_suffix(options, &snapshot);
-  fprintf(stdout, "\n");
+  fprintf(harness_out, "\n");
 
   JS_FreeDVBuffer(ctx, &buffer);
   return 0;
@@ -721,7 +725,7 @@ static int decode_dv_hex(JSContext *ctx, const HarnessOptions *options) {
   const char *json_str = JS_ToCString(ctx, json);
   if (!json_str) {
     JS_FreeValue(ctx, json);
-    fprintf(stdout, "ERROR <stringify>\n");
+    fprintf(harness_out, "ERROR <stringify>\n");
     return 1;
   }
 
@@ -737,10 +741,10 @@ static int decode_dv_hex(JSContext *ctx, const HarnessOptions *options) {
     snapshot.has_trace = JS_ReadGasTrace(ctx, &snapshot.trace) == 0;
   }
 
-  fprintf(stdout, "DVRESULT %s", json_str);
+  fprintf(harness_out, "DVRESULT %s", json_str);
   print_gas_suffix(options, &snapshot);
   print_trace_suffix(options, &snapshot);
-  fprintf(stdout, "\n");
+  fprintf(harness_out, "\n");
 
   JS_FreeCString(ctx, json_str);
   JS_FreeValue(ctx, json);
@@ -846,15 +850,15 @@ static int run_host_call(HarnessRuntime *runtime, const HarnessOptions *options)
       JS_FreeHostResponse(runtime->ctx, &parsed);
       free_default_host_errors(runtime->ctx, &error_table);
       free(req_bytes);
-      fprintf(stdout, "ERROR <stringify>");
+      fprintf(harness_out, "ERROR <stringify>");
       print_gas_suffix(options, &snapshot);
       print_state_suffix(runtime->ctx, options);
       print_trace_suffix(options, &snapshot);
-      fprintf(stdout, "\n");
+      fprintf(harness_out, "\n");
       return 1;
     }
 
-    fprintf(stdout, "HOSTRESP %s UNITS %" PRIu32, json_str, parsed.units);
+    fprintf(harness_out, "HOSTRESP %s UNITS %" PRIu32, json_str, parsed.units);
     JS_FreeCString(runtime->ctx, json_str);
     JS_FreeValue(runtime->ctx, json);
     JS_FreeHostResponse(runtime->ctx, &parsed);
@@ -862,7 +866,7 @@ static int run_host_call(HarnessRuntime *runtime, const HarnessOptions *options)
     print_gas_suffix(options, &snapshot);
     print_state_suffix(runtime->ctx, options);
     print_trace_suffix(options, &snapshot);
-    fprintf(stdout, "\n");
+    fprintf(harness_out, "\n");
     free(req_bytes);
     return 0;
   }
@@ -873,12 +877,12 @@ static int run_host_call(HarnessRuntime *runtime, const HarnessOptions *options)
     snapshot.has_trace = JS_ReadGasTrace(runtime->ctx, &snapshot.trace) == 0;
   }
 
-  fprintf(stdout, "HOSTCALL ");
+  fprintf(harness_out, "HOSTCALL ");
   print_hex_buffer(result.data, result.length);
   print_gas_suffix(options, &snapshot);
   print_state_suffix(runtime->ctx, options);
   print_trace_suffix(options, &snapshot);
-  fprintf(stdout, "\n");
+  fprintf(harness_out, "\n");
 
   free(req_bytes);
   return 0;
@@ -911,7 +915,7 @@ static int eval_source(JSContext *ctx, const char *code, const HarnessOptions *o
   const char *json_str = JS_ToCString(ctx, json);
   if (!json_str) {
     JS_FreeValue(ctx, json);
-    fprintf(stdout, "ERROR <stringify>\n");
+    fprintf(harness_out, "ERROR <stringify>\n");
     return 1;
   }
 
@@ -927,11 +931,11 @@ static int eval_source(JSContext *ctx, const char *code, const HarnessOptions *o
     snapshot.has_trace = JS_ReadGasTrace(ctx, &snapshot.trace) == 0;
   }
 
-  fprintf(stdout, "RESULT %s", json_str);
+  fprintf(harness_out, "RESULT %s", json_str);
   print_gas_suffix(options, &snapshot);
   print_state_suffix(ctx, options);
   print_trace_suffix(options, &snapshot);
-  fprintf(stdout, "\n");
+  fprintf(harness_out, "\n");
 
   JS_FreeCString(ctx, json_str);
   JS_FreeValue(ctx, json);
@@ -945,7 +949,9 @@ static void print_usage(const char *prog) {
           "  %s --dv-encode --eval \"<js-source>\"\n"
           "  %s --dv-decode <hex-string>\n"
           "  %s --host-call <hex-string> [--host-fn-id <u32>] [--host-max-request <u32>] [--host-max-response <u32>] [--host-max-units <u32>] [--host-parse-envelope] [--host-reentrant] [--host-exception] [--gas-limit <u64>] [--report-gas] [--gas-trace] [--abi-manifest-hex <hex> | --abi-manifest-hex-file <path>] [--abi-manifest-hash <hex>] [--context-blob-hex <hex>]\n"
-          "  %s --sha256-hex <hex-string>\n",
+          "  %s --sha256-hex <hex-string>\n"
+          "  %s --serve\n",
+          prog,
           prog,
           prog,
           prog,
@@ -1220,51 +1226,265 @@ static int parse_args(int argc, char **argv, HarnessOptions *opts) {
   return 0;
 }
 
-int main(int argc, char **argv) {
+static int run_request(HarnessRuntime *runtime, const HarnessOptions *options) {
+  JS_SetGasLimit(runtime->ctx, options->gas_limit);
+
+  if (options->report_trace) {
+    if (JS_EnableGasTrace(runtime->ctx, 1) != 0) {
+      fprintf(stderr, "init: failed to enable gas trace\n");
+      return 1;
+    }
+  }
+
+  if (options->dv_decode_hex) {
+    return decode_dv_hex(runtime->ctx, options);
+  }
+  if (options->host_call_hex) {
+    return run_host_call(runtime, options);
+  }
+  if (run_gc_checkpoint(runtime->ctx, options) != 0) {
+    return 1;
+  }
+  if (options->dv_encode) {
+    return encode_dv_source(runtime->ctx, options);
+  }
+  return eval_source(runtime->ctx, options->code, options);
+}
+
+/* A served request may run on the runtime left by the previous one only when
+   its output cannot depend on what that runtime already holds: no user code
+   runs (dv-decode, host-call), gas is unlimited and unreported, and no gas
+   trace or global dump is requested. Everything else gets a fresh runtime, so
+   responses match one-shot runs byte for byte. */
+static int runtime_reusable(const HarnessOptions *options) {
+  return (options->dv_decode_hex != NULL || options->host_call_hex != NULL) &&
+         options->gas_limit == JS_GAS_UNLIMITED && !options->report_gas &&
+         !options->report_trace && options->dump_global == NULL;
+}
+
+static int append_key_part(char **key, size_t *len, const char *part) {
+  const size_t part_len = part ? strlen(part) + 1 : 0;
+  char *next = realloc(*key, *len + part_len + 1);
+  if (!next) {
+    return -1;
+  }
+  next[(*len)++] = part ? 's' : 'n';
+  if (part) {
+    memcpy(next + *len, part, part_len);
+    *len += part_len;
+  }
+  *key = next;
+  return 0;
+}
+
+/* Everything init_runtime reads, flattened into one comparable blob. */
+static char *runtime_key(const HarnessOptions *options, size_t *out_len) {
+  char mode[4] = {
+      options->host_call_hex != NULL ? 'e' : 'm',
+      options->host_call_reentrant ? 'r' : '-',
+      options->host_call_exception ? 'x' : '-',
+      '\0',
+  };
+  char *key = NULL;
+  size_t len = 0;
+
+  if (append_key_part(&key, &len, mode) != 0 ||
+      append_key_part(&key, &len, options->abi_manifest_hex) != 0 ||
+      append_key_part(&key, &len, options->abi_manifest_file) != 0 ||
+      append_key_part(&key, &len, options->abi_manifest_hash) != 0 ||
+      append_key_part(&key, &len, options->context_blob_hex) != 0) {
+    free(key);
+    return NULL;
+  }
+
+  *out_len = len;
+  return key;
+}
+
+typedef struct {
+  HarnessRuntime runtime;
+  char *key;
+  size_t key_len;
+} HarnessRuntimeCache;
+
+static void clear_runtime_cache(HarnessRuntimeCache *cache) {
+  free_runtime(&cache->runtime);
+  memset(&cache->runtime, 0, sizeof(cache->runtime));
+  free(cache->key);
+  cache->key = NULL;
+  cache->key_len = 0;
+}
+
+static int serve_request(int argc, char **argv, HarnessRuntimeCache *cache) {
   HarnessOptions options;
-  int parse_result = parse_args(argc, argv, &options);
-  if (parse_result != 0) {
-    return parse_result;
+  int rc = parse_args(argc, argv, &options);
+  if (rc != 0) {
+    return rc;
   }
 
   if (options.sha256_hex) {
     return run_sha256(&options);
   }
 
-  HarnessRuntime runtime = {0};
+  size_t key_len = 0;
+  char *key = runtime_reusable(&options) ? runtime_key(&options, &key_len) : NULL;
 
-  int init_rc = init_runtime(&runtime, &options);
-  if (init_rc != 0) {
-    return init_rc;
+  if (!key) {
+    HarnessRuntime runtime = {0};
+    rc = init_runtime(&runtime, &options);
+    if (rc != 0) {
+      return rc;
+    }
+    rc = run_request(&runtime, &options);
+    free_runtime(&runtime);
+    return rc;
   }
 
-  JS_SetGasLimit(runtime.ctx, options.gas_limit);
-
-  if (options.report_trace) {
-    if (JS_EnableGasTrace(runtime.ctx, 1) != 0) {
-      fprintf(stderr, "init: failed to enable gas trace\n");
-      free_runtime(&runtime);
-      return 1;
+  if (cache->key == NULL || cache->key_len != key_len || memcmp(cache->key, key, key_len) != 0) {
+    clear_runtime_cache(cache);
+    /* The host stub config lives in the cache slot, so init in place. */
+    rc = init_runtime(&cache->runtime, &options);
+    if (rc != 0) {
+      memset(&cache->runtime, 0, sizeof(cache->runtime));
+      free(key);
+      return rc;
     }
+    cache->key = key;
+    cache->key_len = key_len;
+  } else {
+    free(key);
   }
 
+  return run_request(&cache->runtime, &options);
+}
+
+static int read_exact(uint8_t *buf, size_t len) {
+  return fread(buf, 1, len, stdin) == len ? 0 : -1;
+}
+
+static int write_u32le(uint32_t value) {
+  const uint8_t bytes[4] = {
+      (uint8_t)value,
+      (uint8_t)(value >> 8),
+      (uint8_t)(value >> 16),
+      (uint8_t)(value >> 24),
+  };
+  return fwrite(bytes, 1, sizeof(bytes), stdout) == sizeof(bytes) ? 0 : -1;
+}
+
+/* --serve: requests arrive on stdin as a u32 little-endian byte length followed
+   by that many bytes of NUL-terminated argv tokens (the flags of a one-shot
+   run). Each response on stdout is the one-shot exit code and the byte length
+   of its output (both u32 little-endian), then the output itself. Returns at
+   end of input. */
+static int serve(const char *prog) {
+  HarnessRuntimeCache cache = {0};
   int rc = 0;
-  if (options.dv_decode_hex) {
-    rc = decode_dv_hex(runtime.ctx, &options);
-  } else if (options.host_call_hex) {
-    rc = run_host_call(&runtime, &options);
-  } else {
-    if (run_gc_checkpoint(runtime.ctx, &options) != 0) {
-      free_runtime(&runtime);
-      return 1;
+
+  for (;;) {
+    uint8_t header[4];
+    const size_t got = fread(header, 1, sizeof(header), stdin);
+    if (got == 0 && feof(stdin)) {
+      break;
     }
-    if (options.dv_encode) {
-      rc = encode_dv_source(runtime.ctx, &options);
-    } else {
-      rc = eval_source(runtime.ctx, options.code, &options);
+    if (got != sizeof(header)) {
+      fprintf(stderr, "serve: truncated request header\n");
+      rc = 2;
+      break;
+    }
+
+    const uint32_t len = (uint32_t)header[0] | ((uint32_t)header[1] << 8) |
+                         ((uint32_t)header[2] << 16) | ((uint32_t)header[3] << 24);
+    char *payload = malloc((size_t)len + 1);
+    if (!payload) {
+      fprintf(stderr, "serve: out of memory\n");
+      rc = 1;
+      break;
+    }
+    if (read_exact((uint8_t *)payload, len) != 0) {
+      fprintf(stderr, "serve: truncated request body\n");
+      free(payload);
+      rc = 2;
+      break;
+    }
+    payload[len] = '\0';
+
+    size_t token_count = 0;
+    for (uint32_t i = 0; i < len; i++) {
+      if (payload[i] == '\0') {
+        token_count++;
+      }
     }
+    if (len > 0 && payload[len - 1] != '\0') {
+      token_count++;
+    }
+
+    char **request_argv = calloc(token_count + 2, sizeof(char *));
+    char *out_data = NULL;
+    size_t out_len = 0;
+    FILE *out = request_argv ? open_memstream(&out_data, &out_len) : NULL;
+    if (!out) {
+      fprintf(stderr, "serve: out of memory\n");
+      free(request_argv);
+      free(payload);
+      rc = 1;
+      break;
+    }
+
+    int request_argc = 0;
+    request_argv[request_argc++] = (char *)prog;
+    for (uint32_t offset = 0; offset < len; offset += (uint32_t)strlen(payload + offset) + 1) {
+      request_argv[request_argc++] = payload + offset;
+    }
+
+    harness_out = out;
+    const int status = serve_request(request_argc, request_argv, &cache);
+    harness_out = stdout;
+    fclose(out);
+
+    const int written = write_u32le((uint32_t)status) == 0 &&
+                        write_u32le((uint32_t)out_len) == 0 &&
+                        fwrite(out_data, 1, out_len, stdout) == out_len &&
+                        fflush(stdout) == 0;
+    free(out_data);
+    free(request_argv);
+    free(payload);
+    if (!written) {
+      fprintf(stderr, "serve: failed to write response\n");
+      rc = 1;
+      break;
+    }
+  }
+
+  clear_runtime_cache(&cache);
+  return rc;
+}
+
+int main(int argc, char **argv) {
+  harness_out = stdout;
+
+  if (argc == 2 && strcmp(argv[1], "--serve") == 0) {
+    return serve(argv[0]);
+  }
+
+  HarnessOptions options;
+  int parse_result = parse_args(argc, argv, &options);
+  if (parse_result != 0) {
+    return parse_result;
+  }
+
+  if (options.sha256_hex) {
+    return run_sha256(&options);
+  }
+
+  HarnessRuntime runtime = {0};
+
+  int init_rc = init_runtime(&runtime, &options);
+  if (init_rc != 0) {
+    return init_rc;
   }
 
+  int rc = run_request(&runtime, &options);
   free_runtime(&runtime);
   return rc;
 }